@@ -6,6 +6,7 @@
 
 namespace g2 {
 namespace fasth {
+class testsuites_data;
 /**
 * This class is base of all suites.
 * It is not templated and therefore can be used by test agent.
@@ -20,6 +21,19 @@ class base_suite {
     virtual std::string execute(std::string report_file_name = "") {
         return "";
     };
+    /**
+    * This function executes test suite without generating JUnit report.
+    * Results are added to a report later by add_to_report(). Suites which
+    * override only execute() are run by it.
+    */
+    virtual void run_suite() {
+        execute();
+    }
+    /**
+    * This function adds results of executed test suite to aggregated report.
+    * @param report Report of all suites executed by test agent.
+    */
+    virtual void add_to_report(testsuites_data&) {}
     virtual void set_state(test_run_state new_state) {}
     virtual test_run_state state() { return not_yet; }
 protected:
@@ -0,0 +1,113 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_BENCH_H
+#define INC_LIBG2FASTH_BENCH_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <utility>
+#include "g2fasth_platform.hpp"
+
+namespace g2 {
+namespace fasth {
+/**
+* Measurements of one benchmark run with given parameters.
+*/
+class bench_result {
+public:
+    explicit bench_result(const std::string& name) : d_name(name) {}
+    /**
+    * Adds input parameter of the run, like number of test cases.
+    */
+    bench_result& param(const std::string& name, double value);
+    /**
+    * Adds measured value. Name should include unit, like "elapsed_s".
+    */
+    bench_result& metric(const std::string& name, double value);
+    /**
+    * Adds min, p50, p90, p99, max and mean of samples as metrics named <prefix>_<statistic>.
+    */
+    bench_result& distribution(const std::string& prefix, std::vector<double> samples);
+    /**
+    * Marks the run as not measured, for example because it would exceed time budget.
+    */
+    bench_result& skip(const std::string& reason);
+    const std::string& name() const { return d_name; }
+    std::string to_json() const;
+private:
+    std::string d_name;
+    std::vector<std::pair<std::string, double> > d_params;
+    std::vector<std::pair<std::string, double> > d_metrics;
+    std::string d_skipped;
+};
+
+/**
+* Passed to benchmark functions to collect their results.
+*/
+class bench_context {
+public:
+    bench_context(bool quick, double budget_s) : d_quick(quick), d_budget_s(budget_s) {}
+    /**
+    * Checks if benchmarks should use smallest sizes only, for smoke runs.
+    */
+    bool quick() const { return d_quick; }
+    /**
+    * Returns seconds a single run may take. Larger sizes expected to exceed it are skipped.
+    */
+    double budget_s() const { return d_budget_s; }
+    /**
+    * Starts new result. The reference is valid until the context is destroyed.
+    */
+    bench_result& add(const std::string& name);
+    const std::list<bench_result>& results() const { return d_results; }
+private:
+    bool d_quick;
+    double d_budget_s;
+    std::list<bench_result> d_results;
+};
+
+typedef void (*bench_function)(bench_context& context);
+
+/**
+* Registers benchmark function at static initialization, use G2FASTH_BENCHMARK.
+*/
+struct bench_registration {
+    bench_registration(const char* name, bench_function function);
+};
+
+/**
+* Returns seconds elapsed since start_ns from monotonic_ns().
+*/
+inline double seconds_since(unsigned long long start_ns)
+{
+    return (monotonic_ns() - start_ns) / 1e9;
+}
+
+/**
+* Returns number of allocations made with operator new by the process so far.
+*/
+unsigned long allocation_count();
+
+/**
+* Returns peak resident set size of the process in bytes, or 0 if it's not known.
+*/
+unsigned long long peak_rss_bytes();
+
+/**
+* Lowers the peak resident set size to the current one, so that peak_rss_bytes() reports
+* the peak of the following run. Only Linux supports it, elsewhere the peak of the whole
+* process is reported, so runs should go from smallest to largest.
+*/
+void reset_peak_rss();
+}
+}
+
+/**
+* Defines benchmark function which is run by benchg2fasth.
+*/
+#define G2FASTH_BENCHMARK(name) \
+    static void name(g2::fasth::bench_context& context); \
+    static g2::fasth::bench_registration name##_registration(#name, name); \
+    static void name(g2::fasth::bench_context& context)
+
+#endif // !INC_LIBG2FASTH_BENCH_H
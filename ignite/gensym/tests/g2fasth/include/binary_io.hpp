@@ -0,0 +1,206 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_BINARY_IO_H
+#define INC_LIBG2FASTH_BINARY_IO_H
+
+#include <string>
+#include <cstdio>
+
+namespace g2 {
+namespace fasth {
+/**
+* Helpers for reading and writing length-prefixed binary records.
+* All integers are stored little-endian regardless of host byte order,
+* so files can be moved between Windows and Linux build agents.
+* A record is laid out as [u32 length][u8 type][payload], where length
+* counts the type byte and the payload.
+*/
+namespace binary_io {
+
+inline void put_u8(std::string& out, unsigned char value)
+{
+    out.push_back((char)value);
+}
+
+inline void put_u32(std::string& out, unsigned int value)
+{
+    char buf[4];
+    for (int i = 0; i < 4; i++)
+        buf[i] = (char)((value >> (8 * i)) & 0xff);
+    out.append(buf, 4);
+}
+
+inline void put_u64(std::string& out, unsigned long long value)
+{
+    char buf[8];
+    for (int i = 0; i < 8; i++)
+        buf[i] = (char)((value >> (8 * i)) & 0xff);
+    out.append(buf, 8);
+}
+
+/**
+* Writes unsigned integer in 7-bit groups, small values take one byte.
+*/
+inline void put_varint(std::string& out, unsigned long long value)
+{
+    char buf[10];
+    int n = 0;
+    while (value >= 0x80)
+    {
+        buf[n++] = (char)((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    buf[n++] = (char)value;
+    out.append(buf, n);
+}
+
+/**
+* Writes signed integer as varint, values near zero take one byte.
+*/
+inline void put_svarint(std::string& out, long long value)
+{
+    put_varint(out, ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63));
+}
+
+inline void put_str(std::string& out, const char* str, size_t len)
+{
+    put_u32(out, (unsigned int)len);
+    out.append(str, len);
+}
+
+inline void put_str(std::string& out, const std::string& str)
+{
+    put_str(out, str.data(), str.size());
+}
+
+/**
+* Starts a new record of given type at the end of the buffer.
+* @return Offset of the record, to be passed to end_record().
+*/
+inline size_t begin_record(std::string& out, unsigned char type)
+{
+    size_t offset = out.size();
+    put_u32(out, 0);
+    put_u8(out, type);
+    return offset;
+}
+
+/**
+* Patches the length prefix of the record started at offset.
+*/
+inline void end_record(std::string& out, size_t offset)
+{
+    unsigned int len = (unsigned int)(out.size() - offset - 4);
+    for (int i = 0; i < 4; i++)
+        out[offset + i] = (char)((len >> (8 * i)) & 0xff);
+}
+
+/**
+* Sequential decoder over a record payload. Reading past the end sets
+* the failure flag and returns zeros instead of throwing.
+*/
+class decoder {
+public:
+    decoder(const char* data, size_t size)
+        : d_pos((const unsigned char*)data)
+        , d_end((const unsigned char*)data + size)
+        , d_ok(true) {
+    }
+    bool ok() const { return d_ok; }
+    size_t remaining() const { return d_end - d_pos; }
+    unsigned char get_u8() {
+        if (!need(1))
+            return 0;
+        return *d_pos++;
+    }
+    unsigned int get_u32() {
+        if (!need(4))
+            return 0;
+        unsigned int value = 0;
+        for (int i = 0; i < 4; i++)
+            value |= (unsigned int)d_pos[i] << (8 * i);
+        d_pos += 4;
+        return value;
+    }
+    unsigned long long get_u64() {
+        if (!need(8))
+            return 0;
+        unsigned long long value = 0;
+        for (int i = 0; i < 8; i++)
+            value |= (unsigned long long)d_pos[i] << (8 * i);
+        d_pos += 8;
+        return value;
+    }
+    unsigned long long get_varint() {
+        unsigned long long value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (!need(1))
+                return 0;
+            unsigned char byte = *d_pos++;
+            value |= (unsigned long long)(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        d_ok = false;
+        return 0;
+    }
+    long long get_svarint() {
+        unsigned long long value = get_varint();
+        return (long long)(value >> 1) ^ -(long long)(value & 1);
+    }
+    /**
+    * Returns pointer to next count bytes and skips them, nullptr if there are less.
+    */
+    const char* get_bytes(size_t count) {
+        if (!need(count))
+            return nullptr;
+        const char* bytes = (const char*)d_pos;
+        d_pos += count;
+        return bytes;
+    }
+    bool get_str(std::string& value) {
+        unsigned int len = get_u32();
+        if (!need(len))
+            return false;
+        value.assign((const char*)d_pos, len);
+        d_pos += len;
+        return true;
+    }
+private:
+    bool need(size_t count) {
+        if (d_ok && (size_t)(d_end - d_pos) >= count)
+            return true;
+        d_ok = false;
+        return false;
+    }
+    const unsigned char* d_pos;
+    const unsigned char* d_end;
+    bool d_ok;
+};
+
+/**
+* Reads next record from the file into the buffer.
+* @param file Opened binary file.
+* @param type Receives record type.
+* @param payload Receives record payload (reused between calls).
+* @return false on end of file or on truncated record.
+*/
+inline bool read_record(FILE* file, unsigned char& type, std::string& payload)
+{
+    unsigned char header[5];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header))
+        return false;
+    unsigned int len = header[0] | (header[1] << 8) | (header[2] << 16) | ((unsigned int)header[3] << 24);
+    if (len == 0)
+        return false;
+    type = header[4];
+    payload.resize(len - 1);
+    if (len > 1 && fread(&payload[0], 1, len - 1, file) != len - 1)
+        return false;
+    return true;
+}
+}
+}
+}
+
+#endif // !INC_LIBG2FASTH_BINARY_IO_H
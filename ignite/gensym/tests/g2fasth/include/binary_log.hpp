@@ -0,0 +1,154 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_BINARY_LOG_H
+#define INC_LIBG2FASTH_BINARY_LOG_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <stdarg.h>
+#include "tinythread.h"
+#include "g2fasth_enums.hpp"
+
+namespace g2 {
+namespace fasth {
+class log_capture;
+
+/**
+* Suite and test case the current thread works for. Binary log records are tagged with
+* them, so messages of one test can be extracted from a log shared by many tests.
+* Text messages of the test case are collected in its capture buffer, if the logger
+* captures output of test cases.
+*/
+struct log_context {
+    const std::string* suite_name;
+    const std::string* test_name;
+    log_capture* capture;
+};
+
+/**
+* Returns log context of the calling thread, names are nullptr outside of tests.
+*/
+const log_context& get_log_context();
+
+/**
+* Sets log context of the calling thread for the lifetime of the object
+* and restores the previous one afterwards.
+*/
+class log_context_scope {
+public:
+    log_context_scope(const std::string* suite_name, const std::string* test_name, log_capture* capture = nullptr);
+    ~log_context_scope();
+private:
+    log_context_scope(const log_context_scope&);
+    log_context_scope& operator=(const log_context_scope&);
+    log_context d_saved;
+};
+
+/**
+* Compact binary log of logger messages.
+* Instead of formatted text, a record holds monotonic time, thread, suite and test ids,
+* level, id of the format string and raw arguments. Names and format strings are written
+* once per file session. Records are buffered and written in large blocks, the text is
+* rebuilt offline by binary_log_reader (see tools/log_decode).
+* All loggers writing to the same path share one instance.
+*/
+class binary_log {
+public:
+    /**
+    * Returns binary log for given path, opening it if needed.
+    * @param path Path to the log file. The file is appended to.
+    * @return Shared binary log, or nullptr if the file could not be opened.
+    */
+    static std::shared_ptr<binary_log> open(const std::string& path);
+    ~binary_log();
+    /**
+    * Records printf-style message. Supports conversions of printf() including
+    * length modifiers and '*' width or precision, %n is ignored.
+    */
+    void write(log_level level, const char* fmt, va_list ap);
+    /**
+    * Records plain text message.
+    */
+    void write_text(log_level level, const char* text, size_t length);
+    /**
+    * Writes buffered records to the file.
+    */
+    void flush();
+    /**
+    * Writes buffered records of all binary logs. Logs locked by other threads are
+    * skipped, as it is called from signal handler.
+    */
+    static void flush_all();
+private:
+    binary_log(FILE* file);
+    binary_log(const binary_log&);
+    binary_log& operator=(const binary_log&);
+    unsigned intern_name(const std::string* name);
+    unsigned intern_format(const char* fmt);
+    void begin_message(log_level level, unsigned format_id);
+    void end_message();
+    void write_buffer();
+    tthread::mutex d_mutex;
+    FILE* d_file;
+    unsigned long long d_last_ns;                   // time of previous record
+    unsigned d_generation;                          // distinguishes instances in thread caches
+    std::map<std::string, unsigned> d_names;
+    std::map<std::string, unsigned> d_formats;
+    std::map<const char*, unsigned> d_format_ptrs;  // cache for string literals, verified on hit
+    std::vector<const std::string*> d_format_ids;
+    unsigned d_text_format;
+    size_t d_record;
+    std::string d_buffer;
+};
+
+/**
+* Single message read from a binary log.
+* Name pointers stay valid for the lifetime of the reader.
+*/
+struct binary_log_entry {
+    unsigned long long time_ns;     // since start of the session
+    unsigned long long wall_ms;     // wall clock time in milliseconds since epoch
+    unsigned thread;                // sequential number of logging thread
+    const std::string* suite_name;  // empty outside of suites
+    const std::string* test_name;   // empty outside of test cases
+    log_level level;
+    std::string text;
+};
+
+/**
+* Sequential reader of binary logs, formats messages as logger would.
+*/
+class binary_log_reader {
+public:
+    binary_log_reader();
+    ~binary_log_reader();
+    /**
+    * Opens log file for reading.
+    * @return true if file was opened and has valid header.
+    */
+    bool open(const std::string& path);
+    /**
+    * Reads and formats next message.
+    * @return false at the end of the log.
+    */
+    bool next(binary_log_entry& entry);
+private:
+    binary_log_reader(const binary_log_reader&);
+    binary_log_reader& operator=(const binary_log_reader&);
+    const std::string* string_by_id(const std::vector<const std::string*>& ids, unsigned id) const;
+    FILE* d_file;
+    std::string d_payload;
+    std::deque<std::string> d_strings;              // stable storage of names and formats
+    std::vector<const std::string*> d_names;        // ids of current session
+    std::vector<const std::string*> d_formats;
+    unsigned long long d_session_ns;
+    unsigned long long d_session_wall_ms;
+    unsigned long long d_last_ns;
+};
+}
+}
+
+#endif // !INC_LIBG2FASTH_BINARY_LOG_H
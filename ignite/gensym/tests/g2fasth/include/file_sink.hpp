@@ -0,0 +1,98 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_FILE_SINK_H
+#define INC_LIBG2FASTH_FILE_SINK_H
+
+#include <cstdio>
+#include <string>
+#include <memory>
+#include "tinythread.h"
+
+namespace g2 {
+namespace fasth {
+/**
+* Settings of a log file.
+*/
+struct file_sink_options {
+    file_sink_options()
+        : buffer_size(64 * 1024)
+        , flush_interval_ms(1000)
+        , max_size(0)
+        , rotate_interval_s(0)
+        , max_files(5)
+        , preallocate(0) {
+    }
+    // Messages are collected up to this size before they are written
+    size_t buffer_size;
+    // Collected messages are written by the first write after the oldest one is older,
+    // 0 writes every message. Without further writes they stay buffered until flush().
+    unsigned flush_interval_ms;
+    // File is rotated when it grows over this size, 0 disables size based rotation
+    unsigned long long max_size;
+    // File is rotated by the first write after this time since it was opened,
+    // 0 disables time based rotation
+    unsigned rotate_interval_s;
+    // Number of rotated files kept as <path>.1 ... <path>.N, the oldest one is removed
+    unsigned max_files;
+    // Disk space reserved beyond the end of the file, so appends do not fragment it
+    unsigned long long preallocate;
+};
+
+/**
+* Buffered log file with rotation, owned by loggers which write to it.
+* All loggers writing to the same path share one instance. The file is
+* flushed and closed when the last logger releases it.
+*/
+class file_sink {
+public:
+    /**
+    * Returns file sink for given path, opening it if needed.
+    * @param path Path to the log file. The file is appended to.
+    * @param options Settings used if the file is not opened yet.
+    * @return Shared file sink, or nullptr if the file could not be opened.
+    */
+    static std::shared_ptr<file_sink> open(const std::string& path,
+        const file_sink_options& options = file_sink_options());
+    ~file_sink();
+    /**
+    * Appends text to the buffer, writing the buffer out when it is full or old.
+    * Intervals of the options are checked only here, no thread watches them.
+    */
+    void write(const char* text, size_t length);
+    /**
+    * Appends text followed by new line, as one write.
+    */
+    void write_line(const char* text, size_t length);
+    /**
+    * Writes buffered text to the file.
+    */
+    void flush();
+    /**
+    * Writes buffered text of all file sinks. Sinks locked by other threads are
+    * skipped, as it is called from signal handler.
+    */
+    static void flush_all();
+    const std::string& path() const { return d_path; }
+    const file_sink_options& options() const { return d_options; }
+private:
+    file_sink(const std::string& path, const file_sink_options& options);
+    file_sink(const file_sink&);
+    file_sink& operator=(const file_sink&);
+    bool open_file();
+    void rotate();
+    void reserve();
+    void append(const char* text, size_t length, bool new_line);
+    void write_buffer();
+    tthread::mutex d_mutex;
+    std::string d_path;
+    file_sink_options d_options;
+    FILE* d_file;
+    unsigned long long d_size;          // bytes in the file, including buffered ones
+    unsigned long long d_reserved;      // end of space reserved by preallocation
+    unsigned long long d_opened_ns;
+    unsigned long long d_buffered_ns;   // time of the oldest buffered message
+    std::string d_buffer;
+};
+}
+}
+
+#endif // !INC_LIBG2FASTH_FILE_SINK_H
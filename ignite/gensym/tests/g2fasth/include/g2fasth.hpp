@@ -38,6 +38,66 @@ public:
     */
     const std::string& get_report_type() const { return d_report; }
     /**
+    * Returns path to binary result log
+    * @return Result log file, empty if not requested
+    */
+    const std::string& get_result_log() const { return d_result_log; }
+    /**
+    * Returns capacity of asynchronous log queue
+    * @return Number of queued messages, 0 if logging is synchronous
+    */
+    int get_async_log() const { return d_async_log; }
+    /**
+    * Checks if messages are dropped when asynchronous log queue is full
+    * @return True if messages are dropped, false if logging threads wait
+    */
+    bool get_log_drop() const { return d_log_drop; }
+    /**
+    * Returns path to binary log of messages
+    * @return Binary log file, empty if not requested
+    */
+    const std::string& get_binary_log() const { return d_binary_log; }
+    /**
+    * Returns how messages of test cases are captured
+    * @return "block", "report" or empty if messages are not captured
+    */
+    const std::string& get_log_capture() const { return d_log_capture; }
+    /**
+    * Checks if captured messages of passed test cases are discarded
+    * @return True if only messages of failed test cases are kept
+    */
+    bool get_log_capture_failed() const { return d_log_capture_failed; }
+    /**
+    * Returns path to trace file written at exit
+    * @return Trace file, empty if tracing is off
+    */
+    const std::string& get_trace() const { return d_trace; }
+    /**
+    * Returns path to OpenMetrics file of scheduler and GSI metrics
+    * @return Metrics file, empty if metrics are not written
+    */
+    const std::string& get_metrics() const { return d_metrics; }
+    /**
+    * Returns interval of writing metrics file
+    * @return Seconds between writes, 0 if the file is written only at exit
+    */
+    int get_metrics_interval() const { return d_metrics_interval; }
+    /**
+    * Checks if metrics summary is printed at exit
+    * @return True if summary is printed
+    */
+    bool get_metrics_summary() const { return d_metrics_summary; }
+    /**
+    * Returns interval of printing metrics summary
+    * @return Seconds between summaries, 0 if summary is not printed periodically
+    */
+    int get_metrics_summary_interval() const { return d_metrics_summary_interval; }
+    /**
+    * Applies logging options to the logger
+    * @param target Logger of a test suite
+    */
+    void configure_logger(logger& target) const;
+    /**
     * Set OS signal handler
     */
     void set_signal_handler(bool exit = true);
@@ -57,6 +117,17 @@ private:
     int d_log_level;
     std::string d_output;
     std::string d_report;
+    std::string d_result_log;
+    int d_async_log;
+    bool d_log_drop;
+    std::string d_binary_log;
+    std::string d_log_capture;
+    bool d_log_capture_failed;
+    std::string d_trace;
+    std::string d_metrics;
+    int d_metrics_interval;
+    bool d_metrics_summary;
+    int d_metrics_summary_interval;
     int d_init;
     logger d_logger;
 };
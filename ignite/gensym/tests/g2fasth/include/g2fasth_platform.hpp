@@ -0,0 +1,168 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_PLATFORM_H
+#define INC_LIBG2FASTH_PLATFORM_H
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// Thread-local storage for plain data
+#ifdef WIN32
+#define G2FASTH_THREAD_LOCAL __declspec(thread)
+#else
+#define G2FASTH_THREAD_LOCAL __thread
+#endif
+
+// Atomic operations on long values and pointers shared between threads. Visual Studio 2010
+// and GCC 4.6 have no <atomic>, so compiler intrinsics are used. Loads have
+// acquire and stores release semantics, read-modify-write operations and
+// atomic_fence() are full barriers.
+namespace g2 {
+namespace fasth {
+#ifdef WIN32
+inline long atomic_load(const volatile long* p)
+{
+    long value = *p;
+    _ReadWriteBarrier();
+    return value;
+}
+
+inline void atomic_store(volatile long* p, long value)
+{
+    _ReadWriteBarrier();
+    *p = value;
+}
+
+inline long atomic_add(volatile long* p, long value)
+{
+    return ::InterlockedExchangeAdd(p, value) + value;
+}
+
+inline bool atomic_compare_exchange(volatile long* p, long expected, long desired)
+{
+    return ::InterlockedCompareExchange(p, desired, expected) == expected;
+}
+
+inline void atomic_fence()
+{
+    ::MemoryBarrier();
+}
+
+template <class T>
+inline T* atomic_load_ptr(T* const volatile* p)
+{
+    T* value = *p;
+    _ReadWriteBarrier();
+    return value;
+}
+
+template <class T>
+inline void atomic_store_ptr(T* volatile* p, T* value)
+{
+    _ReadWriteBarrier();
+    *p = value;
+}
+
+template <class T>
+inline bool atomic_compare_exchange_ptr(T* volatile* p, T* expected, T* desired)
+{
+    return ::InterlockedCompareExchangePointer((PVOID volatile*)p, desired, expected) == expected;
+}
+#else
+#if defined(__i386__) || defined(__x86_64__)
+// x86 does not reorder loads with loads nor stores with stores
+#define G2FASTH_COMPILER_BARRIER() __asm__ __volatile__("" ::: "memory")
+#else
+#define G2FASTH_COMPILER_BARRIER() __sync_synchronize()
+#endif
+
+inline long atomic_load(const volatile long* p)
+{
+    long value = *p;
+    G2FASTH_COMPILER_BARRIER();
+    return value;
+}
+
+inline void atomic_store(volatile long* p, long value)
+{
+    G2FASTH_COMPILER_BARRIER();
+    *p = value;
+}
+
+inline long atomic_add(volatile long* p, long value)
+{
+    return __sync_add_and_fetch(p, value);
+}
+
+inline bool atomic_compare_exchange(volatile long* p, long expected, long desired)
+{
+    return __sync_bool_compare_and_swap(p, expected, desired);
+}
+
+inline void atomic_fence()
+{
+    __sync_synchronize();
+}
+
+template <class T>
+inline T* atomic_load_ptr(T* const volatile* p)
+{
+    T* value = *p;
+    G2FASTH_COMPILER_BARRIER();
+    return value;
+}
+
+template <class T>
+inline void atomic_store_ptr(T* volatile* p, T* value)
+{
+    G2FASTH_COMPILER_BARRIER();
+    *p = value;
+}
+
+template <class T>
+inline bool atomic_compare_exchange_ptr(T* volatile* p, T* expected, T* desired)
+{
+    return __sync_bool_compare_and_swap(p, expected, desired);
+}
+#endif
+
+/**
+* Returns difference of two counters which may have wrapped around.
+*/
+inline long counter_distance(long to, long from)
+{
+    return (long)((unsigned long)to - (unsigned long)from);
+}
+
+/**
+* Returns time of monotonic clock in nanoseconds. It is not affected by wall clock
+* adjustments, so differences are valid durations.
+*/
+inline unsigned long long monotonic_ns()
+{
+#ifdef WIN32
+    static LARGE_INTEGER frequency;
+    if (!frequency.QuadPart)
+        ::QueryPerformanceFrequency(&frequency);
+    LARGE_INTEGER counter;
+    ::QueryPerformanceCounter(&counter);
+    unsigned long long ticks = counter.QuadPart, freq = frequency.QuadPart;
+    return ticks / freq * 1000000000ULL + ticks % freq * 1000000000ULL / freq;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+/**
+* Returns sequential number of the calling thread, starting from 1 in order
+* the threads call it first time.
+*/
+unsigned current_thread_index();
+}
+}
+
+#endif // !INC_LIBG2FASTH_PLATFORM_H
@@ -0,0 +1,174 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_GSI_LOAD_GENERATOR_H
+#define INC_LIBG2FASTH_GSI_LOAD_GENERATOR_H
+
+#include <string>
+#include <vector>
+#include "libgsi.hpp"
+#include "tinythread.h"
+
+namespace g2 {
+namespace fasth {
+/**
+* Shapes of offered load.
+*/
+enum load_shape {
+    load_constant,  // rate all the time
+    load_ramp,      // rate changing linearly to peak_rate over ramp_s, then peak_rate
+    load_burst      // peak_rate for burst_s at the start of each period, rate otherwise
+};
+
+/**
+* Aggregate rate of variable updates over time, in updates per second.
+*/
+struct load_profile {
+    load_profile() : shape(load_constant), rate(1000), peak_rate(1000), ramp_s(0), period_s(1), burst_s(0) {}
+
+    static load_profile constant(double rate);
+    static load_profile ramp(double from_rate, double to_rate, double ramp_s);
+    static load_profile burst(double base_rate, double peak_rate, double period_s, double burst_s);
+
+    /**
+    * Returns rate at given second of the run.
+    */
+    double rate_at(double t) const;
+    /**
+    * Returns number of updates due from the start of the run until given second.
+    */
+    double updates_until(double t) const;
+
+    load_shape shape;
+    double rate;
+    double peak_rate;
+    double ramp_s;
+    double period_s;
+    double burst_s;
+};
+
+/**
+* Options of gsi_load_generator::run.
+*/
+struct load_options {
+    load_options() : duration_s(10), interval_s(1), tick_ms(1), poll(false) {}
+    double duration_s;
+    double interval_s;  // time between samples of the time series
+    int tick_ms;        // updates due are queued at this period
+    bool poll;          // calls gsi_g2_poll after each tick, for runs without G2 polling the gateway
+};
+
+/**
+* Measurements of one interval of the run. Rates are per second of the interval.
+*/
+struct load_sample {
+    double time_s;              // end of the interval since start of the run
+    double target_rate;         // rate of the profile at the end of the interval
+    double offered_rate;        // updates requested from update_g2_variable
+    double queued_rate;         // updates queued, the others were merged with pending ones
+    double sent_rate;           // values returned to G2 by gsi_g2_poll
+    size_t backlog;             // updates queued and not yet polled at the end of the interval
+    double latency_p50_us;      // from update_g2_variable to gsi_return_values
+    double latency_p99_us;
+    double latency_max_us;
+};
+
+/**
+* Totals of the run.
+*/
+struct load_summary {
+    load_summary() : elapsed_s(0), offered(0), queued(0), sent(0), max_backlog(0),
+        latency_p50_us(0), latency_p90_us(0), latency_p99_us(0), latency_max_us(0) {}
+    double elapsed_s;
+    long long offered;
+    long long queued;
+    long long sent;
+    size_t max_backlog;
+    double latency_p50_us;
+    double latency_p90_us;
+    double latency_p99_us;
+    double latency_max_us;
+};
+
+/**
+* Offers variable updates to G2 at a scheduled aggregate rate through
+* libgsi::update_g2_variable and measures how many of them G2 absorbs. Updates
+* go to the variables in turn and each one carries a new value. An update of a
+* variable whose previous update is still pending is merged with it by libgsi,
+* so offered rate above what gsi_g2_poll sends shows as merged updates and latency.
+*/
+class gsi_load_generator {
+public:
+    explicit gsi_load_generator(libgsi& gsi);
+    ~gsi_load_generator();
+    /**
+    * Declares variables named <prefix>0 .. <prefix><count - 1> which are not declared
+    * yet and adds them to the updated variables.
+    * @return Number of variables added.
+    */
+    int add_variables(const std::string& prefix, int count, g2_type type = g2_float);
+    /**
+    * Adds declared variable to the updated variables.
+    * @return false if the variable is not declared.
+    */
+    bool add_variable(const std::string& name);
+    size_t variable_count() const { return d_variables.size(); }
+    /**
+    * Offers load on the calling thread until duration of options passes or stop() is called.
+    * @return false if there are no variables to update.
+    */
+    bool run(const load_profile& profile, const load_options& options);
+    /**
+    * Starts run on a new thread.
+    * @return false if already running or there are no variables to update.
+    */
+    bool start(const load_profile& profile, const load_options& options);
+    /**
+    * Stops run and waits for the thread started by start().
+    */
+    void stop();
+    /**
+    * Returns time series of the last run. Not to be called while running on another thread.
+    */
+    const std::vector<load_sample>& samples() const { return d_samples; }
+    const load_summary& summary() const { return d_summary; }
+    /**
+    * Returns time series as CSV with header line.
+    */
+    std::string samples_csv() const;
+    /**
+    * Returns summary as readable text.
+    */
+    std::string summary_text() const;
+private:
+    gsi_load_generator(const gsi_load_generator&);
+    gsi_load_generator& operator=(const gsi_load_generator&);
+    /**
+    * Values of counters at the start of an interval.
+    */
+    struct snapshot {
+        unsigned long long time_ns;
+        long long offered;
+        long long queued;
+        long long sent;
+        std::vector<long long> latency;
+    };
+    void take_snapshot(snapshot& snap, unsigned long long now);
+    void add_sample(const snapshot& from, const snapshot& to, double time_s, double target_rate);
+    static void run_thread(void* arg);
+
+    libgsi& d_gsi;
+    std::vector<g2_variable*> d_variables;
+    size_t d_next_variable;
+    double d_next_value;
+    long long d_offered;
+    long long d_queued;
+    volatile long d_stop;
+    tthread::thread* d_thread;
+    load_profile d_thread_profile;
+    load_options d_thread_options;
+    std::vector<load_sample> d_samples;
+    load_summary d_summary;
+};
+}
+}
+
+#endif // !INC_LIBG2FASTH_GSI_LOAD_GENERATOR_H
@@ -0,0 +1,32 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_GSI_STUB_H
+#define INC_LIBG2FASTH_GSI_STUB_H
+
+#include <string>
+#include <gsi_main.h>
+
+namespace g2 {
+namespace fasth {
+/**
+* In-process stand-in for the GSI C API functions called by libgsi, used by benchgsi
+* to drive GSI callbacks without G2. Items are plain structures, values passed back
+* to G2 are only counted.
+*/
+namespace gsi_stub {
+/**
+* Sets name returned by name_of(), as G2 does for registrations.
+*/
+void set_name(gsi_item item, const std::string& name);
+/**
+* Sets type tag returned by type_of() without changing the value.
+*/
+void set_type(gsi_item item, gsi_int type);
+/**
+* Returns number of items passed to gsi_return_values() and gsi_rpc_return_values().
+*/
+long long returned_items();
+}
+}
+}
+
+#endif // !INC_LIBG2FASTH_GSI_STUB_H
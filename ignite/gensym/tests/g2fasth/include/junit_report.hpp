@@ -2,6 +2,7 @@
 #ifndef INC_LIBG2FASTH_JUNIT_REPORT_H
 #define INC_LIBG2FASTH_JUNIT_REPORT_H
 
+#include <stdio.h>
 #include "tinyxml2.hpp"
 #include "xml_serialization.hpp"
 
@@ -14,10 +15,12 @@ namespace fasth {
 class testcase_failure_data : public xmls::serializable {
 public:
     testcase_failure_data() {
-        set_class_name("failure");
-        register_type("type", &d_type);
+        if (begin_registration<testcase_failure_data>("failure")) {
+            register_type("type", &d_type);
+            end_registration();
+        }
     }
-    void set_properties(std::string failure_type, std::string failure_reason) {
+    void set_properties(const std::string& failure_type, const std::string& failure_reason) {
         d_type = failure_type;
         set_inner_text(failure_reason);
     }
@@ -25,6 +28,17 @@ private:
     xmls::x_string d_type;
 };
 
+/**
+* Output of test case attached to the report.
+*/
+class testcase_output_data : public xmls::serializable {
+public:
+    testcase_output_data() {
+        if (begin_registration<testcase_output_data>("system-out"))
+            end_registration();
+    }
+};
+
 /**
 * This class holds information about test case such as its
 * name, classname and failure occured, if it has failed.
@@ -32,15 +46,21 @@ private:
 class testcase_data : public xmls::serializable {
 public:
     testcase_data() {
-        set_class_name("testcase");
-        register_type("classname", &d_classname);
-        register_type("name", &d_name);
-        register_type("failure", &d_failure);
+        if (begin_registration<testcase_data>("testcase")) {
+            register_type("classname", &d_classname);
+            register_type("name", &d_name);
+            register_type("failure", &d_failure);
+            register_type("system-out", &d_system_out);
+            end_registration();
+        }
+    }
+    void fail_test_case(const std::string& failure_type, const std::string& failure_reason) {
+        d_failure.new_element(get_arena())->set_properties(failure_type, failure_reason);
     }
-    void fail_test_case(std::string failure_type, std::string failure_reason) {
-        d_failure.new_element()->set_properties(failure_type, failure_reason);
+    void set_system_out(const std::string& output) {
+        d_system_out.new_element(get_arena())->set_inner_text(output);
     }
-    void set_properties(std::string class_name, std::string name) {
+    void set_properties(const std::string& class_name, const std::string& name) {
         d_classname = class_name;
         d_name = name;
     }
@@ -48,32 +68,135 @@ private:
     xmls::x_string d_classname;
     xmls::x_string d_name;
     xmls::collection<testcase_failure_data> d_failure;
+    xmls::collection<testcase_output_data> d_system_out;
 };
 
+/**
+* Formats duration in milliseconds as JUnit time attribute (seconds).
+*/
+inline std::string junit_time(int elapsed_ms) {
+    char buf[32];
+    sprintf(buf, "%d.%03d", elapsed_ms / 1000, elapsed_ms % 1000);
+    return buf;
+}
+
 /**
 * This class holds information about test suite such as suite name,
 * number of tests it is containing and collection of test cases.
 */
 class testsuite_data : public xmls::serializable {
 public:
-    testsuite_data(xmls::x_int tests, xmls::x_string start_time) {
-        set_class_name("testsuite");
-        register_type("tests", &d_tests);
-        register_type("start", &d_start_time);
-        register_type("testcases", &d_testcases);
+    testsuite_data() {
+        init();
+    }
+    testsuite_data(int tests, const std::string& start_time) {
+        init();
         d_tests = tests;
         d_start_time=  start_time;
     }
-    testcase_data * add_testcase(std::string class_name, std::string name) {
-        auto test_case = d_testcases.new_element();
+    void set_properties(int tests, const std::string& start_time) {
+        d_tests = tests;
+        d_start_time = start_time;
+    }
+    testcase_data * add_testcase(const std::string& class_name, const std::string& name) {
+        auto test_case = d_testcases.new_element(get_arena());
         test_case->set_properties(class_name, name);
         return test_case;
     }
 private:
+    void init() {
+        if (begin_registration<testsuite_data>("testsuite")) {
+            register_type("tests", &d_tests);
+            register_type("start", &d_start_time);
+            register_type("testcases", &d_testcases);
+            end_registration();
+        }
+    }
     xmls::collection<testcase_data> d_testcases;
     xmls::x_int d_tests;
     xmls::x_string d_start_time;
 };
+
+/**
+* Test suite as part of aggregated report. In addition to standalone
+* suite attributes it reports name, number of failures and time.
+*/
+class aggregated_testsuite_data : public testsuite_data {
+public:
+    aggregated_testsuite_data() {
+        if (begin_registration<aggregated_testsuite_data>("testsuite")) {
+            register_type("name", &d_name);
+            register_type("failures", &d_failures);
+            register_type("time", &d_time);
+            end_registration();
+        }
+    }
+    /**
+    * Sets attributes which are reported only in aggregated report.
+    * @param name Name of the suite.
+    * @param failures Number of failed test cases.
+    * @param elapsed_ms Execution time of the suite.
+    */
+    void set_summary(const std::string& name, int failures, int elapsed_ms) {
+        d_name = name;
+        d_failures = failures;
+        d_time = junit_time(elapsed_ms);
+    }
+private:
+    xmls::x_string d_name;
+    xmls::x_int d_failures;
+    xmls::x_string d_time;
+};
+
+/**
+* This class holds results of several test suites
+* and is serialized as single JUnit report.
+*/
+class testsuites_data : public xmls::serializable {
+public:
+    testsuites_data() {
+        if (begin_registration<testsuites_data>("testsuites")) {
+            register_type("tests", &d_tests);
+            register_type("failures", &d_failures);
+            register_type("time", &d_time);
+            register_type("testsuites", &d_testsuites);
+            end_registration();
+        }
+        d_time = junit_time(0);
+    }
+    /**
+    * Adds test suite to the report. Test and failure totals are updated.
+    * @param name Name of the suite.
+    * @param tests Number of test cases.
+    * @param failures Number of failed test cases.
+    * @param start_time Start time of the suite.
+    * @param elapsed_ms Execution time of the suite.
+    * @return Test suite element, to be filled with test cases.
+    */
+    testsuite_data * add_testsuite(const std::string& name, int tests, int failures, const std::string& start_time, int elapsed_ms) {
+        auto test_suite = d_testsuites.new_element(get_arena());
+        test_suite->set_properties(tests, start_time);
+        test_suite->set_summary(name, failures, elapsed_ms);
+        d_tests = d_tests.value() + tests;
+        d_failures = d_failures.value() + failures;
+        return test_suite;
+    }
+    /**
+    * Sets total execution time. Suites may run in background,
+    * so it is not a sum of suite times.
+    * @param elapsed_ms Wall clock time of the whole run.
+    */
+    void set_elapsed(int elapsed_ms) {
+        d_time = junit_time(elapsed_ms);
+    }
+    int tests() const { return d_tests.value(); }
+    int failures() const { return d_failures.value(); }
+private:
+    xmls::collection<aggregated_testsuite_data> d_testsuites;
+    xmls::x_int d_tests;
+    xmls::x_int d_failures;
+    xmls::x_string d_time;
+};
 }
 }
 
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_KB_LOADER_H
+#define INC_LIBG2FASTH_KB_LOADER_H
+
+#include <string>
+#include <vector>
+#include "libgsi.hpp"
+
+namespace g2 {
+namespace fasth {
+/**
+* GSI variable found in KB export.
+*/
+struct kb_variable {
+    std::string name;           // first name of the item
+    std::string class_name;     // class of the item
+    std::string interface_name; // GSI interface the variable is served by
+    g2_type type;               // resolved from the class hierarchy
+};
+
+/**
+* Loader of G2 KB exported as RDF/XML. It finds items that have a GSI interface name,
+* resolves their type through class definitions in the KB and declares them in libgsi.
+* The file is memory-mapped and scanned in place, irrelevant subtrees are skipped
+* without building a DOM.
+*/
+class kb_loader {
+public:
+    kb_loader();
+    /**
+    * Maps and scans KB export file.
+    * @param path Path to the RDF/XML KB export.
+    * @return true if the file was read, error() describes failure otherwise.
+    */
+    bool load(const std::string& path);
+    /**
+    * Scans KB export held in memory.
+    * @param data KB export text, does not have to be null-terminated.
+    * @param size Size of the text.
+    * @return true if the text was scanned, error() describes failure otherwise.
+    */
+    bool parse(const char* data, size_t size);
+    /**
+    * Declares all found variables in libgsi.
+    * @param gsi libgsi instance.
+    * @return Number of declared variables. Variables declared before are skipped.
+    */
+    int declare_variables(libgsi& gsi) const;
+    /**
+    * Returns variables with resolved types, in document order.
+    */
+    const std::vector<kb_variable>& variables() const { return d_variables; }
+    /**
+    * Returns names of GSI variables whose class could not be resolved to a variable type.
+    */
+    const std::vector<std::string>& unresolved() const { return d_unresolved; }
+    const std::string& error() const { return d_error; }
+private:
+    std::vector<kb_variable> d_variables;
+    std::vector<std::string> d_unresolved;
+    std::string d_error;
+};
+}
+}
+
+#endif // !INC_LIBG2FASTH_KB_LOADER_H
@@ -6,9 +6,15 @@
 #include "logger.hpp"
 #include "gsi_callbacks.h"
 #include "tinythread.h"
+#include "fast_mutex.h"
+#include "metrics.hpp"
+#include "string_convert.hpp"
+#include "value_columns.hpp"
+#include "variable_directory.hpp"
 #include <algorithm>
 #include <functional>
 #include <map>
+#include <unordered_map>
 #include <list>
 #include <string>
 #include <memory>
@@ -64,13 +70,15 @@ enum g2_type {
 
 struct g2_variable {
 protected:
-    g2_variable(g2_type type, bool declaration): handle(0), dec_type(g2_none), reg_type(g2_none) {
+    g2_variable(g2_type type, bool declaration): handle(0), dec_type(g2_none), reg_type(g2_none), update_pending(0), queued_ns(0), assigned_us(0),
+            storage_type(type), columns(nullptr), slot(0), signal(-1) {
         if (declaration)
             dec_type = type;
         else
             reg_type = type;
     }
 public:
+    virtual ~g2_variable() {}
     bool type_ok() { return dec_type == reg_type; }
     bool declared() { return dec_type != g2_none; }
     bool registered() { return reg_type != g2_none; }
@@ -82,22 +90,69 @@ public:
     g2_type dec_type;
     g2_type reg_type;
     gsi_int handle;
+    volatile long update_pending; // queued by update_g2_variable for next gsi_g2_poll
+    unsigned long long queued_ns; // monotonic time the pending update was queued at
+    // Microseconds of monotonic clock wrapping around at assign_temp_value not delivered to
+    // G2 yet, 0 if none. Set by test threads and taken by the gateway with compare-exchange.
+    volatile long assigned_us;
+    g2_type storage_type; // type of the value column, string for symbols too
+    value_columns* columns; // columns holding the values, nullptr if values are held by the variable
+    size_t slot;
+    long signal; // signal of columns providing values, -1 if none
 };
 
+/**
+* Sets value of GSI item.
+*/
+inline void set_item_value(gsi_registered_item item, int value) { gsi_set_int(item, value); }
+inline void set_item_value(gsi_registered_item item, double value) { gsi_set_flt(item, value); }
+inline void set_item_value(gsi_registered_item item, bool value) { gsi_set_log(item, value); }
+inline void set_item_value(gsi_registered_item item, const std::string& value);
+inline void set_item_value(gsi_registered_item item, const interned_string& value) { gsi_set_str(item, value.gensym()); }
+
 /**
 * Stores information about registered G2 variable of specific type, including variable value.
 */
 template <typename T>
 struct g2_typed_variable : public g2_variable {
+    typedef typename column_value<T>::type stored_type;
+
     g2_typed_variable(bool declaration);
-    virtual ~g2_typed_variable() {}
+    /**
+    * Copies variable with its current values, the copy holds them itself.
+    */
+    g2_typed_variable(const g2_typed_variable& other) : g2_variable(other), d_handler(other.d_handler) {
+        columns = nullptr;
+        signal = -1;
+        if (other.columns)
+            other.columns->column<stored_type>().load(other.slot, d_local);
+        else
+            d_local = other.d_local;
+    }
+    virtual ~g2_typed_variable() {
+        if (columns)
+            columns->column<stored_type>().release(slot);
+    }
 
     virtual g2_variable* clone() {
-        //g2_typed_variable<T>* cloned = new g2_typed_variable<T>(*this);
-        //*cloned = *this;
         return new g2_typed_variable<T>(*this);
     }
 
+    /**
+    * Moves values of the variable to a slot of the columns. Called before the
+    * variable is published in libgsi, after its handler is set.
+    */
+    void store_in(value_columns& target) {
+        value_column<stored_type>& column = target.column<stored_type>();
+        slot = column.add(d_handler != nullptr);
+        if (d_local.has_def_value)
+            column.assign_def_value(slot, d_local.def_value);
+        if (d_local.cur_count)
+            column.assign_temp_value(slot, d_local.cur_value, d_local.cur_count);
+        d_local = value_slot<stored_type>();
+        columns = &target;
+    }
+
     /**
     * Gets value of registered variable to GSI.
     */
@@ -112,8 +167,14 @@ struct g2_typed_variable : public g2_variable {
     * @param new_val New value to assign.
     */
     void assign_def_value(T new_val) {
-        d_def_value = new_val;
-        d_has_def_value = true;
+        stored_type stored(new_val);
+        if (columns)
+            columns->column<stored_type>().assign_def_value(slot, stored);
+        else
+        {
+            d_local.def_value = stored;
+            d_local.has_def_value = true;
+        }
     }
 
     /**
@@ -122,76 +183,124 @@ struct g2_typed_variable : public g2_variable {
     * @param count Number of times to return this value.
     */  
     void assign_temp_value(T new_val, int count = 1) {
-        d_cur_value = new_val;
-        d_cur_count = count;
+        assign_stored_value(stored_type(new_val), count);
+    }
+    /**
+    * Assigns a temporary value in the form it's stored in, e.g. string interned already.
+    */
+    void assign_stored_value(const stored_type& new_val, int count) {
+        if (columns)
+            columns->column<stored_type>().assign_temp_value(slot, new_val, count);
+        else
+        {
+            d_local.cur_value = new_val;
+            d_local.cur_count = count;
+        }
     }
 
+    // Set before the variable is published in libgsi, so it's not guarded
     std::function<T()> d_handler;
 
     virtual T value() {
-        if (d_cur_count) {
-            --d_cur_count;
-            return d_cur_value;
-        }
-        else if (d_has_def_value) {
-            return d_def_value;
-        }
-        else if (d_handler)
+        stored_type result;
+        if (next_stored(result))
+            return T(result);
+        return computed_value();
+    }
+private:
+    g2_typed_variable& operator=(const g2_typed_variable&);
+    /**
+    * Takes next temporary or default value, see value_slot::next.
+    */
+    bool next_stored(stored_type& out) {
+        return columns ? columns->column<stored_type>().next(slot, out) : d_local.next(out);
+    }
+    /**
+    * Returns value of the signal or the handler for variable without value.
+    */
+    T computed_value() {
+        if (columns && signal >= 0)
+            return signal_value<T>(columns->signals.evaluate(signal, columns->signals.seconds()));
+        // Handler may take long or use libgsi, so it's called without the lock
+        if (d_handler)
             return d_handler();
         else
             return T();
     }
-private:
-    T d_def_value;
-    bool d_has_def_value;
-    T d_cur_value;
-    int d_cur_count;
+    // Values of variables published in libgsi are in its columns, values of
+    // copies are here. Copies are not shared between threads.
+    value_slot<stored_type> d_local;
 };
 /**
 * Specialized constructors.
 */
 template <>
-inline g2_typed_variable<int>::g2_typed_variable(bool declaration) : g2_variable(g2_integer,declaration), d_has_def_value(false), d_cur_count(0) {}
+inline g2_typed_variable<int>::g2_typed_variable(bool declaration) : g2_variable(g2_integer,declaration) {}
 template <>
-inline g2_typed_variable<std::string>::g2_typed_variable(bool declaration) : g2_variable(g2_string,declaration), d_has_def_value(false), d_cur_count(0) {}
+inline g2_typed_variable<std::string>::g2_typed_variable(bool declaration) : g2_variable(g2_string,declaration) {}
 template <>
-inline g2_typed_variable<bool>::g2_typed_variable(bool declaration) : g2_variable(g2_logical,declaration), d_has_def_value(false), d_cur_count(0) {}
+inline g2_typed_variable<bool>::g2_typed_variable(bool declaration) : g2_variable(g2_logical,declaration) {}
 template <>
-inline g2_typed_variable<double>::g2_typed_variable(bool declaration) : g2_variable(g2_float,declaration), d_has_def_value(false), d_cur_count(0) {}
+inline g2_typed_variable<double>::g2_typed_variable(bool declaration) : g2_variable(g2_float,declaration) {}
 
 /**
-* Function specializations.
+* Function definitions.
 */
-template <>
-inline void g2_typed_variable<int>::get_val(gsi_registered_item item) { gsi_set_int(item, value()); }
-#if defined(GSI_USE_WIDE_STRING_API)
-template <>
-inline void g2_typed_variable<std::string>::get_val(gsi_registered_item item) {
-    short buf[100];
-    gsi_set_str(item, (gsi_char*)g2::fasth::libgsi::gensym_string((const std::string&)value(), &buf[0], 100));
+template <typename T>
+inline void g2_typed_variable<T>::get_val(gsi_registered_item item) {
+    stored_type stored;
+    if (next_stored(stored))
+        set_item_value(item, stored);
+    else
+        set_item_value(item, computed_value());
 }
-#else
-template <>
-inline void g2_typed_variable<std::string>::get_val(gsi_registered_item item) { gsi_set_str(item, const_cast<char*>(value().c_str())); }
-#endif
-template <>
-inline void g2_typed_variable<bool>::get_val(gsi_registered_item item) { gsi_set_log(item, value()); }
-template <>
-inline void g2_typed_variable<double>::get_val(gsi_registered_item item) { gsi_set_flt(item, value()); }
 
 template <>
 inline void g2_typed_variable<int>::set_val(gsi_registered_item item, int count) { assign_temp_value(int_of(item),count); }
 template <>
-#if defined(GSI_USE_WIDE_STRING_API)
-inline void g2_typed_variable<std::string>::set_val(gsi_registered_item item, int count) { assign_temp_value(libgsi::c_string(str_of(item)),count); }
-#else
-inline void g2_typed_variable<std::string>::set_val(gsi_registered_item item, int count) { assign_temp_value(str_of(item),count); }
-#endif
+inline void g2_typed_variable<std::string>::set_val(gsi_registered_item item, int count) { assign_stored_value(symbol_table::intern_gensym(str_of(item)),count); }
 template <>
 inline void g2_typed_variable<bool>::set_val(gsi_registered_item item, int count) { assign_temp_value(!!log_of(item),count); }
 template <>
 inline void g2_typed_variable<double>::set_val(gsi_registered_item item, int count) { assign_temp_value(flt_of(item),count); }
 
+/**
+* Variables of one value type which are read together by GSI callbacks.
+*/
+template <typename T>
+struct value_batch {
+    value_batch() : values(nullptr), capacity(0) {}
+    ~value_batch() { delete[] values; }
+    void add(int item, g2_variable* var) {
+        items.push_back(item);
+        slots.push_back(var->slot);
+        variables.push_back(var);
+    }
+    void reserve() {
+        if (slots.size() > capacity)
+        {
+            // Values are not kept in std::vector, std::vector<bool> has no array
+            delete[] values;
+            capacity = slots.size();
+            values = new T[capacity];
+            resolved.resize(capacity);
+        }
+    }
+    std::vector<int> items;     // index of the item in the callback
+    std::vector<size_t> slots;  // slot in the column
+    std::vector<g2_variable*> variables;
+    std::vector<unsigned char> resolved;
+    // Variables without value which have a signal
+    std::vector<size_t> signal_positions;   // position in the batch
+    std::vector<size_t> signals;
+    std::vector<double> signal_values;
+    T* values;
+    size_t capacity;
+private:
+    value_batch(const value_batch&);
+    value_batch& operator=(const value_batch&);
+};
+
   struct g2_remotefn {
     gsi_function_handle_type handle;
     std::string function_name;
@@ -205,7 +314,9 @@ inline void g2_typed_variable<double>::set_val(gsi_registered_item item, int cou
 */
 class libgsi : public singleton<libgsi> {
 public:
-    libgsi() : d_logger(g2::fasth::log_level::REGULAR), d_continuous(false), d_port(22041), d_error_mode(true),
+    libgsi() : d_poll_items(nullptr), d_poll_capacity(0), d_batched(0), d_sample_every(0),
+            d_get_data_calls(0), d_poll_calls(0), d_registration_calls(0), d_deregistration_calls(0),
+            d_logger(g2::fasth::log_level::REGULAR), d_continuous(false), d_port(22041), d_error_mode(true),
             d_ignore_not_registered_variables(false), d_ignore_not_declared_variables(false) {
         d_logger.add_output_stream(std::cout, g2::fasth::log_level::REGULAR);
     }
@@ -230,6 +341,14 @@ public:
         tthread::lock_guard<tthread::mutex> guard(d_mutex);
         d_error_mode = val;
     }
+    /**
+    * Logs details of every n-th call of gsi_get_data and gsi_g2_poll and of every
+    * n-th registration and deregistration. Calls are always counted by gsi_metrics.
+    * @param every 0 (default) logs no details, 1 logs all of them.
+    */
+    void sample_callback_log(long every) {
+        atomic_store(&d_sample_every, every);
+    }
 
     /**
     * Initializes G2 Gateway, sets up network listeners, and passes control to the API function gsi_run_loop().
@@ -253,11 +372,12 @@ public:
     }
 
     /// String conversion functions
+    /// ASCII text is converted by string_convert.hpp without allocation, other text by GSI.
     /**
     * Converts input wide string to Gensym string.
     * @param wstr Input wide string.
     * @param dest Pointer to the destination array.
-    * @param num Maximum number of characters to be written.
+    * @param num Maximum number of characters to be written, including the terminator.
     * @return Pointer to the destination array.
     */
     static short* gensym_string(const std::wstring& wstr, short* dest, size_t num);
@@ -265,7 +385,7 @@ public:
     * Converts input c string to Gensym string.
     * @param cstr Input c string.
     * @param dest Pointer to the destination array.
-    * @param num Maximum number of characters to be written.
+    * @param num Maximum number of characters to be written, including the terminator.
     * @return Pointer to the destination array.
     */
     static short* gensym_string(const std::string& cstr, short* dest, size_t num);
@@ -276,11 +396,19 @@ public:
     */
     static std::wstring wide_string(short* gstr);
     /**
+    * Converts Gensym string to wide string reusing storage of out, for bulk text.
+    */
+    static void wide_string(const short* gstr, std::wstring& out);
+    /**
     * Converts Gensym string to c string.
     * @param gstr Input Gensym string.
     * @return Converted c string.
     */
     static std::string c_string(short* gstr);
+    /**
+    * Converts Gensym string to c string reusing storage of out, for bulk text.
+    */
+    static void c_string(const short* gstr, std::string& out);
 
     /// GSI callback functions
     gsi_int gsi_get_tcp_port_() {
@@ -297,12 +425,7 @@ public:
 
         // Declare RPC handlers
         for (auto it = d_g2_declared_functions.begin(); it != d_g2_declared_functions.end(); it++ ) {
-#if defined(GSI_USE_WIDE_STRING_API)
-            short buf[100];
-            gsi_rpc_declare_local(it->second, (gsi_char*)g2::fasth::libgsi::gensym_string(it->first, &buf[0], 100));
-#else
-            gsi_rpc_declare_local(it->second, const_cast<char*>(it->first.c_str()));
-#endif
+            gsi_rpc_declare_local(it->second, symbol_table::intern(it->first).gensym());
         }
     }
 
@@ -313,14 +436,14 @@ public:
         gsi_attr identifying_attribute_one = identifying_attr_of(registration,1);
         std::string name = name_of(registration);
         gsi_int type = type_of(registration);
-
-        tthread::lock_guard<tthread::mutex> guard(d_mutex);
-        std::shared_ptr<g2_variable> var;
+        gsi_int handle = handle_of(registration);
 
         {
-            if (d_g2_variables.count(name))
+            tthread::lock_guard<tthread::mutex> guard(d_mutex);
+            variable_entry* entry = d_directory.find(name);
+            g2_variable* var = entry ? entry->variable() : nullptr;
+            if (var && (var->declared() || var->registered()))
             {   // Variable was declared
-                var = d_g2_variables[name];
                 if (type>=GSI_INTEGER_TAG && type<=GSI_FLOAT64_TAG)
                     var->reg_type = (g2_type)type;
                 else
@@ -328,25 +451,29 @@ public:
             }
             else
             {
-                if (type == GSI_INTEGER_TAG)
-                    var = std::shared_ptr<g2_variable>(new g2_typed_variable<int>(false));
-                else if (type == GSI_FLOAT64_TAG)
-                    var = std::shared_ptr<g2_variable>(new g2_typed_variable<double>(false));
-                else if (type == GSI_LOGICAL_TAG)
-                    var = std::shared_ptr<g2_variable>(new g2_typed_variable<bool>(false));
-                else if (type == GSI_STRING_TAG || type == GSI_SYMBOL_TAG)
-                {
-                    var = std::shared_ptr<g2_variable>(new g2_typed_variable<std::string>(false));
-                    var->reg_type = (g2_type)type;
-                }
-                else
+                var = new_g2_variable((g2_type)type, false);
+                if (!var)
                     return;
-                d_g2_variables[name] = var;
+                // Entry holding neither declared nor registered variable is reused
+                if (entry)
+                    d_directory.replace(entry, var);
+                else
+                    entry = d_directory.insert(name, var);
+            }
+            // G2 reuses handles of deleted items, variable still holding the handle loses it
+            variable_entry* previous = d_directory.find((long)handle);
+            if (previous && previous != entry)
+            {
+                d_directory.assign_handle(previous, 0);
+                previous->variable()->handle = 0;
             }
-            var->handle = handle_of(registration);
+            var->handle = handle;
+            d_directory.assign_handle(entry, (long)handle);
         }
 
-        d_logger.log_formatted(log_level::REGULAR, "Variable %s (type tag %d) is registered\n", name.c_str(), type);
+        gsi_metrics::registrations.add();
+        if (sampled(&d_registration_calls))
+            G2FASTH_LOGF(d_logger, REGULAR, "Variable %s (type tag %d) is registered\n", name.c_str(), type);
     }
 
     gsi_int gsi_initialize_context_(char* remote_process_init_string, gsi_int length) {
@@ -354,14 +481,8 @@ public:
             d_g2_init();
         // Declare remote RPC functions
         for (auto it = d_g2_remote_functions.begin(); it != d_g2_remote_functions.end(); it++ ) {
-#if defined(GSI_USE_WIDE_STRING_API)
-            short buf[100];
-            gsi_rpc_declare_remote(&it->second.handle, (gsi_char*)g2::fasth::libgsi::gensym_string(it->first, &buf[0], 100),
-                it->second.receiver_function, it->second.argument_count, it->second.return_count, gsi_current_context());
-#else
-            gsi_rpc_declare_remote(&it->second.handle, const_cast<char*>(it->first.c_str()),
+            gsi_rpc_declare_remote(&it->second.handle, symbol_table::intern(it->first).gensym(),
                 it->second.receiver_function, it->second.argument_count, it->second.return_count, gsi_current_context());
-#endif
         }
         return GSI_ACCEPT;
     }
@@ -372,94 +493,110 @@ public:
     }
 
     void gsi_g2_poll_() {
-        tthread::lock_guard<tthread::mutex> guard(d_update_mutex);
+        // Queue is taken at once, so that update_g2_variable is not blocked by reading values
+        {
+            tthread::lock_guard<tthread::mutex> guard(d_update_mutex);
+            d_poll_variables.swap(d_g2_update_variables);
+        }
 
-        int count = d_g2_update_variables.size();
-        d_logger.log_formatted(log_level::REGULAR, "gsi_g2_poll called with count=%d\n", count);
+        int count = d_poll_variables.size();
+        if (sampled(&d_poll_calls))
+            G2FASTH_LOGF(d_logger, REGULAR, "gsi_g2_poll called with count=%d\n", count);
         if (count)
         {
-            gsi_registered_item* registered_item_array = gsi_make_registered_items(count);
-            /* Loop through registered items sent to this function. */
+            // The array is kept between polls and grows to the largest number of updates
+            if (count > d_poll_capacity)
+            {
+                if (d_poll_items)
+                    gsi_reclaim_registered_items(d_poll_items);
+                d_poll_items = gsi_make_registered_items(count);
+                d_poll_capacity = count;
+                d_poll_queued_ns.resize(count);
+            }
+            int filled = 0;
             for(int n=0; n<count; n++)
             {
-                const std::string& name = d_g2_update_variables[n];
-                if (!d_g2_variables.count(name))
-                    continue;
-                auto& var = d_g2_variables[name];
-                if (!var->declared())
+                g2_variable* var = d_poll_variables[n];
+                // Updates requested from now on are sent by next poll
+                unsigned long long queued_ns = var->queued_ns;
+                atomic_store(&var->update_pending, 0);
+                // Variables not registered by G2 have no item to update
+                if (!var->handle)
                     continue;
-                var->get_val(registered_item_array[n]);
-
-                set_status(registered_item_array[n],NO_ERR); 
-                set_handle(registered_item_array[n],var->handle); 
-
-            } /* End of for loop */
+                d_poll_queued_ns[filled] = queued_ns;
+                note_delivery(var);
+                set_status(d_poll_items[filled],NO_ERR); 
+                set_handle(d_poll_items[filled],var->handle); 
+                batch_value(d_poll_items, filled++, var);
+            }
 
-            gsi_return_values(registered_item_array, count, current_context); 
-            /* Release the allocated memory */
-            gsi_reclaim_registered_items(registered_item_array);
-            d_g2_update_variables.clear();
+            set_batched_values(d_poll_items);
+            if (filled)
+            {
+                gsi_return_values(d_poll_items, filled, current_context); 
+                unsigned long long now = monotonic_ns();
+                for (int n = 0; n < filled; n++)
+                    gsi_metrics::update_latency.record(now - d_poll_queued_ns[n]);
+                record_deliveries(now);
+                gsi_metrics::poll_items.add(filled);
+            }
+            d_poll_variables.clear();
         }
     }
 
     void gsi_set_data_(gsi_registered_item* registered_item_array, gsi_int count) {
-        tthread::lock_guard<tthread::mutex> guard(d_mutex);
+        gsi_metrics::set_data_items.add(count);
+        variable_directory::reader reader(d_directory);
 
         for (int i=0; i<count; i++) {
-            // Get item handle
-            gsi_int handle = handle_of(registered_item_array[i]);
-            // Find variable by handle
-            auto it = std::find_if(d_g2_variables.begin(), d_g2_variables.end(), [handle](const std::pair<std::string, std::shared_ptr<g2_variable>> v) {
-                return v.second->handle == handle;
-            });
-            if (it == d_g2_variables.end())
-                continue;
-            it->second->set_val(registered_item_array[i]);
+            variable_entry* entry = d_directory.find((long)handle_of(registered_item_array[i]));
+            if (entry)
+                entry->variable()->set_val(registered_item_array[i]);
         }
     }
 
     void gsi_get_data_(gsi_registered_item* registered_item_array, gsi_int count) {
-        d_logger.log_formatted(log_level::REGULAR, "gsi_get_data(count=%d)\n", count);
+        gsi_metrics::get_data_items.add(count);
+        if (sampled(&d_get_data_calls))
+            G2FASTH_LOGF(d_logger, REGULAR, "gsi_get_data(count=%d)\n", count);
         {
-            tthread::lock_guard<tthread::mutex> guard(d_mutex);
+            variable_directory::reader reader(d_directory);
 
             for (int i=0; i<count; i++) {
                 set_status(registered_item_array[i], NO_ERR);
-                // Get item handle
-                gsi_int handle = handle_of(registered_item_array[i]);
-                // Find variable by handle
-                auto it = std::find_if(d_g2_variables.begin(), d_g2_variables.end(), [handle](const std::pair<std::string, std::shared_ptr<g2_variable>> v) {
-                    return v.second->handle == handle;
-                });
-                if (it == d_g2_variables.end())
+                variable_entry* entry = d_directory.find((long)handle_of(registered_item_array[i]));
+                if (!entry)
                     continue;
-                it->second->get_val(registered_item_array[i]);
+                batch_value(registered_item_array, i, entry->variable());
+                note_delivery(entry->variable());
             }
+            set_batched_values(registered_item_array);
         }
         // Pass variable values to G2
         gsi_return_values(registered_item_array, count, current_context); 
+        if (!d_delivered_us.empty())
+            record_deliveries(monotonic_ns());
     }
 
     void gsi_receive_deregistrations_(gsi_registered_item* registered_item_array, gsi_int count) {
         tthread::lock_guard<tthread::mutex> guard(d_mutex);
 
         for (int i=0; i<count; i++) {
-            // Get item handle
-            gsi_int handle = handle_of(registered_item_array[i]);
-            // Find variable by handle
-            auto it = std::find_if(d_g2_variables.begin(), d_g2_variables.end(), [handle](const std::pair<std::string, std::shared_ptr<g2_variable>> v) {
-                return v.second->handle == handle;
-            });
-            if (it == d_g2_variables.end())
+            variable_entry* entry = d_directory.find((long)handle_of(registered_item_array[i]));
+            if (!entry)
+                continue;
+            gsi_metrics::deregistrations.add();
+            if (sampled(&d_deregistration_calls))
+                G2FASTH_LOGF(d_logger, REGULAR, "Variable %s is unregistered\n", entry->name().c_str());
+            g2_variable* var = entry->variable();
+            if (!var->declared())
+            {   // Variable which was only registered is removed with its values
+                d_directory.remove(entry);
                 continue;
-            d_logger.log_formatted(log_level::REGULAR, "Variable %s is unregistered\n", it->first.c_str());
-            if (!it->second->declared())
-                d_g2_variables.erase(it);
-            else
-            {
-                it->second->handle = 0;
-                it->second->reg_type = g2_none;
             }
+            d_directory.assign_handle(entry, 0);
+            var->handle = 0;
+            var->reg_type = g2_none;
         }
     }
 
@@ -482,24 +619,79 @@ public:
     template <typename T>
     bool declare_g2_variable(const std::string& name, std::function<T()> handler = nullptr) {
         tthread::lock_guard<tthread::mutex> guard(d_mutex);
-        std::shared_ptr<g2_variable> var;
-        if (d_g2_variables.count(name))
+        variable_entry* entry = d_directory.find(name);
+        // Check if variable was already declared
+        if (entry && entry->variable()->declared())
+            return false;
+        g2_typed_variable<T>* var = new g2_typed_variable<T>(true);
+        var->d_handler = handler;
+        var->store_in(d_columns);
+        publish(entry, name, var);
+        return true;
+    }
+    /**
+    * This function declares several G2 variables at once, e.g. variables found in KB export.
+    * The lock is taken once for the whole range.
+    * @param first Beginning of range of objects with name and type members.
+    * @param last End of the range.
+    * @return Number of declared variables. Variables that were declared before are skipped.
+    */
+    template <typename It>
+    int declare_g2_variables(It first, It last) {
+        tthread::lock_guard<tthread::mutex> guard(d_mutex);
+        int declared = 0;
+        for (It it = first; it != last; ++it)
         {
-            var = d_g2_variables[name];
-            // Check if variable was already declared
-            if (var->declared())
-                return false;
-            // Set var's dec_type
-            std::shared_ptr<g2_variable> tmp = std::shared_ptr<g2_variable>(new g2_typed_variable<T>(true));
-            var->dec_type = tmp->dec_type;
+            variable_entry* entry = d_directory.find(it->name);
+            if (entry && entry->variable()->declared())
+                continue;
+            g2_variable* var = new_g2_variable(it->type, true);
+            if (!var)
+                continue;
+            publish(entry, it->name, var);
+            declared++;
         }
-        else
+        return declared;
+    }
+    /**
+    * Attaches generated signal to declared variable. The signal provides values
+    * when the variable has neither temporary nor default value, instead of the handler.
+    * Values of many variables with signals are computed together in gsi_get_data and
+    * gsi_g2_poll.
+    * @param name Name of G2 variable as it's named in KB.
+    * @param spec Parameters of the signal, a signal attached before is replaced.
+    * @return true (if success) or false (if variable is not declared).
+    */
+    bool attach_signal(const std::string& name, const signal_spec& spec) {
+        tthread::lock_guard<tthread::mutex> guard(d_mutex);
+        variable_entry* entry = d_directory.find(name);
+        if (!entry)
+            return false;
+        g2_variable* var = entry->variable();
+        if (!var->declared() || !var->columns)
+            return false;
+        if (var->signal >= 0)
         {
-            var = std::shared_ptr<g2_variable>(new g2_typed_variable<T>(true));
-            d_g2_variables[name] = var;
+            d_columns.signals.assign((size_t)var->signal, spec);
+            return true;
+        }
+        // Signal is set before the slot is marked, readers see it once they see the mark
+        var->signal = (long)d_columns.signals.add(spec);
+        switch (var->storage_type)
+        {
+        case g2_integer:
+            d_columns.integers.set_has_handler(var->slot);
+            break;
+        case g2_float:
+            d_columns.floats.set_has_handler(var->slot);
+            break;
+        case g2_logical:
+            d_columns.logicals.set_has_handler(var->slot);
+            break;
+        default:
+            d_columns.strings.set_has_handler(var->slot);
+            break;
         }
-        ((g2_typed_variable<T>*)var.get())->d_handler = handler;
-
         return true;
     }
     /**
@@ -509,13 +701,14 @@ public:
     */
     variable_map get_g2_variables(bool only_declared=true) {
         variable_map vars;
-        tthread::lock_guard<tthread::mutex> guard(d_mutex);
-        std::for_each(d_g2_variables.begin(), d_g2_variables.end(), [&](const std::pair<std::string, std::shared_ptr<g2_variable>>& var)
+        variable_directory::reader reader(d_directory);
+        d_directory.for_each([&](const variable_entry& entry)
         {
-            if (var.second->declared() || !only_declared)
+            g2_variable* var = entry.variable();
+            if (var->declared() || (!only_declared && var->registered()))
             {
-                std::shared_ptr<g2_variable> copy(var.second->clone());
-                vars[var.first] = copy;
+                std::shared_ptr<g2_variable> copy(var->clone());
+                vars[entry.name()] = copy;
             }
         });
         return vars;
@@ -528,14 +721,15 @@ public:
     */
     template <typename T>
     bool assign_def_value(const std::string& name, T new_val) {
-        tthread::lock_guard<tthread::mutex> guard(d_mutex);
+        variable_directory::reader reader(d_directory);
         // Must be already declared
-        if (!d_g2_variables.count(name))
+        variable_entry* entry = d_directory.find(name);
+        if (!entry)
             return false;
-        auto& var = d_g2_variables[name];
+        g2_variable* var = entry->variable();
         if (!check_type<T>(var->dec_type))
             return false;
-        ((g2_typed_variable<T>*)var.get())->assign_def_value(new_val);
+        static_cast<g2_typed_variable<T>*>(var)->assign_def_value(new_val);
         return true;
     }
     /**
@@ -547,19 +741,61 @@ public:
     */
     template <typename T>
     bool assign_temp_value(const std::string& name, T new_val, int count = 1) {
-        tthread::lock_guard<tthread::mutex> guard(d_mutex);
+        variable_directory::reader reader(d_directory);
         // Must be already declared
-        if (!d_g2_variables.count(name))
+        variable_entry* entry = d_directory.find(name);
+        if (!entry)
             return false;
-        auto& var = d_g2_variables[name];
+        g2_variable* var = entry->variable();
         if (!check_type<T>(var->dec_type))
             return false;
         if (!var->registered() && !d_ignore_not_registered_variables)
             return false;
-        ((g2_typed_variable<T>*)var.get())->assign_temp_value(new_val, count);
+        static_cast<g2_typed_variable<T>*>(var)->assign_temp_value(new_val, count);
+        // Time to delivery is measured from the first assignment not delivered yet
+        if (!atomic_load(&var->assigned_us))
+            atomic_compare_exchange(&var->assigned_us, 0, clock_us());
         return true;
     }
     /**
+    * Returns declared variable for repeated access without lookup by name. Declared
+    * variables are neither replaced nor freed while libgsi exists.
+    * @param name Name of G2 variable as it's named in KB.
+    * @return Variable or nullptr if no variable with such name is declared.
+    */
+    g2_variable* get_declared_variable(const std::string& name) {
+        variable_directory::reader reader(d_directory);
+        variable_entry* entry = d_directory.find(name);
+        if (!entry)
+            return nullptr;
+        g2_variable* var = entry->variable();
+        return var->declared() && var->columns ? var : nullptr;
+    }
+    /**
+    * Assigns number to variable returned by get_declared_variable. The number is
+    * converted to type of the variable like values of signals.
+    * @param var Declared variable.
+    * @param new_val New value to assign.
+    * @param count 0 assigns the default value, otherwise a temporary value returned next count times.
+    */
+    void assign_number(g2_variable* var, double new_val, int count = 0) {
+        switch (var->storage_type)
+        {
+        case g2_integer:
+            assign_column_value(d_columns.integers, var->slot, signal_value<int>(new_val), count);
+            break;
+        case g2_float:
+            assign_column_value(d_columns.floats, var->slot, new_val, count);
+            break;
+        case g2_logical:
+            assign_column_value(d_columns.logicals, var->slot, signal_value<bool>(new_val), count);
+            break;
+        default:
+            assign_column_value(d_columns.strings, var->slot, interned_string(signal_value<std::string>(new_val)), count);
+            break;
+        }
+    }
+    /**
     * Checks if type of variable is compatible with type T.
     * @param type Type of G2 variable.
     * @return true (if success) or false.
@@ -601,15 +837,18 @@ public:
     std::list<std::string> get_not_declared_variables()
     {
         std::list<std::string> list;
-        tthread::lock_guard<tthread::mutex> guard(d_mutex);
-        std::for_each(d_g2_variables.begin(), d_g2_variables.end(), [&](const std::pair<std::string, std::shared_ptr<g2_variable>>& var)
+        variable_directory::reader reader(d_directory);
+        d_directory.for_each([&](const variable_entry& entry)
         {
-            if (var.second->registered() && !(var.second->declared() && var.second->type_ok()))
+            g2_variable* var = entry.variable();
+            if (var->registered() && !(var->declared() && var->type_ok()))
             {
                 if (!d_ignore_not_declared_variables)
-                    list.push_back(var.first);
+                    list.push_back(entry.name());
             }
         });
+        // Names are hashed, sorting keeps the order independent of the hash
+        list.sort();
         return list;
     }
     /**
@@ -619,32 +858,59 @@ public:
     std::list<std::string> get_not_registered_variables()
     {
         std::list<std::string> list;
-        tthread::lock_guard<tthread::mutex> guard(d_mutex);
-        std::for_each(d_g2_variables.begin(), d_g2_variables.end(), [&](const std::pair<std::string, std::shared_ptr<g2_variable>>& var)
+        variable_directory::reader reader(d_directory);
+        d_directory.for_each([&](const variable_entry& entry)
         {
-            if (var.second->declared() && !(var.second->registered() && var.second->type_ok()))
+            g2_variable* var = entry.variable();
+            if (var->declared() && !(var->registered() && var->type_ok()))
             {
                 if (!d_ignore_not_registered_variables)
-                    list.push_back(var.first);
+                    list.push_back(entry.name());
             }
         });
+        // Names are hashed, sorting keeps the order independent of the hash
+        list.sort();
         return list;
     }
     /**
-    * Executes unsolicited update for G2 variable.
+    * Executes unsolicited update for G2 variable. The value is sent on next gsi_g2_poll.
     * @param name Name of G2 variable as it's named in KB.  
-    * @return true (if success) or false.
+    * @return true (if success) or false (if variable is not declared or its update is already pending).
     */
     bool update_g2_variable(const char* name) {
-        tthread::lock_guard<tthread::mutex> guard(d_update_mutex);
-        auto it = std::find_if(d_g2_update_variables.begin(), d_g2_update_variables.end(), [&](const std::string & val) {
-            return val == name;
-        });
-        if (it != d_g2_update_variables.end())
+        variable_directory::reader reader(d_directory);
+        variable_entry* entry = d_directory.find(name);
+        if (!entry)
             return false;
-        d_g2_update_variables.push_back(name);
+        return update_g2_variable(entry->variable());
+    }
+    /**
+    * Executes unsolicited update for variable returned by get_declared_variable.
+    * @return true (if success) or false (if variable is not declared or its update is already pending).
+    */
+    bool update_g2_variable(g2_variable* var) {
+        if (!var->declared() || !atomic_compare_exchange(&var->update_pending, 0, 1))
+            return false;
+        var->queued_ns = monotonic_ns();
+        tthread::lock_guard<tthread::mutex> guard(d_update_mutex);
+        d_g2_update_variables.push_back(var);
         return true;
     }
+    /**
+    * Returns number of updates queued by update_g2_variable and not yet taken by gsi_g2_poll.
+    */
+    size_t pending_updates() {
+        tthread::lock_guard<tthread::mutex> guard(d_update_mutex);
+        return d_g2_update_variables.size();
+    }
+    /**
+    * Returns latencies of updates from update_g2_variable to gsi_return_values.
+    */
+    const metric_histogram& update_latency() const { return gsi_metrics::update_latency; }
+    /**
+    * Returns number of values sent by gsi_g2_poll.
+    */
+    const metric_counter& updates_sent() const { return gsi_metrics::poll_items; }
 
     /**
     * This function declares G2 local function for using in the tests.
@@ -661,6 +927,16 @@ public:
         return true;  
     }
     /**
+    * Returns G2 local function declared with declare_g2_function, e.g. to call it without G2.
+    * @param name Name of G2 local function as it's named in KB.
+    * @return Pointer to the local function or nullptr if function with such name was not declared.
+    */
+    gsi_rpc_local_fn_type* get_g2_function(const std::string& name) {
+        tthread::lock_guard<tthread::mutex> guard(d_mutex);
+        function_map::const_iterator it = d_g2_declared_functions.find(name);
+        return it != d_g2_declared_functions.end() ? it->second : nullptr;
+    }
+    /**
     * This function declares G2 context initialization function.
     * @param init_fn Pointer to the initialization function.
     * @return true (if success) or false (if function was declared before).
@@ -730,14 +1006,194 @@ public:
     }
 
 private:
-    tthread::mutex d_mutex;
-    variable_map d_g2_variables; // map key is a name
-    std::vector<std::string> d_g2_update_variables; // Names of variables to be updated
+    /**
+    * Creates variable of given type.
+    * @return New variable or nullptr if the type is not supported.
+    */
+    g2_variable* new_g2_variable(g2_type type, bool declaration) {
+        g2_variable* var = nullptr;
+        switch (type)
+        {
+        case g2_integer:
+            var = new_stored_variable<int>(declaration);
+            break;
+        case g2_float:
+            var = new_stored_variable<double>(declaration);
+            break;
+        case g2_logical:
+            var = new_stored_variable<bool>(declaration);
+            break;
+        case g2_string:
+        case g2_symbol:
+            var = new_stored_variable<std::string>(declaration);
+            if (declaration)
+                var->dec_type = type;
+            else
+                var->reg_type = type;
+            break;
+        default:
+            break;
+        }
+        return var;
+    }
+    /**
+    * Creates variable holding its values in d_columns.
+    */
+    template <typename T>
+    g2_typed_variable<T>* new_stored_variable(bool declaration) {
+        g2_typed_variable<T>* var = new g2_typed_variable<T>(declaration);
+        var->store_in(d_columns);
+        return var;
+    }
+    /**
+    * Adds item to the batch of its value type. Values are set by set_batched_values,
+    * variables must not be released before. Batches are limited, so that items are
+    * still in cache when their values are set.
+    */
+    void batch_value(gsi_registered_item* items, int i, g2_variable* var) {
+        if (++d_batched > kMaxBatched)
+            set_batched_values(items);
+        switch (var->columns ? var->storage_type : g2_none)
+        {
+        case g2_integer:
+            d_int_batch.add(i, var);
+            break;
+        case g2_float:
+            d_float_batch.add(i, var);
+            break;
+        case g2_logical:
+            d_logical_batch.add(i, var);
+            break;
+        case g2_string:
+            d_string_batch.add(i, var);
+            break;
+        default:
+            var->get_val(items[i]);
+            break;
+        }
+    }
+    /**
+    * Sets values of batched items. Values are taken from the columns by type, only
+    * variables without a temporary or default value call their handler.
+    */
+    void set_batched_values(gsi_registered_item* items) {
+        d_batched = 0;
+        set_values<int>(d_columns, d_int_batch, items);
+        set_values<double>(d_columns, d_float_batch, items);
+        set_values<bool>(d_columns, d_logical_batch, items);
+        set_values<std::string>(d_columns, d_string_batch, items);
+    }
+    template <typename T>
+    static void set_values(value_columns& columns, value_batch<typename column_value<T>::type>& batch, gsi_registered_item* items) {
+        if (batch.slots.empty())
+            return;
+        batch.reserve();
+        columns.column<typename column_value<T>::type>().resolve(&batch.slots[0], batch.slots.size(), batch.values, &batch.resolved[0]);
+        for (size_t n = 0; n < batch.slots.size(); n++)
+        {
+            if (batch.resolved[n])
+                set_item_value(items[batch.items[n]], batch.values[n]);
+            else if (batch.variables[n]->signal >= 0)
+            {
+                batch.signal_positions.push_back(n);
+                batch.signals.push_back((size_t)batch.variables[n]->signal);
+            }
+            else
+                batch.variables[n]->get_val(items[batch.items[n]]);
+        }
+        if (!batch.signals.empty())
+        {
+            batch.signal_values.resize(batch.signals.size());
+            columns.signals.evaluate(&batch.signals[0], batch.signals.size(), columns.signals.seconds(), &batch.signal_values[0]);
+            for (size_t n = 0; n < batch.signals.size(); n++)
+                set_item_value(items[batch.items[batch.signal_positions[n]]], signal_value<T>(batch.signal_values[n]));
+            batch.signal_positions.clear();
+            batch.signals.clear();
+        }
+        batch.items.clear();
+        batch.slots.clear();
+        batch.variables.clear();
+    }
+    template <typename T>
+    static void assign_column_value(value_column<T>& column, size_t slot, const T& new_val, int count) {
+        if (count)
+            column.assign_temp_value(slot, new_val, count);
+        else
+            column.assign_def_value(slot, new_val);
+    }
+    /**
+    * Counts call and checks if its details should be logged.
+    */
+    bool sampled(volatile long* calls) {
+        long every = atomic_load(&d_sample_every);
+        return every > 0 && atomic_add(calls, 1) % every == 0;
+    }
+    /**
+    * Takes assignment time of value being returned to G2, called on the gateway thread.
+    */
+    void note_delivery(g2_variable* var) {
+        long assigned = atomic_load(&var->assigned_us);
+        // Assignment taken only once, a later one starts the next measurement
+        if (assigned && atomic_compare_exchange(&var->assigned_us, assigned, 0))
+            d_delivered_us.push_back(assigned);
+    }
+    /**
+    * Returns monotonic time in microseconds wrapping around, never 0 which means no time.
+    */
+    static long clock_us() {
+        long now = (long)(unsigned long)(monotonic_ns() / 1000);
+        return now ? now : 1;
+    }
+    /**
+    * Records time from assignment to delivery of values noted since last call.
+    */
+    void record_deliveries(unsigned long long now) {
+        long now_us = (long)(unsigned long)(now / 1000);
+        for (size_t i = 0; i < d_delivered_us.size(); i++)
+            gsi_metrics::delivery_latency.record((unsigned long long)counter_distance(now_us, d_delivered_us[i]) * 1000);
+        d_delivered_us.clear();
+    }
+    /**
+    * Publishes declared variable. A variable which was only registered is replaced,
+    * the new one takes over its registration.
+    */
+    void publish(variable_entry* entry, const std::string& name, g2_variable* var) {
+        if (!entry)
+        {
+            d_directory.insert(name, var);
+            return;
+        }
+        g2_variable* registered = entry->variable();
+        var->reg_type = registered->reg_type;
+        var->handle = registered->handle;
+        d_directory.replace(entry, var);
+    }
+    tthread::mutex d_mutex; // serializes changes of d_directory
+    value_columns d_columns; // values of variables, released by d_directory which is destroyed first
+    variable_directory d_directory;
+    tthread::mutex d_update_mutex;
+    std::vector<g2_variable*> d_g2_update_variables; // Declared variables to be updated, they are never replaced
+    std::vector<g2_variable*> d_poll_variables; // updates being sent by gsi_g2_poll
+    gsi_registered_item* d_poll_items; // reused by gsi_g2_poll, not reclaimed as GSI may be gone at exit
+    int d_poll_capacity;
+    std::vector<unsigned long long> d_poll_queued_ns; // queue times of d_poll_items
+    // Batches of gsi_get_data and gsi_g2_poll, used on the gateway thread only
+    static const int kMaxBatched = 256;
+    int d_batched;
+    value_batch<int> d_int_batch;
+    value_batch<double> d_float_batch;
+    value_batch<bool> d_logical_batch;
+    value_batch<interned_string> d_string_batch;
+    std::vector<long> d_delivered_us; // assignment times of values being returned
+    volatile long d_sample_every;
+    volatile long d_get_data_calls;
+    volatile long d_poll_calls;
+    volatile long d_registration_calls;
+    volatile long d_deregistration_calls;
     function_map d_g2_declared_functions; // map key is a name
     remotefn_map d_g2_remote_functions; // map key is a name
     std::function<void()> d_g2_init;
     std::function<void()> d_g2_shutdown;
-    tthread::mutex d_update_mutex;
     bool d_continuous;
     int d_port;
     bool d_ignore_not_registered_variables;
@@ -866,7 +1322,7 @@ template<typename VT>
 std::shared_ptr<g2_variable> gsi_rpc_handler<T>::create_variable(VT value)
 {
     std::shared_ptr<g2_variable> var = std::shared_ptr<g2_variable>(new g2_typed_variable<VT>(false));
-    ((g2_typed_variable<std::string>*)var.get())->assign_temp_value(value, 1);
+    ((g2_typed_variable<VT>*)var.get())->assign_temp_value(value, 1);
     return var;
 }
 
@@ -877,6 +1333,23 @@ VT gsi_rpc_handler<T>::get_variable_value(std::shared_ptr<g2_variable> var)
     return ((g2_typed_variable<VT>*)var.get())->value();
 }
 
+#if defined(GSI_USE_WIDE_STRING_API)
+// Values of handlers and signals are not interned, they seldom repeat. Short
+// ASCII values are converted on the stack, others by GSI into its buffer.
+inline void set_item_value(gsi_registered_item item, const std::string& value) {
+    short buf[256];
+    if (value.size() < 256 && convert_ascii(value.c_str(), value.size(), buf))
+    {
+        buf[value.size()] = 0;
+        gsi_set_str(item, buf);
+    }
+    else
+        gsi_set_str(item, gsi_convert_string_to_unicode(const_cast<char*>(value.c_str()), GSI_CHAR_SET_GENSYM));
+}
+#else
+inline void set_item_value(gsi_registered_item item, const std::string& value) { gsi_set_str(item, const_cast<char*>(value.c_str())); }
+#endif
+
 }
 }
 
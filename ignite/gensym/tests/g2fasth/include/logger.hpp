@@ -4,30 +4,98 @@
 
 #include <iostream>
 #include <vector>
+#include <memory>
+#include <stdarg.h>
 #include "tinythread.h"
 #include "g2fasth_enums.hpp"
+#include "trace.hpp"
 
 namespace g2 {
 namespace fasth {
+struct log_queue;
+class binary_log;
+class file_sink;
+class logger;
+
+/**
+* Text messages of one test case, collected while it runs to be written at once when it
+* completes. Messages are collected by the logger which began the capture, if they are
+* logged by threads of the test case, including asynchronous continuations and timers.
+*/
+class log_capture {
+public:
+    log_capture() : d_owner(nullptr), d_closed(false) {}
+    /**
+    * Returns captured messages attached to the report, separated by new lines.
+    */
+    std::string text();
+private:
+    friend class logger;
+    log_capture(const log_capture&);
+    log_capture& operator=(const log_capture&);
+    bool append(log_level level, const char* text, size_t length);
+    tthread::mutex d_mutex;
+    const logger* d_owner;
+    bool d_closed;
+    std::string d_buffer;   // messages, each prefixed by level and terminated by zero
+    std::string d_text;
+};
+
 /**
 * This class is responsible for logging to collection of streams.
 * The amount of data logged depends on log level set through the constructor.
+* By default every message is written and flushed by the calling thread. In asynchronous
+* mode messages are queued and written in batches by a background thread.
 */
 class logger {
 private:
     struct stream_info {
         std::ostream* pStream;
+        std::shared_ptr<file_sink> sink;    // owned file, used instead of the stream
         g2::fasth::log_level level;
         stream_info(std::ostream* pStream, log_level level)
             : pStream(pStream), level(level) {
         }
+        stream_info(const std::shared_ptr<file_sink>& sink, log_level level)
+            : pStream(nullptr), sink(sink), level(level) {
+        }
     };
-    void internal_log(log_level, std::string);
+    struct binary_log_info {
+        std::shared_ptr<binary_log> log;
+        g2::fasth::log_level level;
+        binary_log_info(const std::shared_ptr<binary_log>& log, log_level level)
+            : log(log), level(level) {
+        }
+    };
+    void internal_log(log_level, const char*, size_t);
+    void add_stream(const stream_info&);
+    static void write_stream(const stream_info&, const char* data, size_t length);
 public:
+    /**
+    * What to do with a message when the asynchronous queue is full.
+    */
+    enum overflow_policy {
+        // Wait until the background thread frees a slot.
+        block,
+        // Discard the message and count it.
+        drop
+    };
+    /**
+    * What to do with messages of a test case.
+    */
+    enum capture_mode {
+        // Write messages as they are logged.
+        capture_off,
+        // Write messages as one block when the test case completes.
+        capture_block,
+        // Attach messages to the test case in JUnit report instead of writing them.
+        capture_report
+    };
     /**
     * Accepts log level of application.
     */
     logger(g2::fasth::log_level);
+    ~logger();
     /**
     * This method accepts reference output stream instance and log level associated with it.
     */
@@ -37,19 +105,132 @@ public:
     */
     void add_output_stream(std::ostream*, log_level);
     /**
+    * Adds file the logger writes to, sharing its ownership with other loggers.
+    * The file is written in large blocks rather than flushed after each message.
+    */
+    void add_file_sink(const std::shared_ptr<file_sink>&, log_level);
+    /**
+    * Adds binary log receiving messages up to the log level. Messages are stored
+    * unformatted, tagged with time, thread and test case of the calling thread.
+    */
+    void add_binary_log(const std::shared_ptr<binary_log>&, log_level);
+    /**
+    * Checks whether a message with the level would be written to any stream or binary log.
+    * Streams are expected to be added before the logger is used by several threads.
+    */
+    bool is_enabled(log_level level) const { return level <= d_enabled_level; }
+    /**
     * This method logs data with desired log level.
     */
-    void log(log_level, std::string);
+    void log(log_level, const std::string&);
+    void log(log_level, const char*);
+    /**
+    * Logs printf-style formatted message. Short messages are formatted into a buffer
+    * of the calling thread, so nothing is allocated in synchronous mode.
+    */
+    void logf(log_level log_level, const char* fmt, ...);
     void log_formatted(log_level log_level, const std::string fmt_str, ...);
+    /**
+    * Switches logger to asynchronous mode. It should be called before the logger is used
+    * by several threads.
+    * @param capacity Number of messages the queue holds, rounded up to power of two.
+    * 0 flushes queued messages and switches back to synchronous mode.
+    * @param policy What to do when the queue is full.
+    */
+    void set_async(size_t capacity, overflow_policy policy = block);
+    bool is_async() const { return d_queue != nullptr; }
+    /**
+    * Waits until all messages queued so far are written, and writes buffered
+    * records of binary logs.
+    */
+    void flush();
+    /**
+    * Returns number of messages dropped because the queue was full.
+    */
+    long dropped() const;
+    /**
+    * Flushes all asynchronous loggers, waiting at most for timeout_ms.
+    * Used on suite completion and from the signal handler.
+    */
+    static void flush_all(unsigned timeout_ms = 1000);
+    /**
+    * Sets how messages of test cases are captured. It should be called before
+    * the suite is executed.
+    * @param mode Capture mode.
+    * @param failed_only Discard captured messages of passed test cases.
+    */
+    void set_capture(capture_mode mode, bool failed_only = false);
+    capture_mode get_capture() const { return d_capture_mode; }
+    /**
+    * Starts collecting messages of a test case, if capture is on.
+    */
+    void begin_capture(log_capture&);
+    /**
+    * Writes or keeps collected messages of a completed test case according to
+    * capture mode. Messages logged afterwards are written directly.
+    * @param passed Whether the test case passed.
+    */
+    void end_capture(log_capture&, bool passed);
 private:
+    logger(const logger&);
+    logger& operator=(const logger&);
+    void dispatch(log_level, const char* text, size_t length);
+    void format(log_level, const char* fmt, va_list ap, va_list retry_ap);
+    bool is_text_enabled(log_level level) const { return level <= d_text_level; }
+    bool is_binary_enabled(log_level level) const { return level <= d_binary_level; }
+    void write_binary(log_level, const char* text, size_t length);
+    void write_block(const std::string& messages);
+    bool wait_written(long target, unsigned timeout_ms);
+    void stop_async();
+    void drain();
+    static void s_drain_thread_proc(void*);
     tthread::mutex d_mutex;
     log_level d_loglevel;
+    log_level d_enabled_level;  // most detailed level written to any stream or binary log
+    log_level d_text_level;     // most detailed level written to any stream
+    log_level d_binary_level;   // most detailed level written to any binary log
     std::vector<stream_info> d_outputStreams;
+    std::vector<binary_log_info> d_binary_logs;
+    capture_mode d_capture_mode;
+    bool d_capture_failed_only;
+    log_queue* d_queue;
+    tthread::thread* d_drain_thread;
     bool write(const char* data, bool written, std::ostream* stream);
 };
 }
 }
 
+/**
+* Most detailed level of messages compiled in. G2FASTH_LOG and G2FASTH_LOGF calls with more
+* detailed level are constant-folded away, e.g. -DG2FASTH_MIN_LOG_LEVEL=REGULAR strips all
+* VERBOSE messages from the build.
+*/
+#ifndef G2FASTH_MIN_LOG_LEVEL
+#define G2FASTH_MIN_LOG_LEVEL VERBOSE
+#endif
+
+/**
+* Logs the message only if the level is enabled. The message expression is not evaluated
+* otherwise, so concatenations cost nothing when the level is off.
+* @param target logger instance
+* @param level NONE, SILENT, REGULAR or VERBOSE
+* @param message std::string or C string
+*/
+#define G2FASTH_LOG(target, level, message) \
+    do { \
+        if (g2::fasth::level <= g2::fasth::G2FASTH_MIN_LOG_LEVEL && (target).is_enabled(g2::fasth::level)) \
+            (target).log(g2::fasth::level, message); \
+    } while (0)
+
+/**
+* Logs printf-style message only if the level is enabled, arguments are not evaluated otherwise.
+*/
+#define G2FASTH_LOGF(target, level, ...) \
+    do { \
+        if (g2::fasth::level <= g2::fasth::G2FASTH_MIN_LOG_LEVEL && (target).is_enabled(g2::fasth::level)) \
+            (target).logf(g2::fasth::level, __VA_ARGS__); \
+    } while (0)
+
 #ifndef FUNCLOG
 #ifndef WIN32
 #include <sys/time.h>
@@ -63,31 +244,16 @@ inline unsigned GetTickCount()
 }
 #endif
 
-//#define ENABLE_FUNCLOG
-
-class ScopeLog
-{
-    std::string name;
-    std::string suffix;
-public:
-    ScopeLog(const std::string& name, const std::string& suffix=""): name(name), suffix(suffix)
-    {
-        printf("%08u ENTER %s-%s\n", GetTickCount(), this->name.c_str(), this->suffix.c_str());
-    }
-    ~ScopeLog()
-    {
-        printf("%08u LEAVE %s-%s\n", GetTickCount(), this->name.c_str(), this->suffix.c_str());
-    }
-};
-#ifdef ENABLE_FUNCLOG
-#   define FUNCLOG ScopeLog __func_log__(__FUNCTION__)
-#   define FUNCLOG2(suffix) ScopeLog __func_log__(__FUNCTION__,suffix)
-#   define SCOPELOG(name) ScopeLog __scope_log__(name)
-#else
-#   define FUNCLOG
-#   define FUNCLOG2(suffix)
-#   define SCOPELOG(name)
-#endif
+/**
+* Record the enclosing function or scope in the trace, see trace_recorder.
+* They cost one flag check when tracing is off.
+*/
+#define FUNCLOG G2FASTH_TRACE_SCOPE("function", __FUNCTION__)
+#define FUNCLOG2(suffix) \
+    std::string __func_log_name__(g2::fasth::trace_recorder::is_enabled() \
+        ? std::string(__FUNCTION__) + "-" + (suffix) : std::string()); \
+    G2FASTH_TRACE_SCOPE("function", __func_log_name__)
+#define SCOPELOG(name) G2FASTH_TRACE_SCOPE("scope", name)
 #endif
 
 
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_MAPPED_FILE_H
+#define INC_LIBG2FASTH_MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+
+namespace g2 {
+namespace fasth {
+/**
+* Read-only memory mapping of a whole file.
+* The file is mapped for sequential access, so it can be scanned
+* without copying it into process memory.
+*/
+class mapped_file {
+public:
+    mapped_file();
+    ~mapped_file();
+    /**
+    * Maps the file, closing previously mapped one.
+    * @param path Path to the file.
+    * @return true if file was mapped. Empty file is mapped with null data.
+    */
+    bool open(const std::string& path);
+    /**
+    * Unmaps the file.
+    */
+    void close();
+    const char* data() const { return d_data; }
+    size_t size() const { return d_size; }
+    bool is_open() const { return d_open; }
+private:
+    mapped_file(const mapped_file&);
+    mapped_file& operator=(const mapped_file&);
+    const char* d_data;
+    size_t d_size;
+    bool d_open;
+#ifdef WIN32
+    void* d_file;
+    void* d_mapping;
+#endif
+};
+}
+}
+
+#endif // !INC_LIBG2FASTH_MAPPED_FILE_H
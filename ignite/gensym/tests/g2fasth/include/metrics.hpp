@@ -0,0 +1,225 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_METRICS_H
+#define INC_LIBG2FASTH_METRICS_H
+
+#include <string>
+#include <vector>
+#include "g2fasth_platform.hpp"
+
+namespace g2 {
+namespace fasth {
+// Values are spread over shards chosen by thread index, so threads updating
+// the same metric rarely share a cache line. Reads sum all shards.
+const unsigned kMetricShards = 16;
+const unsigned kHistogramShards = 8;
+// Histogram buckets split each power of two into 8, so recorded values are
+// kept with 12.5% precision. Values from 2^40 ns (18 minutes) share the last bucket.
+const unsigned kHistogramSubBucketBits = 3;
+const unsigned kHistogramMaxExponent = 40;
+const unsigned kHistogramBuckets = (1 << kHistogramSubBucketBits)
+    + (kHistogramMaxExponent - kHistogramSubBucketBits) * (1 << kHistogramSubBucketBits);
+
+/**
+* Monotonically increasing count of events.
+*/
+class metric_counter {
+public:
+    metric_counter();
+    void add(long value = 1) {
+        atomic_add(&d_shards[current_thread_index() % kMetricShards].value, value);
+    }
+    long long value() const;
+    void reset();
+private:
+    metric_counter(const metric_counter&);
+    metric_counter& operator=(const metric_counter&);
+    struct shard {
+        volatile long value;
+        char padding[64 - sizeof(long)];
+    };
+    shard d_shards[kMetricShards];
+};
+
+/**
+* Current value of something that goes up and down, like number of busy workers.
+*/
+class metric_gauge {
+public:
+    metric_gauge() : d_value(0) {}
+    void set(long value) { atomic_store(&d_value, value); }
+    void add(long value) { atomic_add(&d_value, value); }
+    long value() const { return atomic_load(&d_value); }
+private:
+    metric_gauge(const metric_gauge&);
+    metric_gauge& operator=(const metric_gauge&);
+    volatile long d_value;
+};
+
+/**
+* Distribution of durations in nanoseconds with logarithmic buckets, in the
+* manner of HDR histograms. Recording is one atomic increment.
+*/
+class metric_histogram {
+public:
+    metric_histogram();
+    ~metric_histogram();
+    void record(unsigned long long value_ns) {
+        atomic_add(&d_shards[current_thread_index() % kHistogramShards][bucket_index(value_ns)], 1);
+    }
+    /**
+    * Returns counts of all buckets summed over shards.
+    */
+    std::vector<long long> buckets() const;
+    long long count() const;
+    /**
+    * Returns value below which given fraction of recorded values falls, 0 if empty.
+    * The value is the highest one of its bucket.
+    */
+    unsigned long long percentile(double fraction) const;
+    /**
+    * Returns percentile of bucket counts, like difference of two buckets() results.
+    */
+    static unsigned long long percentile(const std::vector<long long>& counts, double fraction);
+    void reset();
+    static unsigned bucket_index(unsigned long long value);
+    static unsigned long long bucket_lower(unsigned index);
+    static unsigned long long bucket_upper(unsigned index);
+private:
+    metric_histogram(const metric_histogram&);
+    metric_histogram& operator=(const metric_histogram&);
+    volatile long* d_shards[kHistogramShards];
+};
+
+/**
+* Registry of named metrics. Metrics are registered once and live until the
+* process exits, so references to them can be kept in statics.
+*/
+class metrics_registry {
+public:
+    /**
+    * Returns counter registered with given name, registering it if needed.
+    * @param name Metric family name, "_total" is appended in exported samples.
+    * @param help Description exported with the family.
+    * @param labels Label set of this metric, like callback="gsi_set_data", can be empty.
+    */
+    static metric_counter& counter(const std::string& name, const std::string& help,
+        const std::string& labels = "");
+    static metric_gauge& gauge(const std::string& name, const std::string& help,
+        const std::string& labels = "");
+    /**
+    * Returns histogram registered with given name. Name should end with "_seconds",
+    * values are recorded in nanoseconds and exported in seconds.
+    */
+    static metric_histogram& histogram(const std::string& name, const std::string& help,
+        const std::string& labels = "");
+    /**
+    * Returns all metrics in OpenMetrics text format.
+    */
+    static std::string openmetrics();
+    /**
+    * Writes metrics in OpenMetrics text format. The file is replaced atomically,
+    * so collectors never read partial file.
+    * @return false if the file could not be written.
+    */
+    static bool write_openmetrics(const std::string& path);
+    /**
+    * Returns readable summary of metrics which have been updated, with
+    * percentiles of histograms.
+    */
+    static std::string summary();
+    /**
+    * Writes metrics file periodically from background thread and once more at
+    * process exit.
+    * @param path OpenMetrics file.
+    * @param interval_s Seconds between writes, 0 writes only at exit.
+    */
+    static void start_export(const std::string& path, unsigned interval_s);
+    static void stop_export();
+    /**
+    * Prints summary to standard output at process exit.
+    */
+    static void print_summary_at_exit();
+    /**
+    * Prints summary to standard output periodically from background thread and
+    * once more at process exit.
+    * @param interval_s Seconds between summaries, 0 prints only at exit.
+    */
+    static void start_summary(unsigned interval_s);
+    static void stop_summary();
+    /**
+    * Zeroes counters and histograms. Gauges are kept as they track current state.
+    */
+    static void reset();
+};
+
+/**
+* Records time from its construction to destruction in histogram.
+*/
+class metric_timer {
+public:
+    explicit metric_timer(metric_histogram& histogram)
+        : d_histogram(histogram), d_start(monotonic_ns()) {
+    }
+    ~metric_timer() {
+        d_histogram.record(monotonic_ns() - d_start);
+    }
+private:
+    metric_timer(const metric_timer&);
+    metric_timer& operator=(const metric_timer&);
+    metric_histogram& d_histogram;
+    unsigned long long d_start;
+};
+
+/**
+* Increments gauge for the lifetime of the scope, like number of busy workers.
+*/
+class metric_gauge_scope {
+public:
+    explicit metric_gauge_scope(metric_gauge& gauge) : d_gauge(gauge) {
+        d_gauge.add(1);
+    }
+    ~metric_gauge_scope() {
+        d_gauge.add(-1);
+    }
+private:
+    metric_gauge_scope(const metric_gauge_scope&);
+    metric_gauge_scope& operator=(const metric_gauge_scope&);
+    metric_gauge& d_gauge;
+};
+
+/**
+* Metrics of test scheduling updated by suites, test cases and test agent.
+*/
+struct scheduler_metrics {
+    static metric_counter& tests_started;
+    static metric_counter& tests_passed;
+    static metric_counter& tests_failed;
+    static metric_counter& tests_timed_out;
+    static metric_counter& continuations;
+    static metric_counter& timer_ticks;
+    static metric_gauge& tests_ready;
+    static metric_gauge& busy_workers;
+    static metric_gauge& running_suites;
+    static metric_histogram& start_delay;
+    static metric_histogram& test_duration;
+    static metric_histogram& suite_duration;
+};
+
+/**
+* Metrics of GSI callbacks updated by libgsi. Numbers of calls and their durations
+* are kept by g2fasth_gsi_callback_seconds, these count items passed by the calls
+* and time values take to reach G2.
+*/
+struct gsi_metrics {
+    static metric_counter& get_data_items;
+    static metric_counter& set_data_items;
+    static metric_counter& poll_items;
+    static metric_counter& registrations;
+    static metric_counter& deregistrations;
+    static metric_histogram& update_latency;
+    static metric_histogram& delivery_latency;
+};
+}
+}
+
+#endif // !INC_LIBG2FASTH_METRICS_H
@@ -0,0 +1,111 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_RESULT_LOG_H
+#define INC_LIBG2FASTH_RESULT_LOG_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include "tinythread.h"
+#include "g2fasth_enums.hpp"
+
+namespace g2 {
+namespace fasth {
+/**
+* Compact binary log of test results.
+* Records are appended as each test case completes, suite and test names
+* are written once per file session and referenced by id afterwards.
+* All suites writing to the same path share one instance.
+*/
+class result_log {
+public:
+    /**
+    * Returns result log for given path, opening it if needed.
+    * @param path Path to the log file. The file is appended to.
+    * @return Shared result log, or nullptr if the file could not be opened.
+    */
+    static std::shared_ptr<result_log> open(const std::string& path);
+    ~result_log();
+    /**
+    * Records start of test suite execution.
+    * @param suite_name Name of the suite.
+    * @param start_time Start time as it is reported in JUnit report.
+    */
+    void suite_started(const std::string& suite_name, const std::string& start_time);
+    /**
+    * Records completion of a test case.
+    * @param suite_name Name of the suite.
+    * @param test_name Name of the test case.
+    * @param outcome Outcome of the test case.
+    * @param start_ms Start time in milliseconds since epoch.
+    * @param duration_ms Execution time in milliseconds.
+    * @param failure Failure reason, empty for passed tests.
+    */
+    void test_completed(const std::string& suite_name, const std::string& test_name, test_outcome outcome,
+        unsigned long long start_ms, unsigned duration_ms, const std::string& failure);
+    /**
+    * Returns current wall clock time in milliseconds since epoch.
+    */
+    static unsigned long long now_ms();
+private:
+    result_log(FILE* file);
+    result_log(const result_log&);
+    result_log& operator=(const result_log&);
+    unsigned intern(const std::string& name);
+    void write_buffer();
+    tthread::mutex d_mutex;
+    FILE* d_file;
+    std::map<std::string, unsigned> d_names;
+    std::string d_buffer;
+};
+
+/**
+* Single test case result read from a binary result log.
+* Name pointers stay valid for the lifetime of the reader.
+*/
+struct result_log_entry {
+    const std::string* suite_name;
+    const std::string* test_name;
+    test_outcome outcome;
+    unsigned long long start_ms;
+    unsigned duration_ms;
+    std::string failure;
+};
+
+/**
+* Sequential reader of binary result logs.
+*/
+class result_log_reader {
+public:
+    result_log_reader();
+    ~result_log_reader();
+    /**
+    * Opens log file for reading.
+    * @return true if file was opened and has valid header.
+    */
+    bool open(const std::string& path);
+    /**
+    * Reads next test case result, skipping other records.
+    * @return false at the end of the log.
+    */
+    bool next(result_log_entry& entry);
+    /**
+    * Returns start time recorded for the suite, or empty string if unknown.
+    */
+    const std::string& suite_start_time(const std::string& suite_name) const;
+private:
+    result_log_reader(const result_log_reader&);
+    result_log_reader& operator=(const result_log_reader&);
+    const std::string* name(unsigned id) const;
+    FILE* d_file;
+    std::string d_payload;
+    std::deque<std::string> d_strings;      // stable storage for interned names
+    std::vector<const std::string*> d_ids;  // ids of current session
+    std::map<std::string, std::string> d_suite_start;
+};
+}
+}
+
+#endif // !INC_LIBG2FASTH_RESULT_LOG_H
@@ -0,0 +1,119 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_SIGNAL_GENERATORS_H
+#define INC_LIBG2FASTH_SIGNAL_GENERATORS_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "tinythread.h"
+#include "fast_mutex.h"
+
+namespace g2 {
+namespace fasth {
+
+/**
+* Shapes of generated signals.
+*/
+enum signal_shape {
+    signal_ramp,        // sawtooth from offset to offset + amplitude
+    signal_sine,        // sine around offset
+    signal_noise,       // uniform noise within offset +- amplitude
+    signal_random_walk, // offset plus sum of uniform steps within +- amplitude
+    signal_step,        // offset + amplitude * k for k = 0 .. steps-1, one level per period
+    signal_counter,     // offset increased by amplitude on each read
+    signal_shape_count
+};
+
+/**
+* Parameters of generated signal. Shapes depending on time use period and phase,
+* noise and random walk use seed and give the same sequence for the same seed.
+*/
+struct signal_spec {
+    signal_spec() : shape(signal_sine), offset(0), amplitude(1), period_s(1), phase(0), steps(2), seed(1) {}
+
+    static signal_spec ramp(double offset, double amplitude, double period_s, double phase = 0);
+    static signal_spec sine(double offset, double amplitude, double period_s, double phase = 0);
+    static signal_spec noise(double offset, double amplitude, unsigned seed);
+    static signal_spec random_walk(double start, double max_step, unsigned seed);
+    static signal_spec step(double offset, double height, double period_s, int steps);
+    static signal_spec counter(double start, double increment);
+
+    signal_shape shape;
+    double offset;
+    double amplitude;
+    double period_s;
+    double phase;       // fraction of the period
+    int steps;
+    unsigned seed;
+};
+
+/**
+* Generated signals of G2 variables. Parameters and state of all signals are kept
+* in parallel arrays, a batch is split by shape and each shape is computed by its
+* own loop without branches or calls per value.
+*/
+class signal_bank {
+public:
+    signal_bank();
+
+    /**
+    * Adds signal.
+    * @return Identifier of the signal.
+    */
+    size_t add(const signal_spec& spec);
+    /**
+    * Replaces parameters of the signal and restarts its state.
+    */
+    void assign(size_t id, const signal_spec& spec);
+    /**
+    * Returns seconds since the bank was created, the time signals are evaluated at.
+    */
+    double seconds() const;
+    /**
+    * Computes values of a batch of signals. Noise, random walks and counters advance.
+    * @param ids Signals to compute, a signal may repeat.
+    * @param count Number of signals.
+    * @param t Time in seconds.
+    * @param values Receives values of the signals.
+    */
+    void evaluate(const size_t* ids, size_t count, double t, double* values);
+    /**
+    * Computes value of one signal.
+    */
+    double evaluate(size_t id, double t);
+private:
+    signal_bank(const signal_bank&);
+    signal_bank& operator=(const signal_bank&);
+    void reset(size_t id, const signal_spec& spec);
+
+    std::vector<int> d_shapes;
+    std::vector<double> d_offsets;
+    std::vector<double> d_amplitudes;
+    std::vector<double> d_rates;    // periods per second
+    std::vector<double> d_phases;
+    std::vector<double> d_steps;
+    std::vector<double> d_states;   // position of random walk, value of counter
+    std::vector<unsigned> d_random; // xorshift state
+    std::vector<size_t> d_batch[signal_shape_count]; // positions in the batch by shape
+    unsigned long long d_start_ns;
+    tthread::fast_mutex d_mutex;
+};
+
+/**
+* Converts signal to value of variable. Integers are rounded, logicals are true
+* from 0.5 up and strings get the number formatted.
+*/
+template <typename T>
+T signal_value(double value);
+template <>
+int signal_value<int>(double value);
+template <>
+double signal_value<double>(double value);
+template <>
+bool signal_value<bool>(double value);
+template <>
+std::string signal_value<std::string>(double value);
+}
+}
+
+#endif // !INC_LIBG2FASTH_SIGNAL_GENERATORS_H
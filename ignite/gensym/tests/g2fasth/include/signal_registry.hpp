@@ -0,0 +1,74 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_SIGNAL_REGISTRY_H
+#define INC_LIBG2FASTH_SIGNAL_REGISTRY_H
+
+#include "g2fasth_platform.hpp"
+
+namespace g2 {
+namespace fasth {
+/**
+* Registry of objects flushed from the signal handler, which walks it without locking.
+* Slots are claimed by compare-exchange, so objects registering concurrently get
+* distinct slots. When all slots are taken a block of slots is appended, blocks are
+* never freed. It has no constructor, so a registry with static storage duration is
+* zero-initialized and usable from constructors of other static objects.
+*/
+template <class T>
+struct signal_registry {
+    /**
+    * Registers object, it stays registered until remove() is called.
+    */
+    void add(T* object) {
+        for (block* b = &first; ; b = atomic_load_ptr(&b->next))
+        {
+            for (int i = 0; i < kBlockSize; i++)
+            {
+                if (!atomic_load_ptr(&b->slots[i]) && atomic_compare_exchange_ptr(&b->slots[i], (T*)0, object))
+                    return;
+            }
+            if (!atomic_load_ptr(&b->next))
+            {
+                block* added = new block();
+                if (!atomic_compare_exchange_ptr(&b->next, (block*)0, added))
+                    delete added;
+            }
+        }
+    }
+    void remove(T* object) {
+        for (block* b = &first; b; b = atomic_load_ptr(&b->next))
+        {
+            for (int i = 0; i < kBlockSize; i++)
+            {
+                if (atomic_compare_exchange_ptr(&b->slots[i], object, (T*)0))
+                    return;
+            }
+        }
+    }
+    /**
+    * Calls function with each registered object, also from the signal handler.
+    */
+    template <class F>
+    void for_each(F function) const {
+        for (const block* b = &first; b; b = atomic_load_ptr(&b->next))
+        {
+            for (int i = 0; i < kBlockSize; i++)
+            {
+                T* object = atomic_load_ptr(&b->slots[i]);
+                if (object)
+                    function(object);
+            }
+        }
+    }
+
+    enum { kBlockSize = 16 };
+    // Plain data, so that new block() is zero-initialized
+    struct block {
+        T* volatile slots[kBlockSize];
+        block* volatile next;
+    };
+    block first;
+};
+}
+}
+
+#endif // !INC_LIBG2FASTH_SIGNAL_REGISTRY_H
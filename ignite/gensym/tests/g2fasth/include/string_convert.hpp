@@ -0,0 +1,47 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_STRING_CONVERT_H
+#define INC_LIBG2FASTH_STRING_CONVERT_H
+
+#include <stddef.h>
+
+namespace g2 {
+namespace fasth {
+/**
+* Conversions of ASCII text between narrow, wide and Gensym strings, in which
+* ASCII characters have the same codes, except '~', '@' and '\\' which
+* GSI_CHAR_SET_GENSYM uses as escape characters. These and characters above 127
+* are converted by GSI, so functions converting text report false when they find
+* one and callers fall back to GSI. Functions write into buffers of the caller and allocate nothing.
+* They use AVX2 or SSE2 when the compiler targets them (-mavx2, x64 or
+* /arch:SSE2) and plain loops otherwise. Lengths are in characters and exclude
+* the terminator, which is not written.
+*/
+
+/**
+* Checks if text has only ASCII characters other than the escape characters.
+*/
+bool is_ascii(const char* str, size_t length);
+bool is_ascii(const short* gstr, size_t length);
+
+/**
+* Converts ASCII text, dest receives length characters.
+* @return false if text has other or escape characters, dest is then partly written.
+*/
+bool convert_ascii(const char* str, size_t length, short* dest);
+bool convert_ascii(const short* gstr, size_t length, char* dest);
+bool convert_ascii(const wchar_t* wstr, size_t length, short* dest);
+bool convert_ascii(const short* gstr, size_t length, wchar_t* dest);
+
+/**
+* Returns number of characters of zero-terminated Gensym string.
+*/
+size_t gensym_length(const short* gstr);
+
+/**
+* Returns width of vectors used by conversions in bits, 0 for plain loops.
+*/
+int string_convert_vector_bits();
+}
+}
+
+#endif // !INC_LIBG2FASTH_STRING_CONVERT_H
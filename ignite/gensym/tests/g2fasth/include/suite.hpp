@@ -14,6 +14,9 @@
 #include "g2fasth_typedefs.hpp"
 #include "junit_report.hpp"
 #include "base_suite.hpp"
+#include "result_log.hpp"
+#include "file_sink.hpp"
+#include "metrics.hpp"
 
 namespace g2 {
 namespace fasth {
@@ -41,6 +44,8 @@ private:
 #define G2FASTH_MAX_TIMEOUT      7*24*3600*1000  // 1 week
 // Default timeout for tests
 #define G2FASTH_DEFAULT_TIMEOUT  600*1000        // 10 min
+// Failure reason reported for failed tests
+#define G2FASTH_FAILURE_REASON   "This has failed due to unknow reasons."
 
 template <class T>
 class suite : public base_suite {
@@ -61,13 +66,16 @@ public:
         , d_default_timeout(default_timeout)
         , d_state(not_yet)
         , d_parallel(true)
+        , d_elapsed_ms(0)
+        , d_started_ns(0)
+        , d_ready_reported(0)
     {
         if (d_default_timeout.count() > G2FASTH_MAX_TIMEOUT)
             d_default_timeout = chrono::milliseconds(G2FASTH_MAX_TIMEOUT);
         d_logger.add_output_stream(std::cout, log_level::REGULAR);
         if (!logger_file_path.empty())
         {
-            d_logger.add_output_stream(new std::ofstream(logger_file_path, std::ios_base::app), log_level::VERBOSE);
+            d_logger.add_file_sink(file_sink::open(logger_file_path), log_level::VERBOSE);
         }
     }
     ~suite()
@@ -100,11 +108,31 @@ public:
         d_parallel = parallel;
     }
     /**
+    * Enables binary result log. Results are appended as each test case completes.
+    * Should be called before the suite is executed.
+    * @param result_log_path Path to the binary result log, empty to disable.
+    */
+    void set_result_log(const std::string& result_log_path)
+    {
+        d_result_log = nullptr;
+        if (!result_log_path.empty())
+            d_result_log = result_log::open(result_log_path);
+    }
+    /**
     * This function executes test suite. First it setups test track and then starts execution.
     * @param report_file_name Absolute path of the JUnit report xml, can be empty if report is not to be written
     * @return JUnit report in string format.
     */
     inline std::string execute(std::string report_file_name = "") override {
+        run_suite();
+        return generate_junit_report(report_file_name);
+    }
+    /**
+    * This function executes test suite without generating JUnit report.
+    */
+    void run_suite() override {
+        log_context_scope context(&get_suite_name(), nullptr);
+        G2FASTH_TRACE_SCOPE("suite", get_suite_name());
         int count;
         {
             tthread::lock_guard<tthread::mutex> lg(d_mutex);
@@ -112,11 +140,11 @@ public:
         }
         if (count == 0)
         {
-            d_logger.log(log_level::SILENT, "Setting up test track for test suite : " + get_suite_name());
+            G2FASTH_LOG(d_logger, SILENT, "Setting up test track for test suite : " + get_suite_name());
             setup_test_track();
-            d_logger.log(log_level::SILENT, "Test track setup done for test suite : " + get_suite_name());
+            G2FASTH_LOG(d_logger, SILENT, "Test track setup done for test suite : " + get_suite_name());
         }
-        return start(report_file_name);
+        start();
     }
 
     /**
@@ -206,7 +234,7 @@ public:
         tthread::lock_guard<tthread::mutex> lg(d_mutex);
         std::for_each(d_test_specs.begin(), d_test_specs.end(), [&](std::shared_ptr<test_run_spec<T>> spec) {
             if (spec->is_timeout())
-                spec->complete(test_outcome::fail);
+                spec->time_out();
         });
     }
     /**
@@ -253,6 +281,26 @@ public:
         tthread::lock_guard<tthread::mutex> lg(d_cancel_threads_mutex);
         d_threads_to_cancel.push_back(thread);
     }
+    /**
+    * Called by test run instance when it is completed.
+    * @param test_case_name Name of the test case.
+    * @param outcome Outcome of the test case.
+    * @param elapsed_ms Execution time of the test case.
+    */
+    void test_case_completed(const std::string& test_case_name, test_outcome outcome, int elapsed_ms)
+    {
+        if (!d_result_log)
+            return;
+        unsigned long long end_ms = result_log::now_ms();
+        d_result_log->test_completed(get_suite_name(), test_case_name, outcome, end_ms - elapsed_ms, elapsed_ms,
+            outcome == test_outcome::pass ? std::string() : G2FASTH_FAILURE_REASON);
+    }
+    /**
+    * Returns monotonic time when the suite started executing test cases.
+    */
+    unsigned long long started_ns() const {
+        return d_started_ns;
+    }
 
 protected:
     virtual void before() {};
@@ -264,7 +312,7 @@ protected:
     * @return Handle of cloned test run instance.
     */
     inline test_run_spec<T>& clone(const test_run_spec<T>& instance, const std::string& name) {
-        d_logger.log(log_level::VERBOSE, "Cloning test case " + name + " for execution");
+        G2FASTH_LOG(d_logger, VERBOSE, "Cloning test case " + name + " for execution");
         tthread::lock_guard<tthread::mutex> lg(d_mutex);
         d_test_specs.push_back(instance.clone(name));
         test_run_spec<T>& new_spec = *d_test_specs.back();
@@ -318,9 +366,13 @@ private:
         tthread::lock_guard<tthread::mutex> lg(d_mutex);
         return d_state;
     }
-    inline std::string start(std::string report_file_name) {
+    inline void start() {
+        timing start_timing;
         check_time();
-        d_logger.log(log_level::SILENT, "Starting execution of test suite : " + get_suite_name());
+        d_started_ns = monotonic_ns();
+        G2FASTH_LOG(d_logger, SILENT, "Starting execution of test suite : " + get_suite_name());
+        if (d_result_log)
+            d_result_log->suite_started(get_suite_name(), d_start_time);
         // Execute tests
         bool parallel = d_parallel;
         int concurrency = 16;
@@ -345,18 +397,26 @@ private:
         {
             internal_start();
         }
+        {
+            tthread::lock_guard<tthread::mutex> lg(d_mutex);
+            scheduler_metrics::tests_ready.add(-d_ready_reported);
+            d_ready_reported = 0;
+        }
         extract_result();
         for (auto result = d_results.begin(); result != d_results.end(); ++result)
         {
-            d_logger.log(log_level::REGULAR, "Outcome of " + result->test_case_name() + " is " + test_outcome_str[(int)result->outcome()] + ".");
+            G2FASTH_LOGF(d_logger, REGULAR, "Outcome of %s is %s.", result->test_case_name().c_str(), test_outcome_str[(int)result->outcome()]);
         }
-        d_logger.log(log_level::SILENT, "Done executing test suite : " + get_suite_name());
-        return generate_junit_report(report_file_name);
+        d_elapsed_ms = start_timing.elapsed();
+        G2FASTH_LOG(d_logger, SILENT, "Done executing test suite : " + get_suite_name());
+        d_logger.flush();
     }
     static void s_start_thread_proc(void* p)
     {
+        suite<T>* _this = (suite<T>*)p;
+        log_context_scope context(&_this->get_suite_name(), nullptr);
         try {
-            ((suite<T>*)p)->internal_start();
+            _this->internal_start();
         } catch (...) {}
     }
     void internal_start()
@@ -367,6 +427,8 @@ private:
             auto test_case = get_test_case_to_execute();
             if (test_case)
             {
+                G2FASTH_TRACE_SCOPE("test", test_case->name());
+                metric_gauge_scope busy(scheduler_metrics::busy_workers);
                 before();
                 if (test_case->execute())
                     after();
@@ -387,6 +449,10 @@ private:
             if (spec->state()==test_run_state::not_yet && spec->valid_to_execute())
                 test_cases.push_back(spec);
         });
+        // Test cases left ready after this one is taken wait for a worker
+        long ready = test_cases.size() ? (long)test_cases.size() - 1 : 0;
+        scheduler_metrics::tests_ready.add(ready - d_ready_reported);
+        d_ready_reported = ready;
         if (0 == test_cases.size())
             return nullptr;
         std::shared_ptr<test_run_spec<T>> test_case = test_cases.front();
@@ -405,16 +471,30 @@ private:
     inline std::string generate_junit_report(std::string report_file_name) {
         tthread::lock_guard<tthread::mutex> lg(d_mutex);
         testsuite_data test_suite(d_test_specs.size(), d_start_time);
+        add_testcases(test_suite);
+        return test_suite.to_xml(report_file_name);
+    }
+    void add_to_report(testsuites_data& report) override {
+        tthread::lock_guard<tthread::mutex> lg(d_mutex);
+        int failures = std::count_if(d_test_specs.begin(), d_test_specs.end(), [&](std::shared_ptr<test_run_spec<T>> spec) {
+            return spec->outcome() != test_outcome::pass;
+        });
+        auto test_suite = report.add_testsuite(get_suite_name(), d_test_specs.size(), failures, d_start_time, d_elapsed_ms);
+        add_testcases(*test_suite);
+    }
+    void add_testcases(testsuite_data& test_suite) {
         for (auto it = d_test_specs.begin(); it != d_test_specs.end(); ++it)
         {
             test_run_spec<T>* test_spec = it->get();
             auto test_case = test_suite.add_testcase(get_suite_name() + "." + test_spec->name(), test_spec->name());
             if (test_spec->outcome() != test_outcome::pass)
             {
-                test_case->fail_test_case(test_outcome_str[(int)test_spec->outcome()], "This has failed due to unknow reasons.");
+                test_case->fail_test_case(test_outcome_str[(int)test_spec->outcome()], G2FASTH_FAILURE_REASON);
             }
+            std::string output = test_spec->captured_log();
+            if (!output.empty())
+                test_case->set_system_out(output);
         }
-        return test_suite.to_xml(report_file_name);
     }
     typename std::shared_ptr<test_run_spec<T>> schedule(
             std::function<void(const std::string&)> test_action,
@@ -568,8 +648,12 @@ private:
     test_run_state d_state;
     bool d_parallel;
     std::string d_start_time;
+    int d_elapsed_ms;
+    unsigned long long d_started_ns;
+    long d_ready_reported;      // contribution of this suite to ready tests gauge
+    std::shared_ptr<result_log> d_result_log;
 };
-
+
 }
 }
 
@@ -0,0 +1,132 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_SYMBOL_TABLE_H
+#define INC_LIBG2FASTH_SYMBOL_TABLE_H
+
+#include <stddef.h>
+#include <string>
+#include <gsi_main.h>
+#include "g2fasth_platform.hpp"
+
+namespace g2 {
+namespace fasth {
+/**
+* String held by symbol_table with the forms it is converted to once.
+*/
+struct symbol_entry {
+    volatile long refs;         // interned_string objects referring to the entry
+    size_t hash;
+    symbol_entry* next;         // next entry with the same bucket of hash
+    std::string narrow;
+#if defined(GSI_USE_WIDE_STRING_API)
+    size_t gensym_hash;
+    symbol_entry* gensym_next;  // next entry with the same bucket of gensym_hash
+    std::basic_string<gsi_char> gensym;
+#endif
+};
+
+/**
+* Reference to a string interned in symbol_table. Interning converts the string
+* to the form taken by GSI, which is Gensym string under the wide string API,
+* so values held as interned strings are copied and passed to GSI without any
+* allocation or conversion. Copies share the entry, the entry is dropped from the
+* table with its last reference. The empty string has no entry.
+*/
+class interned_string {
+public:
+    interned_string() : d_entry(nullptr) {}
+    /**
+    * Interns the string.
+    */
+    explicit interned_string(const std::string& str);
+    interned_string(const interned_string& other) : d_entry(other.d_entry) {
+        if (d_entry)
+            atomic_add(&d_entry->refs, 1);
+    }
+    ~interned_string() {
+        if (d_entry)
+            release(d_entry);
+    }
+    interned_string& operator=(const interned_string& other) {
+        if (other.d_entry)
+            atomic_add(&other.d_entry->refs, 1);
+        if (d_entry)
+            release(d_entry);
+        d_entry = other.d_entry;
+        return *this;
+    }
+
+    const std::string& str() const { return d_entry ? d_entry->narrow : empty_string(); }
+    operator const std::string&() const { return str(); }
+    /**
+    * Returns zero-terminated string to pass to gsi_set_str or gsi_set_sym.
+    */
+    gsi_char* gensym() const;
+    size_t size() const { return str().size(); }
+    bool empty() const { return d_entry == nullptr; }
+    bool operator==(const interned_string& other) const { return d_entry == other.d_entry; }
+    bool operator!=(const interned_string& other) const { return d_entry != other.d_entry; }
+private:
+    friend class symbol_table;
+    /**
+    * Takes reference already counted in the entry.
+    */
+    explicit interned_string(symbol_entry* entry) : d_entry(entry) {}
+    static const std::string& empty_string();
+    /**
+    * Drops reference, the last one is dropped under the lock of the table,
+    * so that the entry is not found meanwhile.
+    */
+    static void release(symbol_entry* entry) {
+        for (;;)
+        {
+            long refs = atomic_load(&entry->refs);
+            if (refs <= 1)
+                break;
+            if (atomic_compare_exchange(&entry->refs, refs, refs - 1))
+                return;
+        }
+        release_last(entry);
+    }
+    static void release_last(symbol_entry* entry);
+
+    symbol_entry* d_entry;
+};
+
+inline gsi_char* interned_string::gensym() const
+{
+#if defined(GSI_USE_WIDE_STRING_API)
+    static gsi_char empty = 0;
+    return d_entry ? const_cast<gsi_char*>(d_entry->gensym.c_str()) : &empty;
+#else
+    return const_cast<gsi_char*>(str().c_str());
+#endif
+}
+
+/**
+* Table of interned strings shared by the process. Strings and symbols repeat,
+* so a string is converted only when it is interned the first time while other
+* references to it are alive.
+*/
+class symbol_table {
+public:
+    /**
+    * Returns interned string equal to the string, interning it if needed.
+    */
+    static interned_string intern(const std::string& str) {
+        return intern(str.c_str(), str.size());
+    }
+    static interned_string intern(const char* str, size_t length);
+    /**
+    * Interns zero-terminated string in the form taken by GSI, e.g. returned by
+    * str_of. No conversion is done when the string is interned already.
+    */
+    static interned_string intern_gensym(const gsi_char* gstr);
+    /**
+    * Returns number of interned strings.
+    */
+    static size_t size();
+};
+}
+}
+
+#endif // !INC_LIBG2FASTH_SYMBOL_TABLE_H
@@ -6,6 +6,9 @@
 #include <algorithm>
 #include <assert.h>
 #include "base_suite.hpp"
+#include "junit_report.hpp"
+#include "test_run_spec.hpp"
+#include "metrics.hpp"
 #include "tinythread.h"
 #include <ctime>
 
@@ -59,10 +62,12 @@ public:
         internal_schedule_suite(suite_to_run, suite_after, true);
     }
     /**
-    * This function executes all test suites in its queue.
-    * @param parallel Flag that specifies how to run suites: sequentially or concurrently.
+    * This function executes all test suites in its queue and generates
+    * single JUnit report containing results of all of them.
+    * @return Aggregated JUnit report in string format.
     */
-    inline void execute() {
+    inline std::string execute() {
+        timing run_timing;
         auto bg_count = std::count_if(d_suites.begin(), d_suites.end(), [&](suite_pair sp) { return sp.background; });
         int concurrency = d_concurrency;
         if (bg_count < concurrency)
@@ -79,6 +84,15 @@ public:
             threads.front()->join();
             threads.pop_front();
         }
+        return generate_junit_report(run_timing.elapsed());
+    }
+    /**
+    * Sets path of aggregated JUnit report written by execute().
+    * @param report_file_name Absolute path of the JUnit report xml, can be empty if report is not to be written.
+    */
+    void set_report_file(const std::string& report_file_name)
+    {
+        d_report_file_name = report_file_name;
     }
     void set_concurrency(unsigned new_concurrency)
     {
@@ -124,7 +138,11 @@ private:
             std::shared_ptr<base_suite> suite;
             while (suite = get_suite_to_run(background))
             {
-                suite->execute();
+                {
+                    metric_gauge_scope running(scheduler_metrics::running_suites);
+                    metric_timer timer(scheduler_metrics::suite_duration);
+                    suite->run_suite();
+                }
                 suite->set_state(done);
             }
             if (are_all_suites_completed(background))
@@ -155,6 +173,15 @@ private:
         suite->set_state(ongoing);
         return suite;
     }
+    std::string generate_junit_report(int elapsed_ms)
+    {
+        testsuites_data report;
+        std::for_each(d_suites.begin(), d_suites.end(), [&](suite_pair sp) {
+            sp.first->add_to_report(report);
+        });
+        report.set_elapsed(elapsed_ms);
+        return report.to_xml(d_report_file_name);
+    }
     bool are_all_suites_completed(bool background)
     {
         tthread::lock_guard<tthread::mutex> lg(d_mutex);
@@ -169,6 +196,7 @@ private:
     unsigned d_max_concurrency;
     test_order d_order;
     tthread::chrono::milliseconds d_sleep_quantum;
+    std::string d_report_file_name;
 };
 }
 }
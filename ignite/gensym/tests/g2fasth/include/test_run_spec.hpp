@@ -14,6 +14,8 @@
 #include "g2fasth_typedefs.hpp"
 #include "test_case_graph.hpp"
 #include "logger.hpp"
+#include "binary_log.hpp"
+#include "metrics.hpp"
 #include "tinythread.h"
 #include <ctime>
 
@@ -59,6 +61,7 @@ struct async_run_data
     std::function<void(const std::string&)> func_obj;
     typename test_helper<T>::pmf_t user_func_ptr;
     int interval;
+    bool continuation;
 };
 /**
 * This class is responsible storing relationships with other tests.
@@ -82,6 +85,9 @@ public :
         , d_timeout(0)
         , d_state(test_run_state::not_yet)
         , d_outcome(test_outcome::fail)
+        , d_ready_ns(0)
+        , d_started_ns(0)
+        , d_completed_ns(0)
     {
     }
     /**
@@ -103,6 +109,9 @@ public :
         , d_timeout(timeout)
         , d_state(test_run_state::not_yet)
         , d_outcome(test_outcome::fail)
+        , d_ready_ns(0)
+        , d_started_ns(0)
+        , d_completed_ns(0)
     {
     }
     
@@ -275,16 +284,22 @@ public :
                 data->func_obj = d_action;
                 data->user_func_ptr = ptr_test_case;
                 data->interval = 0;
+                data->continuation = false;
                 timeout = d_timeout;
                 //d_state = test_run_state::ongoing;
                 d_start.start();
+                d_started_ns = monotonic_ns();
+                scheduler_metrics::tests_started.add();
+                if (d_ready_ns && d_started_ns > d_ready_ns)
+                    scheduler_metrics::start_delay.record(d_started_ns - d_ready_ns);
+                d_suite->get_logger().begin_capture(d_capture);
             }
             else
             {
                 int elapsed;
                 if (is_timeout(false, &elapsed))
                 {
-                    internal_complete(test_outcome::fail);
+                    internal_time_out();
                     return true;
                 }
                 timeout = chrono::milliseconds(d_timeout.count() - elapsed);
@@ -292,6 +307,7 @@ public :
                     data->func_obj = d_action;
                 if (!data->user_func_ptr)
                     data->user_func_ptr = ptr_test_case;
+                data->continuation = true;
             }
             data->test_case = this;
             // Run test case body in separate thread to have possibility of time measurement
@@ -311,12 +327,12 @@ public :
                     // The test called complete_test_case() before timed out. So mean test timed in.
                     timed_out = false;
                 else
-                    internal_complete(test_outcome::fail);
+                    internal_time_out();
             }
             test_done = d_state == test_run_state::done;
         }
         if (timed_out)
-            d_suite->get_logger().log(log_level::REGULAR, "Test case '" + name() + "' is timed out");
+            G2FASTH_LOG(d_suite->get_logger(), REGULAR, "Test case '" + name() + "' is timed out");
         return test_done;
     }
     /**
@@ -353,16 +369,18 @@ public :
 
     bool valid_to_execute() {
         tthread::lock_guard<tthread::mutex> lg(d_mutex);
+        // Test case is ready since the suite started or since the last test case it depends on completed
+        d_ready_ns = d_suite->started_ns();
         // If current test case depends on some other test, and other test case is not done, return.
         // We will try to execute this again in next iteration.
-        if (d_after != nullptr && d_suite->get_spec(d_after).state() != test_run_state::done)
+        if (d_after != nullptr && !is_dependency_done(d_suite->get_spec(d_after)))
         {
             return false;
         }
         else if (d_after_run != nullptr)
         {
             auto ptr_test_case = d_after_run->get_ptr_test_case();
-            if (d_suite->get_spec(ptr_test_case).state() != test_run_state::done)
+            if (!is_dependency_done(d_suite->get_spec(ptr_test_case)))
             {
                 return false;
             }
@@ -417,6 +435,27 @@ public :
         tthread::lock_guard<tthread::mutex> lg(d_mutex);
         internal_complete(outcome);
     }
+    /**
+    * This method fails the test because it is timed out.
+    */
+    void time_out() {
+        tthread::lock_guard<tthread::mutex> lg(d_mutex);
+        internal_time_out();
+    }
+    /**
+    * Returns monotonic time of test completion, 0 if the test is not done.
+    */
+    unsigned long long completed_ns() {
+        tthread::lock_guard<tthread::mutex> lg(d_mutex);
+        return d_completed_ns;
+    }
+
+    /**
+    * Returns messages of the test case captured for the report.
+    */
+    std::string captured_log() {
+        return d_capture.text();
+    }
 
     void stop_timer(typename test_helper<T>::pmf_t func_ptr)
     {
@@ -440,12 +479,39 @@ private:
     void internal_complete(test_outcome outcome) {
         if (d_state == test_run_state::done)
             return;
+        int elapsed_ms = d_state == test_run_state::ongoing ? d_start.elapsed() : 0;
+        d_completed_ns = monotonic_ns();
+        if (d_started_ns)
+            scheduler_metrics::test_duration.record(d_completed_ns - d_started_ns);
+        if (outcome == test_outcome::pass)
+            scheduler_metrics::tests_passed.add();
+        else
+            scheduler_metrics::tests_failed.add();
         d_outcome = outcome;
         d_state = test_run_state::done;
+        if (d_suite)
+        {
+            d_suite->get_logger().end_capture(d_capture, outcome == test_outcome::pass);
+            d_suite->test_case_completed(d_name, outcome, elapsed_ms);
+        }
     };
+    void internal_time_out() {
+        if (d_state == test_run_state::done)
+            return;
+        scheduler_metrics::tests_timed_out.add();
+        internal_complete(test_outcome::fail);
+    }
+    bool is_dependency_done(test_run_spec<T>& dependency) {
+        if (dependency.state() != test_run_state::done)
+            return false;
+        unsigned long long completed = dependency.completed_ns();
+        if (completed > d_ready_ns)
+            d_ready_ns = completed;
+        return true;
+    }
     bool validate_after_success_of(test_run_spec<T>& d_after_success_of_test_case) {
         // and other test case is not done or yet to start, return.
-        if (d_after_success_of_test_case.state() != test_run_state::done)
+        if (!is_dependency_done(d_after_success_of_test_case))
             return false;
         // and other test case has failed, we fail this test case too and return.
         if (d_after_success_of_test_case.outcome() == test_outcome::fail)
@@ -461,6 +527,7 @@ private:
         tthread::thread::make_cancel_safe();
         std::unique_ptr<async_run_data<T>> data((async_run_data<T>*)p);
         test_run_spec* _this = data->test_case;
+        log_context_scope context(&_this->d_suite->get_suite_name(), &data->test_case_name, &_this->d_capture);
         try {
             int interval = data->interval;
             if (interval > 0)
@@ -482,12 +549,17 @@ private:
                     if (stop)
                         break;
                     timing start;
+                    G2FASTH_TRACE_SCOPE("timer", data->test_case_name);
+                    scheduler_metrics::timer_ticks.add();
                     data->func_obj(data->test_case_name);
                     action_elapsed_ms = start.elapsed();
                 } while(true);
             }
             else
             {   // simple action call
+                G2FASTH_TRACE_SCOPE(data->continuation ? "async" : "action", data->test_case_name);
+                if (data->continuation)
+                    scheduler_metrics::continuations.add();
                 data->func_obj(data->test_case_name);
             }
         }
@@ -511,7 +583,11 @@ private:
     suite<T>* d_suite;
     chrono::milliseconds d_timeout;
     timing d_start;
+    unsigned long long d_ready_ns;      // monotonic times for scheduler metrics
+    unsigned long long d_started_ns;
+    unsigned long long d_completed_ns;
     std::list<typename test_helper<T>::pmf_t> d_stop_timers;
+    log_capture d_capture;
 };
 
 }
@@ -0,0 +1,169 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_TIME_SERIES_REPLAY_H
+#define INC_LIBG2FASTH_TIME_SERIES_REPLAY_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "libgsi.hpp"
+#include "mapped_file.hpp"
+#include "tinythread.h"
+
+namespace g2 {
+namespace fasth {
+/**
+* Writes recording of (time, variable, value) rows replayed by time_series_replay.
+* The file starts with a header, rows of fixed size follow in order of time and
+* the variable table is at the end:
+*   header:   "G2FRPLY1", u32 variable count, u32 row size, u64 row count,
+*             u64 offset of rows, u64 offset of variable table
+*   row:      i64 time in ns, f64 value, u32 variable, u32 reserved
+*   variable: u8 type tag, str name
+* All integers are little-endian, see binary_io.
+*/
+class replay_writer {
+public:
+    replay_writer();
+    ~replay_writer();
+    /**
+    * Creates the file, replacing existing one.
+    * @return false if the file could not be created.
+    */
+    bool open(const std::string& path);
+    /**
+    * Adds variable to the recording.
+    * @return Variable number to be passed to write().
+    */
+    unsigned add_variable(const std::string& name, g2_type type);
+    /**
+    * Appends row.
+    * @return false if the row is older than the previous one or the variable was not added.
+    */
+    bool write(long long time_ns, unsigned variable, double value);
+    /**
+    * Writes variable table and header and closes the file.
+    * @return false if writing failed.
+    */
+    bool close();
+private:
+    replay_writer(const replay_writer&);
+    replay_writer& operator=(const replay_writer&);
+    void write_buffer();
+    FILE* d_file;
+    bool d_ok;
+    std::string d_buffer;
+    std::vector<std::pair<std::string, g2_type>> d_variables;
+    unsigned long long d_rows;
+    long long d_last_ns;
+};
+
+/**
+* Options of time_series_replay::play.
+*/
+struct replay_options {
+    replay_options() : speed(1), loop(false), temp_reads(0), update_g2(false) {}
+    double speed;       // 1 keeps recorded pace, 2 plays twice as fast, 0 as fast as possible
+    bool loop;          // starts over at the end of the recording
+    int temp_reads;     // 0 assigns default values, otherwise temporary values for so many reads
+    bool update_g2;     // requests unsolicited update of each assigned variable
+};
+
+/**
+* Replays recording written by replay_writer into libgsi variables. The file is
+* memory-mapped and read sequentially, so recordings larger than memory are played
+* without loading them. Seek is a binary search over rows of fixed size.
+*/
+class time_series_replay {
+public:
+    explicit time_series_replay(libgsi& gsi);
+    ~time_series_replay();
+    /**
+    * Maps recording and moves to its first row, closing previous one.
+    * @return false if the file could not be mapped or is not a valid recording.
+    */
+    bool open(const std::string& path);
+    /**
+    * Stops playing and unmaps the recording.
+    */
+    void close();
+
+    size_t variable_count() const { return d_variables.size(); }
+    const std::string& variable_name(size_t variable) const { return d_variables[variable].name; }
+    g2_type variable_type(size_t variable) const { return d_variables[variable].type; }
+    unsigned long long row_count() const { return d_row_count; }
+    /**
+    * Returns time of the first and of the last row, 0 for empty recording.
+    */
+    long long start_ns() const;
+    long long end_ns() const;
+
+    /**
+    * Declares variables of the recording which are not declared yet, with recorded
+    * types. Variables are looked up once here, rows are assigned without lookups.
+    * Called by play and play_until if needed.
+    */
+    void bind();
+    /**
+    * Moves to the first row at or after given time. Not to be called while playing
+    * on another thread.
+    */
+    void seek(long long time_ns);
+    /**
+    * Returns time of the next row, or end_ns() after the last row.
+    */
+    long long position_ns() const;
+    /**
+    * Assigns rows up to and including given time of the recording, without waiting.
+    * @return Number of assigned rows.
+    */
+    unsigned long long play_until(long long time_ns, const replay_options& options = replay_options());
+    /**
+    * Assigns rows from the current position at the pace given by options, on the
+    * calling thread. Returns at the end of recording if it does not loop, or after stop().
+    * @return Number of assigned rows.
+    */
+    unsigned long long play(const replay_options& options);
+    /**
+    * Starts play on a new thread.
+    * @return false if already playing.
+    */
+    bool start(const replay_options& options);
+    /**
+    * Stops play and waits for the thread started by start().
+    */
+    void stop();
+    /**
+    * Returns rows assigned since the recording was opened. Updated in blocks while playing.
+    */
+    unsigned long long rows_played() const;
+private:
+    time_series_replay(const time_series_replay&);
+    time_series_replay& operator=(const time_series_replay&);
+    struct variable_info {
+        std::string name;
+        g2_type type;
+        g2_variable* variable;
+    };
+    unsigned long long run(const replay_options& options);
+    void apply(const char* row, const replay_options& options);
+    long long row_time(unsigned long long row) const;
+    void add_played(unsigned long long rows);
+    static void play_thread(void* arg);
+
+    libgsi& d_gsi;
+    mapped_file d_file;
+    const char* d_rows;
+    unsigned long long d_row_count;
+    unsigned long long d_next;
+    std::vector<variable_info> d_variables;
+    bool d_bound;
+    volatile long d_stop;
+    tthread::thread* d_thread;
+    replay_options d_thread_options;
+    mutable tthread::fast_mutex d_played_mutex;
+    unsigned long long d_played;
+};
+}
+}
+
+#endif // !INC_LIBG2FASTH_TIME_SERIES_REPLAY_H
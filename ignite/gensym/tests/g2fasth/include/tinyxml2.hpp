@@ -1962,6 +1962,174 @@ private:
 };
 
 
+/**
+    XMLReader is a forward-only pull parser. It walks the document and
+    reports elements, attributes and text one event at a time, without
+    creating nodes and without modifying the input. So it can run in place
+    over read-only memory, such as a memory-mapped file.
+
+    @verbatim
+    XMLReader reader;
+    reader.SetBuffer( data, size );
+    XMLReader::Event event;
+    while ( (event = reader.Next()) != XMLReader::END_DOCUMENT && event != XMLReader::PARSE_ERROR ) {
+        if ( event == XMLReader::START_ELEMENT && reader.Name().Equals( "skip" ) ) {
+            reader.SkipSubtree();
+        }
+    }
+    @endverbatim
+
+    Names and values are spans into the input. They are not null-terminated
+    and are raw: DecodedValue() processes entities and newlines the way the
+    DOM parser does. Empty elements are reported as START_ELEMENT followed by
+    END_ELEMENT. Comments, declarations, DOCTYPE and processing instructions
+    are skipped, whitespace-only text is not reported and CDATA is reported
+    as TEXT.
+
+    Input can also be pulled in chunks with SetSource(). The reader then keeps
+    a window of the input which grows to hold the largest single tag or text,
+    and spans stay valid only until the next call to Next() or SkipSubtree().
+*/
+class XMLReader
+{
+public:
+    enum Event {
+        START_ELEMENT,
+        ATTRIBUTE,
+        TEXT,
+        END_ELEMENT,
+        END_DOCUMENT,
+        PARSE_ERROR
+    };
+
+    /// Part of the input, not null-terminated.
+    struct Span {
+        const char* start;
+        const char* end;
+
+        size_t Length() const {
+            return end - start;
+        }
+        bool Equals( const char* str ) const {
+            size_t len = strlen( str );
+            return Length() == len && memcmp( start, str, len ) == 0;
+        }
+        bool StartsWith( const char* str ) const {
+            size_t len = strlen( str );
+            return Length() >= len && memcmp( start, str, len ) == 0;
+        }
+    };
+
+    /** Reads more input for SetSource(). Returns the number of bytes
+        placed in the buffer, 0 at the end of input.
+    */
+    typedef size_t (*ReadCallback)( void* userData, char* buffer, size_t size );
+
+    XMLReader();
+    ~XMLReader();
+
+    /// Reads the document held in memory, which stays valid while reading.
+    void SetBuffer( const char* data, size_t size );
+    /// Reads the document in chunks of at least chunkSize bytes.
+    void SetSource( ReadCallback read, void* userData, size_t chunkSize = 64*1024 );
+
+    /// Reads the next event.
+    Event Next();
+
+    Event CurrentEvent() const {
+        return _event;
+    }
+    /// Name of the element or the attribute.
+    const Span& Name() const {
+        return _name;
+    }
+    /// Raw text or attribute value.
+    const Span& Value() const {
+        return _value;
+    }
+    /// Text or attribute value with entities and newlines processed.
+    const char* DecodedValue();
+    /// True if the current TEXT is a CDATA section.
+    bool CData() const {
+        return _cdata;
+    }
+    /// True if the current element was written as <element/>.
+    bool IsEmptyElement() const {
+        return _emptyTag;
+    }
+    /// Nesting level of the current element, 1 for the root element.
+    int Depth() const {
+        return _stack.Size();
+    }
+
+    /** Skips the rest of the element whose START_ELEMENT or ATTRIBUTE was
+        just read, up to and including its END_ELEMENT. Content is only
+        scanned for tags, attributes and text are not processed.
+        Returns false on parse error.
+    */
+    bool SkipSubtree();
+
+    XMLError ErrorID() const {
+        return _errorID;
+    }
+    /// Offset of the position where the error was detected.
+    size_t ErrorOffset() const {
+        return _errorOffset;
+    }
+
+private:
+    XMLReader( const XMLReader& );	// not supported
+    void operator=( const XMLReader& );	// not supported
+
+    void Reset();
+    bool Fill();
+    bool Need( size_t count );
+    bool Find( const char* pattern, size_t from, size_t* at );
+    bool ScanName( size_t from, size_t* end, unsigned* hash );
+    bool FindTagEnd( size_t from, size_t* at );
+    bool ReadMarkup();
+    bool ReadStartTag();
+    bool ReadEndTag();
+    bool ReadAttribute();
+    void LeaveTag();
+    Event SetError( XMLError error, const char* p );
+
+    enum State {
+        CONTENT,
+        IN_TAG,
+        AFTER_EMPTY_TAG,
+        FINISHED
+    };
+
+    State		_state;
+    Event		_event;
+    Span		_name;
+    Span		_value;
+    Span		_element;	// name of the current start tag
+    bool		_cdata;
+    bool		_emptyTag;
+    bool		_started;
+    const char*	_begin;		// start of the buffer or the window
+    const char*	_p;
+    const char*	_end;
+    const char*	_attr;		// next attribute of the current start tag
+    const char*	_tagEnd;	// '>' or "/>" of the current start tag
+    XMLError	_errorID;
+    size_t		_errorOffset;
+    size_t		_consumed;	// bytes of input before _begin
+
+    ReadCallback	_read;
+    void*			_userData;
+    char*			_window;
+    size_t			_capacity;
+    size_t			_chunkSize;
+    bool			_eof;
+
+    DynArray< unsigned, 16 > _stack;	// hashes of open element names
+    DynArray< char, 64 > _decoded;
+};
+
+
 }	// tinyxml2
 
 
@@ -0,0 +1,102 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_TRACE_H
+#define INC_LIBG2FASTH_TRACE_H
+
+#include <string>
+#include "g2fasth_platform.hpp"
+
+namespace g2 {
+namespace fasth {
+/**
+* Records timeline of suites, test cases, asynchronous continuations, timer ticks
+* and GSI callbacks, and exports it as Chrome trace-event JSON, which can be opened
+* in chrome://tracing or Perfetto.
+* Each thread appends events to its own buffer without locking. Recording is off
+* by default, so instrumented code costs one flag check.
+*/
+class trace_recorder {
+public:
+    /**
+    * Starts recording.
+    * @param path File the trace is written to at process exit, empty to write it explicitly.
+    * @param max_events Number of events kept across all threads, later ones are dropped.
+    */
+    static void start(const std::string& path = "", size_t max_events = 1 << 20);
+    /**
+    * Stops recording. Recorded events are kept.
+    */
+    static void stop();
+    static bool is_enabled() { return atomic_load(&s_enabled) != 0; }
+    /**
+    * Writes recorded events as Chrome trace-event JSON.
+    * @return false if the file could not be written.
+    */
+    static bool write_json(const std::string& path);
+    /**
+    * Discards recorded events. Should not be called while other threads record.
+    */
+    static void clear();
+    /**
+    * Records complete event of the calling thread.
+    * @param category Event category, string literal.
+    * @param name Event name, string literal.
+    * @param start_ns Start time from monotonic_ns().
+    */
+    static void record(const char* category, const char* name, unsigned long long start_ns);
+    /**
+    * Records complete event with name copied from the string.
+    */
+    static void record(const char* category, const std::string& name, unsigned long long start_ns);
+    /**
+    * Returns number of events dropped because the limit of events was reached.
+    */
+    static long dropped();
+    /**
+    * Returns number of events the thread buffers can hold, which bounds their memory.
+    */
+    static size_t capacity();
+private:
+    static volatile long s_enabled;
+};
+
+/**
+* Records time from its construction to destruction as a trace event.
+*/
+class trace_scope {
+public:
+    trace_scope(const char* category, const char* name)
+        : d_category(category), d_name(name), d_dynamic_name(nullptr)
+        , d_start(trace_recorder::is_enabled() ? monotonic_ns() : 0) {
+    }
+    trace_scope(const char* category, const std::string& name)
+        : d_category(category), d_name(nullptr), d_dynamic_name(&name)
+        , d_start(trace_recorder::is_enabled() ? monotonic_ns() : 0) {
+    }
+    ~trace_scope() {
+        if (!d_start)
+            return;
+        if (d_name)
+            trace_recorder::record(d_category, d_name, d_start);
+        else
+            trace_recorder::record(d_category, *d_dynamic_name, d_start);
+    }
+private:
+    trace_scope(const trace_scope&);
+    trace_scope& operator=(const trace_scope&);
+    const char* d_category;
+    const char* d_name;
+    const std::string* d_dynamic_name;  // must outlive the scope
+    unsigned long long d_start;
+};
+}
+}
+
+/**
+* Records the enclosing scope as trace event. Name is string literal or std::string.
+*/
+#define G2FASTH_TRACE_CONCAT2(a, b) a##b
+#define G2FASTH_TRACE_CONCAT(a, b) G2FASTH_TRACE_CONCAT2(a, b)
+#define G2FASTH_TRACE_SCOPE(category, name) \
+    g2::fasth::trace_scope G2FASTH_TRACE_CONCAT(__trace_scope_, __LINE__)(category, name)
+
+#endif // !INC_LIBG2FASTH_TRACE_H
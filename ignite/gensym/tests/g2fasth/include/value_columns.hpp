@@ -0,0 +1,280 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_VALUE_COLUMNS_H
+#define INC_LIBG2FASTH_VALUE_COLUMNS_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "tinythread.h"
+#include "fast_mutex.h"
+#include "g2fasth_platform.hpp"
+#include "signal_generators.hpp"
+#include "symbol_table.hpp"
+
+namespace g2 {
+namespace fasth {
+
+/**
+* Value of G2 variable which is not stored in a column, e.g. a copy returned to tests.
+*/
+template <typename T>
+struct value_slot {
+    value_slot() : def_value(), cur_value(), cur_count(0), has_def_value(false) {}
+    /**
+    * Takes next value, the temporary one first and the default one after it.
+    * @return false if there is no value, so the handler has to provide it.
+    */
+    bool next(T& out) {
+        if (cur_count) {
+            --cur_count;
+            out = cur_value;
+            return true;
+        }
+        if (has_def_value) {
+            out = def_value;
+            return true;
+        }
+        return false;
+    }
+    T def_value;
+    T cur_value;
+    int cur_count;
+    bool has_def_value;
+};
+
+/**
+* Values of G2 variables of one type. Each variable owns a slot, slots are kept in
+* chunks of parallel arrays, so reading a batch of variables touches only counts,
+* flags and values. Each chunk has its own lock, a batch takes it once per run of
+* slots in the chunk, so writers of other chunks never wait for it. Table of chunks
+* is replaced rather than grown in place, so slots are found without a lock.
+*/
+template <typename T>
+class value_column {
+public:
+    value_column() : d_table(new chunk*[kInitialChunks]), d_chunk_count(0), d_capacity(kInitialChunks), d_size(0) {}
+    ~value_column() {
+        for (size_t i = 0; i < d_chunk_count; i++)
+            delete d_table[i];
+        delete[] d_table;
+        for (size_t i = 0; i < d_previous_tables.size(); i++)
+            delete[] d_previous_tables[i];
+    }
+
+    /**
+    * Allocates slot without value. Slots of released variables are reused.
+    * @param has_handler Whether the variable has a handler providing values
+    * when it has neither temporary nor default value.
+    */
+    size_t add(bool has_handler) {
+        size_t slot;
+        {
+            tthread::lock_guard<tthread::fast_mutex> guard(d_mutex);
+            if (!d_free.empty())
+            {
+                slot = d_free.back();
+                d_free.pop_back();
+            }
+            else
+            {
+                slot = d_size++;
+                if (chunk_of(slot) == d_chunk_count)
+                    add_chunk();
+            }
+        }
+        chunk& c = chunk_at(slot);
+        tthread::lock_guard<tthread::fast_mutex> guard(c.mutex);
+        size_t i = index_of(slot);
+        c.counts[i] = 0;
+        c.flags[i] = has_handler ? kHasHandler : 0;
+        c.cur[i] = T();
+        c.def[i] = T();
+        return slot;
+    }
+    /**
+    * Frees slot, its values are dropped.
+    */
+    void release(size_t slot) {
+        {
+            chunk& c = chunk_at(slot);
+            tthread::lock_guard<tthread::fast_mutex> guard(c.mutex);
+            size_t i = index_of(slot);
+            c.counts[i] = 0;
+            c.flags[i] = 0;
+            c.cur[i] = T();
+            c.def[i] = T();
+        }
+        tthread::lock_guard<tthread::fast_mutex> guard(d_mutex);
+        d_free.push_back(slot);
+    }
+
+    /**
+    * Marks slot as having a handler or a signal, which provides values when the
+    * slot has neither temporary nor default value.
+    */
+    void set_has_handler(size_t slot) {
+        chunk& c = chunk_at(slot);
+        tthread::lock_guard<tthread::fast_mutex> guard(c.mutex);
+        c.flags[index_of(slot)] |= kHasHandler;
+    }
+
+    void assign_def_value(size_t slot, const T& value) {
+        chunk& c = chunk_at(slot);
+        tthread::lock_guard<tthread::fast_mutex> guard(c.mutex);
+        c.def[index_of(slot)] = value;
+        c.flags[index_of(slot)] |= kHasDefault;
+    }
+    void assign_temp_value(size_t slot, const T& value, int count) {
+        chunk& c = chunk_at(slot);
+        tthread::lock_guard<tthread::fast_mutex> guard(c.mutex);
+        c.cur[index_of(slot)] = value;
+        c.counts[index_of(slot)] = count;
+    }
+    /**
+    * Takes next value of the slot, see value_slot::next. Slot without values and
+    * without handler gets the empty value.
+    */
+    bool next(size_t slot, T& out) {
+        chunk& c = chunk_at(slot);
+        tthread::lock_guard<tthread::fast_mutex> guard(c.mutex);
+        return take(c, index_of(slot), out);
+    }
+    /**
+    * Copies values of the slot without taking any.
+    */
+    void load(size_t slot, value_slot<T>& out) const {
+        chunk& c = chunk_at(slot);
+        tthread::lock_guard<tthread::fast_mutex> guard(c.mutex);
+        size_t i = index_of(slot);
+        out.def_value = c.def[i];
+        out.cur_value = c.cur[i];
+        out.cur_count = c.counts[i];
+        out.has_def_value = (c.flags[i] & kHasDefault) != 0;
+    }
+    /**
+    * Takes next values of a batch of slots, locking chunk of each run of slots once.
+    * @param slots Slots to read.
+    * @param count Number of slots.
+    * @param values Receives value of each slot, unless the handler has to provide it.
+    * @param resolved Set to 1 for slots which had a value, 0 for slots needing the handler.
+    * @return Number of resolved slots.
+    */
+    size_t resolve(const size_t* slots, size_t count, T* values, unsigned char* resolved) {
+        size_t found = 0;
+        chunk* locked = nullptr;
+        for (size_t n = 0; n < count; n++)
+        {
+            chunk& c = chunk_at(slots[n]);
+            if (&c != locked)
+            {
+                if (locked)
+                    locked->mutex.unlock();
+                c.mutex.lock();
+                locked = &c;
+            }
+            resolved[n] = take(c, index_of(slots[n]), values[n]);
+            found += resolved[n];
+        }
+        if (locked)
+            locked->mutex.unlock();
+        return found;
+    }
+private:
+    value_column(const value_column&);
+    value_column& operator=(const value_column&);
+
+    enum { kChunkBits = 10, kChunkSize = 1 << kChunkBits, kInitialChunks = 16 };
+    enum { kHasDefault = 1, kHasHandler = 2 };
+    struct chunk {
+        tthread::fast_mutex mutex;
+        int counts[kChunkSize];
+        unsigned char flags[kChunkSize];
+        T cur[kChunkSize];
+        T def[kChunkSize];
+    };
+    static size_t chunk_of(size_t slot) { return slot >> kChunkBits; }
+    static size_t index_of(size_t slot) { return slot & (kChunkSize - 1); }
+    chunk& chunk_at(size_t slot) const { return *atomic_load_ptr(&d_table)[chunk_of(slot)]; }
+    /**
+    * Adds chunk under d_mutex. A full table is copied to a larger one, previous
+    * tables are kept until the column is destroyed, as readers may still use them.
+    */
+    void add_chunk() {
+        if (d_chunk_count == d_capacity)
+        {
+            chunk** previous = d_table;
+            chunk** table = new chunk*[d_capacity * 2];
+            for (size_t i = 0; i < d_chunk_count; i++)
+                table[i] = previous[i];
+            d_previous_tables.push_back(previous);
+            atomic_store_ptr(&d_table, table);
+            d_capacity *= 2;
+        }
+        // Slots of the chunk are handed out after it is published
+        atomic_store_ptr(&d_table[d_chunk_count], new chunk);
+        d_chunk_count++;
+    }
+    static bool take(chunk& c, size_t i, T& out) {
+        if (c.counts[i]) {
+            --c.counts[i];
+            out = c.cur[i];
+            return true;
+        }
+        if (c.flags[i] & kHasDefault) {
+            out = c.def[i];
+            return true;
+        }
+        if (c.flags[i] & kHasHandler)
+            return false;
+        out = T();
+        return true;
+    }
+
+    chunk** volatile d_table;
+    size_t d_chunk_count;
+    size_t d_capacity;
+    std::vector<chunk**> d_previous_tables;
+    std::vector<size_t> d_free;
+    size_t d_size;
+    tthread::fast_mutex d_mutex; // guards free slots and adding chunks
+};
+
+/**
+* Type of column values of variables with values of type T. Strings are interned,
+* so that taking a value copies no characters.
+*/
+template <typename T>
+struct column_value {
+    typedef T type;
+};
+template <>
+struct column_value<std::string> {
+    typedef interned_string type;
+};
+
+/**
+* Columns of all supported value types and signals generating values.
+*/
+struct value_columns {
+    template <typename T>
+    value_column<T>& column();
+
+    value_column<int> integers;
+    value_column<double> floats;
+    value_column<bool> logicals;
+    value_column<interned_string> strings;  // strings and symbols
+    signal_bank signals;
+};
+
+template <>
+inline value_column<int>& value_columns::column<int>() { return integers; }
+template <>
+inline value_column<double>& value_columns::column<double>() { return floats; }
+template <>
+inline value_column<bool>& value_columns::column<bool>() { return logicals; }
+template <>
+inline value_column<interned_string>& value_columns::column<interned_string>() { return strings; }
+}
+}
+
+#endif // !INC_LIBG2FASTH_VALUE_COLUMNS_H
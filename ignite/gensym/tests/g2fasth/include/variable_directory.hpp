@@ -0,0 +1,160 @@
+#pragma once
+#ifndef INC_LIBG2FASTH_VARIABLE_DIRECTORY_H
+#define INC_LIBG2FASTH_VARIABLE_DIRECTORY_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include "g2fasth_platform.hpp"
+
+namespace g2 {
+namespace fasth {
+struct g2_variable;
+
+/**
+* Entry of variable_directory. Entries live until they are removed and readers which
+* could find them are done. Variable and handle are changed by writers only.
+*/
+class variable_entry {
+public:
+    variable_entry(const std::string& name, g2_variable* variable)
+        : d_name(name), d_variable(variable), d_handle(0), d_removed(0) {}
+    const std::string& name() const { return d_name; }
+    /**
+    * Returns the variable. It's valid until the reader which found the entry is destroyed.
+    */
+    g2_variable* variable() const { return atomic_load_ptr(&d_variable); }
+    /**
+    * Returns handle assigned by G2 or 0 if the variable is not registered.
+    */
+    long handle() const { return atomic_load(&d_handle); }
+private:
+    friend class variable_directory;
+    variable_entry(const variable_entry&);
+    variable_entry& operator=(const variable_entry&);
+    std::string d_name;
+    g2_variable* volatile d_variable;
+    volatile long d_handle;
+    volatile long d_removed; // links of removed entries are skipped until the table is rebuilt
+};
+
+/**
+* Read-mostly directory of G2 variables indexed by name and by handle. Lookups take
+* no locks and never wait for writers. Writers publish new hash tables and variables
+* instead of changing those readers may use, replaced objects are deleted once no
+* reader which could see them is left (epoch based reclamation). Writers never wait
+* for readers either, so readers may call writers, e.g. from variable handlers.
+* Writers must be serialized by the caller.
+*/
+class variable_directory {
+    struct table;
+public:
+    variable_directory();
+    ~variable_directory();
+
+    /**
+    * Marks a read section. Entries and variables found inside it are not deleted before
+    * the reader is destroyed. Readers may nest.
+    */
+    class reader {
+    public:
+        explicit reader(const variable_directory& directory);
+        ~reader();
+    private:
+        reader(const reader&);
+        reader& operator=(const reader&);
+        volatile long* d_count;
+    };
+
+    /**
+    * Finds entry by name, inside a reader or by writer.
+    * @return Entry or nullptr if no variable with such name was inserted or it was removed.
+    */
+    variable_entry* find(const std::string& name) const;
+    /**
+    * Finds entry by handle, inside a reader or by writer.
+    * @return Entry or nullptr if no variable is registered with the handle.
+    */
+    variable_entry* find(long handle) const;
+    /**
+    * Calls function with each entry, inside a reader or by writer.
+    */
+    template <class F>
+    void for_each(F function) const {
+        const table* current = atomic_load_ptr(&d_table);
+        for (size_t i = 0; i < current->names.size(); i++)
+        {
+            for (const link* l = head(current->names, i); l; l = l->next)
+            {
+                if (!atomic_load(&l->entry->d_removed))
+                    function(*l->entry);
+            }
+        }
+    }
+
+    /**
+    * Adds variable. The name must not be in the directory yet.
+    * @return The new entry.
+    */
+    variable_entry* insert(const std::string& name, g2_variable* variable);
+    /**
+    * Replaces variable of the entry. The previous one is deleted when readers are done with it.
+    */
+    void replace(variable_entry* entry, g2_variable* variable);
+    /**
+    * Sets handle of the entry, 0 removes it from the handle index.
+    */
+    void assign_handle(variable_entry* entry, long handle);
+    /**
+    * Removes entry and its variable. Both are deleted when readers are done with them,
+    * the name may be inserted again right away.
+    */
+    void remove(variable_entry* entry);
+private:
+    variable_directory(const variable_directory&);
+    variable_directory& operator=(const variable_directory&);
+
+    /**
+    * Chain link of one of hash indexes. Key is hash of the name or the handle.
+    */
+    struct link {
+        variable_entry* entry;
+        size_t key;
+        link* next;
+    };
+    /**
+    * Hash tables of both indexes. Links are never changed after they are published,
+    * so the table is rebuilt rather than resized.
+    */
+    struct table {
+        explicit table(size_t bucket_count);
+        std::vector<link*> names;
+        std::vector<link*> handles;
+        std::deque<link> links;
+        size_t handle_links; // including links of handles which changed since
+    };
+    static const link* head(const std::vector<link*>& heads, size_t bucket) {
+        return atomic_load_ptr(reinterpret_cast<link* const volatile*>(&heads[bucket]));
+    }
+    static void push(table& target, std::vector<link*>& heads, size_t bucket, variable_entry* entry, size_t key);
+    void rebuild();
+    void collect();
+
+    table* volatile d_table;
+    std::vector<variable_entry*> d_entries;
+    size_t d_removed_entries; // removed entries still in d_entries, dropped by rebuild()
+    mutable volatile long d_readers[2]; // active readers by parity of epoch they started in
+    volatile long d_epoch;
+    // Replaced objects wait in pending until next epoch starts, then in retired until
+    // readers of previous epoch are gone
+    std::vector<table*> d_pending_tables;
+    std::vector<g2_variable*> d_pending_variables;
+    std::vector<variable_entry*> d_pending_entries;
+    std::vector<table*> d_retired_tables;
+    std::vector<g2_variable*> d_retired_variables;
+    std::vector<variable_entry*> d_retired_entries;
+};
+}
+}
+
+#endif // !INC_LIBG2FASTH_VARIABLE_DIRECTORY_H
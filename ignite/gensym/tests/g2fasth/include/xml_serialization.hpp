@@ -4,7 +4,9 @@
 
 #include <string>
 #include <vector>
-#include <map>
+#include <ctime>
+#include <cstddef>
+#include <new>
 #include "tinyxml2.hpp"
 
 /**
@@ -15,123 +17,160 @@ namespace xmls {
 class serializable;
 
 /**
-* Serializable members base class.
-* All types that need to be serialized should derive from this class.
+* Formats integer value into the buffer, no allocation is done.
+* @param value Value to format.
+* @param buf Buffer of at least 24 characters.
+* @return Pointer to the null-terminated string inside the buffer.
 */
-class member_base {
-protected:
-    std::string d_value;
-public:
-    virtual ~member_base() {};
-    std::string toString() { return d_value; };
-    const char* c_str() { return d_value.c_str(); };
-    std::string *get_string_ptr() { return &d_value; };
-};
+const char* format_int(long long value, char* buf);
 
 /**
 * Serializable string class.
 */
-class x_string : public member_base {
+class x_string {
 private:
-    void assign_value(const std::string value) { d_value = value; };
+    std::string d_value;
 public:
     x_string() {};
-    x_string(std::string value) { assign_value(value); };
-    std::string value() { return d_value; };
-    x_string operator=(const std::string value) { assign_value(value); return *this; };
-    x_string operator=(const char* value) { assign_value(value); return *this; };
+    x_string(const std::string& value) : d_value(value) {};
+    x_string(const char* value) : d_value(value) {};
+    const std::string& value() const { return d_value; };
+    std::string toString() const { return d_value; };
+    const char* c_str() const { return d_value.c_str(); };
+    x_string& operator=(const std::string& value) { d_value = value; return *this; };
+    x_string& operator=(const char* value) { d_value = value; return *this; };
 };
 
 /**
 * Serializable int class.
 */
-class x_int : public member_base {
+class x_int {
 private:
-    void assign_value(const int value);
+    int d_value;
 public:
-    x_int() { assign_value(0); };
-    x_int(int value) { assign_value(value); };
-    int value();
-    x_int operator=(const int value) { assign_value(value); return *this; };
+    x_int() : d_value(0) {};
+    x_int(int value) : d_value(value) {};
+    int value() const { return d_value; };
+    std::string toString() const { char buf[24]; return format_int(d_value, buf); };
+    x_int& operator=(const int value) { d_value = value; return *this; };
 };
 
 /**
 * Serializable bool class.
 */
-class x_bool : public member_base {
+class x_bool {
 private:
-    void assign_value(const bool value) { d_value = value ? "true" : "false"; };
+    bool d_value;
 public:
-    x_bool() { assign_value(false); };
-    x_bool(bool value) { assign_value(value); };
-    bool value();
-    x_bool operator=(const bool value) { assign_value(value); return *this; };
+    x_bool() : d_value(false) {};
+    x_bool(bool value) : d_value(value) {};
+    bool value() const { return d_value; };
+    std::string toString() const { return d_value ? "true" : "false"; };
+    x_bool& operator=(const bool value) { d_value = value; return *this; };
 };
 
 /**
 * Serializable time_t class.
 */
-class x_time_t : public member_base {
+class x_time_t {
 private:
-    void assign_value(const time_t value);
+    time_t d_value;
 public:
-    x_time_t() { assign_value(0); };
-    x_time_t(time_t value) { assign_value(value); };
-    time_t value();
-    x_time_t operator=(const time_t value) { assign_value(value); return *this; };
+    x_time_t() : d_value(0) {};
+    x_time_t(time_t value) : d_value(value) {};
+    time_t value() const { return d_value; };
+    std::string toString() const { char buf[24]; return format_int((long long)d_value, buf); };
+    x_time_t& operator=(const time_t value) { d_value = value; return *this; };
 };
 
 /**
-* Member-Field mapping between type and string representation.
+* Kind of registered member, decides how it is written.
 */
-class field_mapping;
-typedef std::vector<field_mapping*>::iterator FieldMappingIterator;
-class field_mapping {
-public:
-    std::string m_sFieldName;
-    std::string *m_sField;
-    field_mapping(std::string FieldName, std::string *Field) { m_sFieldName = FieldName; m_sField = Field; };
-    std::string getFieldName() { return m_sFieldName; };
-    std::string *getField() { return m_sField; };
+enum field_kind {
+    field_string,
+    field_int,
+    field_bool,
+    field_time,
+    field_subclass,
+    field_collection
 };
 
 /**
-* Member-Class mapping between class and string representation.
+* Registered member: its XML name, kind and offset from the serializable base.
 */
-class class_mapping;
-typedef std::vector<class_mapping*>::iterator ClassMappingIterator;
-class class_mapping {
+struct field_info {
+    std::string name;
+    field_kind kind;
+    ptrdiff_t offset;
+};
+
+/**
+* Field table shared by all instances of a class. It is built once,
+* by the first constructed instance, and never changed afterwards.
+*/
+struct class_table {
+    std::string class_name;
+    std::vector<field_info> fields;
+};
+
+/**
+* Holder of class table of type T. Zero-initialized, so it is
+* safe to use from constructors of static objects.
+*/
+template <typename T>
+struct class_registry {
+    static class_table* table;
+};
+template <typename T>
+class_table* class_registry<T>::table = 0;
+
+/**
+* Bump allocator for collection elements. Memory is released
+* all at once when the arena is destroyed.
+*/
+class arena {
 public:
-    std::string m_sMemberName;
-    serializable *m_cSubclass;
-    class_mapping(std::string MemberName, serializable *subclass) { m_sMemberName = MemberName; m_cSubclass = subclass; };
-    std::string getName() { return m_sMemberName; };
-    serializable *getSubclass() { return m_cSubclass; };
+    arena();
+    ~arena();
+    /**
+    * Allocates aligned block of memory.
+    * @param size Size of the block.
+    * @return Pointer to the block, never null.
+    */
+    void* allocate(size_t size);
+private:
+    arena(const arena&);
+    arena& operator=(const arena&);
+    struct block {
+        block* next;
+        size_t size;
+        size_t used;
+    };
+    block* d_head;
 };
 
 /**
-* Class-collection base, holds collection of children.
+* Class-collection base, holds collection of children as intrusive list.
 */
-class collection_base;
-typedef std::vector<collection_base*>::iterator CollectionIterator;
 class collection_base {
     friend class serializable;
-private:
-    std::string m_sCollectionName;
-    std::string m_sCollectionClassType;
 protected:
-    collection_base() {};
-    std::vector<serializable*> m_vCollection;
-    std::map<serializable*, bool> m_mOwner;
-    void setCollectionName(std::string value) { m_sCollectionName = value; };
-    void setCollectionClassType(std::string value) { m_sCollectionClassType = value; };
-    std::string getCollectionName() { return m_sCollectionName; };
-    virtual serializable *new_element() = 0;
+    collection_base() : d_first(0), d_last(0), d_size(0) {};
+    void link(serializable* item, arena* owner);
+    serializable* d_first;
+    serializable* d_last;
+    size_t d_size;
 public:
-    virtual ~collection_base() {};
-    size_t size() { return m_vCollection.size(); };
-    serializable *getItem(int itemID) { return m_vCollection.at(itemID); };
+    ~collection_base() { Clear(); };
+    size_t size() const { return d_size; };
+    serializable *getItem(int itemID);
+    /**
+    * Destroys all elements. Their memory stays in the arena until it is destroyed.
+    */
     void Clear();
+private:
+    collection_base(const collection_base&);
+    collection_base& operator=(const collection_base&);
 };
 
 /**
@@ -141,88 +180,102 @@ template <typename T>
 class collection : public collection_base {
     friend class serializable;
 public:
-    ~collection() { Clear(); };
-    T *new_element();
-    void addItem(T *item) { m_vCollection.push_back(item); m_mOwner[item] = false; };
-    T *getItem(int itemID) { return (T*)m_vCollection.at(itemID); };
-};
-
-/**
-* Creates new element of type T
-* @return empty object of type T
-*/
-template <typename T>
-T* collection<T>::new_element()
-{
-    T* newItem = new T();
-    m_vCollection.push_back(newItem);
-    m_mOwner[newItem] = true;
-    return newItem;
+    /**
+    * Creates new element of type T
+    * @param owner Arena of the document the collection belongs to.
+    * @return empty object of type T
+    */
+    T *new_element(arena& owner) {
+        T* item = new (owner.allocate(sizeof(T))) T();
+        link(item, &owner);
+        return item;
+    };
+    T *getItem(int itemID) { return (T*)collection_base::getItem(itemID); };
 };
 
 /**
 * Serializeable base class.
 * derive your serializable class from serializable
 */
-typedef std::vector<serializable*>::iterator SerializableIterator;
 class serializable {
     friend class collection_base;
 private:
-    serializable(serializable const &s) { }
-    serializable operator=(serializable const &s) { return *this; };
-protected:
-    std::string d_xml;
-    std::string d_class_name;
+    serializable(serializable const &s);
+    serializable operator=(serializable const &s);
+    bool begin_registration(class_table** table, const char* class_name);
+    void add_field(const char* name, field_kind kind, const void* member);
+    void serialize(tinyxml2::XMLPrinter& printer, const char* element_name) const;
+    const class_table* d_table;
+    class_table* d_registering;
+    class_table** d_registering_slot;
     std::string d_inner_text;
-    std::vector<field_mapping*> d_field_mappings;
-    std::vector<class_mapping*> d_subclass_mappings;
-    std::vector<collection_base*> d_subclass_collections;
+    serializable* d_next;
+    arena* d_arena;
+    bool d_owns_arena;
+protected:
     serializable();
     virtual ~serializable();
-    void set_class_name(std::string class_name) { d_class_name = class_name; };
+    /**
+    * Starts registration of members of class T. Must be called by constructor of T,
+    * followed by register_type() calls and end_registration() when it returns true.
+    * Members are registered only by the first constructed instance of T.
+    * The table is built by the instance and published by end_registration(), so no lock
+    * is held while members are registered.
+    * @param class_name XML name of the class
+    * @return true if members of T have to be registered
+    */
+    template <typename T>
+    bool begin_registration(const char* class_name) {
+        return begin_registration(&class_registry<T>::table, class_name);
+    }
+    /**
+    * Completes registration started by begin_registration().
+    */
+    void end_registration();
 	/**
 	* Register a member
 	* @MemberName XML-Description/Name for the member
 	* @Member Member to register
 	* @return void
 	*/
-	void register_type(std::string MemberName, member_base *Member, std::string DefaultValue = "");
+    void register_type(const char* MemberName, x_string *Member) { add_field(MemberName, field_string, Member); };
+    void register_type(const char* MemberName, x_int *Member) { add_field(MemberName, field_int, Member); };
+    void register_type(const char* MemberName, x_bool *Member) { add_field(MemberName, field_bool, Member); };
+    void register_type(const char* MemberName, x_time_t *Member) { add_field(MemberName, field_time, Member); };
 	/**
 	* Register a member-subclass
 	* @MemberName XML-Description/Name for the member-class
 	* @Member Member-class to register
 	* @return void
 	*/
-	void register_type(std::string MemberName, serializable *Member);
+    void register_type(const char* MemberName, serializable *Member) { add_field(MemberName, field_subclass, Member); };
 	/**
 	* Register a class-collection
 	* @CollectionName XML-Description/Name for the collection
 	* @SubclassCollection collection to register
 	* @return void
 	*/
-    void register_type(std::string CollectionName, collection_base *SubclassCollection);
-	/**
-	* Perform serialization
-	* @classDoc tinyxml Class Document
-	* @rootNode tinyxml Element rootNode
-	* @return void
-	*/
-    void serialize(tinyxml2::XMLDocument *classDoc, tinyxml2::XMLElement *rootNode);
+    void register_type(const char* CollectionName, collection_base *SubclassCollection) { add_field(CollectionName, field_collection, SubclassCollection); };
+    /**
+    * Returns arena for elements of collections. The root document owns it,
+    * collection elements share the arena of their document.
+    */
+    arena& get_arena();
 public:
     /**
     * Gets class name of serializing entity.
 	* @return class name
     */
-    std::string get_class_name() { return d_class_name; };
+    std::string get_class_name() const { return d_table ? d_table->class_name : std::string(); };
     /**
     * Set inner text of the node.
     */
-    void set_inner_text(std::string value) { d_inner_text = value; };
+    void set_inner_text(const std::string& value) { d_inner_text = value; };
     /**
     * Gets inner text of the node.
 	* @return inner text
     */
-    std::string get_inner_text() { return d_inner_text; };
+    const std::string& get_inner_text() const { return d_inner_text; };
     /**
     * Serializes class to xml. If filepath is provided, it saves the generated xml.
 	* @return XML-Data
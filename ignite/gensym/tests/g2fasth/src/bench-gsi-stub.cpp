@@ -0,0 +1,137 @@
+// Functions are defined here, so they must not be declared as imported from gsi.dll
+#undef GSI_USE_DLL
+#include <string>
+#include <vector>
+#include <gsi_main.h>
+#include <gsi_misc.h>
+#include "g2fasth_platform.hpp"
+#include "gsi_stub.hpp"
+
+namespace {
+struct stub_item {
+    stub_item() : type(GSI_NULL_TAG), handle(0), status(NO_ERR), int_value(0), float_value(0) {}
+    gsi_int type;
+    gsi_int handle;
+    gsi_int status;
+    gsi_int int_value;
+    double float_value;
+    std::basic_string<gsi_char> text;   // string or symbol value
+    std::basic_string<gsi_char> name;
+};
+
+/**
+* Items allocated by one gsi_make_items() call. The array passed to the caller is preceded
+* by a pointer to the block, so reclaiming needs no lookup.
+*/
+struct stub_block {
+    std::vector<stub_item> items;
+    std::vector<gsi_item> pointers;
+};
+
+volatile long s_returned_items = 0;
+
+stub_item* item_of(gsi_item item)
+{
+    return reinterpret_cast<stub_item*>(item);
+}
+
+gsi_item* make_items(gsi_int count)
+{
+    stub_block* block = new stub_block;
+    block->items.resize((size_t)count);
+    block->pointers.resize((size_t)count + 1);
+    block->pointers[0] = reinterpret_cast<gsi_item>(block);
+    for (gsi_int i = 0; i < count; i++)
+        block->pointers[(size_t)i + 1] = reinterpret_cast<gsi_item>(&block->items[(size_t)i]);
+    return &block->pointers[1];
+}
+
+void reclaim_items(gsi_item* items)
+{
+    if (items)
+        delete reinterpret_cast<stub_block*>(items[-1]);
+}
+}
+
+extern "C" {
+gsi_int gsi_current_context(void) { return 0; }
+
+void gsi_set_int(gsi_item item, gsi_int value)
+{
+    item_of(item)->type = GSI_INTEGER_TAG;
+    item_of(item)->int_value = value;
+}
+void gsi_set_str(gsi_item item, gsi_char* value)
+{
+    item_of(item)->type = GSI_STRING_TAG;
+    item_of(item)->text = value;
+}
+void gsi_set_sym(gsi_item item, gsi_char* value)
+{
+    item_of(item)->type = GSI_SYMBOL_TAG;
+    item_of(item)->text = value;
+}
+void gsi_set_log(gsi_item item, gsi_int value)
+{
+    item_of(item)->type = GSI_LOGICAL_TAG;
+    item_of(item)->int_value = value;
+}
+void gsi_set_flt(gsi_item item, double value)
+{
+    item_of(item)->type = GSI_FLOAT64_TAG;
+    item_of(item)->float_value = value;
+}
+
+gsi_int gsi_int_of(gsi_item item) { return item_of(item)->int_value; }
+gsi_char* gsi_str_of(gsi_item item) { return const_cast<gsi_char*>(item_of(item)->text.c_str()); }
+gsi_char* gsi_sym_of(gsi_item item) { return const_cast<gsi_char*>(item_of(item)->text.c_str()); }
+gsi_int gsi_log_of(gsi_item item) { return item_of(item)->int_value; }
+double gsi_flt_of(gsi_item item) { return item_of(item)->float_value; }
+gsi_char* gsi_name_of(gsi_item item) { return const_cast<gsi_char*>(item_of(item)->name.c_str()); }
+gsi_int gsi_type_of(gsi_item item) { return item_of(item)->type; }
+gsi_int gsi_handle_of(gsi_item item) { return item_of(item)->handle; }
+// Registrations have no attributes here, the item itself is returned
+gsi_attr gsi_identifying_attr_of(gsi_item item, gsi_int) { return item; }
+void gsi_set_status(gsi_item item, gsi_int status) { item_of(item)->status = status; }
+void gsi_set_handle(gsi_item item, gsi_int handle) { item_of(item)->handle = handle; }
+
+gsi_item* gsi_make_items(gsi_int count) { return make_items(count); }
+void gsi_reclaim_items(gsi_item* items) { reclaim_items(items); }
+gsi_registered_item* gsi_make_registered_items(gsi_int count) { return make_items(count); }
+void gsi_reclaim_registered_items(gsi_registered_item* items) { reclaim_items(items); }
+
+void gsi_return_values(gsi_registered_item*, gsi_int count, gsi_int)
+{
+    g2::fasth::atomic_add(&s_returned_items, (long)count);
+}
+void gsi_rpc_return_values(gsi_item*, gsi_int count, call_identifier_type, gsi_int)
+{
+    g2::fasth::atomic_add(&s_returned_items, (long)count);
+}
+
+void gsirtl_free_i_or_v_contents(gsi_item item)
+{
+    std::basic_string<gsi_char>().swap(item_of(item)->text);
+}
+}
+
+namespace g2 {
+namespace fasth {
+namespace gsi_stub {
+void set_name(gsi_item item, const std::string& name)
+{
+    item_of(item)->name.assign(name.begin(), name.end());
+}
+
+void set_type(gsi_item item, gsi_int type)
+{
+    item_of(item)->type = type;
+}
+
+long long returned_items()
+{
+    return atomic_load(&s_returned_items);
+}
+}
+}
+}
@@ -0,0 +1,416 @@
+// GSI functions are provided by bench-gsi-stub.cpp, not imported from gsi.dll
+#undef GSI_USE_DLL
+#include <math.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "bench.hpp"
+#include "gsi_load_generator.hpp"
+#include "libgsi.hpp"
+#include "gsi_stub.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+/**
+* Variable declaration in the form taken by libgsi::declare_g2_variables.
+*/
+struct bench_variable {
+    std::string name;
+    g2_type type;
+};
+
+const g2_type kTypes[] = { g2_integer, g2_float, g2_logical, g2_string, g2_symbol };
+const int kTypeCount = sizeof(kTypes) / sizeof(kTypes[0]);
+const int kBatch = 100;
+const char kText[] = "benchmark string value of 32 ch";
+
+/**
+* Declarations and sampled callback details of libgsi are logged to std::cout, which
+* would be measured together with the callbacks. Output is discarded while the object exists.
+*/
+class quiet_cout {
+public:
+    quiet_cout() : d_buffer(std::cout.rdbuf(nullptr)) {}
+    ~quiet_cout()
+    {
+        std::cout.rdbuf(d_buffer);
+        std::cout.clear();
+    }
+private:
+    std::streambuf* d_buffer;
+};
+
+/**
+* Sets value of the item according to type, as G2 does for set_data and RPC arguments.
+*/
+void set_value(gsi_item item, g2_type type, int number)
+{
+    switch (type)
+    {
+    case g2_integer:
+        gsi_set_int(item, number);
+        break;
+    case g2_float:
+        gsi_set_flt(item, number * 0.5);
+        break;
+    case g2_logical:
+        gsi_set_log(item, number & 1);
+        break;
+    case g2_string:
+        gsi_set_str(item, (gsi_char*)kText);
+        break;
+    case g2_symbol:
+        gsi_set_sym(item, (gsi_char*)kText);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+* Calls the function until max_calls calls are made or budget_s is spent, at least once.
+* @return Duration of each call in microseconds.
+*/
+template <class F>
+std::vector<double> sample_us(int max_calls, double budget_s, F call)
+{
+    std::vector<double> samples;
+    unsigned long long start = monotonic_ns();
+    do
+    {
+        unsigned long long call_start = monotonic_ns();
+        call();
+        samples.push_back((monotonic_ns() - call_start) / 1e3);
+    } while ((int)samples.size() < max_calls && seconds_since(start) < budget_s);
+    return samples;
+}
+
+double sum(const std::vector<double>& samples)
+{
+    double total = 0;
+    for (size_t i = 0; i < samples.size(); i++)
+        total += samples[i];
+    return total;
+}
+}
+
+G2FASTH_BENCHMARK(gsi_callbacks)
+{
+    const int sizes[] = { 1000, 10000, 100000, 1000000 };
+    const int count = context.quick() ? 2 : sizeof(sizes) / sizeof(sizes[0]);
+    const int max_calls = context.quick() ? 20 : 1000;
+    // Registration and three callbacks share the budget of one size
+    const double phase_s = context.budget_s() / 8;
+    libgsi& gsi = libgsi::getInstance();
+    gsi_int next_handle = 1;
+    int total_variables = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const int size = sizes[i];
+        const int batch = size < kBatch ? size : kBatch;
+        // Variables of the previous sizes stay declared, so names are prefixed by size
+        std::string prefix = "BENCH-" + std::to_string((long long)size) + "-";
+        std::vector<bench_variable> variables((size_t)size);
+        for (int v = 0; v < size; v++)
+        {
+            variables[v].name = prefix + std::to_string((long long)v);
+            variables[v].type = kTypes[v % kTypeCount];
+        }
+        bench_result& result = context.add("gsi_callbacks").param("variables", size).param("batch", batch);
+
+        quiet_cout quiet;
+        unsigned long long start = monotonic_ns();
+        gsi.declare_g2_variables(variables.begin(), variables.end());
+        double declare_s = seconds_since(start);
+
+        gsi_item* registrations = gsi_make_items(size);
+        const gsi_int first_handle = next_handle;
+        for (int v = 0; v < size; v++)
+        {
+            gsi_stub::set_name(registrations[v], variables[v].name);
+            gsi_stub::set_type(registrations[v], variables[v].type);
+            gsi_set_handle(registrations[v], next_handle++);
+        }
+        start = monotonic_ns();
+        for (int v = 0; v < size; v++)
+            gsi.gsi_receive_registration_(registrations[v]);
+        double register_s = seconds_since(start);
+        gsi_reclaim_items(registrations);
+        total_variables += size;
+
+        // Batches pick variables spread over the whole range, like G2 scan intervals would
+        const int stride = size / batch;
+        gsi_registered_item* items = gsi_make_registered_items(batch);
+        for (int b = 0; b < batch; b++)
+            gsi_set_handle(items[b], first_handle + b * stride);
+        std::vector<double> get_us = sample_us(max_calls, phase_s, [&]()
+        {
+            gsi.gsi_get_data_(items, batch);
+        });
+        for (int b = 0; b < batch; b++)
+            set_value(items[b], variables[b * stride].type, b);
+        std::vector<double> set_us = sample_us(max_calls, phase_s, [&]()
+        {
+            gsi.gsi_set_data_(items, batch);
+        });
+        gsi_reclaim_registered_items(items);
+
+        std::vector<double> poll_us = sample_us(max_calls, phase_s, [&]()
+        {
+            for (int b = 0; b < batch; b++)
+                gsi.update_g2_variable(variables[b * stride].name.c_str());
+            gsi.gsi_g2_poll_();
+        });
+
+        // Update of all variables at once, measured after the item array has grown
+        double update_all_s = 0, poll_all_s = 0;
+        unsigned long poll_all_allocations = 0;
+        for (int pass = 0; pass < 2; pass++)
+        {
+            start = monotonic_ns();
+            for (int v = 0; v < size; v++)
+                gsi.update_g2_variable(variables[v].name.c_str());
+            update_all_s = seconds_since(start);
+            unsigned long allocations = allocation_count();
+            start = monotonic_ns();
+            gsi.gsi_g2_poll_();
+            poll_all_s = seconds_since(start);
+            poll_all_allocations = allocation_count() - allocations;
+        }
+
+        // All registered variables in one gsi_get_data, like G2 reading a whole workspace
+        gsi_registered_item* all_items = gsi_make_registered_items(size);
+        for (int v = 0; v < size; v++)
+            gsi_set_handle(all_items[v], first_handle + v);
+        double get_all_s = 0;
+        for (int pass = 0; pass < 2; pass++)
+        {
+            start = monotonic_ns();
+            gsi.gsi_get_data_(all_items, size);
+            get_all_s = seconds_since(start);
+        }
+        gsi_reclaim_registered_items(all_items);
+
+        result.param("total_variables", total_variables)
+            .metric("declare_s", declare_s)
+            .metric("register_s", register_s)
+            .metric("registrations_per_s", size / register_s)
+            .metric("get_data_items_per_s", get_us.size() * batch / sum(get_us) * 1e6)
+            .distribution("get_data_us", get_us)
+            .metric("set_data_items_per_s", set_us.size() * batch / sum(set_us) * 1e6)
+            .distribution("set_data_us", set_us)
+            .metric("poll_items_per_s", poll_us.size() * batch / sum(poll_us) * 1e6)
+            .distribution("poll_us", poll_us)
+            .metric("update_all_s", update_all_s)
+            .metric("poll_all_s", poll_all_s)
+            .metric("poll_all_items_per_s", size / poll_all_s)
+            .metric("poll_all_allocations", poll_all_allocations)
+            .metric("get_all_s", get_all_s)
+            .metric("get_all_items_per_s", size / get_all_s);
+    }
+}
+
+namespace {
+/**
+* Declares and registers float variables, values come from handlers or signals.
+* @return Items of get_data for all the variables.
+*/
+gsi_registered_item* declare_signal_variables(libgsi& gsi, const std::string& prefix, int size, gsi_int first_handle, bool use_signals)
+{
+    gsi_item* registrations = gsi_make_items(size);
+    for (int v = 0; v < size; v++)
+    {
+        std::string name = prefix + std::to_string((long long)v);
+        if (use_signals)
+        {
+            gsi.declare_g2_variable<double>(name);
+            gsi.attach_signal(name, signal_spec::sine(v, 1, 10, v * 0.001));
+        }
+        else
+        {
+            // Handler computing the same sine
+            unsigned long long start = monotonic_ns();
+            std::function<double()> handler = [start, v]() -> double
+            {
+                return v + sin(6.283185307179586 * ((monotonic_ns() - start) / 1e10 + v * 0.001));
+            };
+            gsi.declare_g2_variable<double>(name, handler);
+        }
+        gsi_stub::set_name(registrations[v], name);
+        gsi_stub::set_type(registrations[v], g2_float);
+        gsi_set_handle(registrations[v], first_handle + v);
+        gsi.gsi_receive_registration_(registrations[v]);
+    }
+    gsi_reclaim_items(registrations);
+
+    gsi_registered_item* items = gsi_make_registered_items(size);
+    for (int v = 0; v < size; v++)
+        gsi_set_handle(items[v], first_handle + v);
+    return items;
+}
+}
+
+G2FASTH_BENCHMARK(gsi_signals)
+{
+    const int sizes[] = { 1000, 10000, 100000 };
+    const int count = context.quick() ? 2 : sizeof(sizes) / sizeof(sizes[0]);
+    const int max_calls = context.quick() ? 20 : 200;
+    const double phase_s = context.budget_s() / 6;
+    libgsi& gsi = libgsi::getInstance();
+    // Handles of gsi_callbacks are not reused
+    gsi_int next_handle = 100000000;
+    for (int i = 0; i < count; i++)
+    {
+        const int size = sizes[i];
+        std::string suffix = std::to_string((long long)size) + "-";
+        quiet_cout quiet;
+        gsi_registered_item* handler_items = declare_signal_variables(gsi, "BENCH-HANDLER-" + suffix, size, next_handle, false);
+        next_handle += size;
+        gsi_registered_item* signal_items = declare_signal_variables(gsi, "BENCH-SIGNAL-" + suffix, size, next_handle, true);
+        next_handle += size;
+
+        std::vector<double> handler_us = sample_us(max_calls, phase_s, [&]()
+        {
+            gsi.gsi_get_data_(handler_items, size);
+        });
+        std::vector<double> signal_us = sample_us(max_calls, phase_s, [&]()
+        {
+            gsi.gsi_get_data_(signal_items, size);
+        });
+        gsi_reclaim_registered_items(handler_items);
+        gsi_reclaim_registered_items(signal_items);
+
+        // Signal kernels alone, all shapes mixed
+        signal_bank bank;
+        std::vector<size_t> ids((size_t)size);
+        for (int v = 0; v < size; v++)
+        {
+            signal_spec spec;
+            spec.shape = (signal_shape)(v % signal_shape_count);
+            spec.seed = v;
+            ids[v] = bank.add(spec);
+        }
+        std::vector<double> values((size_t)size);
+        double t = 0;
+        std::vector<double> evaluate_us = sample_us(max_calls, phase_s, [&]()
+        {
+            bank.evaluate(&ids[0], ids.size(), t += 0.01, &values[0]);
+        });
+
+        context.add("gsi_signals").param("variables", size)
+            .metric("handler_items_per_s", handler_us.size() * size / sum(handler_us) * 1e6)
+            .distribution("handler_get_data_us", handler_us)
+            .metric("signal_items_per_s", signal_us.size() * size / sum(signal_us) * 1e6)
+            .distribution("signal_get_data_us", signal_us)
+            .metric("evaluate_values_per_s", evaluate_us.size() * size / sum(evaluate_us) * 1e6);
+    }
+}
+
+G2FASTH_BENCHMARK(gsi_load)
+{
+    const double rates[] = { 1e4, 1e5, 1e6 };
+    const int count = context.quick() ? 1 : sizeof(rates) / sizeof(rates[0]);
+    const int size = 1000;
+    libgsi& gsi = libgsi::getInstance();
+    quiet_cout quiet;
+    gsi_load_generator generator(gsi);
+    generator.add_variables("BENCH-LOAD-", size);
+    // Variables are registered, so gsi_g2_poll returns their values
+    gsi_item* registrations = gsi_make_items(size);
+    for (int v = 0; v < size; v++)
+    {
+        gsi_stub::set_name(registrations[v], "BENCH-LOAD-" + std::to_string((long long)v));
+        gsi_stub::set_type(registrations[v], g2_float);
+        gsi_set_handle(registrations[v], 200000000 + v);
+        gsi.gsi_receive_registration_(registrations[v]);
+    }
+    gsi_reclaim_items(registrations);
+
+    for (int i = 0; i < count; i++)
+    {
+        load_options options;
+        options.duration_s = context.quick() ? 0.2 : context.budget_s() / 6;
+        options.interval_s = options.duration_s;
+        options.poll = true;
+        generator.run(load_profile::constant(rates[i]), options);
+        const load_summary& summary = generator.summary();
+        context.add("gsi_load").param("variables", size).param("target_rate", rates[i])
+            .metric("offered_per_s", summary.offered / summary.elapsed_s)
+            .metric("sent_per_s", summary.sent / summary.elapsed_s)
+            .metric("merged", (double)(summary.offered - summary.queued))
+            .metric("latency_p50_us", summary.latency_p50_us)
+            .metric("latency_p99_us", summary.latency_p99_us);
+    }
+}
+
+/**
+* RPC handler returning its arguments, so both directions of marshalling are measured.
+*/
+class BenchEchoHandler : public gsi_rpc_handler<BenchEchoHandler>
+{
+friend class gsi_rpc_handler<BenchEchoHandler>;
+protected:
+    void handler(const g2_arguments& in_args, g2_arguments& out_args) override
+    {
+        out_args.resize(in_args.size());
+        for (size_t i = 0; i < in_args.size(); i++)
+        {
+            switch (in_args[i]->reg_type)
+            {
+            case g2_integer:
+                out_args[i] = create_variable<int>(get_variable_value<int>(in_args[i]));
+                break;
+            case g2_float:
+                out_args[i] = create_variable<double>(get_variable_value<double>(in_args[i]));
+                break;
+            case g2_logical:
+                out_args[i] = create_variable<bool>(get_variable_value<bool>(in_args[i]));
+                break;
+            default:
+                out_args[i] = create_variable<std::string>(get_variable_value<std::string>(in_args[i]));
+                break;
+            }
+        }
+    }
+public:
+    BenchEchoHandler()
+    {
+        set_function_name("BENCH-ECHO");
+    }
+};
+
+G2FASTH_BENCHMARK(gsi_rpc_marshalling)
+{
+    BenchEchoHandler::add_handler(std::make_shared<BenchEchoHandler>());
+    gsi_rpc_local_fn_type* echo = libgsi::getInstance().get_g2_function("BENCH-ECHO");
+    const int argument_counts[] = { 1, 8 };
+    const int max_calls = context.quick() ? 1000 : 100000;
+    const double phase_s = context.budget_s() / 20;
+    for (int t = 0; t < kTypeCount; t++)
+    {
+        for (int a = 0; a < 2; a++)
+        {
+            const int arguments = argument_counts[a];
+            gsi_item* items = gsi_make_items(arguments);
+            for (int i = 0; i < arguments; i++)
+                set_value(items[i], kTypes[t], i);
+            long long returned = gsi_stub::returned_items();
+            std::vector<double> call_us = sample_us(max_calls, phase_s, [&]()
+            {
+                echo(items, arguments, 0);
+            });
+            gsi_reclaim_items(items);
+            bench_result& result = context.add("gsi_rpc_marshalling")
+                .param("type_tag", kTypes[t]).param("arguments", arguments);
+            if (gsi_stub::returned_items() - returned != (long long)call_us.size() * arguments)
+            {
+                result.skip("handler did not return all arguments");
+                continue;
+            }
+            result.metric("calls_per_s", call_us.size() / sum(call_us) * 1e6)
+                .metric("arguments_per_s", call_us.size() * arguments / sum(call_us) * 1e6)
+                .distribution("call_us", call_us);
+        }
+    }
+}
@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+#include <new>
+#include "bench.hpp"
+#include "tinythread.h"
+#ifdef WIN32
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#endif
+
+using namespace g2::fasth;
+
+namespace {
+volatile long s_allocations;
+}
+
+// Allocations of all benchmarks are counted, replacing operator new is the only
+// portable way to see those made by the standard library
+void* operator new(size_t size)
+{
+    g2::fasth::atomic_add(&s_allocations, 1);
+    void* p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) throw()
+{
+    free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+    free(p);
+}
+
+namespace {
+struct registered_bench {
+    const char* name;
+    bench_function function;
+};
+
+// Benchmarks register from statics of other translation units
+std::vector<registered_bench>& get_benchmarks()
+{
+    static std::vector<registered_bench>* s_benchmarks = new std::vector<registered_bench>;
+    return *s_benchmarks;
+}
+
+void append_escaped(std::string& out, const std::string& text)
+{
+    out += '"';
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        unsigned char c = (unsigned char)text[i];
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += (char)c;
+        }
+        else if (c < 0x20)
+        {
+            char buffer[8];
+            sprintf(buffer, "\\u%04x", c);
+            out += buffer;
+        }
+        else
+            out += (char)c;
+    }
+    out += '"';
+}
+
+void append_values(std::string& out, const std::vector<std::pair<std::string, double> >& values)
+{
+    out += '{';
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        if (i)
+            out += ',';
+        append_escaped(out, values[i].first);
+        char buffer[32];
+        sprintf(buffer, ":%.6g", values[i].second);
+        out += buffer;
+    }
+    out += '}';
+}
+
+double percentile(const std::vector<double>& sorted, double fraction)
+{
+    size_t index = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+const char* parse_flag(const char* arg, const char* flag)
+{
+    size_t length = strlen(flag);
+    if (strncmp(arg, flag, length) != 0)
+        return nullptr;
+    if (arg[length] == '\0')
+        return arg + length;
+    return arg[length] == '=' ? arg + length + 1 : nullptr;
+}
+
+void print_usage()
+{
+    fputs("Usage: benchg2fasth|benchgsi [-filter=substring] [-output=file.json] [-budget=seconds] [-quick] [-list]\n"
+        "Runs benchmarks of the framework and prints results as JSON.\n", stderr);
+}
+}
+
+bench_registration::bench_registration(const char* name, bench_function function)
+{
+    registered_bench bench = { name, function };
+    get_benchmarks().push_back(bench);
+}
+
+bench_result& bench_result::param(const std::string& name, double value)
+{
+    d_params.push_back(std::make_pair(name, value));
+    return *this;
+}
+
+bench_result& bench_result::metric(const std::string& name, double value)
+{
+    d_metrics.push_back(std::make_pair(name, value));
+    return *this;
+}
+
+bench_result& bench_result::distribution(const std::string& prefix, std::vector<double> samples)
+{
+    if (samples.empty())
+        return *this;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (size_t i = 0; i < samples.size(); i++)
+        sum += samples[i];
+    metric(prefix + "_min", samples.front());
+    metric(prefix + "_p50", percentile(samples, 0.5));
+    metric(prefix + "_p90", percentile(samples, 0.9));
+    metric(prefix + "_p99", percentile(samples, 0.99));
+    metric(prefix + "_max", samples.back());
+    metric(prefix + "_mean", sum / samples.size());
+    return *this;
+}
+
+bench_result& bench_result::skip(const std::string& reason)
+{
+    d_skipped = reason;
+    return *this;
+}
+
+std::string bench_result::to_json() const
+{
+    std::string out = "{\"name\":";
+    append_escaped(out, d_name);
+    out += ",\"params\":";
+    append_values(out, d_params);
+    if (!d_skipped.empty())
+    {
+        out += ",\"skipped\":";
+        append_escaped(out, d_skipped);
+    }
+    else
+    {
+        out += ",\"metrics\":";
+        append_values(out, d_metrics);
+    }
+    out += '}';
+    return out;
+}
+
+unsigned long g2::fasth::allocation_count()
+{
+    return (unsigned long)atomic_load(&s_allocations);
+}
+
+unsigned long long g2::fasth::peak_rss_bytes()
+{
+#ifdef WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    // VmHWM is lowered by reset_peak_rss(), getrusage() may keep peak of exited threads
+    FILE* file = fopen("/proc/self/status", "r");
+    if (!file)
+        return 0;
+    unsigned long long peak_kb = 0;
+    char line[128];
+    while (fgets(line, sizeof(line), file))
+    {
+        if (sscanf(line, "VmHWM: %llu kB", &peak_kb) == 1)
+            break;
+    }
+    fclose(file);
+    return peak_kb * 1024;
+#endif
+}
+
+void g2::fasth::reset_peak_rss()
+{
+#ifndef WIN32
+    FILE* file = fopen("/proc/self/clear_refs", "w");
+    if (file)
+    {
+        fputs("5", file);
+        fclose(file);
+    }
+#endif
+}
+
+bench_result& bench_context::add(const std::string& name)
+{
+    d_results.push_back(bench_result(name));
+    return d_results.back();
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filter, output;
+    bool quick = false, list = false;
+    double budget_s = 60;
+    for (int i = 1; i < argc; i++)
+    {
+        const char* value;
+        if ((value = parse_flag(argv[i], "-filter")) && *value)
+            filter = value;
+        else if ((value = parse_flag(argv[i], "-output")) && *value)
+            output = value;
+        else if ((value = parse_flag(argv[i], "-budget")) && *value)
+            budget_s = atof(value);
+        else if (parse_flag(argv[i], "-quick"))
+            quick = true;
+        else if (parse_flag(argv[i], "-list"))
+            list = true;
+        else
+        {
+            print_usage();
+            return 1;
+        }
+    }
+
+    std::vector<registered_bench>& benchmarks = get_benchmarks();
+    bench_context context(quick, budget_s);
+    for (size_t i = 0; i < benchmarks.size(); i++)
+    {
+        if (!filter.empty() && !strstr(benchmarks[i].name, filter.c_str()))
+            continue;
+        if (list)
+        {
+            puts(benchmarks[i].name);
+            continue;
+        }
+        // Progress goes to stderr, so stdout has JSON only
+        fprintf(stderr, "%s...\n", benchmarks[i].name);
+        unsigned long long start = monotonic_ns();
+        benchmarks[i].function(context);
+        fprintf(stderr, "%s done in %.1f s\n", benchmarks[i].name, seconds_since(start));
+    }
+    if (list)
+        return 0;
+
+    char date[32];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    std::string json = "{\"context\":{\"date\":\"";
+    json += date;
+    char buffer[128];
+    sprintf(buffer, "\",\"hardware_concurrency\":%u,\"quick\":%s,\"budget_s\":%.6g},\n\"benchmarks\":[",
+        tthread::thread::hardware_concurrency(), quick ? "true" : "false", budget_s);
+    json += buffer;
+    const char* separator = "\n";
+    for (std::list<bench_result>::const_iterator it = context.results().begin(); it != context.results().end(); ++it)
+    {
+        json += separator;
+        json += it->to_json();
+        separator = ",\n";
+    }
+    json += "\n]}\n";
+
+    if (output.empty())
+    {
+        fputs(json.c_str(), stdout);
+        return 0;
+    }
+    FILE* file = fopen(output.c_str(), "w");
+    if (!file)
+    {
+        fprintf(stderr, "Can't write %s\n", output.c_str());
+        return 1;
+    }
+    fputs(json.c_str(), file);
+    return fclose(file) == 0 ? 0 : 1;
+}
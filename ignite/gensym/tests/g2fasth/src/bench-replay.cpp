@@ -0,0 +1,64 @@
+// GSI functions are provided by bench-gsi-stub.cpp, not imported from gsi.dll
+#undef GSI_USE_DLL
+#include <stdio.h>
+#include <string>
+#include "bench.hpp"
+#include "libgsi.hpp"
+#include "time_series_replay.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+const char kRecording[] = "bench-replay.bin";
+const int kVariables = 1000;
+
+/**
+* Writes recording of variables of all numeric types updated in turn, each 1 ms.
+* @return Size of the file in bytes.
+*/
+double write_recording(int rows)
+{
+    const g2_type types[] = { g2_float, g2_integer, g2_logical };
+    replay_writer writer;
+    if (!writer.open(kRecording))
+        return 0;
+    for (int v = 0; v < kVariables; v++)
+        writer.add_variable("BENCH-REPLAY-" + std::to_string((long long)v), types[v % 3]);
+    for (int i = 0; i < rows; i++)
+        writer.write(i * 1000000LL, i % kVariables, i * 0.25);
+    if (!writer.close())
+        return 0;
+    return 40 + rows * 24.0;
+}
+}
+
+G2FASTH_BENCHMARK(gsi_replay)
+{
+    const int rows = context.quick() ? 100000 : 4000000;
+    double bytes = write_recording(rows);
+    libgsi& gsi = libgsi::getInstance();
+    for (int update = 0; update < 2; update++)
+    {
+        bench_result& result = context.add("gsi_replay")
+            .param("rows", rows).param("variables", kVariables).param("update_g2", update);
+        time_series_replay replay(gsi);
+        if (!bytes || !replay.open(kRecording))
+        {
+            result.skip("recording could not be written");
+            continue;
+        }
+        replay_options options;
+        options.speed = 0;
+        options.update_g2 = update != 0;
+        replay.bind();
+        unsigned long long start = monotonic_ns();
+        unsigned long long played = replay.play(options);
+        double elapsed_s = (monotonic_ns() - start) / 1e9;
+        // Queued updates are sent, as the next poll would do
+        gsi.gsi_g2_poll_();
+        result.metric("elapsed_s", elapsed_s)
+            .metric("rows_per_s", played / elapsed_s)
+            .metric("mb_per_s", bytes / elapsed_s / 1e6);
+    }
+    remove(kRecording);
+}
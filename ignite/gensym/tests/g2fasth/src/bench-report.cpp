@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <string>
+#include "bench.hpp"
+#include "junit_report.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+const char kReportFile[] = "bench-report.xml";
+
+double megabytes(unsigned long long bytes)
+{
+    return bytes / (1024.0 * 1024.0);
+}
+
+/**
+* Fills the suite the way suite::add_testcases does. Every tenth test case fails
+* and every fiftieth has captured output.
+*/
+void add_testcases(testsuite_data& test_suite, int tests)
+{
+    const std::string output(200, 'o');
+    for (int i = 0; i < tests; i++)
+    {
+        std::string name = "test_case_" + std::to_string((long long)i);
+        testcase_data* test_case = test_suite.add_testcase("BenchReport." + name, name);
+        if (i % 10 == 9)
+            test_case->fail_test_case("fail", "This has failed due to unknow reasons.");
+        if (i % 50 == 49)
+            test_case->set_system_out(output);
+    }
+}
+}
+
+G2FASTH_BENCHMARK(junit_report)
+{
+    const int sizes[] = { 1000, 10000, 100000 };
+    const int count = context.quick() ? 1 : sizeof(sizes) / sizeof(sizes[0]);
+    for (int i = 0; i < count; i++)
+    {
+        reset_peak_rss();
+        unsigned long long rss_before = peak_rss_bytes();
+        unsigned long allocations = allocation_count();
+        unsigned long long start = monotonic_ns();
+        size_t report_bytes;
+        double build_s, serialize_s, write_s;
+        unsigned long build_allocations, serialize_allocations;
+        {
+            testsuite_data test_suite(sizes[i], "2026-01-01T00:00:00");
+            add_testcases(test_suite, sizes[i]);
+            build_s = seconds_since(start);
+            build_allocations = allocation_count() - allocations;
+
+            allocations = allocation_count();
+            start = monotonic_ns();
+            report_bytes = test_suite.to_xml("").size();
+            serialize_s = seconds_since(start);
+            serialize_allocations = allocation_count() - allocations;
+
+            // Suites write the file and return the same XML as string
+            start = monotonic_ns();
+            test_suite.to_xml(kReportFile);
+            write_s = seconds_since(start);
+        }
+        double destroy_s = seconds_since(start) - write_s;
+        remove(kReportFile);
+        unsigned long long rss_peak = peak_rss_bytes();
+        context.add("junit_report").param("tests", sizes[i])
+            .metric("build_s", build_s)
+            .metric("build_allocations", build_allocations)
+            .metric("serialize_s", serialize_s)
+            .metric("serialize_allocations", serialize_allocations)
+            .metric("write_s", write_s)
+            .metric("destroy_s", destroy_s)
+            .metric("report_mb", megabytes(report_bytes))
+            .metric("peak_rss_mb", megabytes(rss_peak))
+            .metric("peak_rss_growth_mb", megabytes(rss_peak - rss_before));
+    }
+}
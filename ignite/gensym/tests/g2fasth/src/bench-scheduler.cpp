@@ -0,0 +1,330 @@
+#include <string>
+#include <vector>
+#include <memory>
+#include "bench.hpp"
+#include "suite.hpp"
+#include "test_agent.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+std::string numbered(const char* prefix, int number)
+{
+    return prefix + std::to_string((long long)number);
+}
+}
+
+/**
+* Suite of test cases which complete as soon as they start.
+*/
+class BenchTrivial : public suite<BenchTrivial> {
+public:
+    BenchTrivial() : suite("BenchTrivial", test_order::implied, log_level::NONE) {
+    }
+    void trivial(const std::string& test_case_name)
+    {
+        complete_test_case(test_case_name, test_outcome::pass);
+    }
+};
+
+G2FASTH_BENCHMARK(trivial_throughput)
+{
+    const int sizes[] = { 1000, 10000, 100000 };
+    const int count = context.quick() ? 1 : sizeof(sizes) / sizeof(sizes[0]);
+    double previous_s = 0;
+    for (int i = 0; i < count; i++)
+    {
+        bench_result& result = context.add("trivial_throughput").param("tests", sizes[i]);
+        // Scheduling and execution both scan all test cases, so time grows quadratically
+        if (i > 0)
+        {
+            double ratio = (double)sizes[i] / sizes[i - 1];
+            double estimate_s = previous_s * ratio * ratio;
+            if (estimate_s > context.budget_s())
+            {
+                result.skip("estimated " + std::to_string((long long)estimate_s) + " s exceeds budget");
+                break;
+            }
+        }
+        unsigned long long start = monotonic_ns();
+        BenchTrivial bench_suite;
+        for (int test = 0; test < sizes[i]; test++)
+            bench_suite.run(&BenchTrivial::trivial, numbered("trivial_", test));
+        double schedule_s = seconds_since(start);
+        unsigned long long execute_start = monotonic_ns();
+        bench_suite.run_suite();
+        double execute_s = seconds_since(execute_start);
+        previous_s = schedule_s + execute_s;
+        result.metric("schedule_s", schedule_s)
+            .metric("execute_s", execute_s)
+            .metric("tests_per_s", sizes[i] / execute_s);
+    }
+}
+
+const int kDagNodes = 64;
+
+/**
+* Suite for dependency graphs. Dependencies refer to test functions, so each
+* node which others depend on needs its own function, generated from template.
+*/
+class BenchDag : public suite<BenchDag> {
+public:
+    typedef test_helper<BenchDag>::pmf_t pmf_t;
+    BenchDag() : suite("BenchDag", test_order::implied, log_level::NONE) {
+    }
+    template <int N>
+    void node(const std::string& test_case_name)
+    {
+        complete_test_case(test_case_name, test_outcome::pass);
+    }
+    static pmf_t s_nodes[kDagNodes];
+};
+
+BenchDag::pmf_t BenchDag::s_nodes[kDagNodes];
+
+template <int N>
+struct dag_nodes {
+    static void fill()
+    {
+        BenchDag::s_nodes[N - 1] = &BenchDag::node<N - 1>;
+        dag_nodes<N - 1>::fill();
+    }
+};
+
+template <>
+struct dag_nodes<0> {
+    static void fill() {}
+};
+
+namespace {
+double run_makespan(BenchDag& bench_suite)
+{
+    unsigned long long start = monotonic_ns();
+    bench_suite.run_suite();
+    return seconds_since(start);
+}
+}
+
+G2FASTH_BENCHMARK(dependency_chain)
+{
+    dag_nodes<kDagNodes>::fill();
+    const int length = context.quick() ? 16 : kDagNodes;
+    unsigned long long start = monotonic_ns();
+    BenchDag bench_suite;
+    bench_suite.run(BenchDag::s_nodes[0], "chain_0");
+    for (int i = 1; i < length; i++)
+        bench_suite.run(BenchDag::s_nodes[i], numbered("chain_", i)).after(BenchDag::s_nodes[i - 1]);
+    double schedule_s = seconds_since(start);
+    double makespan_s = run_makespan(bench_suite);
+    context.add("dependency_chain").param("length", length)
+        .metric("schedule_s", schedule_s)
+        .metric("makespan_s", makespan_s)
+        .metric("link_latency_ms", makespan_s * 1000 / length);
+}
+
+G2FASTH_BENCHMARK(fan_out)
+{
+    dag_nodes<kDagNodes>::fill();
+    const int width = context.quick() ? 100 : 1000;
+    unsigned long long start = monotonic_ns();
+    BenchDag bench_suite;
+    bench_suite.run(BenchDag::s_nodes[0], "root");
+    // Nothing depends on leaves, so they can share the function
+    for (int i = 0; i < width; i++)
+        bench_suite.run(BenchDag::s_nodes[1], numbered("leaf_", i)).after(BenchDag::s_nodes[0]);
+    double schedule_s = seconds_since(start);
+    double makespan_s = run_makespan(bench_suite);
+    context.add("fan_out").param("width", width)
+        .metric("schedule_s", schedule_s)
+        .metric("makespan_s", makespan_s)
+        .metric("tests_per_s", (width + 1) / makespan_s);
+}
+
+G2FASTH_BENCHMARK(fan_in)
+{
+    // A test case depends on at most two others (after and after_success_of),
+    // so leaves are joined by binary tree
+    dag_nodes<kDagNodes>::fill();
+    const int width = context.quick() ? 8 : kDagNodes / 2;
+    unsigned long long start = monotonic_ns();
+    BenchDag bench_suite;
+    std::vector<int> level;
+    for (int i = 0; i < width; i++)
+    {
+        bench_suite.run(BenchDag::s_nodes[i], numbered("leaf_", i));
+        level.push_back(i);
+    }
+    int next = width, depth = 0;
+    while (level.size() > 1)
+    {
+        std::vector<int> parents;
+        for (size_t i = 0; i + 1 < level.size(); i += 2)
+        {
+            bench_suite.run(BenchDag::s_nodes[next], numbered("join_", next))
+                .after(BenchDag::s_nodes[level[i]])
+                .after_success_of(BenchDag::s_nodes[level[i + 1]]);
+            parents.push_back(next++);
+        }
+        level.swap(parents);
+        depth++;
+    }
+    double schedule_s = seconds_since(start);
+    double makespan_s = run_makespan(bench_suite);
+    context.add("fan_in").param("width", width).param("depth", depth)
+        .metric("schedule_s", schedule_s)
+        .metric("makespan_s", makespan_s)
+        .metric("level_latency_ms", makespan_s * 1000 / depth);
+}
+
+/**
+* Suite with a single timer test case recording tick times.
+*/
+class BenchTimer : public suite<BenchTimer> {
+public:
+    BenchTimer(int interval_ms, int ticks)
+        : suite("BenchTimer", test_order::implied, log_level::NONE)
+        , d_interval_ms(interval_ms), d_ticks(ticks) {
+    }
+    void setup_test_track() override
+    {
+        run(&BenchTimer::timer_test, "timer_test");
+    }
+    void timer_test(const std::string& test_case_name)
+    {
+        d_times.push_back(monotonic_ns());
+        start_timer(test_case_name, chrono::milliseconds(d_interval_ms), &BenchTimer::tick);
+    }
+    void tick(const std::string& test_case_name)
+    {
+        d_times.push_back(monotonic_ns());
+        if ((int)d_times.size() > d_ticks)
+            complete_test_case(test_case_name, test_outcome::pass);
+    }
+    /**
+    * Returns differences of actual intervals from the requested one, in milliseconds.
+    */
+    std::vector<double> jitter_ms() const
+    {
+        std::vector<double> jitter;
+        for (size_t i = 1; i < d_times.size(); i++)
+            jitter.push_back((d_times[i] - d_times[i - 1]) / 1e6 - d_interval_ms);
+        return jitter;
+    }
+private:
+    int d_interval_ms;
+    int d_ticks;
+    std::vector<unsigned long long> d_times;    // written by one timer thread at a time
+};
+
+G2FASTH_BENCHMARK(timer_jitter)
+{
+    const int intervals[] = { 1, 10, 100 };
+    for (int i = 0; i < 3; i++)
+    {
+        // About two seconds of ticks per interval
+        int ticks = 2000 / intervals[i];
+        if (context.quick())
+            ticks /= 10;
+        BenchTimer bench_suite(intervals[i], ticks);
+        bench_suite.run_suite();
+        context.add("timer_jitter").param("interval_ms", intervals[i]).param("ticks", ticks)
+            .distribution("jitter_ms", bench_suite.jitter_ms());
+    }
+}
+
+/**
+* Suite with a test case continued asynchronously given number of times.
+*/
+class BenchAsync : public suite<BenchAsync> {
+public:
+    explicit BenchAsync(int continuations)
+        : suite("BenchAsync", test_order::implied, log_level::NONE)
+        , d_left(continuations) {
+    }
+    void setup_test_track() override
+    {
+        run(&BenchAsync::async_test, "async_test");
+    }
+    void async_test(const std::string& test_case_name)
+    {
+        d_last = monotonic_ns();
+        go_async(test_case_name, &BenchAsync::continuation);
+    }
+    void continuation(const std::string& test_case_name)
+    {
+        unsigned long long now = monotonic_ns();
+        d_latency_us.push_back((now - d_last) / 1e3);
+        d_last = now;
+        if (--d_left > 0)
+            go_async(test_case_name, &BenchAsync::continuation);
+        else
+            complete_test_case(test_case_name, test_outcome::pass);
+    }
+    const std::vector<double>& latency_us() const { return d_latency_us; }
+private:
+    int d_left;
+    unsigned long long d_last;
+    std::vector<double> d_latency_us;   // each continuation runs after the previous one
+};
+
+G2FASTH_BENCHMARK(async_continuation)
+{
+    const int continuations = context.quick() ? 50 : 1000;
+    BenchAsync bench_suite(continuations);
+    unsigned long long start = monotonic_ns();
+    bench_suite.run_suite();
+    double elapsed_s = seconds_since(start);
+    context.add("async_continuation").param("continuations", continuations)
+        .metric("elapsed_s", elapsed_s)
+        .distribution("latency_us", bench_suite.latency_us());
+}
+
+namespace {
+struct dispatch_times {
+    std::vector<unsigned long long> started;
+    std::vector<unsigned long long> completed;
+};
+}
+
+/**
+* Suite with one trivial test case recording when the agent started it.
+*/
+class BenchDispatch : public suite<BenchDispatch> {
+public:
+    BenchDispatch(int number, dispatch_times& times)
+        : suite(numbered("BenchDispatch_", number), test_order::implied, log_level::NONE)
+        , d_times(times) {
+    }
+    void setup_test_track() override
+    {
+        d_times.started.push_back(monotonic_ns());
+        run(&BenchDispatch::trivial, "trivial");
+    }
+    void trivial(const std::string& test_case_name)
+    {
+        complete_test_case(test_case_name, test_outcome::pass);
+        d_times.completed.push_back(monotonic_ns());
+    }
+private:
+    dispatch_times& d_times;
+};
+
+G2FASTH_BENCHMARK(agent_dispatch)
+{
+    const int suites = context.quick() ? 20 : 200;
+    dispatch_times times;
+    test_agent agent(test_order::implied);
+    for (int i = 0; i < suites; i++)
+        agent.schedule_suite(std::make_shared<BenchDispatch>(i, times));
+    unsigned long long start = monotonic_ns();
+    agent.execute();
+    double elapsed_s = seconds_since(start);
+    // Suites run one after another, so the gap between completion of a test case
+    // and start of the next suite is spent in the agent and suite epilogue
+    std::vector<double> latency_us;
+    for (size_t i = 1; i < times.started.size() && i <= times.completed.size(); i++)
+        latency_us.push_back((times.started[i] - times.completed[i - 1]) / 1e3);
+    context.add("agent_dispatch").param("suites", suites)
+        .metric("elapsed_s", elapsed_s)
+        .distribution("dispatch_us", latency_us);
+}
@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "bench.hpp"
+#include "libgsi.hpp"
+#include "string_convert.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+// GSI conversion buffers hold 4095 characters
+const size_t kLengths[] = { 16, 256, 4000 };
+
+/**
+* Conversions of libgsi before the ASCII fast path, all text went through GSI.
+*/
+short* previous_gensym_string(const std::wstring& wstr, short* dest, size_t num)
+{
+    short* buf = (short*)calloc(wstr.length() + 1, sizeof(short));
+    short* dst = buf;
+    const wchar_t* src = wstr.c_str();
+    while (num-- && (*dst++ = (short)*src++)) ;
+    short* result = gsi_convert_wide_string_to_unicode(buf, GSI_CHAR_SET_GENSYM);
+    free(buf);
+    while (num-- && (*dest++ = (short)*result++)) ;
+    return dest;
+}
+
+short* previous_gensym_string(const std::string& cstr, short* dest, size_t num)
+{
+    short* result = gsi_convert_string_to_unicode(const_cast<char*>(cstr.c_str()), GSI_CHAR_SET_GENSYM);
+    while (num-- && (*dest++ = (short)*result++)) ;
+    return dest;
+}
+
+std::wstring previous_wide_string(short* gstr)
+{
+    std::string cstr((char*)gsi_convert_unicode_to_string(gstr, GSI_CHAR_SET_GENSYM));
+    short* wstr = gsi_convert_unicode_to_wide_string((short*)(cstr.c_str()), GSI_CHAR_SET_GENSYM);
+    const short* pos;
+    for (pos = wstr; *pos; ++pos) ;
+    size_t num = pos - wstr;
+    wchar_t* buf = (wchar_t*)calloc(num + 1, sizeof(wchar_t));
+    wchar_t* dest = buf;
+    while (num-- && (*dest++ = (wchar_t)*wstr++)) ;
+    std::wstring result(buf);
+    free(buf);
+    return result;
+}
+
+std::string previous_c_string(short* gstr)
+{
+    return std::string(gsi_convert_unicode_to_string(gstr, GSI_CHAR_SET_GENSYM));
+}
+
+/**
+* Calls conversion of text of given length repeatedly for budget_s.
+* @return Millions of characters converted per second.
+*/
+template <typename F>
+double mchars_per_s(size_t length, double budget_s, unsigned long& allocations, F convert)
+{
+    const int kBatch = 100;
+    long long calls = 0;
+    unsigned long allocated = allocation_count();
+    unsigned long long start = monotonic_ns();
+    do
+    {
+        for (int i = 0; i < kBatch; i++)
+            convert();
+        calls += kBatch;
+    } while (seconds_since(start) < budget_s);
+    double elapsed_s = seconds_since(start);
+    allocations = (unsigned long)((allocation_count() - allocated) / calls);
+    return calls * length / elapsed_s / 1e6;
+}
+
+/**
+* Adds result comparing conversions of text of given length. Allocations count
+* operator new only, calloc of the previous routines is not counted.
+*/
+template <typename P, typename L, typename A>
+void compare(bench_context& context, const char* name, size_t length, P previous, L current, A ascii)
+{
+    const double phase_s = context.quick() ? 0.05 : context.budget_s() / 40;
+    unsigned long previous_allocations, current_allocations, ascii_allocations;
+    double previous_rate = mchars_per_s(length, phase_s, previous_allocations, previous);
+    double current_rate = mchars_per_s(length, phase_s, current_allocations, current);
+    double ascii_rate = mchars_per_s(length, phase_s, ascii_allocations, ascii);
+    context.add(name).param("length", (double)length).param("vector_bits", string_convert_vector_bits())
+        .metric("previous_mchars_per_s", previous_rate)
+        .metric("libgsi_mchars_per_s", current_rate)
+        .metric("convert_ascii_mchars_per_s", ascii_rate)
+        .metric("speedup", current_rate / previous_rate)
+        .metric("previous_allocations_per_call", previous_allocations)
+        .metric("libgsi_allocations_per_call", current_allocations);
+}
+}
+
+G2FASTH_BENCHMARK(string_conversion)
+{
+    const int count = context.quick() ? 2 : sizeof(kLengths) / sizeof(kLengths[0]);
+    for (int l = 0; l < count; l++)
+    {
+        const size_t length = kLengths[l];
+        std::string text(length, ' ');
+        for (size_t i = 0; i < length; i++)
+            text[i] = (char)('a' + i % 26);
+        std::wstring wtext(text.begin(), text.end());
+        std::vector<short> gtext(text.begin(), text.end());
+        gtext.push_back(0);
+        std::vector<short> dest(length + 1);
+        std::string out;
+        std::wstring wout;
+
+        compare(context, "string_to_gensym", length,
+            [&]() { previous_gensym_string(text, &dest[0], dest.size()); },
+            [&]() { libgsi::gensym_string(text, &dest[0], dest.size()); },
+            [&]() { convert_ascii(text.c_str(), length, &dest[0]); });
+        compare(context, "wide_to_gensym", length,
+            [&]() { previous_gensym_string(wtext, &dest[0], dest.size()); },
+            [&]() { libgsi::gensym_string(wtext, &dest[0], dest.size()); },
+            [&]() { convert_ascii(wtext.c_str(), length, &dest[0]); });
+        compare(context, "gensym_to_string", length,
+            [&]() { out = previous_c_string(&gtext[0]); },
+            [&]() { libgsi::c_string(&gtext[0], out); },
+            [&]() { convert_ascii(&gtext[0], gensym_length(&gtext[0]), &out[0]); });
+        compare(context, "gensym_to_wide", length,
+            [&]() { wout = previous_wide_string(&gtext[0]); },
+            [&]() { libgsi::wide_string(&gtext[0], wout); },
+            [&]() { convert_ascii(&gtext[0], gensym_length(&gtext[0]), &wout[0]); });
+    }
+}
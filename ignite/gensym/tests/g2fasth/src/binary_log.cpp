@@ -0,0 +1,639 @@
+#include <string.h>
+#include <ctype.h>
+#include <stddef.h>
+#include <wchar.h>
+#include "binary_log.hpp"
+#include "binary_io.hpp"
+#include "result_log.hpp"
+#include "g2fasth_platform.hpp"
+
+#ifdef WIN32
+#define snprintf _snprintf
+#endif
+
+using namespace g2::fasth;
+
+namespace {
+// File signature, written once at the beginning of a new log
+const char kMagic[] = "G2FBLOG1";
+const size_t kMagicSize = 8;
+
+// Record types
+enum {
+    record_session = 'B',   // u64 wall clock ms, u64 monotonic ns: all ids before it are forgotten
+    record_name = 'N',      // varint id, str name
+    record_format = 'F',    // varint id, str format
+    record_message = 'M'    // varint time delta ns, varint thread, varint suite id, varint test id,
+                            // u8 level, varint format id, arguments
+};
+
+// Buffered records are written when the buffer grows over this size
+const size_t kWriteThreshold = 64 * 1024;
+
+tthread::mutex s_logs_mutex;
+std::map<std::string, std::weak_ptr<binary_log>> s_logs;
+
+// Open logs, looked up by flush_all() without locking, as it is called from signal handler
+const int kMaxBinaryLogs = 16;
+binary_log* volatile s_binary_logs[kMaxBinaryLogs];
+volatile long s_generation;
+
+G2FASTH_THREAD_LOCAL log_context s_context;
+
+// Ids of context names in the log used last by the thread
+struct name_cache {
+    unsigned generation;
+    const std::string* suite_name;
+    const std::string* test_name;
+    unsigned suite_id;
+    unsigned test_id;
+};
+G2FASTH_THREAD_LOCAL name_cache s_name_cache;
+
+// Arguments consumed by a printf() conversion
+enum arg_kind {
+    arg_none,
+    arg_signed,
+    arg_unsigned,
+    arg_double,
+    arg_string,
+    arg_wide_string,
+    arg_pointer,
+    arg_count
+};
+
+enum arg_size {
+    size_int,
+    size_long,
+    size_long_long,     // also long double
+    size_size
+};
+
+struct format_spec {
+    const char* start;      // '%'
+    const char* flags_end;  // end of flags, width and precision
+    int stars;              // number of '*' width and precision arguments
+    arg_kind kind;
+    arg_size size;
+    char conversion;
+    const char* end;
+};
+
+/**
+* Parses printf() conversion specification starting at '%'.
+* @return Pointer past the specification.
+*/
+const char* parse_spec(const char* p, format_spec& spec)
+{
+    spec.start = p++;
+    spec.stars = 0;
+    while (*p && strchr("-+ #0'", *p))
+        p++;
+    while (isdigit((unsigned char)*p) || *p == '.' || *p == '*')
+    {
+        if (*p == '*')
+            spec.stars++;
+        p++;
+    }
+    spec.flags_end = p;
+    spec.size = size_int;
+    while (true)
+    {
+        if (*p == 'h')
+            p++;
+        else if (*p == 'l' && p[1] == 'l')
+        {
+            spec.size = size_long_long;
+            p += 2;
+        }
+        else if (*p == 'l')
+        {
+            spec.size = size_long;
+            p++;
+        }
+        else if (*p == 'L' || *p == 'q' || *p == 'j')
+        {
+            spec.size = size_long_long;
+            p++;
+        }
+        else if (*p == 'z' || *p == 't')
+        {
+            spec.size = size_size;
+            p++;
+        }
+        else if (*p == 'I')
+        {   // Visual Studio modifiers
+            if (p[1] == '6' && p[2] == '4')
+            {
+                spec.size = size_long_long;
+                p += 3;
+            }
+            else if (p[1] == '3' && p[2] == '2')
+                p += 3;
+            else
+            {
+                spec.size = size_size;
+                p++;
+            }
+        }
+        else
+            break;
+    }
+    spec.conversion = *p;
+    switch (*p)
+    {
+    case 'd': case 'i': case 'c':
+        spec.kind = arg_signed;
+        break;
+    case 'o': case 'u': case 'x': case 'X':
+        spec.kind = arg_unsigned;
+        break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+        spec.kind = arg_double;
+        break;
+    case 's':
+        spec.kind = spec.size == size_long ? arg_wide_string : arg_string;
+        break;
+    case 'p':
+        spec.kind = arg_pointer;
+        break;
+    case 'n':
+        spec.kind = arg_count;
+        break;
+    default:
+        spec.kind = arg_none;
+        break;
+    }
+    spec.end = *p ? p + 1 : p;
+    return spec.end;
+}
+
+/**
+* Formats single value with the conversion, growing the buffer as needed.
+*/
+template <typename T>
+void append_value(std::string& out, const std::string& conversion, int stars, const int* star, T value)
+{
+    char fixed[256];
+    std::vector<char> dynamic;
+    char* buf = fixed;
+    size_t size = sizeof(fixed);
+    while (true)
+    {
+        int length;
+        if (stars == 0)
+            length = snprintf(buf, size, conversion.c_str(), value);
+        else if (stars == 1)
+            length = snprintf(buf, size, conversion.c_str(), star[0], value);
+        else
+            length = snprintf(buf, size, conversion.c_str(), star[0], star[1], value);
+        if (length >= 0 && (size_t)length < size)
+        {
+            out.append(buf, length);
+            return;
+        }
+        // Visual Studio returns -1 on truncation
+        size = length >= 0 ? length + 1 : size * 2;
+        dynamic.resize(size);
+        buf = &dynamic[0];
+    }
+}
+}
+
+const log_context& g2::fasth::get_log_context()
+{
+    return s_context;
+}
+
+log_context_scope::log_context_scope(const std::string* suite_name, const std::string* test_name, log_capture* capture)
+    : d_saved(s_context)
+{
+    s_context.suite_name = suite_name;
+    s_context.test_name = test_name;
+    s_context.capture = capture;
+    s_name_cache.generation = 0;
+}
+
+log_context_scope::~log_context_scope()
+{
+    s_context = d_saved;
+    s_name_cache.generation = 0;
+}
+
+std::shared_ptr<binary_log> binary_log::open(const std::string& path)
+{
+    tthread::lock_guard<tthread::mutex> lg(s_logs_mutex);
+    std::shared_ptr<binary_log> log = s_logs[path].lock();
+    if (log)
+        return log;
+    FILE* file = fopen(path.c_str(), "ab");
+    if (!file)
+        return nullptr;
+    log = std::shared_ptr<binary_log>(new binary_log(file));
+    s_logs[path] = log;
+    return log;
+}
+
+binary_log::binary_log(FILE* file)
+    : d_file(file)
+    , d_last_ns(monotonic_ns())
+    , d_generation((unsigned)atomic_add(&s_generation, 1))
+    , d_record(0)
+{
+    fseek(d_file, 0, SEEK_END);
+    if (ftell(d_file) == 0)
+        d_buffer.append(kMagic, kMagicSize);
+    size_t rec = binary_io::begin_record(d_buffer, record_session);
+    binary_io::put_u64(d_buffer, result_log::now_ms());
+    binary_io::put_u64(d_buffer, d_last_ns);
+    binary_io::end_record(d_buffer, rec);
+    // Messages outside of suites and tests refer to empty name
+    intern_name(nullptr);
+    d_text_format = intern_format("%s");
+    write_buffer();
+    for (int i = 0; i < kMaxBinaryLogs; i++)
+    {
+        if (!s_binary_logs[i])
+        {
+            s_binary_logs[i] = this;
+            break;
+        }
+    }
+}
+
+binary_log::~binary_log()
+{
+    for (int i = 0; i < kMaxBinaryLogs; i++)
+    {
+        if (s_binary_logs[i] == this)
+            s_binary_logs[i] = nullptr;
+    }
+    write_buffer();
+    fclose(d_file);
+}
+
+unsigned binary_log::intern_name(const std::string* name)
+{
+    static const std::string empty;
+    if (!name)
+        name = &empty;
+    auto it = d_names.find(*name);
+    if (it != d_names.end())
+        return it->second;
+    unsigned id = (unsigned)d_names.size();
+    d_names[*name] = id;
+    size_t rec = binary_io::begin_record(d_buffer, record_name);
+    binary_io::put_varint(d_buffer, id);
+    binary_io::put_str(d_buffer, *name);
+    binary_io::end_record(d_buffer, rec);
+    return id;
+}
+
+unsigned binary_log::intern_format(const char* fmt)
+{
+    // Formats are mostly string literals, their address identifies them. The content
+    // is compared anyway, as a buffer may be reused for another format.
+    auto ptr = d_format_ptrs.find(fmt);
+    if (ptr != d_format_ptrs.end() && strcmp(d_format_ids[ptr->second]->c_str(), fmt) == 0)
+        return ptr->second;
+    std::string format(fmt);
+    auto it = d_formats.find(format);
+    if (it == d_formats.end())
+    {
+        unsigned id = (unsigned)d_format_ids.size();
+        it = d_formats.insert(std::make_pair(format, id)).first;
+        d_format_ids.push_back(&it->first);
+        size_t rec = binary_io::begin_record(d_buffer, record_format);
+        binary_io::put_varint(d_buffer, id);
+        binary_io::put_str(d_buffer, format);
+        binary_io::end_record(d_buffer, rec);
+    }
+    d_format_ptrs[fmt] = it->second;
+    return it->second;
+}
+
+void binary_log::begin_message(log_level level, unsigned format_id)
+{
+    name_cache& cache = s_name_cache;
+    if (cache.generation != d_generation || cache.suite_name != s_context.suite_name
+        || cache.test_name != s_context.test_name)
+    {
+        cache.suite_name = s_context.suite_name;
+        cache.test_name = s_context.test_name;
+        cache.suite_id = intern_name(cache.suite_name);
+        cache.test_id = intern_name(cache.test_name);
+        cache.generation = d_generation;
+    }
+    // Time is taken under the lock, so records are ordered and deltas are small
+    unsigned long long now = monotonic_ns();
+    if (now < d_last_ns)
+        now = d_last_ns;
+    d_record = binary_io::begin_record(d_buffer, record_message);
+    binary_io::put_varint(d_buffer, now - d_last_ns);
+    binary_io::put_varint(d_buffer, current_thread_index());
+    binary_io::put_varint(d_buffer, cache.suite_id);
+    binary_io::put_varint(d_buffer, cache.test_id);
+    binary_io::put_u8(d_buffer, (unsigned char)level);
+    binary_io::put_varint(d_buffer, format_id);
+    d_last_ns = now;
+}
+
+void binary_log::end_message()
+{
+    binary_io::end_record(d_buffer, d_record);
+    if (d_buffer.size() >= kWriteThreshold)
+        write_buffer();
+}
+
+void binary_log::write(log_level level, const char* fmt, va_list ap)
+{
+    tthread::lock_guard<tthread::mutex> lg(d_mutex);
+    begin_message(level, intern_format(fmt));
+    format_spec spec;
+    for (const char* p = fmt; (p = strchr(p, '%')) != nullptr; )
+    {
+        if (p[1] == '%')
+        {
+            p += 2;
+            continue;
+        }
+        p = parse_spec(p, spec);
+        for (int i = 0; i < spec.stars; i++)
+            binary_io::put_svarint(d_buffer, va_arg(ap, int));
+        switch (spec.kind)
+        {
+        case arg_signed:
+        {
+            long long value;
+            if (spec.size == size_long_long)
+                value = va_arg(ap, long long);
+            else if (spec.size == size_long)
+                value = va_arg(ap, long);
+            else if (spec.size == size_size)
+                value = va_arg(ap, ptrdiff_t);
+            else
+                value = va_arg(ap, int);
+            binary_io::put_svarint(d_buffer, value);
+            break;
+        }
+        case arg_unsigned:
+        {
+            unsigned long long value;
+            if (spec.size == size_long_long)
+                value = va_arg(ap, unsigned long long);
+            else if (spec.size == size_long)
+                value = va_arg(ap, unsigned long);
+            else if (spec.size == size_size)
+                value = va_arg(ap, size_t);
+            else
+                value = va_arg(ap, unsigned int);
+            binary_io::put_varint(d_buffer, value);
+            break;
+        }
+        case arg_double:
+        {
+            double value = spec.size == size_long_long ? (double)va_arg(ap, long double) : va_arg(ap, double);
+            unsigned long long bits;
+            memcpy(&bits, &value, sizeof(bits));
+            binary_io::put_u64(d_buffer, bits);
+            break;
+        }
+        case arg_string:
+        {
+            const char* value = va_arg(ap, const char*);
+            if (!value)
+                value = "(null)";
+            size_t length = strlen(value);
+            binary_io::put_varint(d_buffer, length);
+            d_buffer.append(value, length);
+            break;
+        }
+        case arg_wide_string:
+        {
+            // Stored narrowed, characters out of ASCII are replaced
+            const wchar_t* value = va_arg(ap, const wchar_t*);
+            if (!value)
+                value = L"(null)";
+            size_t length = wcslen(value);
+            binary_io::put_varint(d_buffer, length);
+            for (size_t i = 0; i < length; i++)
+                d_buffer.push_back(value[i] < 0x80 ? (char)value[i] : '?');
+            break;
+        }
+        case arg_pointer:
+            binary_io::put_varint(d_buffer, (size_t)va_arg(ap, void*));
+            break;
+        case arg_count:
+            va_arg(ap, void*);
+            break;
+        case arg_none:
+            break;
+        }
+    }
+    end_message();
+}
+
+void binary_log::write_text(log_level level, const char* text, size_t length)
+{
+    tthread::lock_guard<tthread::mutex> lg(d_mutex);
+    begin_message(level, d_text_format);
+    binary_io::put_varint(d_buffer, length);
+    d_buffer.append(text, length);
+    end_message();
+}
+
+void binary_log::write_buffer()
+{
+    if (d_buffer.empty())
+        return;
+    fwrite(d_buffer.data(), 1, d_buffer.size(), d_file);
+    fflush(d_file);
+    d_buffer.clear();
+}
+
+void binary_log::flush()
+{
+    tthread::lock_guard<tthread::mutex> lg(d_mutex);
+    write_buffer();
+}
+
+void binary_log::flush_all()
+{
+    for (int i = 0; i < kMaxBinaryLogs; i++)
+    {
+        binary_log* log = s_binary_logs[i];
+        if (log && log->d_mutex.try_lock())
+        {
+            log->write_buffer();
+            log->d_mutex.unlock();
+        }
+    }
+}
+
+binary_log_reader::binary_log_reader()
+    : d_file(nullptr)
+    , d_session_ns(0)
+    , d_session_wall_ms(0)
+    , d_last_ns(0)
+{
+}
+
+binary_log_reader::~binary_log_reader()
+{
+    if (d_file)
+        fclose(d_file);
+}
+
+bool binary_log_reader::open(const std::string& path)
+{
+    if (d_file)
+        fclose(d_file);
+    d_names.clear();
+    d_formats.clear();
+    d_file = fopen(path.c_str(), "rb");
+    if (!d_file)
+        return false;
+    char magic[kMagicSize];
+    if (fread(magic, 1, kMagicSize, d_file) != kMagicSize || memcmp(magic, kMagic, kMagicSize) != 0)
+    {
+        fclose(d_file);
+        d_file = nullptr;
+        return false;
+    }
+    return true;
+}
+
+const std::string* binary_log_reader::string_by_id(const std::vector<const std::string*>& ids, unsigned id) const
+{
+    static const std::string unknown("<unknown>");
+    if (id >= ids.size() || !ids[id])
+        return &unknown;
+    return ids[id];
+}
+
+bool binary_log_reader::next(binary_log_entry& entry)
+{
+    if (!d_file)
+        return false;
+    unsigned char type;
+    while (binary_io::read_record(d_file, type, d_payload))
+    {
+        binary_io::decoder dec(d_payload.data(), d_payload.size());
+        switch (type)
+        {
+        case record_session:
+            d_names.clear();
+            d_formats.clear();
+            d_session_wall_ms = dec.get_u64();
+            d_session_ns = d_last_ns = dec.get_u64();
+            break;
+        case record_name:
+        case record_format:
+        {
+            std::vector<const std::string*>& ids = type == record_name ? d_names : d_formats;
+            unsigned id = (unsigned)dec.get_varint();
+            std::string value;
+            if (!dec.get_str(value))
+                break;
+            d_strings.push_back(value);
+            if (id >= ids.size())
+                ids.resize(id + 1, nullptr);
+            ids[id] = &d_strings.back();
+            break;
+        }
+        case record_message:
+        {
+            d_last_ns += dec.get_varint();
+            entry.time_ns = d_last_ns - d_session_ns;
+            entry.wall_ms = d_session_wall_ms + entry.time_ns / 1000000;
+            entry.thread = (unsigned)dec.get_varint();
+            entry.suite_name = string_by_id(d_names, (unsigned)dec.get_varint());
+            entry.test_name = string_by_id(d_names, (unsigned)dec.get_varint());
+            entry.level = (log_level)dec.get_u8();
+            const char* p = string_by_id(d_formats, (unsigned)dec.get_varint())->c_str();
+            entry.text.clear();
+            format_spec spec;
+            std::string conversion;
+            while (*p)
+            {
+                const char* percent = strchr(p, '%');
+                if (!percent)
+                {
+                    entry.text.append(p);
+                    break;
+                }
+                entry.text.append(p, percent);
+                if (percent[1] == '%')
+                {
+                    entry.text.push_back('%');
+                    p = percent + 2;
+                    continue;
+                }
+                p = parse_spec(percent, spec);
+                int star[2] = { 0, 0 };
+                for (int i = 0; i < spec.stars; i++)
+                {
+                    int value = (int)dec.get_svarint();
+                    if (i < 2)
+                        star[i] = value;
+                }
+                conversion.assign(spec.start, spec.flags_end);
+                switch (spec.kind)
+                {
+                case arg_signed:
+                case arg_unsigned:
+                {
+                    if (spec.conversion == 'c')
+                    {
+                        conversion += 'c';
+                        append_value(entry.text, conversion, spec.stars, star, (int)dec.get_svarint());
+                        break;
+                    }
+                    conversion += "ll";
+                    conversion += spec.conversion;
+                    if (spec.kind == arg_signed)
+                        append_value(entry.text, conversion, spec.stars, star, dec.get_svarint());
+                    else
+                        append_value(entry.text, conversion, spec.stars, star, dec.get_varint());
+                    break;
+                }
+                case arg_double:
+                {
+                    unsigned long long bits = dec.get_u64();
+                    double value;
+                    memcpy(&value, &bits, sizeof(value));
+                    conversion += spec.conversion;
+                    append_value(entry.text, conversion, spec.stars, star, value);
+                    break;
+                }
+                case arg_string:
+                case arg_wide_string:
+                {
+                    size_t length = (size_t)dec.get_varint();
+                    const char* bytes = dec.get_bytes(length);
+                    std::string value(bytes ? bytes : "", bytes ? length : 0);
+                    conversion += 's';
+                    append_value(entry.text, conversion, spec.stars, star, value.c_str());
+                    break;
+                }
+                case arg_pointer:
+                    conversion += 'p';
+                    append_value(entry.text, conversion, spec.stars, star, (void*)(size_t)dec.get_varint());
+                    break;
+                case arg_count:
+                    break;
+                case arg_none:
+                    entry.text.append(spec.start, spec.end);
+                    break;
+                }
+            }
+            if (!dec.ok())
+                entry.text += " <truncated>";
+            return true;
+        }
+        default:
+            break;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <map>
+#ifndef WIN32
+#include <fcntl.h>
+#endif
+#include "file_sink.hpp"
+#include "g2fasth_platform.hpp"
+#include "signal_registry.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+tthread::mutex s_sinks_mutex;
+std::map<std::string, std::weak_ptr<file_sink>> s_sinks;
+
+// Open sinks, looked up by flush_all() without locking, as it is called from signal handler
+signal_registry<file_sink> s_file_sinks;
+
+std::string rotated_path(const std::string& path, unsigned index)
+{
+    char suffix[16];
+    sprintf(suffix, ".%u", index);
+    return path + suffix;
+}
+}
+
+std::shared_ptr<file_sink> file_sink::open(const std::string& path, const file_sink_options& options)
+{
+    tthread::lock_guard<tthread::mutex> lg(s_sinks_mutex);
+    std::shared_ptr<file_sink> sink = s_sinks[path].lock();
+    if (sink)
+        return sink;
+    sink = std::shared_ptr<file_sink>(new file_sink(path, options));
+    if (!sink->d_file)
+        return nullptr;
+    s_sinks[path] = sink;
+    return sink;
+}
+
+file_sink::file_sink(const std::string& path, const file_sink_options& options)
+    : d_path(path)
+    , d_options(options)
+    , d_file(nullptr)
+    , d_size(0)
+    , d_reserved(0)
+    , d_opened_ns(0)
+    , d_buffered_ns(0)
+{
+    if (!open_file())
+        return;
+    d_buffer.reserve(d_options.buffer_size);
+    s_file_sinks.add(this);
+}
+
+file_sink::~file_sink()
+{
+    s_file_sinks.remove(this);
+    if (d_file)
+    {
+        write_buffer();
+        fclose(d_file);
+    }
+}
+
+bool file_sink::open_file()
+{
+    d_file = fopen(d_path.c_str(), "ab");
+    if (!d_file)
+        return false;
+    fseek(d_file, 0, SEEK_END);
+    d_size = d_reserved = (unsigned long long)ftell(d_file);
+    d_opened_ns = monotonic_ns();
+    reserve();
+    return true;
+}
+
+void file_sink::reserve()
+{
+    if (!d_options.preallocate || d_size < d_reserved)
+        return;
+#if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+    // Space is reserved without changing file size, so appends continue at the end
+    fflush(d_file);
+    if (fallocate(fileno(d_file), FALLOC_FL_KEEP_SIZE, d_size, d_options.preallocate) == 0)
+        d_reserved = d_size + d_options.preallocate;
+    else
+        d_options.preallocate = 0;
+#else
+    d_options.preallocate = 0;
+#endif
+}
+
+void file_sink::rotate()
+{
+    write_buffer();
+    fclose(d_file);
+    d_file = nullptr;
+    if (d_options.max_files == 0)
+        remove(d_path.c_str());
+    else
+    {
+        remove(rotated_path(d_path, d_options.max_files).c_str());
+        for (unsigned i = d_options.max_files; i > 1; i--)
+            rename(rotated_path(d_path, i - 1).c_str(), rotated_path(d_path, i).c_str());
+        rename(d_path.c_str(), rotated_path(d_path, 1).c_str());
+    }
+    open_file();
+}
+
+void file_sink::write(const char* text, size_t length)
+{
+    tthread::lock_guard<tthread::mutex> lg(d_mutex);
+    append(text, length, false);
+}
+
+void file_sink::write_line(const char* text, size_t length)
+{
+    tthread::lock_guard<tthread::mutex> lg(d_mutex);
+    append(text, length, true);
+}
+
+void file_sink::append(const char* text, size_t length, bool new_line)
+{
+    if (!d_file)
+        return;
+    if (new_line)
+        length++;
+    unsigned long long now = monotonic_ns();
+    if ((d_options.max_size && d_size > 0 && d_size + length > d_options.max_size)
+        || (d_options.rotate_interval_s && now - d_opened_ns >= d_options.rotate_interval_s * 1000000000ULL))
+    {
+        rotate();
+        if (!d_file)
+            return;
+    }
+    if (d_buffer.empty())
+        d_buffered_ns = now;
+    if (new_line)
+    {
+        d_buffer.append(text, length - 1);
+        d_buffer.push_back('\n');
+    }
+    else
+        d_buffer.append(text, length);
+    d_size += length;
+    if (d_buffer.size() >= d_options.buffer_size
+        || now - d_buffered_ns >= d_options.flush_interval_ms * 1000000ULL)
+        write_buffer();
+}
+
+void file_sink::write_buffer()
+{
+    if (d_buffer.empty())
+        return;
+    fwrite(d_buffer.data(), 1, d_buffer.size(), d_file);
+    fflush(d_file);
+    d_buffer.clear();
+    reserve();
+}
+
+void file_sink::flush()
+{
+    tthread::lock_guard<tthread::mutex> lg(d_mutex);
+    if (d_file)
+        write_buffer();
+}
+
+void file_sink::flush_all()
+{
+    s_file_sinks.for_each([](file_sink* sink)
+    {
+        if (sink->d_mutex.try_lock())
+        {
+            if (sink->d_file)
+                sink->write_buffer();
+            sink->d_mutex.unlock();
+        }
+    });
+}
@@ -2,6 +2,9 @@
 #include <iostream>
 #include <signal.h>
 #include "g2fasth.hpp"
+#include "binary_log.hpp"
+#include "trace.hpp"
+#include "metrics.hpp"
 
 #ifdef WIN32
 #include <io.h>
@@ -13,10 +16,39 @@
 static const char kLogLevelFlag[] = "log_level";
 static const char kOutputFlag[] = "output";
 static const char kReportFlag[] = "report";
+static const char kResultLogFlag[] = "result_log";
+static const char kAsyncLogFlag[] = "async_log";
+static const char kLogDropFlag[] = "log_drop";
+static const char kBinaryLogFlag[] = "binary_log";
+static const char kLogCaptureFlag[] = "log_capture";
+static const char kLogCaptureFailedFlag[] = "log_capture_failed";
+static const char kTraceFlag[] = "trace";
+static const char kMetricsFlag[] = "metrics";
+static const char kMetricsIntervalFlag[] = "metrics_interval";
+static const char kMetricsSummaryFlag[] = "metrics_summary";
+static const char kMetricsSummaryIntervalFlag[] = "metrics_summary_interval";
 
-g2::fasth::g2_options::g2_options() : d_log_level(0), d_init(0), d_logger(g2::fasth::log_level::REGULAR)
+g2::fasth::g2_options::g2_options() : d_log_level(0), d_async_log(0), d_log_drop(false), d_log_capture_failed(false),
+    d_metrics_interval(10), d_metrics_summary(false), d_metrics_summary_interval(0), d_init(0),
+    d_logger(g2::fasth::log_level::REGULAR)
 {
     d_logger.add_output_stream(std::cout, g2::fasth::log_level::REGULAR);
+}
+
+void g2::fasth::g2_options::configure_logger(logger& target) const
+{
+    if (d_async_log > 0)
+        target.set_async(d_async_log, d_log_drop ? logger::drop : logger::block);
+    if (!d_binary_log.empty())
+    {
+        auto log = binary_log::open(d_binary_log);
+        if (log)
+            target.add_binary_log(log, log_level::VERBOSE);
+    }
+    if (d_log_capture == "block")
+        target.set_capture(logger::capture_block, d_log_capture_failed);
+    else if (d_log_capture == "report")
+        target.set_capture(logger::capture_report, d_log_capture_failed);
 }
 
 const char* g2::fasth::g2_options::parse_flag_value(const char* str, const char* flag, bool def_optional) {
@@ -81,7 +113,18 @@ bool g2::fasth::g2_options::parse_string_flag(const char* str, const char* flag,
 bool g2::fasth::g2_options::parse_flag(const char* const arg) {
     return parse_int_flag(arg, kLogLevelFlag, &d_log_level) ||
         parse_string_flag(arg, kOutputFlag, &d_output) ||
-        parse_string_flag(arg, kReportFlag, &d_report);
+        parse_string_flag(arg, kReportFlag, &d_report) ||
+        parse_string_flag(arg, kResultLogFlag, &d_result_log) ||
+        parse_int_flag(arg, kAsyncLogFlag, &d_async_log) ||
+        parse_bool_flag(arg, kLogDropFlag, &d_log_drop) ||
+        parse_string_flag(arg, kBinaryLogFlag, &d_binary_log) ||
+        parse_string_flag(arg, kLogCaptureFlag, &d_log_capture) ||
+        parse_bool_flag(arg, kLogCaptureFailedFlag, &d_log_capture_failed) ||
+        parse_string_flag(arg, kTraceFlag, &d_trace) ||
+        parse_int_flag(arg, kMetricsIntervalFlag, &d_metrics_interval) ||
+        parse_int_flag(arg, kMetricsSummaryIntervalFlag, &d_metrics_summary_interval) ||
+        parse_bool_flag(arg, kMetricsSummaryFlag, &d_metrics_summary) ||
+        parse_string_flag(arg, kMetricsFlag, &d_metrics);
 }
 
 void g2::fasth::g2_options::parse_flags_only(int* argc, char** argv) {
@@ -111,6 +154,16 @@ void g2::fasth::g2_options::parse_arguments(int* argc, char** argv)
 
     d_init = *argc;
     parse_flags_only(argc, argv);
+    // Trace is recorded from now on and written when the process exits
+    if (!d_trace.empty())
+        trace_recorder::start(d_trace);
+    // Metrics file is refreshed periodically and written once more at exit
+    if (!d_metrics.empty())
+        metrics_registry::start_export(d_metrics, d_metrics_interval > 0 ? d_metrics_interval : 0);
+    if (d_metrics_summary_interval > 0)
+        metrics_registry::start_summary(d_metrics_summary_interval);
+    else if (d_metrics_summary)
+        metrics_registry::print_summary_at_exit();
 }
 
 static volatile bool g_exit = true;
@@ -152,6 +205,8 @@ extern "C" void signal_handler( int sig_num )
         message = "Unknown signal"; break;
     }
 
+    // Queued log messages are written before the process exits
+    g2::fasth::logger::flush_all();
 #ifdef WIN32
     _write(_fileno(stdout), message, strlen(message));
 #else
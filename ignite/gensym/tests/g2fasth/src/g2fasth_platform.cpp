@@ -0,0 +1,13 @@
+#include "g2fasth_platform.hpp"
+
+namespace {
+volatile long s_thread_count;
+G2FASTH_THREAD_LOCAL unsigned s_thread_index;
+}
+
+unsigned g2::fasth::current_thread_index()
+{
+    if (!s_thread_index)
+        s_thread_index = (unsigned)atomic_add(&s_thread_count, 1);
+    return s_thread_index;
+}
@@ -1,4 +1,27 @@
 #include "libgsi.hpp"
+#include "trace.hpp"
+#include "metrics.hpp"
+
+namespace {
+g2::fasth::metric_histogram& callback_histogram(const char* name)
+{
+    return g2::fasth::metrics_registry::histogram("g2fasth_gsi_callback_seconds",
+        "Time spent in GSI callbacks.", std::string("callback=\"") + name + "\"");
+}
+
+g2::fasth::metric_histogram& s_get_tcp_port = callback_histogram("gsi_get_tcp_port");
+g2::fasth::metric_histogram& s_set_up = callback_histogram("gsi_set_up");
+g2::fasth::metric_histogram& s_resume_context = callback_histogram("gsi_resume_context");
+g2::fasth::metric_histogram& s_receive_registration = callback_histogram("gsi_receive_registration");
+g2::fasth::metric_histogram& s_initialize_context = callback_histogram("gsi_initialize_context");
+g2::fasth::metric_histogram& s_shutdown_context = callback_histogram("gsi_shutdown_context");
+g2::fasth::metric_histogram& s_g2_poll = callback_histogram("gsi_g2_poll");
+g2::fasth::metric_histogram& s_set_data = callback_histogram("gsi_set_data");
+g2::fasth::metric_histogram& s_get_data = callback_histogram("gsi_get_data");
+g2::fasth::metric_histogram& s_receive_deregistrations = callback_histogram("gsi_receive_deregistrations");
+g2::fasth::metric_histogram& s_receive_message = callback_histogram("gsi_receive_message");
+g2::fasth::metric_histogram& s_pause_context = callback_histogram("gsi_pause_context");
+}
 
 /// GSI callbacks stubs
 
@@ -8,6 +31,8 @@
 */
 gsi_int gsi_get_tcp_port()
 {
+    G2FASTH_TRACE_SCOPE("gsi", "gsi_get_tcp_port");
+    g2::fasth::metric_timer timer(s_get_tcp_port);
     return g2::fasth::libgsi::getInstance().gsi_get_tcp_port_();
 }
 
@@ -17,6 +42,8 @@ gsi_int gsi_get_tcp_port()
 */
 void gsi_set_up()
 {
+    G2FASTH_TRACE_SCOPE("gsi", "gsi_set_up");
+    g2::fasth::metric_timer timer(s_set_up);
     g2::fasth::libgsi::getInstance().gsi_set_up_();
 }
 
@@ -25,6 +52,8 @@ void gsi_set_up()
 */
 void gsi_resume_context()
 {
+    G2FASTH_TRACE_SCOPE("gsi", "gsi_resume_context");
+    g2::fasth::metric_timer timer(s_resume_context);
     g2::fasth::libgsi::getInstance().gsi_resume_context_();
 }
 
@@ -33,6 +62,8 @@ void gsi_resume_context()
 */
 void gsi_receive_registration(gsi_registration registration)
 {
+    G2FASTH_TRACE_SCOPE("gsi", "gsi_receive_registration");
+    g2::fasth::metric_timer timer(s_receive_registration);
     g2::fasth::libgsi::getInstance().gsi_receive_registration_(registration);
 }
 
@@ -41,6 +72,8 @@ void gsi_receive_registration(gsi_registration registration)
 */
 gsi_int gsi_initialize_context(char* remote_process_init_string, gsi_int length)
 {
+    G2FASTH_TRACE_SCOPE("gsi", "gsi_initialize_context");
+    g2::fasth::metric_timer timer(s_initialize_context);
     return g2::fasth::libgsi::getInstance().gsi_initialize_context_(remote_process_init_string, length);
 }
 
@@ -50,6 +83,8 @@ gsi_int gsi_initialize_context(char* remote_process_init_string, gsi_int length)
 */
 void gsi_shutdown_context()
 {
+    G2FASTH_TRACE_SCOPE("gsi", "gsi_shutdown_context");
+    g2::fasth::metric_timer timer(s_shutdown_context);
     g2::fasth::libgsi::getInstance().gsi_shutdown_context_();
 }
 
@@ -58,6 +93,8 @@ void gsi_shutdown_context()
 */
 void gsi_g2_poll()
 {
+    G2FASTH_TRACE_SCOPE("gsi", "gsi_g2_poll");
+    g2::fasth::metric_timer timer(s_g2_poll);
     g2::fasth::libgsi::getInstance().gsi_g2_poll_();
 }
 
@@ -66,6 +103,8 @@ void gsi_g2_poll()
 */
 void gsi_set_data(gsi_registered_item* registered_item_array, gsi_int count)
 {
+    G2FASTH_TRACE_SCOPE("gsi", "gsi_set_data");
+    g2::fasth::metric_timer timer(s_set_data);
     g2::fasth::libgsi::getInstance().gsi_set_data_(registered_item_array, count);
 }
 
@@ -74,6 +113,8 @@ void gsi_set_data(gsi_registered_item* registered_item_array, gsi_int count)
 */
 void gsi_get_data(gsi_registered_item* registered_item_array, gsi_int count)
 {
+    G2FASTH_TRACE_SCOPE("gsi", "gsi_get_data");
+    g2::fasth::metric_timer timer(s_get_data);
     g2::fasth::libgsi::getInstance().gsi_get_data_(registered_item_array, count);
 }
 
@@ -82,6 +123,8 @@ void gsi_get_data(gsi_registered_item* registered_item_array, gsi_int count)
 */
 void gsi_receive_deregistrations(gsi_registered_item* registered_item_array, gsi_int count)
 {
+    G2FASTH_TRACE_SCOPE("gsi", "gsi_receive_deregistrations");
+    g2::fasth::metric_timer timer(s_receive_deregistrations);
     g2::fasth::libgsi::getInstance().gsi_receive_deregistrations_(registered_item_array, count);
 }
 
@@ -90,6 +133,8 @@ void gsi_receive_deregistrations(gsi_registered_item* registered_item_array, gsi
 */
 void gsi_receive_message(char* message, gsi_int length)
 {
+    G2FASTH_TRACE_SCOPE("gsi", "gsi_receive_message");
+    g2::fasth::metric_timer timer(s_receive_message);
     g2::fasth::libgsi::getInstance().gsi_receive_message_(message, length);
 }
 
@@ -99,5 +144,7 @@ void gsi_receive_message(char* message, gsi_int length)
 */
 void gsi_pause_context()
 {
+    G2FASTH_TRACE_SCOPE("gsi", "gsi_pause_context");
+    g2::fasth::metric_timer timer(s_pause_context);
     g2::fasth::libgsi::getInstance().gsi_pause_context_();
 }
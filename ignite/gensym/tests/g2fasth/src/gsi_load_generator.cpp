@@ -0,0 +1,293 @@
+#include <math.h>
+#include <stdio.h>
+#include "gsi_load_generator.hpp"
+#include "g2fasth_platform.hpp"
+#include "metrics.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+std::vector<long long> bucket_difference(const std::vector<long long>& from, const std::vector<long long>& to)
+{
+    std::vector<long long> counts(to);
+    for (size_t i = 0; i < counts.size() && i < from.size(); i++)
+        counts[i] -= from[i];
+    return counts;
+}
+
+double percentile_us(const std::vector<long long>& counts, double fraction)
+{
+    return metric_histogram::percentile(counts, fraction) / 1e3;
+}
+}
+
+load_profile load_profile::constant(double rate)
+{
+    load_profile profile;
+    profile.rate = rate;
+    profile.peak_rate = rate;
+    return profile;
+}
+
+load_profile load_profile::ramp(double from_rate, double to_rate, double ramp_s)
+{
+    load_profile profile;
+    profile.shape = load_ramp;
+    profile.rate = from_rate;
+    profile.peak_rate = to_rate;
+    profile.ramp_s = ramp_s;
+    return profile;
+}
+
+load_profile load_profile::burst(double base_rate, double peak_rate, double period_s, double burst_s)
+{
+    load_profile profile;
+    profile.shape = load_burst;
+    profile.rate = base_rate;
+    profile.peak_rate = peak_rate;
+    profile.period_s = period_s;
+    profile.burst_s = burst_s < period_s ? burst_s : period_s;
+    return profile;
+}
+
+double load_profile::rate_at(double t) const
+{
+    switch (shape)
+    {
+    case load_ramp:
+        if (t >= ramp_s)
+            return peak_rate;
+        return rate + (peak_rate - rate) * t / ramp_s;
+    case load_burst:
+        if (period_s <= 0)
+            return rate;
+        return t - period_s * floor(t / period_s) < burst_s ? peak_rate : rate;
+    default:
+        return rate;
+    }
+}
+
+double load_profile::updates_until(double t) const
+{
+    switch (shape)
+    {
+    case load_ramp:
+        if (t >= ramp_s)
+            return (rate + peak_rate) / 2 * ramp_s + peak_rate * (t - ramp_s);
+        return rate * t + (peak_rate - rate) * t * t / (2 * ramp_s);
+    case load_burst:
+    {
+        if (period_s <= 0)
+            return rate * t;
+        double periods = floor(t / period_s);
+        double rest = t - periods * period_s;
+        double in_burst = rest < burst_s ? rest : burst_s;
+        return periods * (peak_rate * burst_s + rate * (period_s - burst_s))
+            + peak_rate * in_burst + rate * (rest - in_burst);
+    }
+    default:
+        return rate * t;
+    }
+}
+
+gsi_load_generator::gsi_load_generator(libgsi& gsi)
+    : d_gsi(gsi), d_next_variable(0), d_next_value(0), d_offered(0), d_queued(0), d_stop(0), d_thread(nullptr)
+{
+}
+
+gsi_load_generator::~gsi_load_generator()
+{
+    stop();
+}
+
+int gsi_load_generator::add_variables(const std::string& prefix, int count, g2_type type)
+{
+    struct declaration {
+        std::string name;
+        g2_type type;
+    };
+    std::vector<declaration> declarations((size_t)count);
+    for (int i = 0; i < count; i++)
+    {
+        declarations[i].name = prefix + std::to_string((long long)i);
+        declarations[i].type = type;
+    }
+    d_gsi.declare_g2_variables(declarations.begin(), declarations.end());
+    int added = 0;
+    for (int i = 0; i < count; i++)
+        added += add_variable(declarations[i].name);
+    return added;
+}
+
+bool gsi_load_generator::add_variable(const std::string& name)
+{
+    g2_variable* var = d_gsi.get_declared_variable(name);
+    if (!var)
+        return false;
+    d_variables.push_back(var);
+    return true;
+}
+
+void gsi_load_generator::take_snapshot(snapshot& snap, unsigned long long now)
+{
+    snap.time_ns = now;
+    snap.offered = d_offered;
+    snap.queued = d_queued;
+    snap.sent = d_gsi.updates_sent().value();
+    snap.latency = d_gsi.update_latency().buckets();
+}
+
+void gsi_load_generator::add_sample(const snapshot& from, const snapshot& to, double time_s, double target_rate)
+{
+    double interval_s = (to.time_ns - from.time_ns) / 1e9;
+    if (interval_s <= 0)
+        return;
+    std::vector<long long> latency = bucket_difference(from.latency, to.latency);
+    load_sample sample;
+    sample.time_s = time_s;
+    sample.target_rate = target_rate;
+    sample.offered_rate = (to.offered - from.offered) / interval_s;
+    sample.queued_rate = (to.queued - from.queued) / interval_s;
+    sample.sent_rate = (to.sent - from.sent) / interval_s;
+    sample.backlog = d_gsi.pending_updates();
+    sample.latency_p50_us = percentile_us(latency, 0.5);
+    sample.latency_p99_us = percentile_us(latency, 0.99);
+    sample.latency_max_us = percentile_us(latency, 1);
+    d_samples.push_back(sample);
+}
+
+bool gsi_load_generator::run(const load_profile& profile, const load_options& options)
+{
+    if (d_variables.empty())
+        return false;
+    atomic_store(&d_stop, 0);
+    d_thread_profile = profile;
+    d_thread_options = options;
+    run_thread(this);
+    return true;
+}
+
+void gsi_load_generator::run_thread(void* arg)
+{
+    gsi_load_generator* generator = static_cast<gsi_load_generator*>(arg);
+    const load_profile& profile = generator->d_thread_profile;
+    const load_options& options = generator->d_thread_options;
+    libgsi& gsi = generator->d_gsi;
+    std::vector<g2_variable*>& variables = generator->d_variables;
+
+    generator->d_samples.clear();
+    generator->d_summary = load_summary();
+    generator->d_offered = 0;
+    generator->d_queued = 0;
+    const unsigned long long start = monotonic_ns();
+    snapshot first, last;
+    generator->take_snapshot(first, start);
+    last = first;
+    double sample_s = options.interval_s;
+    size_t max_backlog = 0;
+    for (;;)
+    {
+        unsigned long long now = monotonic_ns();
+        double t = (now - start) / 1e9;
+        bool done = t >= options.duration_s || atomic_load(&generator->d_stop);
+        // Updates due so far are queued at once, so the rate holds even if ticks are late
+        long long due = (long long)profile.updates_until(t < options.duration_s ? t : options.duration_s);
+        for (; generator->d_offered < due; generator->d_offered++)
+        {
+            g2_variable* var = variables[generator->d_next_variable];
+            if (++generator->d_next_variable == variables.size())
+                generator->d_next_variable = 0;
+            gsi.assign_number(var, generator->d_next_value += 1);
+            if (gsi.update_g2_variable(var))
+                generator->d_queued++;
+        }
+        size_t backlog = gsi.pending_updates();
+        if (backlog > max_backlog)
+            max_backlog = backlog;
+        if (options.poll)
+            gsi.gsi_g2_poll_();
+
+        if (t >= sample_s || done)
+        {
+            snapshot current;
+            generator->take_snapshot(current, monotonic_ns());
+            generator->add_sample(last, current, t, profile.rate_at(t));
+            last.time_ns = current.time_ns;
+            last.offered = current.offered;
+            last.queued = current.queued;
+            last.sent = current.sent;
+            last.latency.swap(current.latency);
+            while (sample_s <= t)
+                sample_s += options.interval_s;
+        }
+        if (done)
+            break;
+        tthread::this_thread::sleep_for(tthread::chrono::milliseconds(options.tick_ms));
+    }
+
+    load_summary& summary = generator->d_summary;
+    std::vector<long long> latency = bucket_difference(first.latency, last.latency);
+    summary.elapsed_s = (last.time_ns - start) / 1e9;
+    summary.offered = generator->d_offered;
+    summary.queued = generator->d_queued;
+    summary.sent = last.sent - first.sent;
+    summary.max_backlog = max_backlog;
+    summary.latency_p50_us = percentile_us(latency, 0.5);
+    summary.latency_p90_us = percentile_us(latency, 0.9);
+    summary.latency_p99_us = percentile_us(latency, 0.99);
+    summary.latency_max_us = percentile_us(latency, 1);
+}
+
+bool gsi_load_generator::start(const load_profile& profile, const load_options& options)
+{
+    if (d_thread || d_variables.empty())
+        return false;
+    atomic_store(&d_stop, 0);
+    d_thread_profile = profile;
+    d_thread_options = options;
+    d_thread = new tthread::thread(run_thread, this);
+    return true;
+}
+
+void gsi_load_generator::stop()
+{
+    atomic_store(&d_stop, 1);
+    if (d_thread)
+    {
+        d_thread->join();
+        delete d_thread;
+        d_thread = nullptr;
+    }
+}
+
+std::string gsi_load_generator::samples_csv() const
+{
+    std::string csv = "time_s,target_rate,offered_rate,queued_rate,sent_rate,backlog,"
+        "latency_p50_us,latency_p99_us,latency_max_us\n";
+    for (size_t i = 0; i < d_samples.size(); i++)
+    {
+        const load_sample& s = d_samples[i];
+        char line[256];
+        sprintf(line, "%.3f,%.0f,%.0f,%.0f,%.0f,%u,%.1f,%.1f,%.1f\n", s.time_s, s.target_rate,
+            s.offered_rate, s.queued_rate, s.sent_rate, (unsigned)s.backlog,
+            s.latency_p50_us, s.latency_p99_us, s.latency_max_us);
+        csv += line;
+    }
+    return csv;
+}
+
+std::string gsi_load_generator::summary_text() const
+{
+    const load_summary& s = d_summary;
+    double elapsed_s = s.elapsed_s > 0 ? s.elapsed_s : 1;
+    char text[512];
+    sprintf(text, "elapsed %.3f s, %u variables\n"
+        "offered %lld updates (%.0f/s), queued %lld, merged with pending %lld\n"
+        "sent %lld values (%.0f/s), max backlog %u\n"
+        "latency us: p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n",
+        s.elapsed_s, (unsigned)d_variables.size(),
+        s.offered, s.offered / elapsed_s, s.queued, s.offered - s.queued,
+        s.sent, s.sent / elapsed_s, (unsigned)s.max_backlog,
+        s.latency_p50_us, s.latency_p90_us, s.latency_p99_us, s.latency_max_us);
+    return text;
+}
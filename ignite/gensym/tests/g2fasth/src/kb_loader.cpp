@@ -0,0 +1,312 @@
+#include <string.h>
+#include <map>
+#include "kb_loader.hpp"
+#include "mapped_file.hpp"
+#include "tinyxml2.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+typedef tinyxml2::XMLReader xml_reader;
+typedef tinyxml2::XMLReader::Span span;
+
+enum tag_kind {
+    tag_none,   // end of input or malformed document
+    tag_start,
+    tag_end,
+    tag_empty
+};
+
+inline bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/**
+* Reads next tag, skipping attributes. Empty elements are consumed as a whole.
+* @param name Receives tag name.
+* @param text If not null, receives decoded text following the start tag.
+*/
+tag_kind next_tag(xml_reader& reader, span& name, std::string* text = nullptr)
+{
+    while (true)
+    {
+        switch (reader.Next())
+        {
+        case xml_reader::START_ELEMENT:
+            name = reader.Name();
+            if (reader.IsEmptyElement())
+            {
+                reader.SkipSubtree();
+                return tag_empty;
+            }
+            if (text)
+                text->clear();
+            return tag_start;
+        case xml_reader::END_ELEMENT:
+            name = reader.Name();
+            return tag_end;
+        case xml_reader::TEXT:
+            if (text)
+                text->append(reader.DecodedValue());
+            break;
+        case xml_reader::ATTRIBUTE:
+            break;
+        default:
+            return tag_none;
+        }
+    }
+}
+
+/**
+* Returns text with surrounding whitespace trimmed.
+*/
+std::string trim(const std::string& text)
+{
+    size_t begin = 0;
+    size_t end = text.size();
+    while (begin < end && is_space(text[begin]))
+        begin++;
+    while (end > begin && is_space(text[end - 1]))
+        end--;
+    return text.substr(begin, end - begin);
+}
+
+/**
+* Reads values of an attribute whose start tag was just read. The value is either
+* the text of the element or texts of leaf elements of a nested sequence.
+*/
+bool read_values(xml_reader& reader, std::vector<std::string>& values)
+{
+    int depth = 1;
+    bool leaf = true;
+    span name;
+    std::string text;
+    while (depth)
+    {
+        switch (next_tag(reader, name, &text))
+        {
+        case tag_start:
+            depth++;
+            leaf = true;
+            break;
+        case tag_end:
+            if (leaf)
+                values.push_back(trim(text));
+            leaf = false;
+            depth--;
+            break;
+        case tag_empty:
+            leaf = false;
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+struct kb_item {
+    std::string name;
+    std::string class_name;
+    std::string interface_name;
+};
+
+typedef std::map<std::string, std::vector<std::string>> class_map;
+
+/**
+* Reads item element, remembering its first name and GSI interface name.
+*/
+bool read_item(xml_reader& reader, kb_item& item)
+{
+    span name;
+    std::vector<std::string> values;
+    while (true)
+    {
+        switch (next_tag(reader, name))
+        {
+        case tag_start:
+            if (name.Equals("g2:a.NAMES") || name.Equals("g2:a.GSI-INTERFACE-NAME"))
+            {
+                values.clear();
+                if (!read_values(reader, values))
+                    return false;
+                if (!values.empty())
+                    (name.Equals("g2:a.NAMES") ? item.name : item.interface_name) = values.front();
+            }
+            else if (!reader.SkipSubtree())
+                return false;
+            break;
+        case tag_end:
+            return true;
+        case tag_empty:
+            break;
+        default:
+            return false;
+        }
+    }
+}
+
+/**
+* Reads class definition, remembering its direct superior classes.
+*/
+bool read_definition(xml_reader& reader, class_map& classes)
+{
+    span name;
+    std::string class_name;
+    std::vector<std::string> superiors;
+    std::vector<std::string> values;
+    while (true)
+    {
+        switch (next_tag(reader, name))
+        {
+        case tag_start:
+            if (name.Equals("g2:a.CLASS-NAME"))
+            {
+                values.clear();
+                if (!read_values(reader, values))
+                    return false;
+                if (!values.empty())
+                    class_name = values.front();
+            }
+            else if (name.Equals("g2:a.DIRECT-SUPERIOR-CLASSES"))
+            {
+                if (!read_values(reader, superiors))
+                    return false;
+            }
+            else if (!reader.SkipSubtree())
+                return false;
+            break;
+        case tag_end:
+            if (!class_name.empty())
+                classes[class_name].swap(superiors);
+            return true;
+        case tag_empty:
+            break;
+        default:
+            return false;
+        }
+    }
+}
+
+/**
+* Resolves variable type of the class by walking its superior classes.
+*/
+g2_type resolve_type(const std::string& class_name, const class_map& classes, std::map<std::string, g2_type>& resolved)
+{
+    static const struct { const char* class_name; g2_type type; } system_classes[] = {
+        { "INTEGER-VARIABLE", g2_integer },
+        { "FLOAT-VARIABLE", g2_float },
+        { "QUANTITATIVE-VARIABLE", g2_float },
+        { "LOGICAL-VARIABLE", g2_logical },
+        { "TEXT-VARIABLE", g2_string },
+        { "SYMBOLIC-VARIABLE", g2_symbol }
+    };
+    auto found = resolved.find(class_name);
+    if (found != resolved.end())
+        return found->second;
+    for (size_t i = 0; i < sizeof(system_classes) / sizeof(system_classes[0]); i++)
+    {
+        if (class_name == system_classes[i].class_name)
+            return resolved[class_name] = system_classes[i].type;
+    }
+    // Mark as unresolved first, so cycles in broken KBs terminate
+    resolved[class_name] = g2_none;
+    g2_type type = g2_none;
+    auto definition = classes.find(class_name);
+    if (definition != classes.end())
+    {
+        const std::vector<std::string>& superiors = definition->second;
+        for (auto it = superiors.begin(); it != superiors.end() && type == g2_none; ++it)
+            type = resolve_type(*it, classes, resolved);
+    }
+    return resolved[class_name] = type;
+}
+}
+
+kb_loader::kb_loader()
+{
+}
+
+bool kb_loader::load(const std::string& path)
+{
+    mapped_file file;
+    if (!file.open(path))
+    {
+        d_variables.clear();
+        d_unresolved.clear();
+        d_error = "Cannot open " + path;
+        return false;
+    }
+    return parse(file.data(), file.size());
+}
+
+bool kb_loader::parse(const char* data, size_t size)
+{
+    d_variables.clear();
+    d_unresolved.clear();
+    d_error.clear();
+
+    xml_reader reader;
+    reader.SetBuffer(data, size);
+    class_map classes;
+    std::vector<kb_item> items;
+    kb_item item;
+    span name;
+    // Depth 0 is rdf:RDF, top level items are its children. Class definitions
+    // are also found inside the module, among definitions of required modules.
+    int depth = 0;
+    bool ok = true;
+    tag_kind kind;
+    while (ok && (kind = next_tag(reader, name)) != tag_none)
+    {
+        if (kind == tag_end)
+            depth--;
+        else if (kind == tag_empty)
+            continue;
+        else if (name.Equals("g2:c.OBJECT-DEFINITION"))
+            ok = read_definition(reader, classes);
+        else if (depth == 1 && (name.StartsWith("c.") || name.StartsWith("g2:c.")))
+        {
+            item.class_name.assign(name.start + (name.StartsWith("c.") ? 2 : 5), name.end);
+            item.name.clear();
+            item.interface_name.clear();
+            ok = read_item(reader, item);
+            if (ok && !item.name.empty() && !item.interface_name.empty())
+                items.push_back(item);
+        }
+        else if (depth == 1 && !name.Equals("g2:Module"))
+            ok = reader.SkipSubtree();
+        else
+            depth++;
+    }
+    if (!ok || reader.ErrorID() != tinyxml2::XML_SUCCESS)
+    {
+        d_error = "Malformed KB export";
+        return false;
+    }
+
+    std::map<std::string, g2_type> resolved;
+    d_variables.reserve(items.size());
+    for (auto it = items.begin(); it != items.end(); ++it)
+    {
+        g2_type type = resolve_type(it->class_name, classes, resolved);
+        if (type == g2_none)
+        {
+            d_unresolved.push_back(it->name);
+            continue;
+        }
+        kb_variable var;
+        var.name = it->name;
+        var.class_name = it->class_name;
+        var.interface_name = it->interface_name;
+        var.type = type;
+        d_variables.push_back(var);
+    }
+    return true;
+}
+
+int kb_loader::declare_variables(libgsi& gsi) const
+{
+    return gsi.declare_g2_variables(d_variables.begin(), d_variables.end());
+}
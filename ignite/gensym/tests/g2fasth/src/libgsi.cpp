@@ -1,10 +1,31 @@
 #include "libgsi.hpp"
+#include "metrics.hpp"
+#include "string_convert.hpp"
 #include <sstream>
 #include <stdexcept>
 
+namespace {
+g2::fasth::metric_counter& s_errors = g2::fasth::metrics_registry::counter(
+    "g2fasth_gsi_errors", "Errors reported by GSI.");
+g2::fasth::metric_counter& s_missing_procedures = g2::fasth::metrics_registry::counter(
+    "g2fasth_gsi_missing_procedures", "Remote procedure calls to non-declared functions.");
+
+/**
+* Copies string converted by GSI to dest of num characters, the copy is terminated.
+*/
+void copy_converted(const short* gstr, short* dest, size_t num)
+{
+    size_t n = 0;
+    for (; n + 1 < num && gstr[n]; n++)
+        dest[n] = gstr[n];
+    dest[n] = 0;
+}
+}
+
 /// Customized error handler function
 void g2::fasth::libgsi::error_handler_function(gsi_int error_context, gsi_int error_code, gsi_char *error_message)
 {
+    s_errors.add();
     std::stringstream ss;
     ss << "GSI error in context " << error_context;
     ss << ". Code: " << error_code;
@@ -15,6 +36,7 @@ void g2::fasth::libgsi::error_handler_function(gsi_int error_context, gsi_int er
 /// Customized missing procedure handler
 void g2::fasth::libgsi::missing_procedure_function(gsi_char *name)
 {
+    s_missing_procedures.add();
     tthread::lock_guard<tthread::mutex> guard(getInstance().d_mutex);
     if (!getInstance().d_error_mode)
         return;
@@ -28,19 +50,19 @@ short* g2::fasth::libgsi::gensym_string(const std::wstring& wstr, short* dest, s
 {
     if (!dest)
         throw std::invalid_argument("Destination pointer is null.");
-
-    // Get string length
-    size_t n = wstr.length();
-
-    // Copy string to buffer
-    short* buf = (short*)calloc(n + 1, sizeof(short));
-    short* dst = buf;
-    const wchar_t* src = wstr.c_str();
-    while (num-- && (*dst++ = (short)*src++)) ;
-
-    short* result = gsi_convert_wide_string_to_unicode(buf, GSI_CHAR_SET_GENSYM);
-    free(buf);
-    while (num-- && (*dest++ = (short)*result++)) ;
+    if (!num)
+        return dest;
+    size_t n = wstr.length() < num ? wstr.length() : num - 1;
+    if (convert_ascii(wstr.c_str(), n, dest))
+        dest[n] = 0;
+    else
+    {
+        // GSI converts other characters, the narrowed copy is passed to it in dest
+        for (size_t i = 0; i < n; i++)
+            dest[i] = (short)wstr[i];
+        dest[n] = 0;
+        copy_converted(gsi_convert_wide_string_to_unicode(dest, GSI_CHAR_SET_GENSYM), dest, num);
+    }
     return dest;
 }
 
@@ -48,38 +70,54 @@ short* g2::fasth::libgsi::gensym_string(const std::string& cstr, short* dest, si
 {
     if (!dest)
         throw std::invalid_argument("Destination pointer is null.");
-    short* result = gsi_convert_string_to_unicode(const_cast<char*>(cstr.c_str()), GSI_CHAR_SET_GENSYM);
-    while (num-- && (*dest++ = (short)*result++)) ;
+    if (!num)
+        return dest;
+    size_t n = cstr.length() < num ? cstr.length() : num - 1;
+    if (convert_ascii(cstr.c_str(), n, dest))
+        dest[n] = 0;
+    else
+        copy_converted(gsi_convert_string_to_unicode(const_cast<char*>(cstr.c_str()), GSI_CHAR_SET_GENSYM), dest, num);
     return dest;
 }
 
 std::wstring g2::fasth::libgsi::wide_string(short* gstr)
+{
+    std::wstring result;
+    wide_string(gstr, result);
+    return result;
+}
+
+void g2::fasth::libgsi::wide_string(const short* gstr, std::wstring& out)
 {
     if (!gstr)
         throw std::invalid_argument("Pointer to input string is null.");
-    std::string cstr((char*)gsi_convert_unicode_to_string(gstr, GSI_CHAR_SET_GENSYM));
-    short* wstr = gsi_convert_unicode_to_wide_string((short*)(cstr.c_str()), GSI_CHAR_SET_GENSYM);
-
-    // Get string length
-    const short* pos;
-    for (pos = wstr; *pos; ++pos) ;
-    size_t num = pos - wstr;
+    size_t n = gensym_length(gstr);
+    out.resize(n);
+    if (!n || convert_ascii(gstr, n, &out[0]))
+        return;
 
-    // Copy string to buffer
-    wchar_t* buf = (wchar_t*)calloc(num + 1, sizeof(wchar_t));
-    wchar_t* dest = buf;
-    while (num-- && (*dest++ = (wchar_t)*wstr++)) ;
+    // GSI converts Gensym string to c string and that one to wide characters
+    std::string cstr(gsi_convert_unicode_to_string(const_cast<short*>(gstr), GSI_CHAR_SET_GENSYM));
+    const short* wstr = gsi_convert_unicode_to_wide_string((short*)(cstr.c_str()), GSI_CHAR_SET_GENSYM);
+    out.resize(gensym_length(wstr));
+    for (size_t i = 0; i < out.size(); i++)
+        out[i] = (wchar_t)wstr[i];
+}
 
-    // Return result
-    std::wstring result(buf);
-    free(buf);
+std::string g2::fasth::libgsi::c_string(short* gstr)
+{
+    std::string result;
+    c_string(gstr, result);
     return result;
 }
 
-std::string g2::fasth::libgsi::c_string(short* gstr)
+void g2::fasth::libgsi::c_string(const short* gstr, std::string& out)
 {
     if (!gstr)
         throw std::invalid_argument("Pointer to input string is null.");
-    std::string result(gsi_convert_unicode_to_string(gstr, GSI_CHAR_SET_GENSYM));
-    return result;
+    size_t n = gensym_length(gstr);
+    out.resize(n);
+    if (!n || convert_ascii(gstr, n, &out[0]))
+        return;
+    out = gsi_convert_unicode_to_string(const_cast<short*>(gstr), GSI_CHAR_SET_GENSYM);
 }
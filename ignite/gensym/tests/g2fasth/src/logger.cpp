@@ -1,16 +1,141 @@
+#include <cstdio>
 #include <iostream>
 #include <time.h>
 #include <stdarg.h>
 #include <string.h>
-#include <memory>
 #include "logger.hpp"
+#include "binary_log.hpp"
+#include "file_sink.hpp"
+#include "g2fasth_platform.hpp"
+#include "signal_registry.hpp"
 
 using namespace std;
 using namespace g2::fasth;
 
+namespace g2 {
+namespace fasth {
+/**
+* Bounded multi-producer queue of log messages (D. Vyukov's algorithm). Producers reserve
+* a cell by advancing enqueue position and publish it through the cell sequence, so they
+* never take a lock. The single consumer is the drain thread of the logger.
+*/
+struct log_queue {
+    struct cell {
+        volatile long sequence;
+        log_level level;
+        std::string text;
+    };
+    explicit log_queue(size_t capacity, logger::overflow_policy policy)
+        : cells(capacity)
+        , mask((long)capacity - 1)
+        , policy(policy)
+        , enqueue_pos(0)
+        , dequeue_pos(0)
+        , written(0)
+        , dropped(0)
+        , reported_dropped(0)
+        , sleeping(0)
+        , stop(false) {
+        for (size_t i = 0; i < capacity; i++)
+            cells[i].sequence = (long)i;
+    }
+    /**
+    * Moves text into a free cell.
+    * @return false if the queue is full.
+    */
+    bool enqueue(log_level level, const char* text, size_t length) {
+        long pos = atomic_load(&enqueue_pos);
+        cell* c;
+        while (true)
+        {
+            c = &cells[pos & mask];
+            long diff = counter_distance(atomic_load(&c->sequence), pos);
+            if (diff == 0)
+            {
+                if (atomic_compare_exchange(&enqueue_pos, pos, pos + 1))
+                    break;
+                pos = atomic_load(&enqueue_pos);
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = atomic_load(&enqueue_pos);
+        }
+        c->level = level;
+        // Cells keep their buffers, so steady logging does not allocate
+        c->text.assign(text, length);
+        atomic_store(&c->sequence, pos + 1);
+        return true;
+    }
+    /**
+    * Takes the oldest message. Called by the consumer only.
+    */
+    bool dequeue(log_level& level, std::string& text) {
+        if (empty())
+            return false;
+        cell& c = cells[dequeue_pos & mask];
+        level = c.level;
+        text.assign(c.text);
+        atomic_store(&c.sequence, dequeue_pos + mask + 1);
+        dequeue_pos++;
+        return true;
+    }
+    bool empty() const {
+        return counter_distance(atomic_load(&cells[dequeue_pos & mask].sequence), dequeue_pos + 1) < 0;
+    }
+    /**
+    * Wakes the consumer if it waits for messages.
+    */
+    void wake() {
+        atomic_fence();
+        if (atomic_load(&sleeping))
+        {
+            tthread::lock_guard<tthread::mutex> lg(wake_mutex);
+            wake_cond.notify_one();
+        }
+    }
+    std::vector<cell> cells;
+    const long mask;
+    const logger::overflow_policy policy;
+    volatile long enqueue_pos;
+    long dequeue_pos;
+    volatile long written;              // messages taken out and written by the consumer
+    volatile long dropped;
+    long reported_dropped;
+    volatile long sleeping;
+    volatile bool stop;
+    tthread::mutex wake_mutex;
+    tthread::condition_variable wake_cond;
+};
+}
+}
+
+namespace {
+// Loggers in asynchronous mode, looked up by flush_all() without locking,
+// as it is called from signal handler.
+signal_registry<logger> s_async_loggers;
+// Messages taken from the queue and written at once
+const int kDrainBatch = 256;
+// Formatted messages up to this size are not allocated
+const int kFormatBufferSize = 1024;
+G2FASTH_THREAD_LOCAL char s_format_buffer[kFormatBufferSize];
+}
+
 logger::logger(g2::fasth::log_level logLevel)
     :d_loglevel(logLevel)
+    , d_enabled_level(NONE)
+    , d_text_level(NONE)
+    , d_binary_level(NONE)
+    , d_capture_mode(capture_off)
+    , d_capture_failed_only(false)
+    , d_queue(nullptr)
+    , d_drain_thread(nullptr)
+{
+}
+
+logger::~logger()
 {
+    stop_async();
 }
 
 void logger::add_output_stream(std::ostream &output_stream, log_level level)
@@ -20,12 +145,38 @@ void logger::add_output_stream(std::ostream &output_stream, log_level level)
 
 void logger::add_output_stream(std::ostream *output_stream, log_level level)
 {
-    stream_info stream_info(output_stream, level);
+    add_stream(stream_info(output_stream, level));
+}
+
+void logger::add_file_sink(const std::shared_ptr<file_sink>& sink, log_level level)
+{
+    if (sink)
+        add_stream(stream_info(sink, level));
+}
+
+void logger::add_stream(const stream_info& stream_info)
+{
+    log_level level = stream_info.level;
     tthread::lock_guard<tthread::mutex> lg(d_mutex);
     d_outputStreams.push_back(stream_info);
+    // Streams with level above the logger level are never written to
+    if (level <= d_loglevel && level > d_text_level)
+        d_text_level = level;
+    if (d_text_level > d_enabled_level)
+        d_enabled_level = d_text_level;
+}
+
+void logger::add_binary_log(const std::shared_ptr<binary_log>& log, log_level level)
+{
+    tthread::lock_guard<tthread::mutex> lg(d_mutex);
+    d_binary_logs.push_back(binary_log_info(log, level));
+    if (level <= d_loglevel && level > d_binary_level)
+        d_binary_level = level;
+    if (d_binary_level > d_enabled_level)
+        d_enabled_level = d_binary_level;
 }
 
-void logger::internal_log(log_level log_level, std::string text)
+void logger::internal_log(log_level log_level, const char* text, size_t length)
 {
     // If the log level passed is greater then permissible log level of suite, quit.
     if (log_level > d_loglevel)
@@ -45,8 +196,13 @@ void logger::internal_log(log_level log_level, std::string text)
         {
             continue;
         }
+        if (iter->sink)
+        {
+            iter->sink->write_line(text, length);
+            continue;
+        }
         auto ptr_stream = iter->pStream;
-        auto written = write(text.c_str(), false, ptr_stream);
+        auto written = write(text, false, ptr_stream);
         if (written)
         {
             (*ptr_stream) << endl;
@@ -55,10 +211,287 @@ void logger::internal_log(log_level log_level, std::string text)
     }
 }
 
-void logger::log(log_level log_level, std::string text)
+void logger::log(log_level log_level, const std::string& text)
+{
+    if (is_text_enabled(log_level))
+        dispatch(log_level, text.c_str(), text.size());
+    if (is_binary_enabled(log_level))
+        write_binary(log_level, text.c_str(), text.size());
+}
+
+void logger::log(log_level log_level, const char* text)
+{
+    if (!is_enabled(log_level))
+        return;
+    size_t length = strlen(text);
+    if (is_text_enabled(log_level))
+        dispatch(log_level, text, length);
+    if (is_binary_enabled(log_level))
+        write_binary(log_level, text, length);
+}
+
+void logger::write_binary(log_level log_level, const char* text, size_t length)
+{
+    for (size_t i = 0; i < d_binary_logs.size(); i++)
+    {
+        if (log_level <= d_binary_logs[i].level)
+            d_binary_logs[i].log->write_text(log_level, text, length);
+    }
+}
+
+void logger::dispatch(log_level log_level, const char* text, size_t length)
+{
+    log_capture* capture = get_log_context().capture;
+    if (capture && capture->d_owner == this && capture->append(log_level, text, length))
+        return;
+    if (!d_queue)
+    {
+        tthread::lock_guard<tthread::mutex> lg(d_mutex);
+        internal_log(log_level, text, length);
+        return;
+    }
+    while (!d_queue->enqueue(log_level, text, length))
+    {
+        if (d_queue->policy == drop)
+        {
+            atomic_add(&d_queue->dropped, 1);
+            return;
+        }
+        d_queue->wake();
+        tthread::this_thread::yield();
+    }
+    d_queue->wake();
+}
+
+void logger::set_async(size_t capacity, overflow_policy policy)
+{
+    stop_async();
+    if (capacity == 0)
+        return;
+    size_t size = 2;
+    while (size < capacity)
+        size *= 2;
+    d_queue = new log_queue(size, policy);
+    d_drain_thread = new tthread::thread(s_drain_thread_proc, this);
+    s_async_loggers.add(this);
+}
+
+void logger::stop_async()
+{
+    if (!d_queue)
+        return;
+    s_async_loggers.remove(this);
+    // The drain thread writes everything queued before it exits
+    d_queue->stop = true;
+    d_queue->wake();
+    d_drain_thread->join();
+    delete d_drain_thread;
+    delete d_queue;
+    d_drain_thread = nullptr;
+    d_queue = nullptr;
+}
+
+void logger::flush()
+{
+    if (d_queue)
+        wait_written(atomic_load(&d_queue->enqueue_pos), 0);
+    for (size_t i = 0; i < d_binary_logs.size(); i++)
+        d_binary_logs[i].log->flush();
+    for (size_t i = 0; i < d_outputStreams.size(); i++)
+    {
+        if (d_outputStreams[i].sink)
+            d_outputStreams[i].sink->flush();
+    }
+}
+
+bool logger::wait_written(long target, unsigned timeout_ms)
+{
+    unsigned waited = 0;
+    while (counter_distance(atomic_load(&d_queue->written), target) < 0)
+    {
+        if (timeout_ms && waited++ >= timeout_ms)
+            return false;
+        d_queue->wake();
+        tthread::this_thread::sleep_for(tthread::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+long logger::dropped() const
+{
+    return d_queue ? atomic_load(&d_queue->dropped) : 0;
+}
+
+void logger::flush_all(unsigned timeout_ms)
+{
+    s_async_loggers.for_each([timeout_ms](logger* instance)
+    {
+        if (instance->d_queue)
+            instance->wait_written(atomic_load(&instance->d_queue->enqueue_pos), timeout_ms);
+    });
+    binary_log::flush_all();
+    file_sink::flush_all();
+}
+
+void logger::s_drain_thread_proc(void* p)
+{
+    ((logger*)p)->drain();
+}
+
+void logger::drain()
+{
+    log_queue& queue = *d_queue;
+    std::vector<std::string> batches;
+    log_level level;
+    std::string text;
+    while (true)
+    {
+        int count = 0;
+        {
+            tthread::lock_guard<tthread::mutex> lg(d_mutex);
+            batches.resize(d_outputStreams.size());
+            long dropped = atomic_load(&queue.dropped);
+            if (dropped != queue.reported_dropped)
+            {
+                char notice[64];
+                sprintf(notice, "%ld log messages dropped\n", dropped - queue.reported_dropped);
+                queue.reported_dropped = dropped;
+                for (size_t i = 0; i < batches.size(); i++)
+                    batches[i] += notice;
+            }
+            for (; count < kDrainBatch && queue.dequeue(level, text); count++)
+            {
+                for (size_t i = 0; i < d_outputStreams.size(); i++)
+                {
+                    // Same filtering as in synchronous mode
+                    if (d_outputStreams[i].level > d_loglevel || level > d_outputStreams[i].level)
+                        continue;
+                    batches[i] += text;
+                    batches[i] += '\n';
+                }
+            }
+            // One write and flush per stream for the whole batch
+            for (size_t i = 0; i < batches.size(); i++)
+            {
+                if (batches[i].empty())
+                    continue;
+                write_stream(d_outputStreams[i], batches[i].data(), batches[i].size());
+                batches[i].clear();
+            }
+        }
+        if (count)
+        {
+            atomic_add(&queue.written, count);
+            continue;
+        }
+        tthread::lock_guard<tthread::mutex> lg(queue.wake_mutex);
+        atomic_store(&queue.sleeping, 1);
+        atomic_fence();
+        if (queue.empty())
+        {
+            if (queue.stop)
+                break;
+            queue.wake_cond.wait(queue.wake_mutex);
+        }
+        atomic_store(&queue.sleeping, 0);
+    }
+}
+
+bool log_capture::append(log_level level, const char* text, size_t length)
 {
     tthread::lock_guard<tthread::mutex> lg(d_mutex);
-    internal_log(log_level, text);
+    if (d_closed)
+        return false;
+    d_buffer.push_back((char)level);
+    d_buffer.append(text, length);
+    d_buffer.push_back('\0');
+    return true;
+}
+
+std::string log_capture::text()
+{
+    tthread::lock_guard<tthread::mutex> lg(d_mutex);
+    return d_text;
+}
+
+void logger::set_capture(capture_mode mode, bool failed_only)
+{
+    d_capture_mode = mode;
+    d_capture_failed_only = failed_only;
+}
+
+void logger::begin_capture(log_capture& capture)
+{
+    tthread::lock_guard<tthread::mutex> lg(capture.d_mutex);
+    capture.d_owner = d_capture_mode == capture_off ? nullptr : this;
+    capture.d_closed = false;
+    capture.d_buffer.clear();
+    capture.d_text.clear();
+}
+
+void logger::end_capture(log_capture& capture, bool passed)
+{
+    std::string messages;
+    {
+        tthread::lock_guard<tthread::mutex> lg(capture.d_mutex);
+        if (capture.d_owner != this || capture.d_closed)
+            return;
+        capture.d_closed = true;
+        messages.swap(capture.d_buffer);
+        if (messages.empty() || (passed && d_capture_failed_only))
+            return;
+        if (d_capture_mode == capture_report)
+        {
+            for (size_t pos = 0; pos < messages.size(); )
+            {
+                size_t end = messages.find('\0', pos);
+                if (!capture.d_text.empty())
+                    capture.d_text += '\n';
+                capture.d_text.append(messages, pos + 1, end - pos - 1);
+                pos = end + 1;
+            }
+            return;
+        }
+    }
+    write_block(messages);
+}
+
+void logger::write_block(const std::string& messages)
+{
+    // The drain thread of asynchronous mode writes under the same lock,
+    // so the block is not interleaved with other messages
+    tthread::lock_guard<tthread::mutex> lg(d_mutex);
+    std::string block;
+    for (size_t i = 0; i < d_outputStreams.size(); i++)
+    {
+        if (d_outputStreams[i].level > d_loglevel)
+            continue;
+        block.clear();
+        for (size_t pos = 0; pos < messages.size(); )
+        {
+            size_t end = messages.find('\0', pos);
+            if ((log_level)messages[pos] <= d_outputStreams[i].level)
+            {
+                block.append(messages, pos + 1, end - pos - 1);
+                block += '\n';
+            }
+            pos = end + 1;
+        }
+        if (block.empty())
+            continue;
+        write_stream(d_outputStreams[i], block.data(), block.size());
+    }
+}
+
+void logger::write_stream(const stream_info& stream, const char* data, size_t length)
+{
+    if (stream.sink)
+    {
+        stream.sink->write(data, length);
+        return;
+    }
+    stream.pStream->write(data, length);
+    stream.pStream->flush();
 }
 
 bool logger::write(const char* data, bool written, std::ostream* stream)
@@ -71,30 +504,72 @@ bool logger::write(const char* data, bool written, std::ostream* stream)
     return true;
 }
 
-void logger::log_formatted(log_level log_level, const std::string fmt_str, ...)
+void logger::logf(log_level log_level, const char* fmt, ...)
 {
-    tthread::lock_guard<tthread::mutex> lg(d_mutex);
-    // If the log level passed is greater then permissible log level of suite, quit.
-    if (log_level > d_loglevel)
-    {
+    if (!is_enabled(log_level))
         return;
+    va_list ap, retry_ap;
+    if (is_text_enabled(log_level))
+    {
+        va_start(ap, fmt);
+        va_start(retry_ap, fmt);
+        format(log_level, fmt, ap, retry_ap);
+        va_end(retry_ap);
+        va_end(ap);
+    }
+    // Binary logs store the arguments, each one reads the list from the start
+    for (size_t i = 0; i < d_binary_logs.size(); i++)
+    {
+        if (log_level > d_binary_logs[i].level || log_level > d_loglevel)
+            continue;
+        va_start(ap, fmt);
+        d_binary_logs[i].log->write(log_level, fmt, ap);
+        va_end(ap);
     }
+}
 
-    int final_n, n = ((int)fmt_str.size()) * 2; /* Reserve two times as much as the length of the fmt_str */
-    std::unique_ptr<char[]> formatted;
-    va_list ap;
-    while(true)
+void logger::log_formatted(log_level log_level, const std::string fmt_str, ...)
+{
+    if (!is_enabled(log_level))
+        return;
+    va_list ap, retry_ap;
+    if (is_text_enabled(log_level))
     {
-        formatted.reset(new char[n]); /* Wrap the plain char array into the unique_ptr */
-        strcpy(&formatted[0], fmt_str.c_str());
         va_start(ap, fmt_str);
-        final_n = vsnprintf(&formatted[0], n, fmt_str.c_str(), ap);
+        va_start(retry_ap, fmt_str);
+        format(log_level, fmt_str.c_str(), ap, retry_ap);
+        va_end(retry_ap);
         va_end(ap);
-        if (final_n < 0 || final_n >= n)
-            n += abs(final_n - n + 1);
-        else
-            break;
     }
+    for (size_t i = 0; i < d_binary_logs.size(); i++)
+    {
+        if (log_level > d_binary_logs[i].level || log_level > d_loglevel)
+            continue;
+        va_start(ap, fmt_str);
+        d_binary_logs[i].log->write(log_level, fmt_str.c_str(), ap);
+        va_end(ap);
+    }
+}
 
-    internal_log(log_level, std::string(formatted.get()));
-}
\ No newline at end of file
+void logger::format(log_level log_level, const char* fmt, va_list ap, va_list retry_ap)
+{
+    // Visual Studio 2010 has no va_copy(), so callers start the list twice.
+    // The second list is used only when the message does not fit the buffer.
+    int length = vsnprintf(s_format_buffer, kFormatBufferSize, fmt, ap);
+#ifdef WIN32
+    // vsnprintf() of Visual Studio 2010 returns -1 on truncation. Its va_list
+    // is a plain pointer, so the retry list can be used twice.
+    if (length < 0)
+        length = _vscprintf(fmt, retry_ap);
+#endif
+    if (length < 0)
+        return;
+    if (length < kFormatBufferSize)
+    {
+        dispatch(log_level, s_format_buffer, length);
+        return;
+    }
+    std::vector<char> text(length + 1);
+    vsnprintf(&text[0], length + 1, fmt, retry_ap);
+    dispatch(log_level, &text[0], length);
+}
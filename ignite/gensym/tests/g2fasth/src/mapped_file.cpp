@@ -0,0 +1,115 @@
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "mapped_file.hpp"
+
+using namespace g2::fasth;
+
+mapped_file::mapped_file()
+    : d_data(nullptr)
+    , d_size(0)
+    , d_open(false)
+#ifdef WIN32
+    , d_file(INVALID_HANDLE_VALUE)
+    , d_mapping(nullptr)
+#endif
+{
+}
+
+mapped_file::~mapped_file()
+{
+    close();
+}
+
+#ifdef WIN32
+bool mapped_file::open(const std::string& path)
+{
+    close();
+    HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER size;
+    if (!::GetFileSizeEx(file, &size) || (unsigned long long)size.QuadPart > (size_t)-1)
+    {
+        ::CloseHandle(file);
+        return false;
+    }
+    d_file = file;
+    d_size = (size_t)size.QuadPart;
+    d_open = true;
+    if (d_size == 0)
+        return true;
+    d_mapping = ::CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (d_mapping)
+        d_data = (const char*)::MapViewOfFile(d_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!d_data)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void mapped_file::close()
+{
+    if (d_data)
+        ::UnmapViewOfFile(d_data);
+    if (d_mapping)
+        ::CloseHandle(d_mapping);
+    if (d_file != INVALID_HANDLE_VALUE)
+        ::CloseHandle(d_file);
+    d_data = nullptr;
+    d_mapping = nullptr;
+    d_file = INVALID_HANDLE_VALUE;
+    d_size = 0;
+    d_open = false;
+}
+#else
+bool mapped_file::open(const std::string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    d_size = (size_t)st.st_size;
+    d_open = true;
+    if (d_size == 0)
+    {
+        ::close(fd);
+        return true;
+    }
+    void* data = mmap(NULL, d_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        d_size = 0;
+        d_open = false;
+        return false;
+    }
+    madvise(data, d_size, MADV_SEQUENTIAL);
+    d_data = (const char*)data;
+    return true;
+}
+
+void mapped_file::close()
+{
+    if (d_data)
+        munmap((void*)d_data, d_size);
+    d_data = nullptr;
+    d_size = 0;
+    d_open = false;
+}
+#endif
@@ -0,0 +1,575 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include "metrics.hpp"
+#include "tinythread.h"
+
+using namespace g2::fasth;
+
+namespace {
+enum metric_type { counter_type, gauge_type, histogram_type };
+const char* const metric_type_name[] = { "counter", "gauge", "histogram" };
+
+struct metric_entry {
+    std::string name;
+    std::string help;
+    std::string labels;
+    metric_type type;
+    void* metric;
+};
+
+struct registry {
+    tthread::mutex mutex;
+    std::vector<metric_entry*> entries;     // in order of registration
+};
+
+// Metrics are registered by statics of other translation units, so the
+// registry is created on first use instead of being a static itself.
+registry& get_registry()
+{
+    static registry* s_registry = new registry;
+    return *s_registry;
+}
+
+void* find_or_add(const std::string& name, const std::string& help, const std::string& labels, metric_type type)
+{
+    registry& r = get_registry();
+    tthread::lock_guard<tthread::mutex> lg(r.mutex);
+    for (size_t i = 0; i < r.entries.size(); i++)
+    {
+        metric_entry* entry = r.entries[i];
+        if (entry->name != name || entry->labels != labels)
+            continue;
+        if (entry->type != type)
+            throw std::invalid_argument("Metric " + name + " is already registered as " + metric_type_name[entry->type]);
+        return entry->metric;
+    }
+    metric_entry* entry = new metric_entry;
+    entry->name = name;
+    entry->help = help;
+    entry->labels = labels;
+    entry->type = type;
+    if (type == counter_type)
+        entry->metric = new metric_counter;
+    else if (type == gauge_type)
+        entry->metric = new metric_gauge;
+    else
+        entry->metric = new metric_histogram;
+    r.entries.push_back(entry);
+    return entry->metric;
+}
+
+void append_format(std::string& out, const char* format, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length > 0)
+        out.append(buffer, length < (int)sizeof(buffer) ? length : sizeof(buffer) - 1);
+}
+
+void append_sample(std::string& out, const std::string& name, const char* suffix,
+    const std::string& labels, const std::string& extra_label)
+{
+    out += name;
+    out += suffix;
+    if (!labels.empty() || !extra_label.empty())
+    {
+        out += '{';
+        out += labels;
+        if (!labels.empty() && !extra_label.empty())
+            out += ',';
+        out += extra_label;
+        out += '}';
+    }
+    out += ' ';
+}
+
+// Exported buckets end at powers of four from 1 microsecond to 1 minute, which
+// are boundaries of internal buckets, so exported counts are exact.
+const unsigned kExportFirstExponent = 10;
+const unsigned kExportLastExponent = 36;
+
+void append_histogram(std::string& out, const metric_entry& entry)
+{
+    std::vector<long long> buckets = ((metric_histogram*)entry.metric)->buckets();
+    long long cumulative = 0;
+    double sum_ns = 0;
+    unsigned index = 0;
+    for (unsigned exponent = kExportFirstExponent; exponent <= kExportLastExponent; exponent += 2)
+    {
+        unsigned long long bound = 1ULL << exponent;
+        for (; index < kHistogramBuckets && metric_histogram::bucket_upper(index) <= bound; index++)
+        {
+            cumulative += buckets[index];
+            // Sum is estimated from bucket midpoints
+            sum_ns += buckets[index] * 0.5 * (metric_histogram::bucket_lower(index) + metric_histogram::bucket_upper(index));
+        }
+        std::string le;
+        append_format(le, "le=\"%.9g\"", bound / 1e9);
+        append_sample(out, entry.name, "_bucket", entry.labels, le);
+        append_format(out, "%lld\n", cumulative);
+    }
+    for (; index < kHistogramBuckets; index++)
+    {
+        cumulative += buckets[index];
+        sum_ns += buckets[index] * 0.5 * (metric_histogram::bucket_lower(index) + metric_histogram::bucket_upper(index));
+    }
+    append_sample(out, entry.name, "_bucket", entry.labels, "le=\"+Inf\"");
+    append_format(out, "%lld\n", cumulative);
+    append_sample(out, entry.name, "_sum", entry.labels, "");
+    append_format(out, "%.9g\n", sum_ns / 1e9);
+    append_sample(out, entry.name, "_count", entry.labels, "");
+    append_format(out, "%lld\n", cumulative);
+}
+
+void append_duration(std::string& out, const char* label, unsigned long long ns)
+{
+    if (ns < 1000)
+        append_format(out, " %s=%lluns", label, ns);
+    else if (ns < 1000000)
+        append_format(out, " %s=%.1fus", label, ns / 1e3);
+    else if (ns < 1000000000ULL)
+        append_format(out, " %s=%.1fms", label, ns / 1e6);
+    else
+        append_format(out, " %s=%.2fs", label, ns / 1e9);
+}
+
+unsigned floor_log2(unsigned long long value)
+{
+    unsigned result = 0;
+    if (value >> 32) { value >>= 32; result += 32; }
+    if (value >> 16) { value >>= 16; result += 16; }
+    if (value >> 8) { value >>= 8; result += 8; }
+    if (value >> 4) { value >>= 4; result += 4; }
+    if (value >> 2) { value >>= 2; result += 2; }
+    if (value >> 1) result += 1;
+    return result;
+}
+
+tthread::mutex s_export_mutex;
+tthread::thread* s_export_thread;
+volatile long s_export_stop;
+std::string s_export_path;
+unsigned s_export_interval_s;
+bool s_print_summary;
+bool s_exit_registered;
+tthread::thread* s_summary_thread;
+volatile long s_summary_stop;
+unsigned s_summary_interval_s;
+
+/**
+* Calls the action each interval until stop is set.
+*/
+void run_periodically(volatile long* stop, unsigned interval_s, void (*action)())
+{
+    unsigned long long interval_ns = interval_s * 1000000000ULL;
+    unsigned long long next = monotonic_ns() + interval_ns;
+    while (!atomic_load(stop))
+    {
+        tthread::this_thread::sleep_for(tthread::chrono::milliseconds(50));
+        if (monotonic_ns() < next)
+            continue;
+        action();
+        next += interval_ns;
+    }
+}
+
+void write_export()
+{
+    metrics_registry::write_openmetrics(s_export_path);
+}
+
+void print_summary()
+{
+    fputs(metrics_registry::summary().c_str(), stdout);
+    fflush(stdout);
+}
+
+void export_thread_proc(void*)
+{
+    run_periodically(&s_export_stop, s_export_interval_s, write_export);
+}
+
+void summary_thread_proc(void*)
+{
+    run_periodically(&s_summary_stop, s_summary_interval_s, print_summary);
+}
+
+void write_at_exit()
+{
+    metrics_registry::stop_export();
+    metrics_registry::stop_summary();
+    tthread::lock_guard<tthread::mutex> lg(s_export_mutex);
+    if (!s_export_path.empty())
+        metrics_registry::write_openmetrics(s_export_path);
+    if (s_print_summary)
+        print_summary();
+}
+
+void register_at_exit()
+{
+    if (!s_exit_registered)
+    {
+        atexit(write_at_exit);
+        s_exit_registered = true;
+    }
+}
+}
+
+metric_counter::metric_counter()
+{
+    reset();
+}
+
+long long metric_counter::value() const
+{
+    long long sum = 0;
+    for (unsigned i = 0; i < kMetricShards; i++)
+        sum += atomic_load(&d_shards[i].value);
+    return sum;
+}
+
+void metric_counter::reset()
+{
+    for (unsigned i = 0; i < kMetricShards; i++)
+        atomic_store(&d_shards[i].value, 0);
+}
+
+metric_histogram::metric_histogram()
+{
+    for (unsigned i = 0; i < kHistogramShards; i++)
+    {
+        d_shards[i] = new long[kHistogramBuckets];
+        memset((void*)d_shards[i], 0, kHistogramBuckets * sizeof(long));
+    }
+}
+
+metric_histogram::~metric_histogram()
+{
+    for (unsigned i = 0; i < kHistogramShards; i++)
+        delete[] d_shards[i];
+}
+
+std::vector<long long> metric_histogram::buckets() const
+{
+    std::vector<long long> result(kHistogramBuckets, 0);
+    for (unsigned i = 0; i < kHistogramShards; i++)
+        for (unsigned j = 0; j < kHistogramBuckets; j++)
+            result[j] += atomic_load(&d_shards[i][j]);
+    return result;
+}
+
+long long metric_histogram::count() const
+{
+    std::vector<long long> counts = buckets();
+    long long result = 0;
+    for (unsigned i = 0; i < kHistogramBuckets; i++)
+        result += counts[i];
+    return result;
+}
+
+unsigned long long metric_histogram::percentile(double fraction) const
+{
+    return percentile(buckets(), fraction);
+}
+
+unsigned long long metric_histogram::percentile(const std::vector<long long>& counts, double fraction)
+{
+    long long total = 0;
+    for (unsigned i = 0; i < kHistogramBuckets; i++)
+        total += counts[i];
+    if (!total)
+        return 0;
+    long long target = (long long)(fraction * total + 0.999999);
+    if (target < 1)
+        target = 1;
+    long long cumulative = 0;
+    for (unsigned i = 0; i < kHistogramBuckets; i++)
+    {
+        cumulative += counts[i];
+        if (cumulative >= target)
+            return bucket_upper(i) - 1;
+    }
+    return bucket_upper(kHistogramBuckets - 1) - 1;
+}
+
+void metric_histogram::reset()
+{
+    for (unsigned i = 0; i < kHistogramShards; i++)
+        for (unsigned j = 0; j < kHistogramBuckets; j++)
+            atomic_store(&d_shards[i][j], 0);
+}
+
+unsigned metric_histogram::bucket_index(unsigned long long value)
+{
+    const unsigned sub_buckets = 1 << kHistogramSubBucketBits;
+    if (value < sub_buckets)
+        return (unsigned)value;
+    unsigned exponent = floor_log2(value);
+    if (exponent >= kHistogramMaxExponent)
+        return kHistogramBuckets - 1;
+    unsigned shift = exponent - kHistogramSubBucketBits;
+    return sub_buckets + shift * sub_buckets + (unsigned)((value >> shift) & (sub_buckets - 1));
+}
+
+unsigned long long metric_histogram::bucket_lower(unsigned index)
+{
+    const unsigned sub_buckets = 1 << kHistogramSubBucketBits;
+    if (index < sub_buckets)
+        return index;
+    unsigned shift = (index - sub_buckets) / sub_buckets;
+    unsigned sub = (index - sub_buckets) % sub_buckets;
+    return (unsigned long long)(sub_buckets + sub) << shift;
+}
+
+unsigned long long metric_histogram::bucket_upper(unsigned index)
+{
+    const unsigned sub_buckets = 1 << kHistogramSubBucketBits;
+    if (index < sub_buckets)
+        return index + 1;
+    unsigned shift = (index - sub_buckets) / sub_buckets;
+    unsigned sub = (index - sub_buckets) % sub_buckets;
+    return (unsigned long long)(sub_buckets + sub + 1) << shift;
+}
+
+metric_counter& metrics_registry::counter(const std::string& name, const std::string& help, const std::string& labels)
+{
+    return *(metric_counter*)find_or_add(name, help, labels, counter_type);
+}
+
+metric_gauge& metrics_registry::gauge(const std::string& name, const std::string& help, const std::string& labels)
+{
+    return *(metric_gauge*)find_or_add(name, help, labels, gauge_type);
+}
+
+metric_histogram& metrics_registry::histogram(const std::string& name, const std::string& help, const std::string& labels)
+{
+    return *(metric_histogram*)find_or_add(name, help, labels, histogram_type);
+}
+
+std::string metrics_registry::openmetrics()
+{
+    registry& r = get_registry();
+    std::vector<metric_entry*> entries;
+    {
+        tthread::lock_guard<tthread::mutex> lg(r.mutex);
+        entries = r.entries;
+    }
+    std::string out;
+    std::vector<bool> written(entries.size(), false);
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        if (written[i])
+            continue;
+        // Samples of a family are written together after its metadata
+        const metric_entry& family = *entries[i];
+        out += "# TYPE " + family.name + " " + metric_type_name[family.type] + "\n";
+        if (!family.help.empty())
+            out += "# HELP " + family.name + " " + family.help + "\n";
+        for (size_t j = i; j < entries.size(); j++)
+        {
+            const metric_entry& entry = *entries[j];
+            if (written[j] || entry.name != family.name)
+                continue;
+            written[j] = true;
+            if (entry.type == counter_type)
+            {
+                append_sample(out, entry.name, "_total", entry.labels, "");
+                append_format(out, "%lld\n", ((metric_counter*)entry.metric)->value());
+            }
+            else if (entry.type == gauge_type)
+            {
+                append_sample(out, entry.name, "", entry.labels, "");
+                append_format(out, "%ld\n", ((metric_gauge*)entry.metric)->value());
+            }
+            else
+                append_histogram(out, entry);
+        }
+    }
+    out += "# EOF\n";
+    return out;
+}
+
+bool metrics_registry::write_openmetrics(const std::string& path)
+{
+    std::string text = openmetrics();
+    std::string temp_path = path + ".tmp";
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    if (!file)
+        return false;
+    bool written = fwrite(text.data(), 1, text.size(), file) == text.size();
+    if (fclose(file) != 0 || !written)
+    {
+        remove(temp_path.c_str());
+        return false;
+    }
+#ifdef WIN32
+    return ::MoveFileExA(temp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(temp_path.c_str(), path.c_str()) == 0;
+#endif
+}
+
+std::string metrics_registry::summary()
+{
+    registry& r = get_registry();
+    std::vector<metric_entry*> entries;
+    {
+        tthread::lock_guard<tthread::mutex> lg(r.mutex);
+        entries = r.entries;
+    }
+    std::string out = "Metrics summary:\n";
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        const metric_entry& entry = *entries[i];
+        std::string name = entry.labels.empty() ? entry.name : entry.name + "{" + entry.labels + "}";
+        if (entry.type == counter_type)
+        {
+            long long value = ((metric_counter*)entry.metric)->value();
+            if (value)
+                append_format(out, "  %s_total %lld\n", name.c_str(), value);
+        }
+        else if (entry.type == gauge_type)
+        {
+            long value = ((metric_gauge*)entry.metric)->value();
+            if (value)
+                append_format(out, "  %s %ld\n", name.c_str(), value);
+        }
+        else
+        {
+            const metric_histogram& histogram = *(metric_histogram*)entry.metric;
+            long long count = histogram.count();
+            if (!count)
+                continue;
+            append_format(out, "  %s count=%lld", name.c_str(), count);
+            append_duration(out, "p50", histogram.percentile(0.5));
+            append_duration(out, "p90", histogram.percentile(0.9));
+            append_duration(out, "p99", histogram.percentile(0.99));
+            append_duration(out, "max", histogram.percentile(1.0));
+            out += '\n';
+        }
+    }
+    return out;
+}
+
+void metrics_registry::start_export(const std::string& path, unsigned interval_s)
+{
+    stop_export();
+    tthread::lock_guard<tthread::mutex> lg(s_export_mutex);
+    s_export_path = path;
+    s_export_interval_s = interval_s;
+    register_at_exit();
+    if (interval_s > 0)
+    {
+        atomic_store(&s_export_stop, 0);
+        s_export_thread = new tthread::thread(export_thread_proc, nullptr);
+    }
+}
+
+void metrics_registry::stop_export()
+{
+    tthread::thread* thread;
+    {
+        tthread::lock_guard<tthread::mutex> lg(s_export_mutex);
+        thread = s_export_thread;
+        s_export_thread = nullptr;
+    }
+    if (!thread)
+        return;
+    atomic_store(&s_export_stop, 1);
+    thread->join();
+    delete thread;
+}
+
+void metrics_registry::print_summary_at_exit()
+{
+    tthread::lock_guard<tthread::mutex> lg(s_export_mutex);
+    s_print_summary = true;
+    register_at_exit();
+}
+
+void metrics_registry::start_summary(unsigned interval_s)
+{
+    stop_summary();
+    tthread::lock_guard<tthread::mutex> lg(s_export_mutex);
+    s_print_summary = true;
+    s_summary_interval_s = interval_s;
+    register_at_exit();
+    if (interval_s > 0)
+    {
+        atomic_store(&s_summary_stop, 0);
+        s_summary_thread = new tthread::thread(summary_thread_proc, nullptr);
+    }
+}
+
+void metrics_registry::stop_summary()
+{
+    tthread::thread* thread;
+    {
+        tthread::lock_guard<tthread::mutex> lg(s_export_mutex);
+        thread = s_summary_thread;
+        s_summary_thread = nullptr;
+    }
+    if (!thread)
+        return;
+    atomic_store(&s_summary_stop, 1);
+    thread->join();
+    delete thread;
+}
+
+void metrics_registry::reset()
+{
+    registry& r = get_registry();
+    tthread::lock_guard<tthread::mutex> lg(r.mutex);
+    for (size_t i = 0; i < r.entries.size(); i++)
+    {
+        if (r.entries[i]->type == counter_type)
+            ((metric_counter*)r.entries[i]->metric)->reset();
+        else if (r.entries[i]->type == histogram_type)
+            ((metric_histogram*)r.entries[i]->metric)->reset();
+    }
+}
+
+metric_counter& scheduler_metrics::tests_started = metrics_registry::counter(
+    "g2fasth_tests_started", "Test cases started.");
+metric_counter& scheduler_metrics::tests_passed = metrics_registry::counter(
+    "g2fasth_tests_passed", "Test cases completed with pass outcome.");
+metric_counter& scheduler_metrics::tests_failed = metrics_registry::counter(
+    "g2fasth_tests_failed", "Test cases completed with fail outcome, including timed out ones.");
+metric_counter& scheduler_metrics::tests_timed_out = metrics_registry::counter(
+    "g2fasth_tests_timed_out", "Test cases failed because of timeout.");
+metric_counter& scheduler_metrics::continuations = metrics_registry::counter(
+    "g2fasth_continuations", "Asynchronous continuations of test cases run.");
+metric_counter& scheduler_metrics::timer_ticks = metrics_registry::counter(
+    "g2fasth_timer_ticks", "Timer actions of test cases run.");
+metric_gauge& scheduler_metrics::tests_ready = metrics_registry::gauge(
+    "g2fasth_tests_ready", "Test cases ready to start and waiting for a worker.");
+metric_gauge& scheduler_metrics::busy_workers = metrics_registry::gauge(
+    "g2fasth_busy_workers", "Suite workers executing a test case.");
+metric_gauge& scheduler_metrics::running_suites = metrics_registry::gauge(
+    "g2fasth_running_suites", "Test suites being executed.");
+metric_histogram& scheduler_metrics::start_delay = metrics_registry::histogram(
+    "g2fasth_test_start_delay_seconds", "Time from test case being ready to its start.");
+metric_histogram& scheduler_metrics::test_duration = metrics_registry::histogram(
+    "g2fasth_test_duration_seconds", "Time from test case start to its completion.");
+metric_histogram& scheduler_metrics::suite_duration = metrics_registry::histogram(
+    "g2fasth_suite_duration_seconds", "Time of test suite execution.");
+metric_counter& gsi_metrics::get_data_items = metrics_registry::counter(
+    "g2fasth_gsi_items", "Items passed by GSI callbacks.", "callback=\"gsi_get_data\"");
+metric_counter& gsi_metrics::set_data_items = metrics_registry::counter(
+    "g2fasth_gsi_items", "Items passed by GSI callbacks.", "callback=\"gsi_set_data\"");
+metric_counter& gsi_metrics::poll_items = metrics_registry::counter(
+    "g2fasth_gsi_items", "Items passed by GSI callbacks.", "callback=\"gsi_g2_poll\"");
+metric_counter& gsi_metrics::registrations = metrics_registry::counter(
+    "g2fasth_gsi_items", "Items passed by GSI callbacks.", "callback=\"gsi_receive_registration\"");
+metric_counter& gsi_metrics::deregistrations = metrics_registry::counter(
+    "g2fasth_gsi_items", "Items passed by GSI callbacks.", "callback=\"gsi_receive_deregistrations\"");
+metric_histogram& gsi_metrics::update_latency = metrics_registry::histogram(
+    "g2fasth_gsi_update_latency_seconds", "Time from update_g2_variable to gsi_return_values of the update.");
+metric_histogram& gsi_metrics::delivery_latency = metrics_registry::histogram(
+    "g2fasth_gsi_delivery_latency_seconds", "Time from assign_temp_value to gsi_return_values of the value.");
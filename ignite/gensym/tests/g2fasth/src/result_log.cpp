@@ -0,0 +1,219 @@
+#include <string.h>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+#include "result_log.hpp"
+#include "binary_io.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+// File signature, written once at the beginning of a new log
+const char kMagic[] = "G2FRLOG1";
+const size_t kMagicSize = 8;
+
+// Record types
+enum {
+    record_session = 'B',   // u64 time: all name ids before it are forgotten
+    record_name = 'N',      // u32 id, str name
+    record_suite = 'S',     // u32 suite id, str start time
+    record_case = 'C'       // u32 suite id, u32 test id, u8 outcome, u64 start, u32 duration, str failure
+};
+
+tthread::mutex s_logs_mutex;
+std::map<std::string, std::weak_ptr<result_log>> s_logs;
+}
+
+std::shared_ptr<result_log> result_log::open(const std::string& path)
+{
+    tthread::lock_guard<tthread::mutex> lg(s_logs_mutex);
+    std::shared_ptr<result_log> log = s_logs[path].lock();
+    if (log)
+        return log;
+    FILE* file = fopen(path.c_str(), "ab");
+    if (!file)
+        return nullptr;
+    log = std::shared_ptr<result_log>(new result_log(file));
+    s_logs[path] = log;
+    return log;
+}
+
+result_log::result_log(FILE* file)
+    : d_file(file)
+{
+    fseek(d_file, 0, SEEK_END);
+    if (ftell(d_file) == 0)
+        d_buffer.append(kMagic, kMagicSize);
+    size_t rec = binary_io::begin_record(d_buffer, record_session);
+    binary_io::put_u64(d_buffer, now_ms());
+    binary_io::end_record(d_buffer, rec);
+    write_buffer();
+}
+
+result_log::~result_log()
+{
+    fclose(d_file);
+}
+
+unsigned result_log::intern(const std::string& name)
+{
+    auto it = d_names.find(name);
+    if (it != d_names.end())
+        return it->second;
+    unsigned id = (unsigned)d_names.size();
+    d_names[name] = id;
+    size_t rec = binary_io::begin_record(d_buffer, record_name);
+    binary_io::put_u32(d_buffer, id);
+    binary_io::put_str(d_buffer, name);
+    binary_io::end_record(d_buffer, rec);
+    return id;
+}
+
+void result_log::write_buffer()
+{
+    if (d_buffer.empty())
+        return;
+    fwrite(d_buffer.data(), 1, d_buffer.size(), d_file);
+    fflush(d_file);
+    d_buffer.clear();
+}
+
+void result_log::suite_started(const std::string& suite_name, const std::string& start_time)
+{
+    tthread::lock_guard<tthread::mutex> lg(d_mutex);
+    unsigned suite_id = intern(suite_name);
+    size_t rec = binary_io::begin_record(d_buffer, record_suite);
+    binary_io::put_u32(d_buffer, suite_id);
+    binary_io::put_str(d_buffer, start_time);
+    binary_io::end_record(d_buffer, rec);
+    write_buffer();
+}
+
+void result_log::test_completed(const std::string& suite_name, const std::string& test_name, test_outcome outcome,
+    unsigned long long start_ms, unsigned duration_ms, const std::string& failure)
+{
+    tthread::lock_guard<tthread::mutex> lg(d_mutex);
+    unsigned suite_id = intern(suite_name);
+    unsigned test_id = intern(test_name);
+    size_t rec = binary_io::begin_record(d_buffer, record_case);
+    binary_io::put_u32(d_buffer, suite_id);
+    binary_io::put_u32(d_buffer, test_id);
+    binary_io::put_u8(d_buffer, (unsigned char)outcome);
+    binary_io::put_u64(d_buffer, start_ms);
+    binary_io::put_u32(d_buffer, duration_ms);
+    binary_io::put_str(d_buffer, failure);
+    binary_io::end_record(d_buffer, rec);
+    write_buffer();
+}
+
+unsigned long long result_log::now_ms()
+{
+#ifdef WIN32
+    FILETIME ft;
+    ::GetSystemTimeAsFileTime(&ft);
+    unsigned long long t = ((unsigned long long)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    // FILETIME counts 100 ns intervals since 1601-01-01
+    return (t - 116444736000000000ULL) / 10000;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (unsigned long long)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+#endif
+}
+
+result_log_reader::result_log_reader()
+    : d_file(nullptr)
+{
+}
+
+result_log_reader::~result_log_reader()
+{
+    if (d_file)
+        fclose(d_file);
+}
+
+bool result_log_reader::open(const std::string& path)
+{
+    if (d_file)
+        fclose(d_file);
+    d_ids.clear();
+    d_file = fopen(path.c_str(), "rb");
+    if (!d_file)
+        return false;
+    char magic[kMagicSize];
+    if (fread(magic, 1, kMagicSize, d_file) != kMagicSize || memcmp(magic, kMagic, kMagicSize) != 0)
+    {
+        fclose(d_file);
+        d_file = nullptr;
+        return false;
+    }
+    return true;
+}
+
+const std::string* result_log_reader::name(unsigned id) const
+{
+    static const std::string unknown("<unknown>");
+    if (id >= d_ids.size() || !d_ids[id])
+        return &unknown;
+    return d_ids[id];
+}
+
+bool result_log_reader::next(result_log_entry& entry)
+{
+    if (!d_file)
+        return false;
+    unsigned char type;
+    while (binary_io::read_record(d_file, type, d_payload))
+    {
+        binary_io::decoder dec(d_payload.data(), d_payload.size());
+        switch (type)
+        {
+        case record_session:
+            d_ids.clear();
+            break;
+        case record_name:
+        {
+            unsigned id = dec.get_u32();
+            std::string value;
+            if (!dec.get_str(value))
+                break;
+            d_strings.push_back(value);
+            if (id >= d_ids.size())
+                d_ids.resize(id + 1, nullptr);
+            d_ids[id] = &d_strings.back();
+            break;
+        }
+        case record_suite:
+        {
+            const std::string* suite_name = name(dec.get_u32());
+            std::string start_time;
+            if (dec.get_str(start_time) && !d_suite_start.count(*suite_name))
+                d_suite_start[*suite_name] = start_time;
+            break;
+        }
+        case record_case:
+            entry.suite_name = name(dec.get_u32());
+            entry.test_name = name(dec.get_u32());
+            entry.outcome = dec.get_u8() ? test_outcome::pass : test_outcome::fail;
+            entry.start_ms = dec.get_u64();
+            entry.duration_ms = dec.get_u32();
+            dec.get_str(entry.failure);
+            if (dec.ok())
+                return true;
+            break;
+        default:
+            // Unknown records are skipped to allow adding new ones later
+            break;
+        }
+    }
+    return false;
+}
+
+const std::string& result_log_reader::suite_start_time(const std::string& suite_name) const
+{
+    static const std::string empty;
+    auto it = d_suite_start.find(suite_name);
+    return it == d_suite_start.end() ? empty : it->second;
+}
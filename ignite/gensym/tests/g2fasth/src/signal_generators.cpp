@@ -0,0 +1,223 @@
+#include <math.h>
+#include <stdio.h>
+#include <string>
+#include "signal_generators.hpp"
+#include "g2fasth_platform.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+const double kTwoPi = 6.283185307179586;
+
+/**
+* Seeds xorshift generator, which must not start from zero.
+*/
+unsigned random_state(unsigned seed)
+{
+    unsigned state = seed * 2654435761U ^ 0x9E3779B9U;
+    return state ? state : 1;
+}
+
+/**
+* Returns uniform value in [-1, 1) and advances the generator.
+*/
+double uniform(unsigned& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return (state >> 8) * (2.0 / 16777216.0) - 1.0;
+}
+}
+
+signal_spec signal_spec::ramp(double offset, double amplitude, double period_s, double phase)
+{
+    signal_spec spec;
+    spec.shape = signal_ramp;
+    spec.offset = offset;
+    spec.amplitude = amplitude;
+    spec.period_s = period_s;
+    spec.phase = phase;
+    return spec;
+}
+
+signal_spec signal_spec::sine(double offset, double amplitude, double period_s, double phase)
+{
+    signal_spec spec = ramp(offset, amplitude, period_s, phase);
+    spec.shape = signal_sine;
+    return spec;
+}
+
+signal_spec signal_spec::noise(double offset, double amplitude, unsigned seed)
+{
+    signal_spec spec;
+    spec.shape = signal_noise;
+    spec.offset = offset;
+    spec.amplitude = amplitude;
+    spec.seed = seed;
+    return spec;
+}
+
+signal_spec signal_spec::random_walk(double start, double max_step, unsigned seed)
+{
+    signal_spec spec = noise(start, max_step, seed);
+    spec.shape = signal_random_walk;
+    return spec;
+}
+
+signal_spec signal_spec::step(double offset, double height, double period_s, int steps)
+{
+    signal_spec spec = ramp(offset, height, period_s);
+    spec.shape = signal_step;
+    spec.steps = steps;
+    return spec;
+}
+
+signal_spec signal_spec::counter(double start, double increment)
+{
+    signal_spec spec;
+    spec.shape = signal_counter;
+    spec.offset = start;
+    spec.amplitude = increment;
+    return spec;
+}
+
+signal_bank::signal_bank()
+    : d_start_ns(monotonic_ns())
+{
+}
+
+size_t signal_bank::add(const signal_spec& spec)
+{
+    tthread::lock_guard<tthread::fast_mutex> guard(d_mutex);
+    size_t id = d_shapes.size();
+    d_shapes.push_back(0);
+    d_offsets.push_back(0);
+    d_amplitudes.push_back(0);
+    d_rates.push_back(0);
+    d_phases.push_back(0);
+    d_steps.push_back(0);
+    d_states.push_back(0);
+    d_random.push_back(0);
+    reset(id, spec);
+    return id;
+}
+
+void signal_bank::assign(size_t id, const signal_spec& spec)
+{
+    tthread::lock_guard<tthread::fast_mutex> guard(d_mutex);
+    reset(id, spec);
+}
+
+void signal_bank::reset(size_t id, const signal_spec& spec)
+{
+    d_shapes[id] = spec.shape;
+    d_offsets[id] = spec.offset;
+    d_amplitudes[id] = spec.amplitude;
+    d_rates[id] = spec.period_s > 0 ? 1 / spec.period_s : 0;
+    d_phases[id] = spec.phase;
+    d_steps[id] = spec.steps > 0 ? spec.steps : 1;
+    d_states[id] = 0;
+    d_random[id] = random_state(spec.seed);
+}
+
+double signal_bank::seconds() const
+{
+    return (monotonic_ns() - d_start_ns) / 1e9;
+}
+
+void signal_bank::evaluate(const size_t* ids, size_t count, double t, double* values)
+{
+    tthread::lock_guard<tthread::fast_mutex> guard(d_mutex);
+    for (size_t n = 0; n < count; n++)
+        d_batch[d_shapes[ids[n]]].push_back(n);
+
+    const double* offsets = d_offsets.empty() ? nullptr : &d_offsets[0];
+    const double* amplitudes = d_amplitudes.empty() ? nullptr : &d_amplitudes[0];
+    const double* rates = d_rates.empty() ? nullptr : &d_rates[0];
+    const double* phases = d_phases.empty() ? nullptr : &d_phases[0];
+    const double* steps = d_steps.empty() ? nullptr : &d_steps[0];
+    double* states = d_states.empty() ? nullptr : &d_states[0];
+    unsigned* random = d_random.empty() ? nullptr : &d_random[0];
+
+    std::vector<size_t>& ramps = d_batch[signal_ramp];
+    for (size_t i = 0; i < ramps.size(); i++)
+    {
+        size_t n = ramps[i], id = ids[n];
+        double x = t * rates[id] + phases[id];
+        values[n] = offsets[id] + amplitudes[id] * (x - floor(x));
+    }
+    std::vector<size_t>& sines = d_batch[signal_sine];
+    for (size_t i = 0; i < sines.size(); i++)
+    {
+        size_t n = sines[i], id = ids[n];
+        values[n] = offsets[id] + amplitudes[id] * sin(kTwoPi * (t * rates[id] + phases[id]));
+    }
+    std::vector<size_t>& levels = d_batch[signal_step];
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        size_t n = levels[i], id = ids[n];
+        double k = floor(t * rates[id] + phases[id]);
+        values[n] = offsets[id] + amplitudes[id] * (k - steps[id] * floor(k / steps[id]));
+    }
+    std::vector<size_t>& noises = d_batch[signal_noise];
+    for (size_t i = 0; i < noises.size(); i++)
+    {
+        size_t n = noises[i], id = ids[n];
+        values[n] = offsets[id] + amplitudes[id] * uniform(random[id]);
+    }
+    std::vector<size_t>& walks = d_batch[signal_random_walk];
+    for (size_t i = 0; i < walks.size(); i++)
+    {
+        size_t n = walks[i], id = ids[n];
+        states[id] += amplitudes[id] * uniform(random[id]);
+        values[n] = offsets[id] + states[id];
+    }
+    std::vector<size_t>& counters = d_batch[signal_counter];
+    for (size_t i = 0; i < counters.size(); i++)
+    {
+        size_t n = counters[i], id = ids[n];
+        values[n] = offsets[id] + states[id];
+        states[id] += amplitudes[id];
+    }
+
+    for (int shape = 0; shape < signal_shape_count; shape++)
+        d_batch[shape].clear();
+}
+
+double signal_bank::evaluate(size_t id, double t)
+{
+    double value;
+    evaluate(&id, 1, t, &value);
+    return value;
+}
+
+namespace g2 {
+namespace fasth {
+template <>
+int signal_value<int>(double value)
+{
+    return (int)floor(value + 0.5);
+}
+
+template <>
+double signal_value<double>(double value)
+{
+    return value;
+}
+
+template <>
+bool signal_value<bool>(double value)
+{
+    return value >= 0.5;
+}
+
+template <>
+std::string signal_value<std::string>(double value)
+{
+    char buf[32];
+    sprintf(buf, "%g", value);
+    return buf;
+}
+}
+}
@@ -0,0 +1,331 @@
+#include "string_convert.hpp"
+
+#if defined(__AVX2__)
+#define G2FASTH_CONVERT_AVX2
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define G2FASTH_CONVERT_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+// Wide characters are 16 bits on Windows and 32 bits elsewhere
+const bool kShortWideChars = sizeof(wchar_t) == sizeof(short);
+
+/**
+* Checks if the character has the same code in all three forms. Characters above
+* 127 and '~', '@' and '\\', which GSI_CHAR_SET_GENSYM uses as escape characters,
+* are converted by GSI.
+*/
+inline bool is_plain(unsigned long c)
+{
+    return c < 0x80 && c != '~' && c != '@' && c != '\\';
+}
+
+#if defined(G2FASTH_CONVERT_AVX2)
+/**
+* Sets all bits of each character which is an escape character.
+*/
+inline __m256i escapes_epi8(__m256i v)
+{
+    return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('~')),
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('@'))), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+}
+inline __m256i escapes_epi16(__m256i v)
+{
+    return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi16(v, _mm256_set1_epi16('~')),
+        _mm256_cmpeq_epi16(v, _mm256_set1_epi16('@'))), _mm256_cmpeq_epi16(v, _mm256_set1_epi16('\\')));
+}
+inline __m256i escapes_epi32(__m256i v)
+{
+    return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi32(v, _mm256_set1_epi32('~')),
+        _mm256_cmpeq_epi32(v, _mm256_set1_epi32('@'))), _mm256_cmpeq_epi32(v, _mm256_set1_epi32('\\')));
+}
+#endif
+#if defined(G2FASTH_CONVERT_SSE2)
+inline __m128i escapes_epi8(__m128i v)
+{
+    return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('~')),
+        _mm_cmpeq_epi8(v, _mm_set1_epi8('@'))), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+}
+inline __m128i escapes_epi16(__m128i v)
+{
+    return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(v, _mm_set1_epi16('~')),
+        _mm_cmpeq_epi16(v, _mm_set1_epi16('@'))), _mm_cmpeq_epi16(v, _mm_set1_epi16('\\')));
+}
+inline __m128i escapes_epi32(__m128i v)
+{
+    return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi32(v, _mm_set1_epi32('~')),
+        _mm_cmpeq_epi32(v, _mm_set1_epi32('@'))), _mm_cmpeq_epi32(v, _mm_set1_epi32('\\')));
+}
+
+/**
+* Checks if no bit of the vector is set.
+*/
+inline bool is_zero(__m128i v)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) == 0xFFFF;
+}
+#endif
+
+/**
+* Copies plain ASCII text of 16-bit characters.
+*/
+bool copy_ascii(const short* src, size_t length, short* dest)
+{
+    size_t i = 0;
+#if defined(G2FASTH_CONVERT_SSE2)
+    const __m128i high = _mm_set1_epi16((short)0xFF80);
+    for (; i + 8 <= length; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        if (!is_zero(_mm_or_si128(_mm_and_si128(v, high), escapes_epi16(v))))
+            return false;
+        _mm_storeu_si128((__m128i*)(dest + i), v);
+    }
+#endif
+    for (; i < length; i++)
+    {
+        if (!is_plain((unsigned short)src[i]))
+            return false;
+        dest[i] = src[i];
+    }
+    return true;
+}
+}
+
+bool g2::fasth::is_ascii(const char* str, size_t length)
+{
+    size_t i = 0;
+#if defined(G2FASTH_CONVERT_AVX2)
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(str + i));
+        if (_mm256_movemask_epi8(_mm256_or_si256(v, escapes_epi8(v))))
+            return false;
+    }
+#endif
+#if defined(G2FASTH_CONVERT_SSE2)
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(str + i));
+        if (_mm_movemask_epi8(_mm_or_si128(v, escapes_epi8(v))))
+            return false;
+    }
+#endif
+    for (; i < length; i++)
+    {
+        if (!is_plain((unsigned char)str[i]))
+            return false;
+    }
+    return true;
+}
+
+bool g2::fasth::is_ascii(const short* gstr, size_t length)
+{
+    size_t i = 0;
+#if defined(G2FASTH_CONVERT_AVX2)
+    const __m256i high256 = _mm256_set1_epi16((short)0xFF80);
+    for (; i + 16 <= length; i += 16)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(gstr + i));
+        __m256i special = _mm256_or_si256(_mm256_and_si256(v, high256), escapes_epi16(v));
+        if (!_mm256_testz_si256(special, special))
+            return false;
+    }
+#endif
+#if defined(G2FASTH_CONVERT_SSE2)
+    const __m128i high = _mm_set1_epi16((short)0xFF80);
+    for (; i + 8 <= length; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(gstr + i));
+        if (!is_zero(_mm_or_si128(_mm_and_si128(v, high), escapes_epi16(v))))
+            return false;
+    }
+#endif
+    for (; i < length; i++)
+    {
+        if (!is_plain((unsigned short)gstr[i]))
+            return false;
+    }
+    return true;
+}
+
+bool g2::fasth::convert_ascii(const char* str, size_t length, short* dest)
+{
+    size_t i = 0;
+#if defined(G2FASTH_CONVERT_AVX2)
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(str + i));
+        if (_mm256_movemask_epi8(_mm256_or_si256(v, escapes_epi8(v))))
+            return false;
+        _mm256_storeu_si256((__m256i*)(dest + i), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)));
+        _mm256_storeu_si256((__m256i*)(dest + i + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)));
+    }
+#endif
+#if defined(G2FASTH_CONVERT_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(str + i));
+        if (_mm_movemask_epi8(_mm_or_si128(v, escapes_epi8(v))))
+            return false;
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128((__m128i*)(dest + i + 8), _mm_unpackhi_epi8(v, zero));
+    }
+#endif
+    for (; i < length; i++)
+    {
+        if (!is_plain((unsigned char)str[i]))
+            return false;
+        dest[i] = str[i];
+    }
+    return true;
+}
+
+bool g2::fasth::convert_ascii(const short* gstr, size_t length, char* dest)
+{
+    size_t i = 0;
+#if defined(G2FASTH_CONVERT_AVX2)
+    const __m256i high256 = _mm256_set1_epi16((short)0xFF80);
+    for (; i + 32 <= length; i += 32)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(gstr + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(gstr + i + 16));
+        __m256i special = _mm256_or_si256(_mm256_and_si256(_mm256_or_si256(a, b), high256),
+            _mm256_or_si256(escapes_epi16(a), escapes_epi16(b)));
+        if (!_mm256_testz_si256(special, special))
+            return false;
+        // Packing works within 128-bit lanes, quarters are put in order after it
+        __m256i packed = _mm256_packus_epi16(a, b);
+        _mm256_storeu_si256((__m256i*)(dest + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+#endif
+#if defined(G2FASTH_CONVERT_SSE2)
+    const __m128i high = _mm_set1_epi16((short)0xFF80);
+    for (; i + 16 <= length; i += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(gstr + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(gstr + i + 8));
+        if (!is_zero(_mm_or_si128(_mm_and_si128(_mm_or_si128(a, b), high), _mm_or_si128(escapes_epi16(a), escapes_epi16(b)))))
+            return false;
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_packus_epi16(a, b));
+    }
+#endif
+    for (; i < length; i++)
+    {
+        if (!is_plain((unsigned short)gstr[i]))
+            return false;
+        dest[i] = (char)gstr[i];
+    }
+    return true;
+}
+
+bool g2::fasth::convert_ascii(const wchar_t* wstr, size_t length, short* dest)
+{
+    if (kShortWideChars)
+        return copy_ascii((const short*)wstr, length, dest);
+    size_t i = 0;
+#if defined(G2FASTH_CONVERT_AVX2)
+    const __m256i high256 = _mm256_set1_epi32(~0x7F);
+    for (; i + 16 <= length; i += 16)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(wstr + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(wstr + i + 8));
+        __m256i special = _mm256_or_si256(_mm256_and_si256(_mm256_or_si256(a, b), high256),
+            _mm256_or_si256(escapes_epi32(a), escapes_epi32(b)));
+        if (!_mm256_testz_si256(special, special))
+            return false;
+        __m256i packed = _mm256_packs_epi32(a, b);
+        _mm256_storeu_si256((__m256i*)(dest + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+#endif
+#if defined(G2FASTH_CONVERT_SSE2)
+    const __m128i high = _mm_set1_epi32(~0x7F);
+    for (; i + 8 <= length; i += 8)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i*)(wstr + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(wstr + i + 4));
+        if (!is_zero(_mm_or_si128(_mm_and_si128(_mm_or_si128(a, b), high), _mm_or_si128(escapes_epi32(a), escapes_epi32(b)))))
+            return false;
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_packs_epi32(a, b));
+    }
+#endif
+    for (; i < length; i++)
+    {
+        if (!is_plain((unsigned long)wstr[i]))
+            return false;
+        dest[i] = (short)wstr[i];
+    }
+    return true;
+}
+
+bool g2::fasth::convert_ascii(const short* gstr, size_t length, wchar_t* dest)
+{
+    if (kShortWideChars)
+        return copy_ascii(gstr, length, (short*)dest);
+    size_t i = 0;
+#if defined(G2FASTH_CONVERT_AVX2)
+    const __m256i high256 = _mm256_set1_epi16((short)0xFF80);
+    for (; i + 16 <= length; i += 16)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(gstr + i));
+        __m256i special = _mm256_or_si256(_mm256_and_si256(v, high256), escapes_epi16(v));
+        if (!_mm256_testz_si256(special, special))
+            return false;
+        _mm256_storeu_si256((__m256i*)(dest + i), _mm256_cvtepu16_epi32(_mm256_castsi256_si128(v)));
+        _mm256_storeu_si256((__m256i*)(dest + i + 8), _mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1)));
+    }
+#endif
+#if defined(G2FASTH_CONVERT_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i high = _mm_set1_epi16((short)0xFF80);
+    for (; i + 8 <= length; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(gstr + i));
+        if (!is_zero(_mm_or_si128(_mm_and_si128(v, high), escapes_epi16(v))))
+            return false;
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_unpacklo_epi16(v, zero));
+        _mm_storeu_si128((__m128i*)(dest + i + 4), _mm_unpackhi_epi16(v, zero));
+    }
+#endif
+    for (; i < length; i++)
+    {
+        if (!is_plain((unsigned short)gstr[i]))
+            return false;
+        dest[i] = (wchar_t)gstr[i];
+    }
+    return true;
+}
+
+size_t g2::fasth::gensym_length(const short* gstr)
+{
+    const short* p = gstr;
+#if defined(G2FASTH_CONVERT_SSE2)
+    // Aligned loads do not cross pages, so reading past the terminator is safe
+    for (; ((size_t)p & 15) != 0; p++)
+    {
+        if (!*p)
+            return p - gstr;
+    }
+    const __m128i zero = _mm_setzero_si128();
+    while (!_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_load_si128((const __m128i*)p), zero)))
+        p += 8;
+#endif
+    while (*p)
+        p++;
+    return p - gstr;
+}
+
+int g2::fasth::string_convert_vector_bits()
+{
+#if defined(G2FASTH_CONVERT_AVX2)
+    return 256;
+#elif defined(G2FASTH_CONVERT_SSE2)
+    return 128;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,215 @@
+#include <string.h>
+#include <vector>
+#include "symbol_table.hpp"
+#include "string_convert.hpp"
+#include "metrics.hpp"
+#include "tinythread.h"
+#include "fast_mutex.h"
+
+using namespace g2::fasth;
+
+namespace {
+metric_gauge& s_entries = metrics_registry::gauge(
+    "g2fasth_interned_strings", "Strings interned in the symbol table.");
+
+const size_t kInitialBuckets = 256;
+
+/**
+* FNV-1a hash of characters, narrow and Gensym strings are hashed alike.
+*/
+template <typename C>
+size_t hash_of(const C* str, size_t length)
+{
+    size_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+        hash = (hash ^ (unsigned short)str[i]) * 16777619u;
+    return hash;
+}
+
+struct table {
+    table() : count(0), buckets(kInitialBuckets, nullptr)
+#if defined(GSI_USE_WIDE_STRING_API)
+        , gensym_buckets(kInitialBuckets, nullptr)
+#endif
+    {
+    }
+    tthread::fast_mutex mutex;
+    size_t count;
+    std::vector<symbol_entry*> buckets;
+#if defined(GSI_USE_WIDE_STRING_API)
+    std::vector<symbol_entry*> gensym_buckets;
+#endif
+};
+
+/**
+* Table is never destroyed, static objects may release interned strings at exit
+* after it would be.
+*/
+table& the_table()
+{
+    static table* t = new table;
+    return *t;
+}
+
+symbol_entry*& bucket_of(std::vector<symbol_entry*>& buckets, size_t hash)
+{
+    return buckets[hash & (buckets.size() - 1)];
+}
+
+void grow(table& t)
+{
+    std::vector<symbol_entry*> buckets(t.buckets.size() * 2, nullptr);
+#if defined(GSI_USE_WIDE_STRING_API)
+    std::vector<symbol_entry*> gensym_buckets(buckets.size(), nullptr);
+#endif
+    for (size_t i = 0; i < t.buckets.size(); i++)
+    {
+        symbol_entry* next;
+        for (symbol_entry* entry = t.buckets[i]; entry; entry = next)
+        {
+            next = entry->next;
+            symbol_entry*& head = bucket_of(buckets, entry->hash);
+            entry->next = head;
+            head = entry;
+#if defined(GSI_USE_WIDE_STRING_API)
+            symbol_entry*& gensym_head = bucket_of(gensym_buckets, entry->gensym_hash);
+            entry->gensym_next = gensym_head;
+            gensym_head = entry;
+#endif
+        }
+    }
+    t.buckets.swap(buckets);
+#if defined(GSI_USE_WIDE_STRING_API)
+    t.gensym_buckets.swap(gensym_buckets);
+#endif
+}
+
+symbol_entry* find(table& t, const char* str, size_t length, size_t hash)
+{
+    for (symbol_entry* entry = bucket_of(t.buckets, hash); entry; entry = entry->next)
+    {
+        if (entry->hash == hash && entry->narrow.size() == length && memcmp(entry->narrow.data(), str, length) == 0)
+            return entry;
+    }
+    return nullptr;
+}
+
+/**
+* Adds entry for the string, converting it to Gensym string once.
+*/
+symbol_entry* add(table& t, const char* str, size_t length, size_t hash)
+{
+    if (t.count >= t.buckets.size())
+        grow(t);
+    symbol_entry* entry = new symbol_entry;
+    entry->refs = 0;
+    entry->hash = hash;
+    entry->narrow.assign(str, length);
+    symbol_entry*& head = bucket_of(t.buckets, hash);
+    entry->next = head;
+    head = entry;
+#if defined(GSI_USE_WIDE_STRING_API)
+    entry->gensym.resize(length);
+    // Converted string is in a buffer of GSI, which is reused by next conversion
+    if (!convert_ascii(str, length, &entry->gensym[0]))
+        entry->gensym = gsi_convert_string_to_unicode(const_cast<char*>(entry->narrow.c_str()), GSI_CHAR_SET_GENSYM);
+    entry->gensym_hash = hash_of(entry->gensym.data(), entry->gensym.size());
+    symbol_entry*& gensym_head = bucket_of(t.gensym_buckets, entry->gensym_hash);
+    entry->gensym_next = gensym_head;
+    gensym_head = entry;
+#endif
+    t.count++;
+    s_entries.add(1);
+    return entry;
+}
+
+symbol_entry* find_or_add(table& t, const char* str, size_t length)
+{
+    size_t hash = hash_of(str, length);
+    symbol_entry* entry = find(t, str, length, hash);
+    if (!entry)
+        entry = add(t, str, length, hash);
+    atomic_add(&entry->refs, 1);
+    return entry;
+}
+
+void unlink(symbol_entry*& head, symbol_entry* entry, symbol_entry* symbol_entry::*next)
+{
+    symbol_entry** link = &head;
+    while (*link != entry)
+        link = &((*link)->*next);
+    *link = entry->*next;
+}
+}
+
+interned_string::interned_string(const std::string& str) : d_entry(nullptr)
+{
+    interned_string interned = symbol_table::intern(str);
+    d_entry = interned.d_entry;
+    interned.d_entry = nullptr;
+}
+
+const std::string& interned_string::empty_string()
+{
+    static const std::string empty;
+    return empty;
+}
+
+void interned_string::release_last(symbol_entry* entry)
+{
+    table& t = the_table();
+    tthread::lock_guard<tthread::fast_mutex> guard(t.mutex);
+    // The entry may have been found again since the reference was checked
+    if (atomic_add(&entry->refs, -1) != 0)
+        return;
+    unlink(bucket_of(t.buckets, entry->hash), entry, &symbol_entry::next);
+#if defined(GSI_USE_WIDE_STRING_API)
+    unlink(bucket_of(t.gensym_buckets, entry->gensym_hash), entry, &symbol_entry::gensym_next);
+#endif
+    t.count--;
+    s_entries.add(-1);
+    delete entry;
+}
+
+interned_string symbol_table::intern(const char* str, size_t length)
+{
+    if (!length)
+        return interned_string();
+    table& t = the_table();
+    tthread::lock_guard<tthread::fast_mutex> guard(t.mutex);
+    return interned_string(find_or_add(t, str, length));
+}
+
+interned_string symbol_table::intern_gensym(const gsi_char* gstr)
+{
+    if (!gstr || !*gstr)
+        return interned_string();
+#if defined(GSI_USE_WIDE_STRING_API)
+    size_t length = gensym_length(gstr);
+    size_t hash = hash_of(gstr, length);
+    table& t = the_table();
+    tthread::lock_guard<tthread::fast_mutex> guard(t.mutex);
+    for (symbol_entry* entry = bucket_of(t.gensym_buckets, hash); entry; entry = entry->gensym_next)
+    {
+        if (entry->gensym_hash == hash && entry->gensym.size() == length
+            && memcmp(entry->gensym.data(), gstr, length * sizeof(gsi_char)) == 0)
+        {
+            atomic_add(&entry->refs, 1);
+            return interned_string(entry);
+        }
+    }
+    std::string narrow(length, '\0');
+    if (!convert_ascii(gstr, length, &narrow[0]))
+        narrow = gsi_convert_unicode_to_string(const_cast<gsi_char*>(gstr), GSI_CHAR_SET_GENSYM);
+    return interned_string(find_or_add(t, narrow.c_str(), narrow.size()));
+#else
+    return intern(gstr, strlen(gstr));
+#endif
+}
+
+size_t symbol_table::size()
+{
+    table& t = the_table();
+    tthread::lock_guard<tthread::fast_mutex> guard(t.mutex);
+    return t.count;
+}
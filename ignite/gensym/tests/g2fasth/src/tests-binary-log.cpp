@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <sstream>
+#include "catch.hpp"
+#include "suite.hpp"
+#include "binary_log.hpp"
+
+using namespace g2::fasth;
+
+class TestBinaryLog : public g2::fasth::suite<TestBinaryLog> {
+public:
+    TestBinaryLog()
+        : suite("TestBinaryLog", g2::fasth::test_order::implied, g2::fasth::log_level::VERBOSE) {
+    };
+    void setup_test_track() override
+    {
+        run(&TestBinaryLog::first_test, "first_test");
+        run(&TestBinaryLog::second_test, "second_test");
+    };
+    void first_test(const std::string& test_case_name)
+    {
+        get_logger().logf(log_level::VERBOSE, "message %d of %s", 1, test_case_name.c_str());
+        complete_test_case(test_case_name, test_outcome::pass);
+    }
+    void second_test(const std::string& test_case_name)
+    {
+        get_logger().log(log_level::VERBOSE, "message of " + test_case_name);
+        complete_test_case(test_case_name, test_outcome::pass);
+    }
+};
+
+TEST_CASE("Binary log should rebuild formatted messages") {
+    const char* path = "tests-binary-log.bin";
+    remove(path);
+    {
+        logger target(log_level::VERBOSE);
+        target.add_binary_log(binary_log::open(path), log_level::VERBOSE);
+        REQUIRE(target.is_enabled(log_level::VERBOSE));
+        target.log(log_level::REGULAR, "plain text");
+        target.logf(log_level::VERBOSE, "%d %i %u %x %05ld %lld %zu|%c|", -5, 42, 7u, 255u, 12L, -1234567890123LL,
+            (size_t)99, 'z');
+        target.logf(log_level::VERBOSE, "%.3f %e %-6s| %*d %.*s %%", 3.14159, 1e10, "ab", 4, 7, 2, "xyz");
+        target.log_formatted(log_level::SILENT, "name=%s null=%s", "value", (const char*)nullptr);
+        target.flush();
+    }
+    binary_log_reader reader;
+    REQUIRE(reader.open(path));
+    binary_log_entry entry;
+    REQUIRE(reader.next(entry));
+    REQUIRE(entry.text == "plain text");
+    REQUIRE(entry.level == log_level::REGULAR);
+    REQUIRE(entry.suite_name->empty());
+    REQUIRE(reader.next(entry));
+    REQUIRE(entry.text == "-5 42 7 ff 00012 -1234567890123 99|z|");
+    REQUIRE(reader.next(entry));
+    REQUIRE(entry.text == "3.142 1.000000e+10 ab    |    7 xy %");
+    REQUIRE(reader.next(entry));
+    REQUIRE(entry.text == "name=value null=(null)");
+    REQUIRE(entry.level == log_level::SILENT);
+    REQUIRE_FALSE(reader.next(entry));
+    remove(path);
+}
+
+TEST_CASE("Binary log should tag messages with suite and test case") {
+    const char* path = "tests-binary-log-suite.bin";
+    remove(path);
+    {
+        TestBinaryLog test_suite;
+        test_suite.get_logger().add_binary_log(binary_log::open(path), log_level::VERBOSE);
+        test_suite.execute();
+    }
+    binary_log_reader reader;
+    REQUIRE(reader.open(path));
+    binary_log_entry entry;
+    std::map<std::string, std::string> messages;
+    unsigned long long last_ns = 0;
+    while (reader.next(entry))
+    {
+        REQUIRE(*entry.suite_name == "TestBinaryLog");
+        REQUIRE(entry.time_ns >= last_ns);
+        REQUIRE(entry.thread > 0);
+        last_ns = entry.time_ns;
+        if (!entry.test_name->empty())
+            messages[*entry.test_name] = entry.text;
+    }
+    REQUIRE(messages["first_test"] == "message 1 of first_test");
+    REQUIRE(messages["second_test"] == "message of second_test");
+    remove(path);
+}
+
+TEST_CASE("Binary log should be smaller than text log") {
+    const char* path = "tests-binary-log-size.bin";
+    remove(path);
+    std::ostringstream text;
+    {
+        logger target(log_level::VERBOSE);
+        target.add_output_stream(text, log_level::VERBOSE);
+        target.add_binary_log(binary_log::open(path), log_level::VERBOSE);
+        for (int i = 0; i < 1000; i++)
+            target.logf(log_level::VERBOSE, "Variable %s of item %d changed from %d to %d", "TEMPERATURE", i, i * 3, i * 3 + 1);
+    }
+    FILE* file = fopen(path, "rb");
+    REQUIRE(file != nullptr);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    REQUIRE(size < (long)text.str().size());
+    remove(path);
+}
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "catch.hpp"
+#include "suite.hpp"
+#include "file_sink.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+std::string read_file(const std::string& path)
+{
+    std::ifstream file(path.c_str(), std::ios_base::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+}
+
+class TestFileSink : public suite<TestFileSink> {
+public:
+    TestFileSink(const std::string& path)
+        : suite("TestFileSink", test_order::implied, log_level::VERBOSE, path) {
+    };
+    void setup_test_track() override
+    {
+        run(&TestFileSink::only_test, "only_test");
+    };
+    void only_test(const std::string& test_case_name)
+    {
+        get_logger().logf(log_level::VERBOSE, "%s logged", test_case_name.c_str());
+        complete_test_case(test_case_name, test_outcome::pass);
+    }
+};
+
+TEST_CASE("File sink should be shared by path") {
+    const char* path = "tests-file-sink-shared.log";
+    remove(path);
+    {
+        auto first = file_sink::open(path);
+        auto second = file_sink::open(path);
+        REQUIRE(first != nullptr);
+        REQUIRE(first == second);
+        logger first_logger(log_level::VERBOSE), second_logger(log_level::VERBOSE);
+        first_logger.add_file_sink(first, log_level::VERBOSE);
+        second_logger.add_file_sink(second, log_level::VERBOSE);
+        first_logger.log(log_level::VERBOSE, "first");
+        second_logger.log(log_level::VERBOSE, "second");
+    }
+    REQUIRE(read_file(path) == "first\nsecond\n");
+    remove(path);
+}
+
+TEST_CASE("File sink should buffer messages until flushed") {
+    const char* path = "tests-file-sink-buffer.log";
+    remove(path);
+    file_sink_options options;
+    options.flush_interval_ms = 60000;
+    logger target(log_level::VERBOSE);
+    target.add_file_sink(file_sink::open(path, options), log_level::VERBOSE);
+    target.log(log_level::VERBOSE, "buffered");
+    REQUIRE(read_file(path).empty());
+    target.flush();
+    REQUIRE(read_file(path) == "buffered\n");
+    remove(path);
+}
+
+TEST_CASE("Flush of all file sinks should write buffers of every open sink") {
+    // More sinks than one block of the registry holds
+    const int kSinks = 20;
+    file_sink_options options;
+    options.flush_interval_ms = 60000;
+    std::vector<std::shared_ptr<file_sink> > sinks;
+    for (int i = 0; i < kSinks; i++)
+    {
+        std::string path = "tests-file-sink-all-" + std::to_string((long long)i) + ".log";
+        remove(path.c_str());
+        sinks.push_back(file_sink::open(path, options));
+        REQUIRE(sinks[i] != nullptr);
+        sinks[i]->write_line("line", 4);
+        REQUIRE(read_file(path) == "");
+    }
+    file_sink::flush_all();
+    for (int i = 0; i < kSinks; i++)
+    {
+        REQUIRE(read_file(sinks[i]->path()) == "line\n");
+        std::string path = sinks[i]->path();
+        sinks[i].reset();
+        remove(path.c_str());
+    }
+}
+
+TEST_CASE("File sink should rotate file by size") {
+    const char* path = "tests-file-sink-rotate.log";
+    remove(path);
+    remove("tests-file-sink-rotate.log.1");
+    remove("tests-file-sink-rotate.log.2");
+    {
+        file_sink_options options;
+        options.max_size = 20;
+        options.max_files = 1;
+        options.preallocate = 4096;
+        auto sink = file_sink::open(path, options);
+        for (int i = 0; i < 3; i++)
+            sink->write_line("0123456789", 10);
+    }
+    // Preallocated space is not counted in file size
+    REQUIRE(read_file(path) == "0123456789\n");
+    REQUIRE(read_file("tests-file-sink-rotate.log.1") == "0123456789\n");
+    REQUIRE(read_file("tests-file-sink-rotate.log.2").empty());
+    remove(path);
+    remove("tests-file-sink-rotate.log.1");
+}
+
+TEST_CASE("Suite should write log file given in constructor") {
+    const char* path = "tests-file-sink-suite.log";
+    remove(path);
+    {
+        TestFileSink test_suite(path);
+        test_suite.execute();
+        REQUIRE(read_file(path).find("only_test logged\n") != std::string::npos);
+    }
+    remove(path);
+}
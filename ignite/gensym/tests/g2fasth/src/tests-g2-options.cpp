@@ -1,3 +1,4 @@
+#include <stdio.h>
 #include <signal.h>
 #include "catch.hpp"
 #include "g2fasth.hpp"
@@ -116,3 +117,63 @@ TEST_CASE("Signal handling") {
     options.set_signal_handler(false);
     raise(SIGILL);
 }
+
+TEST_CASE("parse_arguments should parse result log flag") {
+    g2_options options;
+    int argc = 2;
+    char argv0[] = "test";
+    char argv1[] = "-result_log=results.bin";
+    char* argv[] = {argv0, argv1, nullptr};
+    options.parse_arguments(&argc, argv);
+    REQUIRE(options.get_result_log() == std::string("results.bin"));
+    REQUIRE(argc == 1);
+}
+
+TEST_CASE("parse_arguments should parse asynchronous log flags") {
+    g2_options options;
+    int argc = 3;
+    char argv0[] = "test";
+    char argv1[] = "-async_log=1024";
+    char argv2[] = "-log_drop";
+    char* argv[] = {argv0, argv1, argv2, nullptr};
+    options.parse_arguments(&argc, argv);
+    REQUIRE(options.get_async_log() == 1024);
+    REQUIRE(options.get_log_drop());
+    REQUIRE(argc == 1);
+    logger target(log_level::VERBOSE);
+    options.configure_logger(target);
+    REQUIRE(target.is_async());
+}
+
+TEST_CASE("parse_arguments should parse binary log flag") {
+    g2_options options;
+    int argc = 2;
+    char argv0[] = "test";
+    char argv1[] = "-binary_log=tests-options-log.bin";
+    char* argv[] = {argv0, argv1, nullptr};
+    options.parse_arguments(&argc, argv);
+    REQUIRE(options.get_binary_log() == std::string("tests-options-log.bin"));
+    REQUIRE(argc == 1);
+    {
+        logger target(log_level::VERBOSE);
+        REQUIRE_FALSE(target.is_enabled(log_level::VERBOSE));
+        options.configure_logger(target);
+        REQUIRE(target.is_enabled(log_level::VERBOSE));
+    }
+    remove("tests-options-log.bin");
+}
+
+TEST_CASE("parse_arguments should parse metrics flags") {
+    g2_options options;
+    REQUIRE(options.get_metrics_interval() == 10);
+    int argc = 2;
+    char argv0[] = "test";
+    char argv1[] = "-metrics_interval=5";
+    char* argv[] = {argv0, argv1, nullptr};
+    options.parse_arguments(&argc, argv);
+    REQUIRE(options.get_metrics_interval() == 5);
+    REQUIRE(options.get_metrics().empty());
+    REQUIRE_FALSE(options.get_metrics_summary());
+    REQUIRE(options.get_metrics_summary_interval() == 0);
+    REQUIRE(argc == 1);
+}
@@ -0,0 +1,81 @@
+#include <math.h>
+#include <string>
+#include "catch.hpp"
+#include "gsi_load_generator.hpp"
+
+using namespace g2::fasth;
+
+TEST_CASE("Load profiles should schedule updates by their rate") {
+    load_profile constant = load_profile::constant(100);
+    REQUIRE(constant.rate_at(5) == 100);
+    REQUIRE(fabs(constant.updates_until(2.5) - 250) < 1e-9);
+
+    load_profile ramp = load_profile::ramp(0, 100, 2);
+    REQUIRE(fabs(ramp.rate_at(1) - 50) < 1e-9);
+    REQUIRE(ramp.rate_at(3) == 100);
+    REQUIRE(fabs(ramp.updates_until(1) - 25) < 1e-9);
+    REQUIRE(fabs(ramp.updates_until(3) - 200) < 1e-9);
+
+    // 1000 updates/s in the first 0.1 s of each second, 10 updates/s otherwise
+    load_profile burst = load_profile::burst(10, 1000, 1, 0.1);
+    REQUIRE(burst.rate_at(0.05) == 1000);
+    REQUIRE(burst.rate_at(0.5) == 10);
+    REQUIRE(burst.rate_at(1.05) == 1000);
+    REQUIRE(fabs(burst.updates_until(0.05) - 50) < 1e-9);
+    REQUIRE(fabs(burst.updates_until(1) - 109) < 1e-9);
+    REQUIRE(fabs(burst.updates_until(2.05) - 268) < 1e-9);
+}
+
+TEST_CASE("Load generator should merge updates which are not polled") {
+    libgsi& gsiobj = libgsi::getInstance();
+    gsi_load_generator generator(gsiobj);
+    load_options options;
+    REQUIRE(false == generator.run(load_profile::constant(1000), options));
+    REQUIRE(generator.add_variables("LOAD-MERGED-", 10) == 10);
+    REQUIRE(false == generator.add_variable("LOAD-NOT-DECLARED"));
+
+    options.duration_s = 0.2;
+    options.interval_s = 0.05;
+    REQUIRE(generator.run(load_profile::constant(1000), options));
+    const load_summary& summary = generator.summary();
+    REQUIRE(summary.offered == 200);
+    // Without gsi_g2_poll each variable keeps its first update pending
+    REQUIRE(summary.queued == 10);
+    REQUIRE(summary.max_backlog >= 10);
+    REQUIRE(generator.samples().size() >= 4);
+    REQUIRE(generator.samples().back().backlog >= 10);
+    REQUIRE(generator.samples_csv().find("time_s,target_rate") == 0);
+    REQUIRE(generator.summary_text().find("offered 200 updates") != std::string::npos);
+
+    // Pending updates are sent to G2, which has not registered the variables
+    gsiobj.gsi_g2_poll_();
+}
+
+TEST_CASE("Polling load generator should queue each update") {
+    gsi_load_generator generator(libgsi::getInstance());
+    REQUIRE(generator.add_variables("LOAD-POLLED-", 100, g2_integer) == 100);
+    load_options options;
+    options.duration_s = 0.2;
+    options.interval_s = 0.1;
+    options.tick_ms = 10;
+    options.poll = true;
+    REQUIRE(generator.run(load_profile::ramp(500, 1500, 0.2), options));
+    REQUIRE(generator.summary().offered == 200);
+    REQUIRE(generator.summary().queued == 200);
+    REQUIRE(generator.samples().back().target_rate == 1500);
+}
+
+TEST_CASE("Load generator started on its thread should stop on request") {
+    gsi_load_generator generator(libgsi::getInstance());
+    REQUIRE(generator.add_variables("LOAD-STOPPED-", 10) == 10);
+    load_options options;
+    options.duration_s = 60;
+    options.poll = true;
+    options.tick_ms = 10;
+    REQUIRE(generator.start(load_profile::constant(100), options));
+    REQUIRE(false == generator.start(load_profile::constant(100), options));
+    tthread::this_thread::sleep_for(tthread::chrono::milliseconds(50));
+    generator.stop();
+    REQUIRE(generator.summary().elapsed_s < 60);
+    REQUIRE(generator.samples().size() == 1);
+}
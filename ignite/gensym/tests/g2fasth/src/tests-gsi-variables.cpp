@@ -211,3 +211,19 @@ TEST_CASE("Assigning to undeclared variable or variable with wrong type should f
     REQUIRE(false == gsiobj.assign_temp_value("BOOL-VAR-6", true, 2));   // 2 reads
     REQUIRE(false == gsiobj.assign_temp_value("STRING-VAR-6", std::string("Temporary string value"), 3));    // 3 reads
 }
+
+TEST_CASE("Temporary value should keep time of its first assignment until delivered") {
+    g2::fasth::libgsi& gsiobj = g2::fasth::libgsi::getInstance();
+    gsiobj.ignore_not_registered_variables();
+
+    REQUIRE(true == gsiobj.declare_g2_variable<int>("INT-VAR-7"));
+    g2::fasth::g2_variable* var = gsiobj.get_declared_variable("INT-VAR-7");
+    REQUIRE(var->assigned_us == 0);
+    REQUIRE(true == gsiobj.assign_def_value("INT-VAR-7", 60));
+    REQUIRE(var->assigned_us == 0);
+    REQUIRE(true == gsiobj.assign_temp_value("INT-VAR-7", 90, 1));
+    long assigned_us = var->assigned_us;
+    REQUIRE(assigned_us != 0);
+    REQUIRE(true == gsiobj.assign_temp_value("INT-VAR-7", 91, 1));
+    REQUIRE(var->assigned_us == assigned_us);
+}
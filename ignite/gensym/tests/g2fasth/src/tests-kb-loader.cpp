@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include "catch.hpp"
+#include "kb_loader.hpp"
+
+using namespace g2::fasth;
+
+static const char kb_export[] =
+    "<?xml version=\"1.0\"?>\n"
+    "<rdf:RDF xmlns:rdf=\"http://www.w3.org/TR/WD-rdf-syntax#\" xmlns:g2=\"g2-beta-12-0-16.rdf\" xmlns=\"\">\n"
+    "<g2:Module ID=\"KB-TEST\">\n"
+    "  <g2:externaldefinitions><g2:Sequence><rdf:li>\n"
+    "    <g2:c.OBJECT-DEFINITION>\n"
+    "      <g2:a.CLASS-NAME g2:type=\"Symbol\">BASE-INTEGER-CLASS</g2:a.CLASS-NAME>\n"
+    "      <g2:a.DIRECT-SUPERIOR-CLASSES><g2:Sequence>\n"
+    "        <rdf:li g2:type=\"Symbol\">INTEGER-VARIABLE</rdf:li></g2:Sequence></g2:a.DIRECT-SUPERIOR-CLASSES>\n"
+    "    </g2:c.OBJECT-DEFINITION></rdf:li></g2:Sequence></g2:externaldefinitions>\n"
+    "</g2:Module>\n"
+    "<!-- <c.GSI-FLOAT-CLASS> in comment is ignored -->\n"
+    "<c.GSI-FLOAT-CLASS ID=\"1\">\n"
+    "  <g2:a.OPTIONS><g2:Structure>\n"
+    "    <g2:sa.FORWARD-CHAIN g2:type=\"TruthValue\">false</g2:sa.FORWARD-CHAIN></g2:Structure></g2:a.OPTIONS>\n"
+    "  <g2:a.NAMES g2:type=\"Symbol\">FLOAT64-DAT</g2:a.NAMES>\n"
+    "  <g2:a.GSI-INTERFACE-NAME g2:type=\"Symbol\">RPC-INTERFACE</g2:a.GSI-INTERFACE-NAME>\n"
+    "  <g2:a.FOLLOWING-ITEM-IN-WORKSPACE-LAYERING><c.GSI-INTEGER-CLASS rdf:resource=\"#2\"/></g2:a.FOLLOWING-ITEM-IN-WORKSPACE-LAYERING>\n"
+    "</c.GSI-FLOAT-CLASS>\n"
+    "<c.GSI-INTEGER-CLASS ID=\"2\">\n"
+    "  <g2:a.NAMES><g2:Sequence><rdf:li g2:type=\"Symbol\">INTEGER-DAT</rdf:li>"
+    "<rdf:li g2:type=\"Symbol\">OTHER-NAME</rdf:li></g2:Sequence></g2:a.NAMES>\n"
+    "  <g2:a.GSI-INTERFACE-NAME g2:type=\"Symbol\">RPC-INTERFACE</g2:a.GSI-INTERFACE-NAME>\n"
+    "</c.GSI-INTEGER-CLASS>\n"
+    "<g2:c.SYMBOLIC-VARIABLE ID=\"3\">\n"
+    "  <g2:a.NAMES g2:type=\"Symbol\">SYMBOL-DAT</g2:a.NAMES>\n"
+    "  <g2:a.GSI-INTERFACE-NAME g2:type=\"Symbol\">RPC-INTERFACE</g2:a.GSI-INTERFACE-NAME>\n"
+    "</g2:c.SYMBOLIC-VARIABLE>\n"
+    "<g2:c.INTEGER-VARIABLE ID=\"4\">\n"
+    "  <g2:a.NAMES g2:type=\"Symbol\">NOT-GSI-VAR</g2:a.NAMES>\n"
+    "</g2:c.INTEGER-VARIABLE>\n"
+    "<c.UNKNOWN-CLASS ID=\"5\">\n"
+    "  <g2:a.NAMES g2:type=\"Symbol\">UNKNOWN-DAT</g2:a.NAMES>\n"
+    "  <g2:a.GSI-INTERFACE-NAME g2:type=\"Symbol\">RPC-INTERFACE</g2:a.GSI-INTERFACE-NAME>\n"
+    "</c.UNKNOWN-CLASS>\n"
+    "<g2:c.OBJECT-DEFINITION ID=\"6\">\n"
+    "  <g2:a.CLASS-NAME g2:type=\"Symbol\">GSI-FLOAT-CLASS</g2:a.CLASS-NAME>\n"
+    "  <g2:a.DIRECT-SUPERIOR-CLASSES><g2:Sequence>\n"
+    "    <rdf:li g2:type=\"Symbol\">FLOAT-VARIABLE</rdf:li>\n"
+    "    <rdf:li g2:type=\"Symbol\">GSI-DATA-SERVICE</rdf:li></g2:Sequence></g2:a.DIRECT-SUPERIOR-CLASSES>\n"
+    "</g2:c.OBJECT-DEFINITION>\n"
+    "<g2:c.OBJECT-DEFINITION ID=\"7\">\n"
+    "  <g2:a.CLASS-NAME g2:type=\"Symbol\">GSI-INTEGER-CLASS</g2:a.CLASS-NAME>\n"
+    "  <g2:a.DIRECT-SUPERIOR-CLASSES><g2:Sequence>\n"
+    "    <rdf:li g2:type=\"Symbol\">GSI-DATA-SERVICE</rdf:li>\n"
+    "    <rdf:li g2:type=\"Symbol\">BASE-INTEGER-CLASS</rdf:li></g2:Sequence></g2:a.DIRECT-SUPERIOR-CLASSES>\n"
+    "</g2:c.OBJECT-DEFINITION>\n"
+    "</rdf:RDF>\n";
+
+TEST_CASE("KB loader should find GSI variables and resolve their types") {
+    kb_loader loader;
+    REQUIRE(loader.parse(kb_export, sizeof(kb_export) - 1));
+    const std::vector<kb_variable>& vars = loader.variables();
+    REQUIRE(vars.size() == 3);
+    REQUIRE(vars[0].name == "FLOAT64-DAT");
+    REQUIRE(vars[0].class_name == "GSI-FLOAT-CLASS");
+    REQUIRE(vars[0].interface_name == "RPC-INTERFACE");
+    REQUIRE(vars[0].type == g2_float);
+    REQUIRE(vars[1].name == "INTEGER-DAT");
+    REQUIRE(vars[1].type == g2_integer);
+    REQUIRE(vars[2].name == "SYMBOL-DAT");
+    REQUIRE(vars[2].type == g2_symbol);
+    REQUIRE(loader.unresolved().size() == 1);
+    REQUIRE(loader.unresolved()[0] == "UNKNOWN-DAT");
+}
+
+TEST_CASE("KB loader should read KB export from file") {
+    const char* path = "tests-kb-loader.xml";
+    FILE* file = fopen(path, "wb");
+    REQUIRE(file != nullptr);
+    fwrite(kb_export, 1, sizeof(kb_export) - 1, file);
+    fclose(file);
+    kb_loader loader;
+    REQUIRE(loader.load(path));
+    REQUIRE(loader.variables().size() == 3);
+    remove(path);
+    REQUIRE_FALSE(loader.load(path));
+    REQUIRE_FALSE(loader.error().empty());
+    REQUIRE(loader.variables().empty());
+}
+
+TEST_CASE("KB loader should reject truncated KB export") {
+    kb_loader loader;
+    REQUIRE_FALSE(loader.parse(kb_export, 200));
+    REQUIRE_FALSE(loader.error().empty());
+}
+
+TEST_CASE("Variables loaded from KB should be declared in libgsi") {
+    static const char kb[] =
+        "<rdf:RDF>\n"
+        "<g2:c.INTEGER-VARIABLE><g2:a.NAMES>KB-VAR-1</g2:a.NAMES><g2:a.GSI-INTERFACE-NAME>GSI</g2:a.GSI-INTERFACE-NAME></g2:c.INTEGER-VARIABLE>\n"
+        "<g2:c.TEXT-VARIABLE><g2:a.NAMES>KB-VAR-2</g2:a.NAMES><g2:a.GSI-INTERFACE-NAME>GSI</g2:a.GSI-INTERFACE-NAME></g2:c.TEXT-VARIABLE>\n"
+        "</rdf:RDF>\n";
+    kb_loader loader;
+    REQUIRE(loader.parse(kb, sizeof(kb) - 1));
+    libgsi& gsiobj = libgsi::getInstance();
+    REQUIRE(loader.declare_variables(gsiobj) == 2);
+    REQUIRE(loader.declare_variables(gsiobj) == 0);
+    libgsi::variable_map vars = gsiobj.get_g2_variables();
+    REQUIRE(vars.count("KB-VAR-1") == 1);
+    REQUIRE(vars["KB-VAR-1"]->dec_type == g2_integer);
+    REQUIRE(vars.count("KB-VAR-2") == 1);
+    REQUIRE(vars["KB-VAR-2"]->dec_type == g2_string);
+}
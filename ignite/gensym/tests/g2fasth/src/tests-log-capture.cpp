@@ -0,0 +1,89 @@
+#include <sstream>
+#include "catch.hpp"
+#include "suite.hpp"
+
+using namespace g2::fasth;
+
+class TestLogCapture : public suite<TestLogCapture> {
+public:
+    TestLogCapture()
+        : suite("TestLogCapture", test_order::implied, log_level::VERBOSE) {
+        get_logger().add_output_stream(output, log_level::VERBOSE);
+    };
+    void setup_test_track() override
+    {
+        run(&TestLogCapture::first_test, "first_test");
+        run(&TestLogCapture::second_test, "second_test");
+    };
+    void first_test(const std::string& test_case_name)
+    {
+        log_lines(test_case_name);
+        go_async(test_case_name, &TestLogCapture::first_test_continuation);
+    }
+    void first_test_continuation(const std::string& test_case_name)
+    {
+        get_logger().logf(log_level::VERBOSE, "%s continued", test_case_name.c_str());
+        complete_test_case(test_case_name, test_outcome::pass);
+    }
+    void second_test(const std::string& test_case_name)
+    {
+        log_lines(test_case_name);
+        complete_test_case(test_case_name, test_outcome::fail);
+    }
+    void log_lines(const std::string& test_case_name)
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            get_logger().logf(log_level::VERBOSE, "%s line %d", test_case_name.c_str(), i);
+            tthread::this_thread::sleep_for(tthread::chrono::milliseconds(5));
+        }
+    }
+    std::ostringstream output;
+};
+
+namespace {
+// Checks that all lines of the test case follow each other
+bool is_contiguous(const std::string& output, const std::string& test_case_name, int count)
+{
+    size_t pos = output.find(test_case_name + " line 0");
+    if (pos == std::string::npos)
+        return false;
+    std::istringstream lines(output.substr(pos));
+    std::string line;
+    for (int i = 0; i < count; i++)
+    {
+        if (!std::getline(lines, line) || line.compare(0, test_case_name.size(), test_case_name) != 0)
+            return false;
+    }
+    return true;
+}
+}
+
+TEST_CASE("Captured messages of a test case should be written as one block") {
+    TestLogCapture test_suite;
+    test_suite.get_logger().set_capture(logger::capture_block);
+    test_suite.execute();
+    std::string output = test_suite.output.str();
+    // Five lines of the action and one of asynchronous continuation
+    REQUIRE(is_contiguous(output, "first_test", 6));
+    REQUIRE(output.find("first_test continued") != std::string::npos);
+    REQUIRE(is_contiguous(output, "second_test", 5));
+    REQUIRE(output.find("Outcome of first_test") != std::string::npos);
+}
+
+TEST_CASE("Captured messages of failed test cases should be attached to report") {
+    TestLogCapture test_suite;
+    test_suite.get_logger().set_capture(logger::capture_report, true);
+    std::string report = test_suite.execute();
+    std::string output = test_suite.output.str();
+    REQUIRE(output.find("line") == std::string::npos);
+    REQUIRE(report.find("<system-out>second_test line 0\nsecond_test line 1") != std::string::npos);
+    REQUIRE(report.find("first_test line") == std::string::npos);
+}
+
+TEST_CASE("Messages should not be captured by default") {
+    TestLogCapture test_suite;
+    std::string report = test_suite.execute();
+    REQUIRE(test_suite.output.str().find("second_test line 4") != std::string::npos);
+    REQUIRE(report.find("system-out") == std::string::npos);
+}
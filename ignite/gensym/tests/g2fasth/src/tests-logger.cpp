@@ -1,6 +1,12 @@
+#include <algorithm>
 #include <memory>
+#include <sstream>
+#include <vector>
 #include "catch.hpp"
+// VERBOSE messages logged through macros are compiled out in this file
+#define G2FASTH_MIN_LOG_LEVEL REGULAR
 #include "logger.hpp"
+#include "signal_registry.hpp"
 
 using namespace g2::fasth;
 
@@ -42,4 +48,153 @@ TEST_CASE("Logger set at lower log level should not log data with higher log lev
     logger_instance.add_output_stream(std::cout, g2::fasth::log_level::REGULAR);
     logger_instance.log(log_level::REGULAR, "Sample Log");
     REQUIRE(d_buffer.str().empty());
-}
\ No newline at end of file
+}
+TEST_CASE("Asynchronous logger should write all messages in order on flush") {
+    std::stringstream buffer;
+    logger logger_instance(g2::fasth::log_level::VERBOSE);
+    logger_instance.add_output_stream(buffer, g2::fasth::log_level::REGULAR);
+    logger_instance.set_async(8);
+    std::string expected;
+    for (int i = 0; i < 100; i++)
+    {
+        std::string text = "Message " + std::to_string((long long)i);
+        logger_instance.log(log_level::REGULAR, text);
+        logger_instance.log(log_level::VERBOSE, "Filtered out");
+        expected += text + "\n";
+    }
+    logger_instance.flush();
+    REQUIRE(buffer.str() == expected);
+    REQUIRE(logger_instance.dropped() == 0);
+}
+
+/**
+* Stream buffer which blocks writer until the test releases it.
+*/
+struct blocking_buffer : std::stringbuf {
+    tthread::mutex gate;
+    int sync() override {
+        tthread::lock_guard<tthread::mutex> lg(gate);
+        return std::stringbuf::sync();
+    }
+};
+
+TEST_CASE("Asynchronous logger should count dropped messages when queue is full") {
+    blocking_buffer buffer;
+    std::ostream stream(&buffer);
+    logger logger_instance(g2::fasth::log_level::VERBOSE);
+    logger_instance.add_output_stream(stream, g2::fasth::log_level::VERBOSE);
+    logger_instance.set_async(4, logger::drop);
+    buffer.gate.lock();
+    for (int i = 0; i < 100; i++)
+        logger_instance.log(log_level::REGULAR, "Message");
+    REQUIRE(logger_instance.dropped() > 0);
+    buffer.gate.unlock();
+    logger_instance.flush();
+    int written = 0;
+    std::string line;
+    std::istringstream lines(buffer.str());
+    while (std::getline(lines, line))
+        written += line == "Message";
+    REQUIRE(written + logger_instance.dropped() == 100);
+}
+
+namespace {
+const int kRegistered = 100;
+int s_objects[kRegistered];
+signal_registry<int> s_registry;
+
+/**
+* Registers every fourth object, starting at the one given by the thread.
+*/
+void register_objects(void* p)
+{
+    for (int i = *(int*)p; i < kRegistered; i += 4)
+        s_registry.add(&s_objects[i]);
+}
+}
+
+TEST_CASE("Signal registry should keep all objects registered concurrently") {
+    int starts[4] = { 0, 1, 2, 3 };
+    std::vector<tthread::thread*> threads;
+    for (int t = 0; t < 4; t++)
+        threads.push_back(new tthread::thread(register_objects, &starts[t]));
+    for (int t = 0; t < 4; t++)
+    {
+        threads[t]->join();
+        delete threads[t];
+    }
+    std::vector<int> seen(kRegistered, 0);
+    s_registry.for_each([&](int* object) { seen[object - s_objects]++; });
+    REQUIRE(std::count(seen.begin(), seen.end(), 1) == kRegistered);
+
+    for (int i = 0; i < kRegistered; i++)
+        s_registry.remove(&s_objects[i]);
+    int count = 0;
+    s_registry.for_each([&](int*) { count++; });
+    REQUIRE(count == 0);
+}
+
+TEST_CASE("Flush of all loggers should reach every asynchronous logger") {
+    // More loggers than one block of the registry holds
+    const int kLoggers = 40;
+    std::vector<std::stringstream*> buffers;
+    std::vector<logger*> loggers;
+    for (int i = 0; i < kLoggers; i++)
+    {
+        buffers.push_back(new std::stringstream());
+        loggers.push_back(new logger(g2::fasth::log_level::REGULAR));
+        loggers[i]->add_output_stream(*buffers[i], g2::fasth::log_level::REGULAR);
+        loggers[i]->set_async(8);
+        loggers[i]->log(log_level::REGULAR, "Message");
+    }
+    logger::flush_all(0);
+    for (int i = 0; i < kLoggers; i++)
+    {
+        REQUIRE(buffers[i]->str() == "Message\n");
+        delete loggers[i];
+        delete buffers[i];
+    }
+}
+
+static int s_evaluated = 0;
+
+static std::string counted_message(const char* text)
+{
+    s_evaluated++;
+    return text;
+}
+
+TEST_CASE("Logging macros should not evaluate message of disabled level") {
+    std::stringstream buffer;
+    logger logger_instance(g2::fasth::log_level::VERBOSE);
+    logger_instance.add_output_stream(buffer, g2::fasth::log_level::SILENT);
+    s_evaluated = 0;
+    G2FASTH_LOG(logger_instance, REGULAR, counted_message("Disabled by stream level"));
+    G2FASTH_LOGF(logger_instance, REGULAR, "%s", counted_message("Disabled by stream level").c_str());
+    REQUIRE(s_evaluated == 0);
+    G2FASTH_LOG(logger_instance, SILENT, counted_message("Enabled"));
+    REQUIRE(s_evaluated == 1);
+    REQUIRE(buffer.str() == "Enabled\n");
+}
+
+TEST_CASE("Logging macros should strip levels below compile-time minimum") {
+    std::stringstream buffer;
+    logger logger_instance(g2::fasth::log_level::VERBOSE);
+    logger_instance.add_output_stream(buffer, g2::fasth::log_level::VERBOSE);
+    REQUIRE(logger_instance.is_enabled(log_level::VERBOSE));
+    s_evaluated = 0;
+    G2FASTH_LOG(logger_instance, VERBOSE, counted_message("Stripped"));
+    REQUIRE(s_evaluated == 0);
+    REQUIRE(buffer.str().empty());
+}
+
+TEST_CASE("Logger should format short and long messages") {
+    std::stringstream buffer;
+    logger logger_instance(g2::fasth::log_level::REGULAR);
+    logger_instance.add_output_stream(buffer, g2::fasth::log_level::REGULAR);
+    logger_instance.logf(log_level::REGULAR, "Test %s took %d ms", "first", 42);
+    std::string long_text(5000, 'x');
+    logger_instance.logf(log_level::REGULAR, "[%s]", long_text.c_str());
+    logger_instance.log_formatted(log_level::REGULAR, "%d-%d", 1, 2);
+    REQUIRE(buffer.str() == "Test first took 42 ms\n[" + long_text + "]\n1-2\n");
+}
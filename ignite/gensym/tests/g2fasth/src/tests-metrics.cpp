@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include "catch.hpp"
+#include "test_agent.hpp"
+#include "suite.hpp"
+#include "metrics.hpp"
+
+using namespace g2::fasth;
+
+class TestMetrics : public suite<TestMetrics> {
+public:
+    TestMetrics()
+        : suite("TestMetrics", test_order::implied, log_level::NONE, "", chrono::milliseconds(200)) {
+    };
+    void setup_test_track() override
+    {
+        run(&TestMetrics::first_test, "first_test");
+        run(&TestMetrics::second_test, "second_test").after(&TestMetrics::first_test);
+        run(&TestMetrics::timed_out_test, "timed_out_test");
+    };
+    void first_test(const std::string& test_case_name)
+    {
+        go_async(test_case_name, &TestMetrics::continuation);
+    }
+    void continuation(const std::string& test_case_name)
+    {
+        complete_test_case(test_case_name, test_outcome::pass);
+    }
+    void second_test(const std::string& test_case_name)
+    {
+        complete_test_case(test_case_name, test_outcome::fail);
+    }
+    void timed_out_test(const std::string&)
+    {
+    }
+};
+
+namespace {
+std::string read_file(const std::string& path)
+{
+    std::ifstream file(path.c_str(), std::ios_base::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+void add_from_thread(void* p)
+{
+    metric_counter* counter = (metric_counter*)p;
+    for (int i = 0; i < 1000; i++)
+        counter->add();
+}
+}
+
+TEST_CASE("Metric counter should sum values added by all threads") {
+    metric_counter& counter = metrics_registry::counter("tests_metrics_counter", "Counter of tests.");
+    REQUIRE(&counter == &metrics_registry::counter("tests_metrics_counter", "Counter of tests."));
+    REQUIRE_THROWS_AS(metrics_registry::gauge("tests_metrics_counter", ""), std::invalid_argument);
+    long long before = counter.value();
+    std::list<std::shared_ptr<tthread::thread>> threads;
+    for (int i = 0; i < 8; i++)
+        threads.push_back(std::make_shared<tthread::thread>(add_from_thread, &counter));
+    while (threads.size())
+    {
+        threads.front()->join();
+        threads.pop_front();
+    }
+    REQUIRE(counter.value() - before == 8000);
+}
+
+TEST_CASE("Metric histogram should keep values with bounded relative error") {
+    for (unsigned long long value = 1; value < (1ULL << 40); value = value * 3 + 1)
+    {
+        unsigned index = metric_histogram::bucket_index(value);
+        REQUIRE(metric_histogram::bucket_lower(index) <= value);
+        REQUIRE(value < metric_histogram::bucket_upper(index));
+        REQUIRE(metric_histogram::bucket_upper(index) - metric_histogram::bucket_lower(index) <= value / 8 + 1);
+    }
+    REQUIRE(metric_histogram::bucket_index(1ULL << 50) == kHistogramBuckets - 1);
+
+    metric_histogram& histogram = metrics_registry::histogram("tests_metrics_seconds", "Histogram of tests.");
+    histogram.reset();
+    REQUIRE(histogram.percentile(0.5) == 0);
+    for (unsigned long long value = 1; value <= 1000; value++)
+        histogram.record(value * 1000);
+    REQUIRE(histogram.count() == 1000);
+    unsigned long long median = histogram.percentile(0.5);
+    REQUIRE(median >= 500000);
+    REQUIRE(median <= 500000 + 500000 / 8);
+    unsigned long long max = histogram.percentile(1.0);
+    REQUIRE(max >= 1000000);
+    REQUIRE(max <= 1000000 + 1000000 / 8);
+}
+
+TEST_CASE("Metrics should be exported in OpenMetrics text format") {
+    const char* path = "tests-metrics.prom";
+    metrics_registry::counter("tests_metrics_labeled", "Labeled counter.", "kind=\"first\"").add(2);
+    metrics_registry::counter("tests_metrics_labeled", "Labeled counter.", "kind=\"second\"").add(3);
+    metric_histogram& histogram = metrics_registry::histogram("tests_metrics_export_seconds", "Exported histogram.");
+    histogram.reset();
+    histogram.record(1500);
+    histogram.record(3000000);
+    std::string text = metrics_registry::openmetrics();
+    REQUIRE(text.find("# TYPE tests_metrics_labeled counter\n"
+        "# HELP tests_metrics_labeled Labeled counter.\n"
+        "tests_metrics_labeled_total{kind=\"first\"} ") != std::string::npos);
+    REQUIRE(text.find("tests_metrics_labeled_total{kind=\"second\"} ") != std::string::npos);
+    REQUIRE(text.find("# TYPE tests_metrics_export_seconds histogram\n") != std::string::npos);
+    REQUIRE(text.find("tests_metrics_export_seconds_bucket{le=\"1.024e-06\"} 0\n") != std::string::npos);
+    REQUIRE(text.find("tests_metrics_export_seconds_bucket{le=\"4.096e-06\"} 1\n") != std::string::npos);
+    REQUIRE(text.find("tests_metrics_export_seconds_bucket{le=\"+Inf\"} 2\n") != std::string::npos);
+    REQUIRE(text.find("tests_metrics_export_seconds_count 2\n") != std::string::npos);
+    REQUIRE(text.find("# TYPE g2fasth_tests_started counter\n") != std::string::npos);
+    REQUIRE(text.substr(text.size() - 6) == "# EOF\n");
+    REQUIRE(metrics_registry::write_openmetrics(path));
+    REQUIRE(read_file(path).find("tests_metrics_export_seconds_count 2\n") != std::string::npos);
+    REQUIRE(read_file(std::string(path) + ".tmp").empty());
+    remove(path);
+}
+
+TEST_CASE("Scheduler metrics should be updated by test agent, suite and test cases") {
+    long long started = scheduler_metrics::tests_started.value();
+    long long passed = scheduler_metrics::tests_passed.value();
+    long long failed = scheduler_metrics::tests_failed.value();
+    long long timed_out = scheduler_metrics::tests_timed_out.value();
+    long long continuations = scheduler_metrics::continuations.value();
+    long long delays = scheduler_metrics::start_delay.count();
+    long long durations = scheduler_metrics::test_duration.count();
+    long long suites = scheduler_metrics::suite_duration.count();
+    {
+        test_agent agent(test_order::implied);
+        agent.schedule_suite(std::make_shared<TestMetrics>());
+        agent.execute();
+    }
+    REQUIRE(scheduler_metrics::tests_started.value() - started == 3);
+    REQUIRE(scheduler_metrics::tests_passed.value() - passed == 1);
+    REQUIRE(scheduler_metrics::tests_failed.value() - failed == 2);
+    REQUIRE(scheduler_metrics::tests_timed_out.value() - timed_out == 1);
+    REQUIRE(scheduler_metrics::continuations.value() - continuations == 1);
+    REQUIRE(scheduler_metrics::start_delay.count() - delays == 3);
+    REQUIRE(scheduler_metrics::test_duration.count() - durations == 3);
+    REQUIRE(scheduler_metrics::suite_duration.count() - suites == 1);
+    REQUIRE(scheduler_metrics::busy_workers.value() == 0);
+    REQUIRE(scheduler_metrics::running_suites.value() == 0);
+    REQUIRE(scheduler_metrics::tests_ready.value() == 0);
+    std::string summary = metrics_registry::summary();
+    REQUIRE(summary.find("g2fasth_test_duration_seconds count=") != std::string::npos);
+    REQUIRE(summary.find(" p99=") != std::string::npos);
+}
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include "catch.hpp"
+#include "suite.hpp"
+#include "result_log.hpp"
+
+using namespace g2::fasth;
+
+class TestResultLog : public g2::fasth::suite<TestResultLog> {
+public:
+    TestResultLog()
+        : suite("TestResultLog", g2::fasth::test_order::implied, g2::fasth::log_level::NONE) {
+    };
+    void setup_test_track() override
+    {
+        run(&TestResultLog::passing_test, "passing_test");
+        run(&TestResultLog::failing_test, "failing_test");
+    };
+    void passing_test(const std::string& test_case_name)
+    {
+        complete_test_case(test_case_name, test_outcome::pass);
+    }
+    void failing_test(const std::string& test_case_name)
+    {
+        complete_test_case(test_case_name, test_outcome::fail);
+    }
+};
+
+TEST_CASE("Result log should record outcome of every completed test case") {
+    const char* path = "tests-result-log.bin";
+    remove(path);
+    {
+        TestResultLog test_suite;
+        test_suite.set_result_log(path);
+        test_suite.execute();
+    }
+    result_log_reader reader;
+    REQUIRE(reader.open(path));
+    result_log_entry entry;
+    REQUIRE(reader.next(entry));
+    REQUIRE(*entry.suite_name == "TestResultLog");
+    REQUIRE(*entry.test_name == "passing_test");
+    REQUIRE(entry.outcome == test_outcome::pass);
+    REQUIRE(entry.failure.empty());
+    REQUIRE(reader.next(entry));
+    REQUIRE(*entry.test_name == "failing_test");
+    REQUIRE(entry.outcome == test_outcome::fail);
+    REQUIRE(entry.failure == G2FASTH_FAILURE_REASON);
+    REQUIRE_FALSE(reader.next(entry));
+    REQUIRE_FALSE(reader.suite_start_time("TestResultLog").empty());
+    remove(path);
+}
+
+TEST_CASE("Result log should be appended by subsequent runs") {
+    const char* path = "tests-result-log-append.bin";
+    remove(path);
+    for (int i = 0; i < 2; i++)
+    {
+        TestResultLog test_suite;
+        test_suite.set_result_log(path);
+        test_suite.execute();
+    }
+    result_log_reader reader;
+    REQUIRE(reader.open(path));
+    result_log_entry entry;
+    int count = 0;
+    while (reader.next(entry))
+    {
+        REQUIRE(*entry.suite_name == "TestResultLog");
+        count++;
+    }
+    REQUIRE(count == 4);
+    remove(path);
+}
+
+TEST_CASE("Result log reader should reject files without signature") {
+    const char* path = "tests-result-log-bad.bin";
+    FILE* file = fopen(path, "wb");
+    REQUIRE(file != nullptr);
+    fputs("<testsuite/>", file);
+    fclose(file);
+    result_log_reader reader;
+    REQUIRE_FALSE(reader.open(path));
+    remove(path);
+}
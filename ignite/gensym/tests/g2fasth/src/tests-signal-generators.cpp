@@ -0,0 +1,92 @@
+#include <math.h>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "libgsi.hpp"
+#include "signal_generators.hpp"
+
+using namespace g2::fasth;
+
+TEST_CASE("Signals depending on time should be computed at given time") {
+    signal_bank bank;
+    size_t ramp = bank.add(signal_spec::ramp(10, 4, 2));
+    size_t sine = bank.add(signal_spec::sine(1, 2, 4, 0.25));
+    size_t step = bank.add(signal_spec::step(0, 5, 1, 3));
+
+    REQUIRE(fabs(bank.evaluate(ramp, 0.5) - 11) < 1e-9);
+    REQUIRE(fabs(bank.evaluate(ramp, 2.5) - 11) < 1e-9);
+    // Phase of quarter period starts the sine at its maximum
+    REQUIRE(fabs(bank.evaluate(sine, 0) - 3) < 1e-9);
+    REQUIRE(fabs(bank.evaluate(sine, 2) + 1) < 1e-9);
+    REQUIRE(bank.evaluate(step, 0.5) == 0);
+    REQUIRE(bank.evaluate(step, 1.5) == 5);
+    REQUIRE(bank.evaluate(step, 2.5) == 10);
+    REQUIRE(bank.evaluate(step, 3.5) == 0);
+}
+
+TEST_CASE("Seeded signals should repeat their sequence") {
+    signal_bank bank;
+    size_t first = bank.add(signal_spec::noise(100, 10, 42));
+    size_t second = bank.add(signal_spec::noise(100, 10, 42));
+    size_t walk = bank.add(signal_spec::random_walk(0, 1, 7));
+    double previous = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        double value = bank.evaluate(first, 0);
+        REQUIRE(value == bank.evaluate(second, 0));
+        REQUIRE(value >= 90);
+        REQUIRE(value < 110);
+        double position = bank.evaluate(walk, 0);
+        REQUIRE(fabs(position - previous) <= 1);
+        previous = position;
+    }
+    // Assigning parameters restarts the signal
+    bank.assign(first, signal_spec::noise(100, 10, 42));
+    bank.assign(second, signal_spec::noise(100, 10, 42));
+    REQUIRE(bank.evaluate(first, 0) == bank.evaluate(second, 0));
+}
+
+TEST_CASE("Batch of signals should give the values of single evaluations") {
+    signal_bank bank;
+    signal_bank single;
+    std::vector<size_t> ids;
+    for (int i = 0; i < 600; i++)
+    {
+        signal_spec spec;
+        switch (i % 6)
+        {
+        case 0: spec = signal_spec::ramp(i, 2, 1 + i % 5); break;
+        case 1: spec = signal_spec::sine(0, i, 3, 0.1); break;
+        case 2: spec = signal_spec::noise(0, 1, i); break;
+        case 3: spec = signal_spec::random_walk(i, 0.5, i); break;
+        case 4: spec = signal_spec::step(0, 1, 0.5, 4); break;
+        default: spec = signal_spec::counter(i, 2); break;
+        }
+        ids.push_back(bank.add(spec));
+        single.add(spec);
+    }
+    std::vector<double> values(ids.size());
+    for (int round = 0; round < 3; round++)
+    {
+        bank.evaluate(&ids[0], ids.size(), round * 0.7, &values[0]);
+        for (size_t i = 0; i < ids.size(); i++)
+            REQUIRE(values[i] == single.evaluate(ids[i], round * 0.7));
+    }
+    REQUIRE(values[5] == 5 + 2 * 2);
+}
+
+TEST_CASE("Signal values should be converted to variable types") {
+    REQUIRE(signal_value<int>(2.5) == 3);
+    REQUIRE(signal_value<int>(-2.4) == -2);
+    REQUIRE(signal_value<bool>(0.5) == true);
+    REQUIRE(signal_value<bool>(0.49) == false);
+    REQUIRE(signal_value<std::string>(1.5) == "1.5");
+}
+
+TEST_CASE("Signals should be attached to declared variables only") {
+    libgsi& gsiobj = libgsi::getInstance();
+    REQUIRE(false == gsiobj.attach_signal("SIGNAL-VAR-0", signal_spec::counter(0, 1)));
+    REQUIRE(true == gsiobj.declare_g2_variable<int>("SIGNAL-VAR-0"));
+    REQUIRE(true == gsiobj.attach_signal("SIGNAL-VAR-0", signal_spec::counter(0, 1)));
+    REQUIRE(true == gsiobj.attach_signal("SIGNAL-VAR-0", signal_spec::sine(0, 1, 10)));
+}
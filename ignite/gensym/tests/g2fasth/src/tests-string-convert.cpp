@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "string_convert.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+// Longer than two vectors of any width, so that vector loops and tails are covered
+const size_t kMaxLength = 100;
+// Escape characters of Gensym strings
+const char kEscapes[] = { '~', '@', '\\' };
+
+/**
+* Returns printable ASCII text without escape characters, which converts without GSI.
+*/
+std::string ascii_text(size_t length)
+{
+    std::string text(length, ' ');
+    for (size_t i = 0; i < length; i++)
+    {
+        text[i] = (char)(32 + (i * 7) % 95);
+        if (std::find(kEscapes, kEscapes + sizeof(kEscapes), text[i]) != kEscapes + sizeof(kEscapes))
+            text[i] = '_';
+    }
+    return text;
+}
+}
+
+TEST_CASE("Text should be ASCII unless a character above 127 is anywhere in it") {
+    for (size_t length = 0; length <= kMaxLength; length++)
+    {
+        std::string text = ascii_text(length);
+        std::vector<short> gensym(text.begin(), text.end());
+        gensym.push_back(0);
+        REQUIRE(is_ascii(text.c_str(), length));
+        REQUIRE(is_ascii(&gensym[0], length));
+        for (size_t i = 0; i < length; i++)
+        {
+            text[i] = (char)0xE9;
+            gensym[i] = 0x100;
+            REQUIRE(false == is_ascii(text.c_str(), length));
+            REQUIRE(false == is_ascii(&gensym[0], length));
+            text[i] = 'a';
+            gensym[i] = 'a';
+        }
+    }
+}
+
+TEST_CASE("ASCII text should convert between narrow, wide and Gensym strings") {
+    for (size_t length = 0; length <= kMaxLength; length++)
+    {
+        std::string text = ascii_text(length);
+        std::wstring wide(text.begin(), text.end());
+        // Characters after the converted ones must stay untouched
+        std::vector<short> gensym(length + 1, -1);
+        std::string narrow(length + 1, '#');
+        std::wstring widened(length + 1, L'#');
+
+        REQUIRE(convert_ascii(text.c_str(), length, &gensym[0]));
+        REQUIRE(gensym[length] == -1);
+        gensym[length] = 0;
+        REQUIRE(gensym_length(&gensym[0]) == length);
+        REQUIRE(convert_ascii(&gensym[0], length, &narrow[0]));
+        REQUIRE(narrow == text + "#");
+        REQUIRE(convert_ascii(&gensym[0], length, &widened[0]));
+        REQUIRE(widened == wide + L"#");
+
+        std::fill(gensym.begin(), gensym.end(), -1);
+        REQUIRE(convert_ascii(wide.c_str(), length, &gensym[0]));
+        REQUIRE(gensym[length] == -1);
+        for (size_t i = 0; i < length; i++)
+            REQUIRE(gensym[i] == text[i]);
+    }
+}
+
+TEST_CASE("Conversion should report text which is not ASCII") {
+    for (size_t length = 1; length <= kMaxLength; length++)
+    {
+        std::vector<short> gensym(length);
+        std::string narrow(length, ' ');
+        std::wstring wide(length, L' ');
+        for (size_t i = 0; i < length; i += 7)
+        {
+            std::string text = ascii_text(length);
+            text[i] = (char)0x80;
+            REQUIRE(false == convert_ascii(text.c_str(), length, &gensym[0]));
+
+            std::wstring wtext(length, L'w');
+            wtext[i] = (wchar_t)0x20AC;
+            REQUIRE(false == convert_ascii(wtext.c_str(), length, &gensym[0]));
+
+            std::vector<short> gtext(length, 'g');
+            gtext[i] = (short)0xFFFF;
+            REQUIRE(false == convert_ascii(&gtext[0], length, &narrow[0]));
+            REQUIRE(false == convert_ascii(&gtext[0], length, &wide[0]));
+        }
+    }
+}
+
+TEST_CASE("Conversion should leave escape characters of Gensym strings to GSI") {
+    for (size_t length = 1; length <= kMaxLength; length++)
+    {
+        std::vector<short> gensym(length);
+        std::string narrow(length, ' ');
+        std::wstring wide(length, L' ');
+        for (size_t e = 0; e < sizeof(kEscapes); e++)
+        {
+            // Positions in vector loops and in tails
+            for (size_t i = 0; i < length; i += 5)
+            {
+                std::string text = ascii_text(length);
+                std::wstring wtext(text.begin(), text.end());
+                std::vector<short> gtext(text.begin(), text.end());
+                REQUIRE(is_ascii(text.c_str(), length));
+                REQUIRE(convert_ascii(&gtext[0], length, &narrow[0]));
+
+                text[i] = wtext[i] = gtext[i] = kEscapes[e];
+                REQUIRE(false == is_ascii(text.c_str(), length));
+                REQUIRE(false == is_ascii(&gtext[0], length));
+                REQUIRE(false == convert_ascii(text.c_str(), length, &gensym[0]));
+                REQUIRE(false == convert_ascii(wtext.c_str(), length, &gensym[0]));
+                REQUIRE(false == convert_ascii(&gtext[0], length, &narrow[0]));
+                REQUIRE(false == convert_ascii(&gtext[0], length, &wide[0]));
+            }
+        }
+    }
+}
+
+TEST_CASE("Length of Gensym string should not depend on its alignment") {
+    std::vector<short> buffer(kMaxLength + 16, 'x');
+    for (size_t offset = 0; offset < 8; offset++)
+    {
+        for (size_t length = 0; length + offset < kMaxLength; length++)
+        {
+            buffer[offset + length] = 0;
+            REQUIRE(gensym_length(&buffer[offset]) == length);
+            buffer[offset + length] = 'x';
+        }
+    }
+}
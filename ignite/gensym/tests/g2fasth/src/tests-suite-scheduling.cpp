@@ -237,4 +237,38 @@ TEST_CASE("Run dependent suites in parallel and one by one") {
     REQUIRE(output == expected);
 }
 
+TEST_CASE("Test agent should return single report of sequential and background suites") {
+    auto test_one = std::make_shared<TestOne>();
+    auto test_two = std::make_shared<TestTwo>();
+    test_agent agent;
+    agent.schedule_background_suite(test_one);
+    agent.schedule_suite(test_two);
+    auto report = agent.execute();
+    REQUIRE(report.find("<testsuites tests=\"2\" failures=\"0\" time=\"") == 0);
+    REQUIRE(report.find("name=\"TestOne\" failures=\"0\"") != std::string::npos);
+    REQUIRE(report.find("name=\"TestTwo\" failures=\"0\"") != std::string::npos);
+    REQUIRE(report.find("<testcase classname=\"TestOne.first_test\" name=\"first_test\"/>") != std::string::npos);
+    REQUIRE(report.find("<testcase classname=\"TestTwo.first_test\" name=\"first_test\"/>") != std::string::npos);
+}
+
+// Suite extending base_suite directly, which only overrides execute()
+class ExecuteOnlySuite : public base_suite {
+public:
+    ExecuteOnlySuite() : base_suite("ExecuteOnlySuite"), d_state(not_yet), executed(0) {}
+    std::string execute(std::string) override {
+        executed++;
+        return "";
+    }
+    void set_state(test_run_state new_state) override { d_state = new_state; }
+    test_run_state state() override { return d_state; }
+    test_run_state d_state;
+    int executed;
+};
 
+TEST_CASE("Test agent should run suite which overrides only execute") {
+    auto suite = std::make_shared<ExecuteOnlySuite>();
+    test_agent agent;
+    agent.schedule_suite(suite);
+    agent.execute();
+    REQUIRE(suite->executed == 1);
+}
@@ -0,0 +1,76 @@
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "libgsi.hpp"
+#include "symbol_table.hpp"
+
+using namespace g2::fasth;
+
+TEST_CASE("Interned strings should share the entry while it is referenced") {
+    size_t size = symbol_table::size();
+    interned_string first = symbol_table::intern("INTERNED-SYMBOL");
+    interned_string second(std::string("INTERNED-SYMBOL"));
+    REQUIRE(first == second);
+    REQUIRE(first.str() == "INTERNED-SYMBOL");
+    REQUIRE(first != symbol_table::intern("OTHER-SYMBOL"));
+    REQUIRE(symbol_table::size() == size + 1);
+    {
+        interned_string copy(first);
+        first = interned_string();
+        REQUIRE(copy == second);
+    }
+    second = first;
+    REQUIRE(symbol_table::size() == size);
+}
+
+TEST_CASE("Empty string should not be interned") {
+    interned_string empty;
+    REQUIRE(empty.empty());
+    REQUIRE(empty.str() == "");
+    REQUIRE(empty.gensym()[0] == 0);
+    REQUIRE(symbol_table::intern("") == empty);
+    REQUIRE(symbol_table::intern_gensym(nullptr) == empty);
+}
+
+TEST_CASE("Strings from GSI should be interned by their Gensym form") {
+    interned_string symbol = symbol_table::intern("GENSYM-SYMBOL");
+    REQUIRE(symbol_table::intern_gensym(symbol.gensym()) == symbol);
+
+    std::string text(300, 'x');
+    interned_string long_text = symbol_table::intern(text);
+    REQUIRE(long_text.size() == 300);
+    REQUIRE(symbol_table::intern_gensym(long_text.gensym()).str() == text);
+}
+
+TEST_CASE("Interned strings should be found after the table grows") {
+    size_t size = symbol_table::size();
+    std::vector<interned_string> strings;
+    for (int i = 0; i < 1000; i++)
+        strings.push_back(symbol_table::intern("GROWING-" + std::to_string((long long)i)));
+    REQUIRE(symbol_table::size() == size + 1000);
+    for (int i = 0; i < 1000; i++)
+        REQUIRE(symbol_table::intern("GROWING-" + std::to_string((long long)i)) == strings[i]);
+    strings.clear();
+    REQUIRE(symbol_table::size() == size);
+}
+
+TEST_CASE("String variables should return interned values of any length") {
+    libgsi& gsiobj = libgsi::getInstance();
+    gsiobj.ignore_not_registered_variables();
+    REQUIRE(true == gsiobj.declare_g2_variable<std::string>("INTERNED-STRING-VAR"));
+    std::string text(200, 'y');
+    REQUIRE(true == gsiobj.assign_temp_value("INTERNED-STRING-VAR", text, 1));
+    REQUIRE(true == gsiobj.assign_def_value("INTERNED-STRING-VAR", std::string("INTERNED-DEFAULT")));
+
+    g2_variable* var = gsiobj.get_declared_variable("INTERNED-STRING-VAR");
+    gsi_item* items = gsi_make_items(2);
+    var->get_val(items[0]);
+    var->get_val(items[1]);
+    REQUIRE(symbol_table::intern_gensym(str_of(items[0])).str() == text);
+    REQUIRE(symbol_table::intern_gensym(str_of(items[1])).str() == "INTERNED-DEFAULT");
+
+    // Value set by GSI is interned from the item
+    var->set_val(items[0], 1);
+    REQUIRE(((g2_typed_variable<std::string>*)var)->value() == text);
+    gsi_reclaim_items(items);
+}
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <string>
+#include "catch.hpp"
+#include "g2fasth_platform.hpp"
+#include "libgsi.hpp"
+#include "time_series_replay.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+const long long kSecond = 1000000000LL;
+
+template <typename T>
+T variable_value(libgsi& gsi, const std::string& name)
+{
+    libgsi::variable_map vars = gsi.get_g2_variables();
+    return static_cast<g2_typed_variable<T>*>(vars[name].get())->value();
+}
+
+/**
+* Writes rows at each half second: REPLAY-A counts 0, 1, 2, ..., REPLAY-B alternates.
+*/
+void write_recording(const char* path, const std::string& prefix, int rows)
+{
+    replay_writer writer;
+    REQUIRE(writer.open(path));
+    unsigned a = writer.add_variable(prefix + "-A", g2_float);
+    unsigned b = writer.add_variable(prefix + "-B", g2_logical);
+    for (int i = 0; i < rows; i++)
+        REQUIRE(writer.write(i * kSecond / 2, i % 2 ? b : a, i % 2 ? i / 2 % 2 : i / 2));
+    REQUIRE(false == writer.write(0, a, 1));
+    REQUIRE(writer.close());
+}
+}
+
+TEST_CASE("Replay should read recording written by replay_writer") {
+    const char* path = "tests-replay.bin";
+    write_recording(path, "REPLAY-META", 10);
+    libgsi& gsiobj = libgsi::getInstance();
+    time_series_replay replay(gsiobj);
+    REQUIRE(replay.open(path));
+    REQUIRE(replay.variable_count() == 2);
+    REQUIRE(replay.variable_name(0) == "REPLAY-META-A");
+    REQUIRE(replay.variable_type(1) == g2_logical);
+    REQUIRE(replay.row_count() == 10);
+    REQUIRE(replay.start_ns() == 0);
+    REQUIRE(replay.end_ns() == 9 * kSecond / 2);
+
+    replay.seek(kSecond + 1);
+    REQUIRE(replay.position_ns() == 3 * kSecond / 2);
+    replay.seek(100 * kSecond);
+    REQUIRE(replay.position_ns() == replay.end_ns());
+    replay.close();
+    remove(path);
+}
+
+TEST_CASE("Replay should reject file which is not a recording") {
+    const char* path = "tests-replay-bad.bin";
+    FILE* file = fopen(path, "wb");
+    REQUIRE(file != nullptr);
+    fputs("G2FRPLY1 but not much else", file);
+    fclose(file);
+    time_series_replay replay(libgsi::getInstance());
+    REQUIRE(false == replay.open(path));
+    REQUIRE(false == replay.open("tests-replay-missing.bin"));
+    remove(path);
+}
+
+TEST_CASE("Replay should assign recorded values to variables") {
+    const char* path = "tests-replay-values.bin";
+    write_recording(path, "REPLAY-VALUES", 10);
+    libgsi& gsiobj = libgsi::getInstance();
+    time_series_replay replay(gsiobj);
+    REQUIRE(replay.open(path));
+
+    REQUIRE(replay.play_until(2 * kSecond) == 5);
+    REQUIRE(variable_value<double>(gsiobj, "REPLAY-VALUES-A") == 2);
+    REQUIRE(variable_value<bool>(gsiobj, "REPLAY-VALUES-B") == true);
+
+    replay_options options;
+    options.speed = 0;
+    REQUIRE(replay.play(options) == 5);
+    REQUIRE(replay.rows_played() == 10);
+    REQUIRE(variable_value<double>(gsiobj, "REPLAY-VALUES-A") == 4);
+    REQUIRE(variable_value<bool>(gsiobj, "REPLAY-VALUES-B") == false);
+
+    // Temporary values are returned for given number of reads, then the default again
+    replay.seek(0);
+    options.temp_reads = 1;
+    REQUIRE(replay.play_until(0, options) == 1);
+    g2_typed_variable<double>* a = static_cast<g2_typed_variable<double>*>(gsiobj.get_declared_variable("REPLAY-VALUES-A"));
+    REQUIRE(a->value() == 0);
+    REQUIRE(a->value() == 4);
+    replay.close();
+    remove(path);
+}
+
+TEST_CASE("Looping replay should play until stopped") {
+    const char* path = "tests-replay-loop.bin";
+    write_recording(path, "REPLAY-LOOP", 4);
+    time_series_replay replay(libgsi::getInstance());
+    REQUIRE(replay.open(path));
+    replay_options options;
+    options.speed = 0;
+    options.loop = true;
+    REQUIRE(replay.start(options));
+    REQUIRE(false == replay.start(options));
+    while (replay.rows_played() < 3 * 4096)
+        tthread::this_thread::yield();
+    replay.stop();
+    REQUIRE(replay.rows_played() >= 3 * 4096);
+    replay.close();
+    remove(path);
+}
+
+TEST_CASE("Paced replay should keep recorded time") {
+    const char* path = "tests-replay-paced.bin";
+    write_recording(path, "REPLAY-PACED", 10);
+    time_series_replay replay(libgsi::getInstance());
+    REQUIRE(replay.open(path));
+    // 4.5 s of the recording are played at 30 times the speed
+    replay_options options;
+    options.speed = 30;
+    unsigned long long start_ns = monotonic_ns();
+    REQUIRE(replay.play(options) == 10);
+    REQUIRE(monotonic_ns() - start_ns >= 140000000ULL);
+    replay.close();
+    remove(path);
+}
@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "catch.hpp"
+#include "suite.hpp"
+#include "trace.hpp"
+
+using namespace g2::fasth;
+
+class TestTrace : public suite<TestTrace> {
+public:
+    TestTrace()
+        : suite("TestTrace", test_order::implied, log_level::NONE) {
+    };
+    void setup_test_track() override
+    {
+        run(&TestTrace::traced_test, "traced_test");
+    };
+    void traced_test(const std::string& test_case_name)
+    {
+        FUNCLOG;
+        go_async(test_case_name, &TestTrace::traced_continuation);
+    }
+    void traced_continuation(const std::string& test_case_name)
+    {
+        complete_test_case(test_case_name, test_outcome::pass);
+    }
+};
+
+namespace {
+std::string read_file(const std::string& path)
+{
+    std::ifstream file(path.c_str());
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+}
+
+TEST_CASE("Trace recorder should record suite, test case and asynchronous continuation") {
+    const char* path = "tests-trace.json";
+    trace_recorder::clear();
+    trace_recorder::start();
+    {
+        TestTrace test_suite;
+        test_suite.execute();
+    }
+    trace_recorder::stop();
+    REQUIRE(trace_recorder::write_json(path));
+    std::string trace = read_file(path);
+    REQUIRE(trace.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[") == 0);
+    REQUIRE(trace.find("{\"name\":\"TestTrace\",\"cat\":\"suite\",\"ph\":\"X\"") != std::string::npos);
+    REQUIRE(trace.find("{\"name\":\"traced_test\",\"cat\":\"test\"") != std::string::npos);
+    REQUIRE(trace.find("{\"name\":\"traced_test\",\"cat\":\"action\"") != std::string::npos);
+    REQUIRE(trace.find("{\"name\":\"traced_test\",\"cat\":\"async\"") != std::string::npos);
+    REQUIRE(trace.find("traced_test\",\"cat\":\"function\"") != std::string::npos);
+    REQUIRE(trace.substr(trace.size() - 3) == "]}\n");
+    trace_recorder::clear();
+    remove(path);
+}
+
+TEST_CASE("Trace recorder should not record when stopped") {
+    const char* path = "tests-trace-stopped.json";
+    trace_recorder::clear();
+    {
+        SCOPELOG("not recorded");
+    }
+    REQUIRE(trace_recorder::write_json(path));
+    REQUIRE(read_file(path).find("not recorded") == std::string::npos);
+    remove(path);
+}
+
+TEST_CASE("Trace recorder should escape names and drop events over the limit") {
+    const char* path = "tests-trace-escape.json";
+    trace_recorder::clear();
+    trace_recorder::start("", 2);
+    for (int i = 0; i < 3; i++)
+    {
+        SCOPELOG("quoted \"name\"");
+    }
+    trace_recorder::stop();
+    REQUIRE(trace_recorder::dropped() == 1);
+    REQUIRE(trace_recorder::write_json(path));
+    REQUIRE(read_file(path).find("\"quoted \\\"name\\\"\"") != std::string::npos);
+    trace_recorder::clear();
+    remove(path);
+}
+
+namespace {
+void record_events(void* p)
+{
+    for (int i = 0; i < *(int*)p; i++)
+    {
+        SCOPELOG("threaded");
+    }
+}
+
+size_t count_events(const std::string& text, const std::string& name)
+{
+    size_t count = 0;
+    for (size_t at = text.find(name); at != std::string::npos; at = text.find(name, at + 1))
+        count++;
+    return count;
+}
+}
+
+TEST_CASE("Trace recorder should reuse buffers of exited threads") {
+    const char* path = "tests-trace-threads.json";
+    trace_recorder::clear();
+    trace_recorder::start();
+    const int kThreads = 1000;
+    int events = 1;
+    for (int i = 0; i < kThreads; i++)
+    {
+        tthread::thread thread(record_events, &events);
+        thread.join();
+    }
+    trace_recorder::stop();
+    // Threads run one by one, so they all record into a single buffer
+    REQUIRE(trace_recorder::capacity() <= 2 * kThreads);
+    REQUIRE(trace_recorder::capacity() < 64 * 1024);
+    REQUIRE(trace_recorder::dropped() == 0);
+    REQUIRE(trace_recorder::write_json(path));
+    REQUIRE(count_events(read_file(path), "\"name\":\"threaded\"") == kThreads);
+    trace_recorder::clear();
+    remove(path);
+}
+
+TEST_CASE("Trace recorder should limit events across all threads") {
+    const char* path = "tests-trace-limit.json";
+    trace_recorder::clear();
+    trace_recorder::start("", 100);
+    int events = 50;
+    std::vector<tthread::thread*> threads;
+    for (int t = 0; t < 4; t++)
+        threads.push_back(new tthread::thread(record_events, &events));
+    for (int t = 0; t < 4; t++)
+    {
+        threads[t]->join();
+        delete threads[t];
+    }
+    trace_recorder::stop();
+    REQUIRE(trace_recorder::capacity() <= 100);
+    REQUIRE(trace_recorder::write_json(path));
+    size_t recorded = count_events(read_file(path), "\"name\":\"threaded\"");
+    REQUIRE(recorded <= 100);
+    REQUIRE(recorded + trace_recorder::dropped() == 200);
+    trace_recorder::clear();
+    remove(path);
+}
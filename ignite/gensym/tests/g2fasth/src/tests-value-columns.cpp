@@ -0,0 +1,139 @@
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "libgsi.hpp"
+#include "value_columns.hpp"
+
+using namespace g2::fasth;
+
+TEST_CASE("Value column should return temporary values before the default one") {
+    value_column<int> column;
+    size_t slot = column.add(false);
+    int value = -1;
+    REQUIRE(column.next(slot, value));
+    REQUIRE(value == 0);
+
+    column.assign_def_value(slot, 60);
+    column.assign_temp_value(slot, 90, 2);
+    REQUIRE(column.next(slot, value));
+    REQUIRE(value == 90);
+    REQUIRE(column.next(slot, value));
+    REQUIRE(value == 90);
+    REQUIRE(column.next(slot, value));
+    REQUIRE(value == 60);
+}
+
+TEST_CASE("Value column should leave slots with handler to the handler") {
+    value_column<std::string> column;
+    size_t with_handler = column.add(true);
+    size_t without_handler = column.add(false);
+    std::string value;
+    REQUIRE(false == column.next(with_handler, value));
+    REQUIRE(column.next(without_handler, value));
+    REQUIRE(value == "");
+
+    column.assign_temp_value(with_handler, "Temporary", 1);
+    REQUIRE(column.next(with_handler, value));
+    REQUIRE(value == "Temporary");
+    REQUIRE(false == column.next(with_handler, value));
+}
+
+TEST_CASE("Value column should resolve a batch of slots spread over chunks") {
+    value_column<double> column;
+    std::vector<size_t> slots;
+    for (int i = 0; i < 5000; i++)
+    {
+        size_t slot = column.add(i % 2 == 1);
+        if (i % 3 == 0)
+            column.assign_def_value(slot, i * 0.5);
+        slots.push_back(slot);
+    }
+    std::vector<double> values(slots.size());
+    std::vector<unsigned char> resolved(slots.size());
+    size_t found = column.resolve(&slots[0], slots.size(), &values[0], &resolved[0]);
+
+    size_t expected = 0;
+    for (int i = 0; i < 5000; i++)
+    {
+        bool has_value = i % 3 == 0 || i % 2 == 0;
+        REQUIRE(resolved[i] == (has_value ? 1 : 0));
+        if (i % 3 == 0)
+            REQUIRE(values[i] == i * 0.5);
+        else if (i % 2 == 0)
+            REQUIRE(values[i] == 0.0);
+        expected += has_value;
+    }
+    REQUIRE(found == expected);
+}
+
+TEST_CASE("Value column should reuse released slots without their values") {
+    value_column<bool> column;
+    size_t first = column.add(false);
+    column.assign_def_value(first, true);
+    column.release(first);
+    size_t second = column.add(false);
+    REQUIRE(second == first);
+    bool value = true;
+    REQUIRE(column.next(second, value));
+    REQUIRE(value == false);
+}
+
+namespace {
+struct writer_data {
+    value_column<int>* column;
+    volatile long stop;
+    volatile long writes;
+};
+
+/**
+* Assigns values to the first slots while the main thread adds slots and reads them.
+*/
+void writer_thread(void* p)
+{
+    writer_data* data = static_cast<writer_data*>(p);
+    while (!atomic_load(&data->stop))
+    {
+        for (size_t slot = 0; slot < 100; slot++)
+            data->column->assign_def_value(slot, (int)slot);
+        atomic_add(&data->writes, 1);
+    }
+}
+}
+
+TEST_CASE("Value column should be written while slots are added and resolved") {
+    value_column<int> column;
+    std::vector<size_t> slots;
+    for (int i = 0; i < 100; i++)
+        slots.push_back(column.add(false));
+    writer_data data = { &column, 0, 0 };
+    tthread::thread writer(writer_thread, &data);
+    // Enough chunks for the table of chunks to be replaced several times
+    for (int i = 0; i < 100000; i++)
+        slots.push_back(column.add(false));
+    while (!atomic_load(&data.writes))
+        tthread::this_thread::yield();
+    std::vector<int> values(slots.size());
+    std::vector<unsigned char> resolved(slots.size());
+    REQUIRE(column.resolve(&slots[0], slots.size(), &values[0], &resolved[0]) == slots.size());
+    atomic_store(&data.stop, 1);
+    writer.join();
+    for (int i = 0; i < 100; i++)
+        REQUIRE(values[i] == i);
+}
+
+TEST_CASE("Copy of stored variable should hold the values itself") {
+    value_columns columns;
+    g2_typed_variable<int> var(true);
+    var.assign_def_value(60);
+    var.store_in(columns);
+    var.assign_temp_value(90, 1);
+
+    std::unique_ptr<g2_variable> copy(var.clone());
+    g2_typed_variable<int>* typed_copy = static_cast<g2_typed_variable<int>*>(copy.get());
+    REQUIRE(typed_copy->columns == nullptr);
+    REQUIRE(typed_copy->value() == 90);
+    REQUIRE(typed_copy->value() == 60);
+    // Reading the copy does not take values of the variable
+    REQUIRE(var.value() == 90);
+    REQUIRE(var.value() == 60);
+}
@@ -0,0 +1,134 @@
+#include <string>
+#include "catch.hpp"
+#include "libgsi.hpp"
+#include "variable_directory.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+std::string variable_name(int i)
+{
+    return "VAR-" + std::to_string((long long)i);
+}
+
+struct lookup_data {
+    variable_directory* directory;
+    volatile long stop;
+    volatile long lookups;
+    volatile long errors;
+};
+
+/**
+* Looks up variables while the main thread inserts and replaces them.
+*/
+void lookup_thread(void* p)
+{
+    lookup_data* data = static_cast<lookup_data*>(p);
+    while (!atomic_load(&data->stop))
+    {
+        variable_directory::reader reader(*data->directory);
+        for (int i = 0; i < 100; i++)
+        {
+            variable_entry* entry = data->directory->find(variable_name(i));
+            if (!entry)
+                continue;
+            if (entry->variable()->dec_type != g2_integer || entry->name() != variable_name(i))
+                atomic_add(&data->errors, 1);
+            atomic_add(&data->lookups, 1);
+        }
+    }
+}
+}
+
+TEST_CASE("Variable directory should find variables by name and by handle") {
+    variable_directory directory;
+    // More variables than initial buckets, so the tables are rebuilt
+    for (int i = 0; i < 1000; i++)
+    {
+        variable_entry* entry = directory.insert(variable_name(i), new g2_typed_variable<int>(true));
+        directory.assign_handle(entry, i + 1);
+    }
+    for (int i = 0; i < 1000; i++)
+    {
+        variable_entry* entry = directory.find(variable_name(i));
+        REQUIRE(entry != nullptr);
+        REQUIRE(entry->handle() == i + 1);
+        REQUIRE(directory.find((long)(i + 1)) == entry);
+    }
+    REQUIRE(directory.find(std::string("VAR-1000")) == nullptr);
+    REQUIRE(directory.find(0L) == nullptr);
+    REQUIRE(directory.find(1001L) == nullptr);
+
+    int count = 0;
+    directory.for_each([&](const variable_entry&) { count++; });
+    REQUIRE(count == 1000);
+}
+
+TEST_CASE("Variable directory should drop previous handle of variable") {
+    variable_directory directory;
+    variable_entry* first = directory.insert("FIRST", new g2_typed_variable<int>(true));
+    variable_entry* second = directory.insert("SECOND", new g2_typed_variable<int>(true));
+    directory.assign_handle(first, 7);
+    directory.assign_handle(first, 8);
+    REQUIRE(directory.find(7L) == nullptr);
+    REQUIRE(directory.find(8L) == first);
+
+    // Handle of deregistered variable can be reused by another one
+    directory.assign_handle(first, 0);
+    directory.assign_handle(second, 8);
+    REQUIRE(directory.find(8L) == second);
+    REQUIRE(first->handle() == 0);
+}
+
+TEST_CASE("Variable directory should forget removed variables") {
+    variable_directory directory;
+    // Names keep changing, as G2 items are created and deleted
+    for (int round = 0; round < 20; round++)
+    {
+        for (int i = 0; i < 100; i++)
+        {
+            variable_entry* entry = directory.insert(variable_name(round * 100 + i), new g2_typed_variable<int>(false));
+            directory.assign_handle(entry, i + 1);
+        }
+        for (int i = 0; i < 100; i++)
+            directory.remove(directory.find((long)(i + 1)));
+    }
+    REQUIRE(directory.find(std::string("VAR-1999")) == nullptr);
+    REQUIRE(directory.find(1L) == nullptr);
+    int count = 0;
+    directory.for_each([&](const variable_entry&) { count++; });
+    REQUIRE(count == 0);
+
+    // Removed name can be inserted again
+    variable_entry* entry = directory.insert("VAR-5", new g2_typed_variable<int>(true));
+    REQUIRE(directory.find(std::string("VAR-5")) == entry);
+}
+
+TEST_CASE("Variable directory lookups should run concurrently with changes") {
+    variable_directory directory;
+    lookup_data data = { &directory, 0, 0, 0 };
+    tthread::thread reader(lookup_thread, &data);
+    for (int i = 0; i < 100; i++)
+        directory.insert(variable_name(i), new g2_typed_variable<int>(true));
+    for (int round = 0; round < 100; round++)
+    {
+        for (int i = 0; i < 100; i++)
+        {
+            variable_entry* entry = directory.find(variable_name(i));
+            directory.replace(entry, new g2_typed_variable<int>(true));
+            directory.assign_handle(entry, round * 100 + i + 1);
+        }
+        // Every tenth variable is removed and inserted again
+        for (int i = round % 10; i < 100; i += 10)
+        {
+            variable_entry* entry = directory.find(variable_name(i));
+            long handle = entry->handle();
+            directory.remove(entry);
+            directory.assign_handle(directory.insert(variable_name(i), new g2_typed_variable<int>(true)), handle);
+        }
+    }
+    atomic_store(&data.stop, 1);
+    reader.join();
+    REQUIRE(data.errors == 0);
+    REQUIRE(directory.find(std::string("VAR-99"))->handle() == 10000);
+}
@@ -3,6 +3,7 @@
 #include "libgsi.hpp"
 
 #include <cstring>
+#include <vector>
 
 TEST_CASE("Conversion from string to Gensym string and back") {
     g2::fasth::libgsi& gsiobj = g2::fasth::libgsi::getInstance();
@@ -23,4 +24,34 @@ TEST_CASE("Conversion from wide string to Gensym string and back") {
     gsiobj.gensym_string(L"Test wide string", gensym_str, 100);
     std::wstring result = gsiobj.wide_string(gensym_str);
     REQUIRE(result == L"Test wide string");
-}
\ No newline at end of file
+}
+
+TEST_CASE("Converted Gensym string should be terminated within destination") {
+    short gensym_str[8];
+    REQUIRE(g2::fasth::libgsi::gensym_string("Truncated string", gensym_str, 8) == gensym_str);
+    REQUIRE(g2::fasth::libgsi::c_string(gensym_str) == "Truncat");
+    REQUIRE(g2::fasth::libgsi::gensym_string(L"Truncated wide string", gensym_str, 8) == gensym_str);
+    REQUIRE(g2::fasth::libgsi::wide_string(gensym_str) == L"Truncat");
+}
+
+TEST_CASE("Text with escape characters of Gensym strings should be converted by GSI") {
+    const char* texts[] = { "a~b", "C:\\dir", "x@y" };
+    for (size_t t = 0; t < sizeof(texts) / sizeof(texts[0]); t++)
+    {
+        // GSI returns converted text in its buffer, which is reused by next conversion
+        const short* converted = gsi_convert_string_to_unicode(const_cast<char*>(texts[t]), GSI_CHAR_SET_GENSYM);
+        std::vector<short> expected(converted, converted + g2::fasth::gensym_length(converted) + 1);
+        short gensym_str[100];
+        g2::fasth::libgsi::gensym_string(texts[t], gensym_str, 100);
+        REQUIRE(std::vector<short>(gensym_str, gensym_str + expected.size()) == expected);
+        REQUIRE(g2::fasth::libgsi::c_string(gensym_str) == texts[t]);
+    }
+}
+
+TEST_CASE("Text with other than ASCII characters should be converted by GSI") {
+    short gensym_str[100];
+    g2::fasth::libgsi::gensym_string("Caf\xe9 au lait", gensym_str, 100);
+    std::string result;
+    g2::fasth::libgsi::c_string(gensym_str, result);
+    REQUIRE(result == "Caf\xe9 au lait");
+}
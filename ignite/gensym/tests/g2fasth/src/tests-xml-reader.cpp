@@ -0,0 +1,158 @@
+#include <string.h>
+#include <string>
+#include "catch.hpp"
+#include "tinyxml2.hpp"
+
+using namespace tinyxml2;
+
+static const char document[] =
+    "\xEF\xBB\xBF<?xml version=\"1.0\"?>\n"
+    "<!DOCTYPE root>\n"
+    "<root id=\"1\" name='a &amp; b'>\n"
+    "  <!-- <ignored/> -->\n"
+    "  <empty flag=\"x\"/>\n"
+    "  <text>1 &lt; 2&#x21;\r\nnext</text>\n"
+    "  <skipped><a><b attr=\"&gt;\">text</b><c/></a><![CDATA[</skipped>]]></skipped>\n"
+    "  <data><![CDATA[<raw &amp;>]]></data>\n"
+    "</root>\n";
+
+/**
+* Describes all events read, one per line.
+*/
+static std::string read_events(XMLReader& reader)
+{
+    std::string events;
+    XMLReader::Event event;
+    while ((event = reader.Next()) != XMLReader::END_DOCUMENT && event != XMLReader::PARSE_ERROR)
+    {
+        const XMLReader::Span& name = reader.Name();
+        switch (event)
+        {
+        case XMLReader::START_ELEMENT:
+            events += "start " + std::string(name.start, name.end);
+            if (name.Equals("skipped"))
+            {
+                reader.SkipSubtree();
+                events += " skipped";
+            }
+            break;
+        case XMLReader::ATTRIBUTE:
+            events += "attribute " + std::string(name.start, name.end) + "=" + reader.DecodedValue();
+            break;
+        case XMLReader::TEXT:
+            events += std::string(reader.CData() ? "cdata " : "text ") + reader.DecodedValue();
+            break;
+        case XMLReader::END_ELEMENT:
+            events += "end " + std::string(name.start, name.end);
+            break;
+        default:
+            break;
+        }
+        events += "\n";
+    }
+    if (event == XMLReader::PARSE_ERROR)
+        events += "error\n";
+    return events;
+}
+
+static const char expected_events[] =
+    "start root\n"
+    "attribute id=1\n"
+    "attribute name=a & b\n"
+    "start empty\n"
+    "attribute flag=x\n"
+    "end empty\n"
+    "start text\n"
+    "text 1 < 2!\nnext\n"
+    "end text\n"
+    "start skipped skipped\n"
+    "start data\n"
+    "cdata <raw &amp;>\n"
+    "end data\n"
+    "end root\n";
+
+struct chunked_input {
+    const char* data;
+    size_t size;
+    size_t chunk;
+};
+
+static size_t read_chunk(void* user_data, char* buffer, size_t size)
+{
+    chunked_input* input = (chunked_input*)user_data;
+    size_t count = input->size < input->chunk ? input->size : input->chunk;
+    if (count > size)
+        count = size;
+    memcpy(buffer, input->data, count);
+    input->data += count;
+    input->size -= count;
+    return count;
+}
+
+TEST_CASE("XML reader should report elements, attributes and text in document order") {
+    XMLReader reader;
+    reader.SetBuffer(document, sizeof(document) - 1);
+    REQUIRE(read_events(reader) == expected_events);
+    REQUIRE(reader.ErrorID() == XML_SUCCESS);
+    REQUIRE(reader.Next() == XMLReader::END_DOCUMENT);
+}
+
+TEST_CASE("XML reader should read chunked input the same way as a buffer") {
+    size_t chunks[] = { 1, 3, 7, 64 };
+    for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++)
+    {
+        chunked_input input = { document, sizeof(document) - 1, chunks[i] };
+        XMLReader reader;
+        reader.SetSource(read_chunk, &input, chunks[i]);
+        REQUIRE(read_events(reader) == expected_events);
+    }
+}
+
+TEST_CASE("XML reader should track depth and skip empty elements") {
+    static const char xml[] = "<a><b/><c><d/></c></a>";
+    XMLReader reader;
+    reader.SetBuffer(xml, sizeof(xml) - 1);
+    REQUIRE(reader.Next() == XMLReader::START_ELEMENT);
+    REQUIRE(reader.Depth() == 1);
+    REQUIRE(reader.Next() == XMLReader::START_ELEMENT);
+    REQUIRE(reader.IsEmptyElement());
+    REQUIRE(reader.Depth() == 2);
+    REQUIRE(reader.SkipSubtree());
+    REQUIRE(reader.Depth() == 1);
+    REQUIRE(reader.Next() == XMLReader::START_ELEMENT);
+    REQUIRE(reader.Name().Equals("c"));
+    REQUIRE_FALSE(reader.IsEmptyElement());
+    REQUIRE(reader.SkipSubtree());
+    REQUIRE(reader.Next() == XMLReader::END_ELEMENT);
+    REQUIRE(reader.Name().Equals("a"));
+    REQUIRE(reader.Depth() == 0);
+    REQUIRE(reader.Next() == XMLReader::END_DOCUMENT);
+}
+
+TEST_CASE("XML reader should report malformed documents") {
+    static const char* documents[] = {
+        "<a><b></a>",
+        "<a>text",
+        "<a b=\"1></a>",
+        "<a b></a>",
+        "<a><!-- comment </a>",
+        "</a>"
+    };
+    static const XMLError errors[] = {
+        XML_ERROR_MISMATCHED_ELEMENT,
+        XML_ERROR_PARSING_ELEMENT,
+        XML_ERROR_PARSING_ELEMENT,
+        XML_ERROR_PARSING_ATTRIBUTE,
+        XML_ERROR_PARSING_COMMENT,
+        XML_ERROR_MISMATCHED_ELEMENT
+    };
+    for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++)
+    {
+        XMLReader reader;
+        reader.SetBuffer(documents[i], strlen(documents[i]));
+        std::string events = read_events(reader);
+        REQUIRE(events.substr(events.size() - 6) == "error\n");
+        REQUIRE(reader.ErrorID() == errors[i]);
+        REQUIRE(reader.Next() == XMLReader::PARSE_ERROR);
+    }
+}
@@ -0,0 +1,104 @@
+#include <stdexcept>
+#include "catch.hpp"
+#include "junit_report.hpp"
+
+using namespace g2::fasth;
+
+class sample_item : public xmls::serializable {
+public:
+    sample_item() {
+        if (begin_registration<sample_item>("item")) {
+            register_type("count", &d_count);
+            register_type("enabled", &d_enabled);
+            register_type("stamp", &d_stamp);
+            end_registration();
+        }
+    }
+    xmls::x_int d_count;
+    xmls::x_bool d_enabled;
+    xmls::x_time_t d_stamp;
+};
+
+class sample_document : public xmls::serializable {
+public:
+    sample_document() {
+        if (begin_registration<sample_document>("document")) {
+            register_type("title", &d_title);
+            register_type("items", &d_items);
+            end_registration();
+        }
+    }
+    sample_item* add_item() { return d_items.new_element(get_arena()); }
+    xmls::x_string d_title;
+    xmls::collection<sample_item> d_items;
+};
+
+class throwing_item : public xmls::serializable {
+public:
+    explicit throwing_item(bool fail) {
+        if (begin_registration<throwing_item>("throwing")) {
+            register_type("count", &d_count);
+            if (fail)
+                throw std::runtime_error("registration failed");
+            end_registration();
+        }
+    }
+    xmls::x_int d_count;
+};
+
+TEST_CASE("format_int should format integers without allocation") {
+    char buf[24];
+    REQUIRE(std::string(xmls::format_int(0, buf)) == "0");
+    REQUIRE(std::string(xmls::format_int(-42, buf)) == "-42");
+    REQUIRE(std::string(xmls::format_int(9223372036854775807LL, buf)) == "9223372036854775807");
+    REQUIRE(std::string(xmls::format_int(-9223372036854775807LL - 1, buf)) == "-9223372036854775808");
+}
+
+TEST_CASE("Serializable should write typed members as attributes") {
+    sample_document doc;
+    doc.d_title = "a<b";
+    auto item = doc.add_item();
+    item->d_count = -7;
+    item->d_enabled = true;
+    item->d_stamp = 1234567890;
+    doc.add_item();
+    REQUIRE(doc.d_items.size() == 2);
+    REQUIRE(doc.to_xml("") == "<document title=\"a&lt;b\">\n"
+        "    <item count=\"-7\" enabled=\"true\" stamp=\"1234567890\"/>\n"
+        "    <item count=\"0\" enabled=\"false\" stamp=\"0\"/>\n"
+        "</document>\n");
+}
+
+TEST_CASE("Derived serializable should write members of base class first") {
+    testsuites_data report;
+    auto test_suite = report.add_testsuite("Suite", 1, 1, "start", 1500);
+    test_suite->add_testcase("Suite.test", "test")->fail_test_case("Fail", "reason");
+    report.set_elapsed(2001);
+    REQUIRE(report.to_xml("") == "<testsuites tests=\"1\" failures=\"1\" time=\"2.001\">\n"
+        "    <testsuite tests=\"1\" start=\"start\" name=\"Suite\" failures=\"1\" time=\"1.500\">\n"
+        "        <testcase classname=\"Suite.test\" name=\"test\">\n"
+        "            <failure type=\"Fail\">reason</failure>\n"
+        "        </testcase>\n"
+        "    </testsuite>\n"
+        "</testsuites>\n");
+}
+
+TEST_CASE("Standalone suite should not write attributes of aggregated report") {
+    testsuite_data test_suite(2, "start");
+    test_suite.add_testcase("Suite.a", "a");
+    test_suite.add_testcase("Suite.b", "b");
+    REQUIRE(test_suite.to_xml("") == "<testsuite tests=\"2\" start=\"start\">\n"
+        "    <testcase classname=\"Suite.a\" name=\"a\"/>\n"
+        "    <testcase classname=\"Suite.b\" name=\"b\"/>\n"
+        "</testsuite>\n");
+}
+
+TEST_CASE("Failed registration should not block registration by next instance") {
+    REQUIRE_THROWS(throwing_item(true));
+    throwing_item item(false);
+    item.d_count = 3;
+    REQUIRE(item.to_xml("") == "<throwing count=\"3\"/>\n");
+    // Registration by other classes must not be blocked either
+    sample_item other;
+    REQUIRE(other.to_xml("") == "<item count=\"0\" enabled=\"false\" stamp=\"0\"/>\n");
+}
@@ -0,0 +1,350 @@
+#include <string.h>
+#include "time_series_replay.hpp"
+#include "binary_io.hpp"
+#include "g2fasth_platform.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+const char kMagic[] = "G2FRPLY1";
+const size_t kMagicSize = 8;
+const size_t kHeaderSize = kMagicSize + 4 + 4 + 8 + 8 + 8;
+const size_t kRowSize = 24;
+
+// Buffered rows are written when the buffer grows over this size
+const size_t kWriteThreshold = 1024 * 1024;
+// Played rows are counted in blocks, so that the counter lock is rare
+const unsigned long long kReportRows = 4096;
+// Longer waits for the next row sleep, shorter ones yield
+const double kSleepNs = 2e6;
+
+unsigned int load_u32(const char* p)
+{
+    const unsigned char* b = (const unsigned char*)p;
+    return b[0] | (b[1] << 8) | (b[2] << 16) | ((unsigned int)b[3] << 24);
+}
+
+unsigned long long load_u64(const char* p)
+{
+    return load_u32(p) | ((unsigned long long)load_u32(p + 4) << 32);
+}
+
+double load_f64(const char* p)
+{
+    unsigned long long bits = load_u64(p);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+bool valid_type(int type)
+{
+    return type == g2_integer || type == g2_float || type == g2_logical || type == g2_string || type == g2_symbol;
+}
+}
+
+replay_writer::replay_writer()
+    : d_file(nullptr), d_ok(false), d_rows(0), d_last_ns(0)
+{
+}
+
+replay_writer::~replay_writer()
+{
+    close();
+}
+
+bool replay_writer::open(const std::string& path)
+{
+    close();
+    d_file = fopen(path.c_str(), "wb");
+    if (!d_file)
+        return false;
+    d_ok = true;
+    d_rows = 0;
+    d_variables.clear();
+    // Header is written by close(), when counts are known
+    d_buffer.assign(kHeaderSize, '\0');
+    return true;
+}
+
+unsigned replay_writer::add_variable(const std::string& name, g2_type type)
+{
+    d_variables.push_back(std::make_pair(name, type));
+    return (unsigned)(d_variables.size() - 1);
+}
+
+bool replay_writer::write(long long time_ns, unsigned variable, double value)
+{
+    if (!d_file || variable >= d_variables.size() || (d_rows && time_ns < d_last_ns))
+        return false;
+    unsigned long long bits;
+    memcpy(&bits, &value, sizeof(bits));
+    binary_io::put_u64(d_buffer, (unsigned long long)time_ns);
+    binary_io::put_u64(d_buffer, bits);
+    binary_io::put_u32(d_buffer, variable);
+    binary_io::put_u32(d_buffer, 0);
+    d_last_ns = time_ns;
+    d_rows++;
+    if (d_buffer.size() >= kWriteThreshold)
+        write_buffer();
+    return true;
+}
+
+void replay_writer::write_buffer()
+{
+    if (!d_buffer.empty() && fwrite(d_buffer.data(), 1, d_buffer.size(), d_file) != d_buffer.size())
+        d_ok = false;
+    d_buffer.clear();
+}
+
+bool replay_writer::close()
+{
+    if (!d_file)
+        return false;
+    for (size_t i = 0; i < d_variables.size(); i++)
+    {
+        binary_io::put_u8(d_buffer, (unsigned char)d_variables[i].second);
+        binary_io::put_str(d_buffer, d_variables[i].first);
+    }
+    write_buffer();
+
+    std::string header(kMagic, kMagicSize);
+    binary_io::put_u32(header, (unsigned int)d_variables.size());
+    binary_io::put_u32(header, (unsigned int)kRowSize);
+    binary_io::put_u64(header, d_rows);
+    binary_io::put_u64(header, kHeaderSize);
+    binary_io::put_u64(header, kHeaderSize + d_rows * kRowSize);
+    if (fseek(d_file, 0, SEEK_SET) != 0 || fwrite(header.data(), 1, header.size(), d_file) != header.size())
+        d_ok = false;
+    if (fclose(d_file) != 0)
+        d_ok = false;
+    d_file = nullptr;
+    return d_ok;
+}
+
+time_series_replay::time_series_replay(libgsi& gsi)
+    : d_gsi(gsi), d_rows(nullptr), d_row_count(0), d_next(0), d_bound(false), d_stop(0),
+      d_thread(nullptr), d_played(0)
+{
+}
+
+time_series_replay::~time_series_replay()
+{
+    close();
+}
+
+bool time_series_replay::open(const std::string& path)
+{
+    close();
+    if (!d_file.open(path))
+        return false;
+    binary_io::decoder header(d_file.data(), d_file.size());
+    const char* magic = header.get_bytes(kMagicSize);
+    unsigned int variables = header.get_u32();
+    unsigned int row_size = header.get_u32();
+    unsigned long long rows = header.get_u64();
+    unsigned long long rows_offset = header.get_u64();
+    unsigned long long variables_offset = header.get_u64();
+    if (!header.ok() || memcmp(magic, kMagic, kMagicSize) != 0 || row_size != kRowSize
+        || rows_offset < kHeaderSize || variables_offset > d_file.size() || rows_offset > variables_offset
+        || rows > (variables_offset - rows_offset) / kRowSize)
+    {
+        close();
+        return false;
+    }
+
+    binary_io::decoder table(d_file.data() + variables_offset, (size_t)(d_file.size() - variables_offset));
+    d_variables.resize(variables);
+    for (unsigned int i = 0; i < variables; i++)
+    {
+        int type = table.get_u8();
+        if (!table.get_str(d_variables[i].name) || !valid_type(type))
+        {
+            close();
+            return false;
+        }
+        d_variables[i].type = (g2_type)type;
+        d_variables[i].variable = nullptr;
+    }
+    d_rows = d_file.data() + rows_offset;
+    d_row_count = rows;
+    d_next = 0;
+    return true;
+}
+
+void time_series_replay::close()
+{
+    stop();
+    d_file.close();
+    d_rows = nullptr;
+    d_row_count = 0;
+    d_next = 0;
+    d_variables.clear();
+    d_bound = false;
+    d_played = 0;
+}
+
+long long time_series_replay::row_time(unsigned long long row) const
+{
+    return (long long)load_u64(d_rows + row * kRowSize);
+}
+
+long long time_series_replay::start_ns() const
+{
+    return d_row_count ? row_time(0) : 0;
+}
+
+long long time_series_replay::end_ns() const
+{
+    return d_row_count ? row_time(d_row_count - 1) : 0;
+}
+
+void time_series_replay::bind()
+{
+    d_gsi.declare_g2_variables(d_variables.begin(), d_variables.end());
+    for (size_t i = 0; i < d_variables.size(); i++)
+        d_variables[i].variable = d_gsi.get_declared_variable(d_variables[i].name);
+    d_bound = true;
+}
+
+void time_series_replay::seek(long long time_ns)
+{
+    unsigned long long first = 0, last = d_row_count;
+    while (first < last)
+    {
+        unsigned long long middle = first + (last - first) / 2;
+        if (row_time(middle) < time_ns)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    d_next = first;
+}
+
+long long time_series_replay::position_ns() const
+{
+    return d_next < d_row_count ? row_time(d_next) : end_ns();
+}
+
+void time_series_replay::apply(const char* row, const replay_options& options)
+{
+    unsigned int variable = load_u32(row + 16);
+    if (variable >= d_variables.size())
+        return;
+    g2_variable* var = d_variables[variable].variable;
+    if (!var)
+        return;
+    d_gsi.assign_number(var, load_f64(row + 8), options.temp_reads);
+    if (options.update_g2)
+        d_gsi.update_g2_variable(var);
+}
+
+void time_series_replay::add_played(unsigned long long rows)
+{
+    tthread::lock_guard<tthread::fast_mutex> guard(d_played_mutex);
+    d_played += rows;
+}
+
+unsigned long long time_series_replay::rows_played() const
+{
+    tthread::lock_guard<tthread::fast_mutex> guard(d_played_mutex);
+    return d_played;
+}
+
+unsigned long long time_series_replay::play_until(long long time_ns, const replay_options& options)
+{
+    if (!d_bound)
+        bind();
+    unsigned long long played = 0;
+    for (; d_next < d_row_count && row_time(d_next) <= time_ns; d_next++, played++)
+        apply(d_rows + d_next * kRowSize, options);
+    add_played(played);
+    return played;
+}
+
+unsigned long long time_series_replay::play(const replay_options& options)
+{
+    atomic_store(&d_stop, 0);
+    return run(options);
+}
+
+unsigned long long time_series_replay::run(const replay_options& options)
+{
+    if (!d_bound)
+        bind();
+    unsigned long long played = 0, unreported = 0;
+    // Recording time from the current row on is mapped to monotonic time at given speed
+    const long long base_ns = position_ns();
+    const unsigned long long wall_start = monotonic_ns();
+    double elapsed_ns = 0;
+    long long loop_offset = 0;
+    while (!atomic_load(&d_stop))
+    {
+        if (d_next == d_row_count)
+        {
+            if (!options.loop || !d_row_count)
+                break;
+            loop_offset += end_ns() - start_ns();
+            d_next = 0;
+            continue;
+        }
+        if (options.speed > 0)
+        {
+            // Clock is read only when the next row is not known to be due
+            double due_ns = (row_time(d_next) + loop_offset - base_ns) / options.speed;
+            if (due_ns > elapsed_ns)
+            {
+                elapsed_ns = (double)(monotonic_ns() - wall_start);
+                if (due_ns > elapsed_ns)
+                {
+                    add_played(unreported);
+                    unreported = 0;
+                    if (due_ns - elapsed_ns > kSleepNs)
+                        tthread::this_thread::sleep_for(tthread::chrono::milliseconds(1));
+                    else
+                        tthread::this_thread::yield();
+                    continue;
+                }
+            }
+        }
+        apply(d_rows + d_next * kRowSize, options);
+        d_next++;
+        played++;
+        if (++unreported == kReportRows)
+        {
+            add_played(unreported);
+            unreported = 0;
+        }
+    }
+    add_played(unreported);
+    return played;
+}
+
+void time_series_replay::play_thread(void* arg)
+{
+    time_series_replay* replay = static_cast<time_series_replay*>(arg);
+    replay->run(replay->d_thread_options);
+}
+
+bool time_series_replay::start(const replay_options& options)
+{
+    if (d_thread)
+        return false;
+    if (!d_bound)
+        bind();
+    atomic_store(&d_stop, 0);
+    d_thread_options = options;
+    d_thread = new tthread::thread(play_thread, this);
+    return true;
+}
+
+void time_series_replay::stop()
+{
+    atomic_store(&d_stop, 1);
+    if (d_thread)
+    {
+        d_thread->join();
+        delete d_thread;
+        d_thread = nullptr;
+    }
+}
@@ -2094,6 +2094,621 @@ bool XMLPrinter::Visit( const XMLUnknown& unknown )
     return true;
 }
 
+
+
+// --------- XMLReader ----------- //
+
+// XMLUtil::IsNameChar() and IsWhiteSpace() in the "C" locale, without
+// a library call per character.
+static const unsigned char nameBytes[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,	// 0_
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,	// 1_
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0,	// 2_
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,	// 3_
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 4_
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 1,	// 5_
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 6_
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,	// 7_
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 8_
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 9_
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// A_
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// B_
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// C_
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// D_
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// E_
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1	// F_
+};
+
+static inline bool IsNameByte( unsigned char ch )
+{
+    return nameBytes[ch] != 0;
+}
+
+static inline bool IsSpaceByte( char ch )
+{
+    return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
+}
+
+// Element names are hashed to match end tags without keeping the names.
+// Eight bytes are mixed at a time, names are mostly longer than that.
+static inline unsigned HashName( const char* p, size_t length )
+{
+    unsigned long long hash = 14695981039346656037ULL ^ length;
+    unsigned long long word;
+    for( ; length >= sizeof(word); length -= sizeof(word), p += sizeof(word) ) {
+        memcpy( &word, p, sizeof(word) );
+        hash = ( hash ^ word ) * 1099511628211ULL;
+    }
+    for( ; length; --length, ++p ) {
+        hash = ( hash ^ (unsigned char)*p ) * 1099511628211ULL;
+    }
+    return (unsigned)( hash ^ ( hash >> 32 ) );
+}
+
+
+
+XMLReader::XMLReader() :
+    _begin( 0 ),
+    _p( 0 ),
+    _end( 0 ),
+    _read( 0 ),
+    _userData( 0 ),
+    _window( 0 ),
+    _capacity( 0 ),
+    _chunkSize( 0 ),
+    _eof( true )
+{
+    Reset();
+}
+
+
+XMLReader::~XMLReader()
+{
+    delete [] _window;
+}
+
+
+void XMLReader::Reset()
+{
+    _state = CONTENT;
+    _event = END_DOCUMENT;
+    _name.start = _name.end = 0;
+    _value.start = _value.end = 0;
+    _element = _name;
+    _cdata = false;
+    _emptyTag = false;
+    _started = false;
+    _attr = _tagEnd = 0;
+    _errorID = XML_SUCCESS;
+    _errorOffset = 0;
+    _consumed = 0;
+    _stack.PopArr( _stack.Size() );
+}
+
+
+void XMLReader::SetBuffer( const char* data, size_t size )
+{
+    Reset();
+    _read = 0;
+    _userData = 0;
+    _eof = true;
+    _begin = _p = data;
+    _end = data + size;
+}
+
+
+void XMLReader::SetSource( ReadCallback read, void* userData, size_t chunkSize )
+{
+    Reset();
+    _read = read;
+    _userData = userData;
+    _chunkSize = chunkSize ? chunkSize : 1;
+    _eof = false;
+    if ( _capacity < 2 * _chunkSize ) {
+        delete [] _window;
+        _capacity = 2 * _chunkSize;
+        _window = new char[_capacity];
+    }
+    _begin = _p = _end = _window;
+}
+
+
+bool XMLReader::Fill()
+{
+    // Only the input from _p on is kept, so it is called at token boundaries.
+    if ( _eof ) {
+        return false;
+    }
+    size_t keep = _end - _p;
+    if ( keep + _chunkSize > _capacity ) {
+        size_t capacity = _capacity * 2;
+        while ( keep + _chunkSize > capacity ) {
+            capacity *= 2;
+        }
+        char* window = new char[capacity];
+        memcpy( window, _p, keep );
+        delete [] _window;
+        _window = window;
+        _capacity = capacity;
+    }
+    else if ( _p != _window ) {
+        memmove( _window, _p, keep );
+    }
+    _consumed += _p - _begin;
+    _begin = _p = _window;
+
+    char* end = _window + keep;
+    char* limit = _window + _capacity;
+    while ( end < limit ) {
+        size_t count = _read( _userData, end, limit - end );
+        if ( count == 0 ) {
+            _eof = true;
+            break;
+        }
+        end += count;
+    }
+    const bool added = end != _window + keep;
+    _end = end;
+    return added;
+}
+
+
+bool XMLReader::Need( size_t count )
+{
+    while ( (size_t)(_end - _p) < count ) {
+        if ( !Fill() ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool XMLReader::Find( const char* pattern, size_t from, size_t* at )
+{
+    // Offsets are relative to _p, so they survive refills.
+    const size_t len = strlen( pattern );
+    for( ;; ) {
+        const char* q = _p + from;
+        while ( q < _end ) {
+            q = static_cast<const char*>( memchr( q, pattern[0], _end - q ) );
+            if ( !q || (size_t)(_end - q) < len ) {
+                break;
+            }
+            if ( memcmp( q, pattern, len ) == 0 ) {
+                *at = q - _p;
+                return true;
+            }
+            ++q;
+        }
+        size_t scanned = _end - _p;
+        if ( scanned >= from + len ) {
+            from = scanned - len + 1;
+        }
+        if ( !Fill() ) {
+            return false;
+        }
+    }
+}
+
+
+bool XMLReader::ScanName( size_t from, size_t* end, unsigned* hash )
+{
+    size_t i = from;
+    for( ;; ) {
+        for( ; _p + i < _end; ++i ) {
+            if ( !IsNameByte( (unsigned char)_p[i] ) ) {
+                *end = i;
+                *hash = HashName( _p + from, i - from );
+                return true;
+            }
+        }
+        if ( !Fill() ) {
+            return false;
+        }
+    }
+}
+
+
+bool XMLReader::FindTagEnd( size_t from, size_t* at )
+{
+    // '>' inside quoted attribute values does not end the tag. Quotes are
+    // rare compared to the rest of the tag, so both are looked up with memchr.
+    size_t i = from;
+    for( ;; ) {
+        const char* q = _p + i;
+        const char* gt = static_cast<const char*>( memchr( q, '>', _end - q ) );
+        const char* limit = gt ? gt : _end;
+        const char* quote = static_cast<const char*>( memchr( q, DOUBLE_QUOTE, limit - q ) );
+        const char* single = static_cast<const char*>( memchr( q, SINGLE_QUOTE, ( quote ? quote : limit ) - q ) );
+        if ( single ) {
+            quote = single;
+        }
+        if ( quote ) {
+            const char* close = static_cast<const char*>( memchr( quote + 1, *quote, _end - quote - 1 ) );
+            if ( close ) {
+                i = close + 1 - _p;
+                continue;
+            }
+            i = quote - _p;
+        }
+        else if ( gt ) {
+            *at = gt - _p;
+            return true;
+        }
+        else {
+            i = _end - _p;
+        }
+        if ( !Fill() ) {
+            return false;
+        }
+    }
+}
+
+
+XMLReader::Event XMLReader::SetError( XMLError error, const char* p )
+{
+    _errorID = error;
+    _errorOffset = _consumed + ( p - _begin );
+    _state = FINISHED;
+    _event = PARSE_ERROR;
+    return _event;
+}
+
+
+XMLReader::Event XMLReader::Next()
+{
+    switch ( _state ) {
+        case FINISHED:
+            return _event;
+        case AFTER_EMPTY_TAG:
+            _stack.Pop();
+            _state = CONTENT;
+            _name = _element;
+            _value.start = _value.end = 0;
+            _event = END_ELEMENT;
+            return _event;
+        case IN_TAG:
+            if ( ReadAttribute() ) {
+                return _event;
+            }
+            LeaveTag();
+            if ( _state == AFTER_EMPTY_TAG ) {
+                return Next();
+            }
+            break;
+        default:
+            break;
+    }
+    _emptyTag = false;
+    _cdata = false;
+
+    if ( !_started ) {
+        _started = true;
+        if ( Need( 3 ) ) {
+            bool bom = false;
+            _p = XMLUtil::ReadBOM( _p, &bom );
+        }
+    }
+    for( ;; ) {
+        if ( _p == _end && !Fill() ) {
+            if ( !_stack.Empty() ) {
+                return SetError( XML_ERROR_PARSING_ELEMENT, _p );
+            }
+            _state = FINISHED;
+            _name.start = _name.end = 0;
+            _value.start = _value.end = 0;
+            _event = END_DOCUMENT;
+            return _event;
+        }
+        if ( *_p == '<' ) {
+            if ( ReadMarkup() ) {
+                return _event;
+            }
+            continue;
+        }
+        const char* lt = static_cast<const char*>( memchr( _p, '<', _end - _p ) );
+        if ( !lt ) {
+            size_t at = 0;
+            lt = Find( "<", _end - _p, &at ) ? _p + at : _end;
+        }
+        const char* start = _p;
+        _p = lt;
+        if ( _stack.Empty() ) {
+            // Text outside the root element is ignored.
+            continue;
+        }
+        const char* q = start;
+        while ( q < _p && IsSpaceByte( *q ) ) {
+            ++q;
+        }
+        if ( q < _p ) {
+            _name.start = _name.end = 0;
+            _value.start = start;
+            _value.end = _p;
+            _event = TEXT;
+            return _event;
+        }
+    }
+}
+
+
+bool XMLReader::ReadMarkup()
+{
+    // Returns true if an event was read, false if the markup was skipped.
+    size_t at = 0;
+    if ( !Need( 2 ) ) {
+        SetError( XML_ERROR_PARSING, _p );
+        return true;
+    }
+    const char c = _p[1];
+    if ( c == '/' ) {
+        return ReadEndTag();
+    }
+    if ( c == '?' ) {
+        if ( !Find( "?>", 2, &at ) ) {
+            SetError( XML_ERROR_PARSING_DECLARATION, _p );
+            return true;
+        }
+        _p += at + 2;
+        return false;
+    }
+    if ( c == '!' ) {
+        Need( 9 );
+        const size_t available = _end - _p;
+        if ( available >= 4 && memcmp( _p, "<!--", 4 ) == 0 ) {
+            if ( !Find( "-->", 4, &at ) ) {
+                SetError( XML_ERROR_PARSING_COMMENT, _p );
+                return true;
+            }
+            _p += at + 3;
+            return false;
+        }
+        if ( available >= 9 && memcmp( _p, "<![CDATA[", 9 ) == 0 ) {
+            if ( !Find( "]]>", 9, &at ) ) {
+                SetError( XML_ERROR_PARSING_CDATA, _p );
+                return true;
+            }
+            _name.start = _name.end = 0;
+            _value.start = _p + 9;
+            _value.end = _p + at;
+            _p += at + 3;
+            if ( _stack.Empty() ) {
+                return false;
+            }
+            _cdata = true;
+            _event = TEXT;
+            return true;
+        }
+        // DOCTYPE and other declarations
+        if ( !Find( ">", 2, &at ) ) {
+            SetError( XML_ERROR_PARSING_UNKNOWN, _p );
+            return true;
+        }
+        _p += at + 1;
+        return false;
+    }
+    return ReadStartTag();
+}
+
+
+bool XMLReader::ReadStartTag()
+{
+    size_t nameEnd = 0;
+    size_t at = 0;
+    unsigned hash = 0;
+    if ( !XMLUtil::IsNameStartChar( (unsigned char)_p[1] )
+            || !ScanName( 1, &nameEnd, &hash ) || !FindTagEnd( nameEnd, &at ) ) {
+        SetError( XML_ERROR_PARSING_ELEMENT, _p );
+        return true;
+    }
+    const char* gt = _p + at;
+    _name.start = _p + 1;
+    _name.end = _p + nameEnd;
+    _element = _name;
+    _value.start = _value.end = 0;
+    _emptyTag = gt[-1] == '/' && gt - 1 >= _name.end;
+    _tagEnd = _emptyTag ? gt - 1 : gt;
+    _attr = _name.end;
+    _stack.Push( hash );
+    _state = IN_TAG;
+    _event = START_ELEMENT;
+    return true;
+}
+
+
+bool XMLReader::ReadAttribute()
+{
+    // Returns true if an attribute or an error was read, false at the end of the tag.
+    const char* p = _attr;
+    while ( p < _tagEnd && IsSpaceByte( *p ) ) {
+        ++p;
+    }
+    if ( p == _tagEnd ) {
+        return false;
+    }
+    if ( !XMLUtil::IsNameStartChar( (unsigned char)*p ) ) {
+        SetError( XML_ERROR_PARSING_ATTRIBUTE, p );
+        return true;
+    }
+    const char* name = p;
+    while ( p < _tagEnd && IsNameByte( (unsigned char)*p ) ) {
+        ++p;
+    }
+    _name.start = name;
+    _name.end = p;
+    while ( p < _tagEnd && IsSpaceByte( *p ) ) {
+        ++p;
+    }
+    if ( p == _tagEnd || *p != '=' ) {
+        SetError( XML_ERROR_PARSING_ATTRIBUTE, p );
+        return true;
+    }
+    ++p;
+    while ( p < _tagEnd && IsSpaceByte( *p ) ) {
+        ++p;
+    }
+    const char* close = 0;
+    if ( p < _tagEnd && ( *p == DOUBLE_QUOTE || *p == SINGLE_QUOTE ) ) {
+        close = static_cast<const char*>( memchr( p + 1, *p, _tagEnd - p - 1 ) );
+    }
+    if ( !close ) {
+        SetError( XML_ERROR_PARSING_ATTRIBUTE, p );
+        return true;
+    }
+    _value.start = p + 1;
+    _value.end = close;
+    _attr = close + 1;
+    _event = ATTRIBUTE;
+    return true;
+}
+
+
+void XMLReader::LeaveTag()
+{
+    if ( _emptyTag ) {
+        _p = _tagEnd + 2;
+        _state = AFTER_EMPTY_TAG;
+    }
+    else {
+        _p = _tagEnd + 1;
+        _state = CONTENT;
+    }
+}
+
+
+bool XMLReader::ReadEndTag()
+{
+    size_t nameEnd = 0;
+    size_t at = 0;
+    unsigned hash = 0;
+    if ( !ScanName( 2, &nameEnd, &hash ) || !Find( ">", nameEnd, &at ) ) {
+        SetError( XML_ERROR_PARSING_ELEMENT, _p );
+        return true;
+    }
+    const char* gt = _p + at;
+    const char* q = _p + nameEnd;
+    _name.start = _p + 2;
+    _name.end = q;
+    _value.start = _value.end = 0;
+    while ( q < gt && IsSpaceByte( *q ) ) {
+        ++q;
+    }
+    if ( q != gt || _name.start == _name.end ) {
+        SetError( XML_ERROR_PARSING_ELEMENT, _p );
+        return true;
+    }
+    if ( _stack.Empty() || _stack.Pop() != hash ) {
+        SetError( XML_ERROR_MISMATCHED_ELEMENT, _p );
+        return true;
+    }
+    _p = gt + 1;
+    _event = END_ELEMENT;
+    return true;
+}
+
+
+bool XMLReader::SkipSubtree()
+{
+    if ( _state != IN_TAG ) {
+        return _state != FINISHED;
+    }
+    LeaveTag();
+    if ( _state == AFTER_EMPTY_TAG ) {
+        _stack.Pop();
+        _state = CONTENT;
+        _event = END_ELEMENT;
+        return true;
+    }
+    const int depth = _stack.Size() - 1;
+    while ( _stack.Size() > depth ) {
+        if ( _p == _end && !Fill() ) {
+            SetError( XML_ERROR_PARSING_ELEMENT, _p );
+            return false;
+        }
+        if ( *_p != '<' ) {
+            // Text is not looked at, only tags are.
+            const char* lt = static_cast<const char*>( memchr( _p, '<', _end - _p ) );
+            _p = lt ? lt : _end;
+            continue;
+        }
+        if ( !ReadMarkup() ) {
+            continue;
+        }
+        if ( _event == PARSE_ERROR ) {
+            return false;
+        }
+        if ( _event == START_ELEMENT ) {
+            // Attributes are not parsed, the whole tag is skipped.
+            LeaveTag();
+            if ( _state == AFTER_EMPTY_TAG ) {
+                _stack.Pop();
+                _state = CONTENT;
+            }
+        }
+    }
+    _name.start = _name.end = 0;
+    _value.start = _value.end = 0;
+    _emptyTag = false;
+    _cdata = false;
+    _event = END_ELEMENT;
+    return true;
+}
+
+
+const char* XMLReader::DecodedValue()
+{
+    _decoded.PopArr( _decoded.Size() );
+    const char* p = _value.start;
+    const char* end = _value.end;
+    while ( p < end ) {
+        if ( *p == CR ) {
+            // CR LF and lone CR become LF
+            _decoded.Push( LF );
+            ++p;
+            if ( p < end && *p == LF ) {
+                ++p;
+            }
+            continue;
+        }
+        if ( *p == '&' && !_cdata ) {
+            if ( p + 1 < end && *(p+1) == '#' ) {
+                // GetCharacterRef() needs the terminating ';' inside the value
+                char buf[10] = { 0 };
+                int len = 0;
+                const char* next = 0;
+                if ( memchr( p, ';', end - p ) ) {
+                    next = XMLUtil::GetCharacterRef( p, buf, &len );
+                }
+                if ( next && len > 0 ) {
+                    memcpy( _decoded.PushArr( len ), buf, len );
+                    p = next;
+                    continue;
+                }
+            }
+            else {
+                int i = 0;
+                for( ; i < NUM_ENTITIES; ++i ) {
+                    const int length = entities[i].length;
+                    if ( end - p > length + 1
+                            && strncmp( p + 1, entities[i].pattern, length ) == 0
+                            && *(p + length + 1) == ';' ) {
+                        break;
+                    }
+                }
+                if ( i < NUM_ENTITIES ) {
+                    _decoded.Push( entities[i].value );
+                    p += entities[i].length + 2;
+                    continue;
+                }
+            }
+        }
+        _decoded.Push( *p++ );
+    }
+    _decoded.Push( 0 );
+    return _decoded.Mem();
+}
+
 }   // namespace tinyxml2
 
 
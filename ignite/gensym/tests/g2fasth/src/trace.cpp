@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <stdlib.h>
+#ifndef WIN32
+#include <pthread.h>
+#endif
+#include "trace.hpp"
+#include "tinythread.h"
+
+using namespace g2::fasth;
+
+namespace {
+struct trace_event {
+    const char* category;
+    const char* name;           // nullptr if dynamic name is used
+    std::string dynamic_name;
+    unsigned long long start_ns;
+    unsigned long long duration_ns;
+    unsigned thread;
+};
+
+// Events of a thread are stored in linked chunks, so appending never moves them
+// and the writer can read published events while the thread records more.
+// Chunks grow from a small one, as most threads run a single test action.
+const long kFirstChunkSize = 16;
+const long kMaxChunkSize = 1024;
+struct trace_chunk {
+    explicit trace_chunk(long size) : events(new trace_event[size]), size(size), count(0), next(nullptr) {}
+    ~trace_chunk() { delete[] events; }
+    trace_event* events;
+    long size;
+    volatile long count;        // published events
+    trace_chunk* volatile next;
+};
+
+/**
+* Events recorded by threads. When a thread exits its buffer with the events is
+* handed to the next thread which records, so buffers are bounded by threads
+* running at once rather than by threads started.
+*/
+struct thread_buffer {
+    unsigned thread;            // current owner
+    trace_chunk* volatile first;
+    trace_chunk* last;
+    thread_buffer* next;
+    thread_buffer* next_free;
+};
+
+tthread::mutex s_buffers_mutex;
+thread_buffer* s_buffers;
+thread_buffer* s_free_buffers;
+G2FASTH_THREAD_LOCAL thread_buffer* s_buffer;
+volatile long s_dropped;
+volatile long s_reserved;       // events chunks of all buffers can hold
+size_t s_max_events;
+unsigned long long s_origin_ns;
+std::string s_path;
+bool s_exit_registered;
+
+void release_buffer(void* p)
+{
+    thread_buffer* buffer = static_cast<thread_buffer*>(p);
+    tthread::lock_guard<tthread::mutex> lg(s_buffers_mutex);
+    buffer->next_free = s_free_buffers;
+    s_free_buffers = buffer;
+    s_buffer = nullptr;
+}
+
+// Buffer is released when the thread exits, by callback of a key with the buffer as value
+#ifdef WIN32
+void WINAPI release_buffer_callback(void* p)
+{
+    if (p)
+        release_buffer(p);
+}
+DWORD s_exit_key = FLS_OUT_OF_INDEXES;
+
+void set_exit_value(thread_buffer* buffer)
+{
+    if (s_exit_key == FLS_OUT_OF_INDEXES)
+        s_exit_key = FlsAlloc(release_buffer_callback);
+    FlsSetValue(s_exit_key, buffer);
+}
+#else
+pthread_key_t s_exit_key;
+bool s_exit_key_created;
+
+void set_exit_value(thread_buffer* buffer)
+{
+    if (!s_exit_key_created)
+        s_exit_key_created = pthread_key_create(&s_exit_key, release_buffer) == 0;
+    pthread_setspecific(s_exit_key, buffer);
+}
+#endif
+
+thread_buffer* attach_buffer()
+{
+    tthread::lock_guard<tthread::mutex> lg(s_buffers_mutex);
+    thread_buffer* buffer = s_free_buffers;
+    if (buffer)
+        s_free_buffers = buffer->next_free;
+    else
+    {
+        buffer = new thread_buffer;
+        buffer->first = buffer->last = nullptr;
+        buffer->next = s_buffers;
+        s_buffers = buffer;
+    }
+    buffer->thread = current_thread_index();
+    set_exit_value(buffer);
+    return buffer;
+}
+
+/**
+* Takes up to wanted events of the limit shared by all threads.
+* @return Number of events granted, 0 if the limit is reached.
+*/
+long reserve_events(long wanted)
+{
+    for (;;)
+    {
+        long reserved = atomic_load(&s_reserved);
+        long available = (long)s_max_events - reserved;
+        if (available <= 0)
+            return 0;
+        long granted = wanted < available ? wanted : available;
+        if (atomic_compare_exchange(&s_reserved, reserved, reserved + granted))
+            return granted;
+    }
+}
+
+trace_event* next_event(trace_chunk*& chunk)
+{
+    thread_buffer* buffer = s_buffer;
+    if (!buffer)
+        buffer = s_buffer = attach_buffer();
+    chunk = buffer->last;
+    if (!chunk || chunk->count == chunk->size)
+    {
+        long size = !chunk ? kFirstChunkSize : chunk->size < kMaxChunkSize ? chunk->size * 2 : kMaxChunkSize;
+        size = reserve_events(size);
+        if (!size)
+        {
+            atomic_add(&s_dropped, 1);
+            return nullptr;
+        }
+        // The chunk is initialized before readers can reach it
+        trace_chunk* added = new trace_chunk(size);
+        if (chunk)
+            atomic_store_ptr(&chunk->next, added);
+        else
+            atomic_store_ptr(&buffer->first, added);
+        buffer->last = chunk = added;
+    }
+    chunk->events[chunk->count].thread = buffer->thread;
+    return &chunk->events[chunk->count];
+}
+
+void publish(trace_chunk* chunk, trace_event* event, const char* category, unsigned long long start_ns)
+{
+    event->category = category;
+    event->start_ns = start_ns;
+    event->duration_ns = monotonic_ns() - start_ns;
+    atomic_store(&chunk->count, chunk->count + 1);
+}
+
+void write_escaped(FILE* file, const char* text)
+{
+    fputc('"', file);
+    for (const char* p = text; *p; p++)
+    {
+        unsigned char c = (unsigned char)*p;
+        if (c == '"' || c == '\\')
+            fprintf(file, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(file, "\\u%04x", c);
+        else
+            fputc(c, file);
+    }
+    fputc('"', file);
+}
+
+void write_at_exit()
+{
+    if (!s_path.empty())
+        trace_recorder::write_json(s_path);
+}
+}
+
+volatile long trace_recorder::s_enabled;
+
+void trace_recorder::start(const std::string& path, size_t max_events)
+{
+    {
+        tthread::lock_guard<tthread::mutex> lg(s_buffers_mutex);
+        s_max_events = max_events;
+        if (!s_origin_ns)
+            s_origin_ns = monotonic_ns();
+        s_path = path;
+        if (!path.empty() && !s_exit_registered)
+        {
+            atexit(write_at_exit);
+            s_exit_registered = true;
+        }
+    }
+    atomic_store(&s_enabled, 1);
+}
+
+void trace_recorder::stop()
+{
+    atomic_store(&s_enabled, 0);
+}
+
+void trace_recorder::record(const char* category, const char* name, unsigned long long start_ns)
+{
+    trace_chunk* chunk;
+    trace_event* event = next_event(chunk);
+    if (!event)
+        return;
+    event->name = name;
+    publish(chunk, event, category, start_ns);
+}
+
+void trace_recorder::record(const char* category, const std::string& name, unsigned long long start_ns)
+{
+    trace_chunk* chunk;
+    trace_event* event = next_event(chunk);
+    if (!event)
+        return;
+    event->name = nullptr;
+    event->dynamic_name = name;
+    publish(chunk, event, category, start_ns);
+}
+
+long trace_recorder::dropped()
+{
+    return atomic_load(&s_dropped);
+}
+
+size_t trace_recorder::capacity()
+{
+    return (size_t)atomic_load(&s_reserved);
+}
+
+void trace_recorder::clear()
+{
+    tthread::lock_guard<tthread::mutex> lg(s_buffers_mutex);
+    for (thread_buffer* buffer = s_buffers; buffer; buffer = buffer->next)
+    {
+        trace_chunk* chunk = buffer->first;
+        while (chunk)
+        {
+            trace_chunk* next = chunk->next;
+            delete chunk;
+            chunk = next;
+        }
+        buffer->first = buffer->last = nullptr;
+    }
+    atomic_store(&s_dropped, 0);
+    atomic_store(&s_reserved, 0);
+    s_origin_ns = monotonic_ns();
+}
+
+bool trace_recorder::write_json(const std::string& path)
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+    tthread::lock_guard<tthread::mutex> lg(s_buffers_mutex);
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+    const char* separator = "\n";
+    for (thread_buffer* buffer = s_buffers; buffer; buffer = buffer->next)
+    {
+        // Threads which used the buffer in turn are named before their first event
+        unsigned thread = 0;
+        for (trace_chunk* chunk = atomic_load_ptr(&buffer->first); chunk; chunk = atomic_load_ptr(&chunk->next))
+        {
+            long count = atomic_load(&chunk->count);
+            for (long i = 0; i < count; i++)
+            {
+                const trace_event& event = chunk->events[i];
+                if (event.thread != thread)
+                {
+                    thread = event.thread;
+                    fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+                        separator, thread, thread);
+                    separator = ",\n";
+                }
+                // Timestamps are in microseconds since the recording started
+                unsigned long long start = event.start_ns > s_origin_ns ? event.start_ns - s_origin_ns : 0;
+                fputs(separator, file);
+                fputs("{\"name\":", file);
+                write_escaped(file, event.name ? event.name : event.dynamic_name.c_str());
+                fputs(",\"cat\":", file);
+                write_escaped(file, event.category);
+                fprintf(file, ",\"ph\":\"X\",\"ts\":%llu.%03d,\"dur\":%llu.%03d,\"pid\":1,\"tid\":%u}",
+                    start / 1000, (int)(start % 1000), event.duration_ns / 1000,
+                    (int)(event.duration_ns % 1000), event.thread);
+            }
+        }
+    }
+    fputs("\n]}\n", file);
+    return fclose(file) == 0;
+}
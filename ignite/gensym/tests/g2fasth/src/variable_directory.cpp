@@ -0,0 +1,241 @@
+#include "variable_directory.hpp"
+#include "libgsi.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+const size_t kMinBuckets = 64;
+
+/**
+* FNV-1a hash of all characters of the name. Visual Studio 2010 std::hash samples
+* every tenth character of long strings, so generated names would collide.
+*/
+size_t name_hash(const std::string& name)
+{
+    size_t hash = 2166136261U;
+    for (size_t i = 0; i < name.size(); i++)
+        hash = (hash ^ (unsigned char)name[i]) * 16777619U;
+    return hash;
+}
+
+/**
+* Deletes removed entries with their variables.
+*/
+void delete_entries(std::vector<variable_entry*>& entries)
+{
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        delete entries[i]->variable();
+        delete entries[i];
+    }
+    entries.clear();
+}
+
+size_t handle_bucket(long handle, size_t bucket_count)
+{
+    // Fibonacci hashing spreads handles which are multiples of a power of two
+    return ((unsigned long)handle * 2654435761UL) & (bucket_count - 1);
+}
+}
+
+variable_directory::table::table(size_t bucket_count)
+    : names(bucket_count, nullptr), handles(bucket_count, nullptr), handle_links(0)
+{
+}
+
+variable_directory::reader::reader(const variable_directory& directory)
+{
+    // Reader counts in the parity of the epoch which is still current after
+    // the count is taken, so that collect() sees it
+    for (;;)
+    {
+        long epoch = atomic_load(&directory.d_epoch);
+        d_count = &directory.d_readers[epoch & 1];
+        atomic_add(d_count, 1);
+        if (atomic_load(&directory.d_epoch) == epoch)
+            break;
+        atomic_add(d_count, -1);
+    }
+}
+
+variable_directory::reader::~reader()
+{
+    atomic_add(d_count, -1);
+}
+
+variable_directory::variable_directory()
+    : d_table(new table(kMinBuckets)), d_removed_entries(0), d_epoch(0)
+{
+    d_readers[0] = d_readers[1] = 0;
+}
+
+variable_directory::~variable_directory()
+{
+    for (size_t i = 0; i < d_entries.size(); i++)
+    {
+        delete d_entries[i]->d_variable;
+        delete d_entries[i];
+    }
+    delete d_table;
+    for (size_t i = 0; i < d_pending_tables.size(); i++)
+        delete d_pending_tables[i];
+    for (size_t i = 0; i < d_retired_tables.size(); i++)
+        delete d_retired_tables[i];
+    for (size_t i = 0; i < d_pending_variables.size(); i++)
+        delete d_pending_variables[i];
+    for (size_t i = 0; i < d_retired_variables.size(); i++)
+        delete d_retired_variables[i];
+    delete_entries(d_pending_entries);
+    delete_entries(d_retired_entries);
+}
+
+variable_entry* variable_directory::find(const std::string& name) const
+{
+    const table* current = atomic_load_ptr(&d_table);
+    size_t key = name_hash(name);
+    for (const link* l = head(current->names, key & (current->names.size() - 1)); l; l = l->next)
+    {
+        if (l->key == key && l->entry->d_name == name && !atomic_load(&l->entry->d_removed))
+            return l->entry;
+    }
+    return nullptr;
+}
+
+variable_entry* variable_directory::find(long handle) const
+{
+    if (!handle)
+        return nullptr;
+    const table* current = atomic_load_ptr(&d_table);
+    for (const link* l = head(current->handles, handle_bucket(handle, current->handles.size())); l; l = l->next)
+    {
+        // Links of handles changed since are skipped
+        if (l->key == (size_t)handle && l->entry->handle() == handle)
+            return l->entry;
+    }
+    return nullptr;
+}
+
+void variable_directory::push(table& target, std::vector<link*>& heads, size_t bucket, variable_entry* entry, size_t key)
+{
+    link added = { entry, key, heads[bucket] };
+    target.links.push_back(added);
+    // The link is complete before readers can reach it
+    atomic_store_ptr(reinterpret_cast<link* volatile*>(&heads[bucket]), &target.links.back());
+}
+
+variable_entry* variable_directory::insert(const std::string& name, g2_variable* variable)
+{
+    variable_entry* entry = new variable_entry(name, variable);
+    d_entries.push_back(entry);
+    table* current = d_table;
+    if (d_entries.size() > current->names.size())
+        rebuild();
+    else
+    {
+        size_t key = name_hash(name);
+        push(*current, current->names, key & (current->names.size() - 1), entry, key);
+    }
+    collect();
+    return entry;
+}
+
+void variable_directory::replace(variable_entry* entry, g2_variable* variable)
+{
+    g2_variable* previous = entry->d_variable;
+    d_pending_variables.push_back(previous);
+    atomic_store_ptr(&entry->d_variable, variable);
+    collect();
+}
+
+void variable_directory::assign_handle(variable_entry* entry, long handle)
+{
+    if (entry->d_handle == handle)
+        return;
+    atomic_store(&entry->d_handle, handle);
+    if (handle)
+    {
+        table* current = d_table;
+        if (current->handle_links >= current->handles.size())
+            rebuild();
+        else
+        {
+            push(*current, current->handles, handle_bucket(handle, current->handles.size()), entry, (size_t)handle);
+            current->handle_links++;
+        }
+    }
+    collect();
+}
+
+void variable_directory::remove(variable_entry* entry)
+{
+    atomic_store(&entry->d_handle, 0);
+    atomic_store(&entry->d_removed, 1);
+    // Links can't be unlinked in place, so the table is rebuilt once half of entries are removed
+    if (++d_removed_entries * 2 > d_entries.size())
+        rebuild();
+    collect();
+}
+
+void variable_directory::rebuild()
+{
+    // Removed entries are deleted with the previous table, which may still link them
+    size_t live = 0;
+    for (size_t i = 0; i < d_entries.size(); i++)
+    {
+        if (d_entries[i]->d_removed)
+            d_pending_entries.push_back(d_entries[i]);
+        else
+            d_entries[live++] = d_entries[i];
+    }
+    d_entries.resize(live);
+    d_removed_entries = 0;
+
+    size_t handles = 0;
+    for (size_t i = 0; i < d_entries.size(); i++)
+    {
+        if (d_entries[i]->d_handle)
+            handles++;
+    }
+    size_t needed = d_entries.size() > handles ? d_entries.size() : handles;
+    size_t bucket_count = kMinBuckets;
+    while (bucket_count < needed * 2)
+        bucket_count *= 2;
+
+    table* next = new table(bucket_count);
+    for (size_t i = 0; i < d_entries.size(); i++)
+    {
+        variable_entry* entry = d_entries[i];
+        size_t key = name_hash(entry->d_name);
+        push(*next, next->names, key & (bucket_count - 1), entry, key);
+        if (entry->d_handle)
+            push(*next, next->handles, handle_bucket(entry->d_handle, bucket_count), entry, (size_t)entry->d_handle);
+    }
+    next->handle_links = handles;
+    table* previous = d_table;
+    d_pending_tables.push_back(previous);
+    atomic_store_ptr(&d_table, next);
+}
+
+void variable_directory::collect()
+{
+    if (!d_retired_tables.empty() || !d_retired_variables.empty() || !d_retired_entries.empty())
+    {
+        // Readers which could see retired objects counted in parity of previous epoch
+        if (atomic_load(&d_readers[(d_epoch - 1) & 1]))
+            return;
+        for (size_t i = 0; i < d_retired_tables.size(); i++)
+            delete d_retired_tables[i];
+        for (size_t i = 0; i < d_retired_variables.size(); i++)
+            delete d_retired_variables[i];
+        d_retired_tables.clear();
+        d_retired_variables.clear();
+        delete_entries(d_retired_entries);
+    }
+    if (!d_pending_tables.empty() || !d_pending_variables.empty() || !d_pending_entries.empty())
+    {
+        d_retired_tables.swap(d_pending_tables);
+        d_retired_variables.swap(d_pending_variables);
+        d_retired_entries.swap(d_pending_entries);
+        atomic_add(&d_epoch, 1);
+    }
+}
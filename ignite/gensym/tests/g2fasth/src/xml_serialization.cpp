@@ -1,8 +1,10 @@
-#include <algorithm>
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
 #include <string>
-#include <iostream>
-#include <sstream>
 #include "xml_serialization.hpp"
+#include "tinythread.h"
+#include "g2fasth_platform.hpp"
 
 using namespace std;
 
@@ -11,172 +13,263 @@ using namespace std;
 */
 namespace xmls
 {
-/**
-* Assign a value to the xint member
-*/
-void x_int::assign_value(int value)
+namespace {
+// Guards publication of class tables, instances constructed concurrently
+// may both build the table of a class and only one of them is kept.
+tthread::mutex s_registry_mutex;
+
+const size_t kArenaAlignment = 16;
+const size_t kArenaFirstBlock = 4096;
+const size_t kArenaMaxBlock = 256 * 1024;
+
+inline size_t align_size(size_t size)
 {
-    stringstream ss;
-    ss << value;
-    d_value = ss.str();
-};
+    return (size + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+}
+}
 
 /**
-* Returns the int-value of the xint member
-* @return current value
+* Formats integer value into the buffer
 */
-int x_int::value()
+const char* format_int(long long value, char* buf)
 {
-    stringstream ss(d_value);
-    int value;
-    if ((ss >> value).fail())
-        return 0;
-    return value;
-};
+    char* p = buf + 23;
+    *p = 0;
+    unsigned long long v = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    do {
+        *--p = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    if (value < 0)
+        *--p = '-';
+    return p;
+}
 
-/**
-Returns the bool-value of the xbool member
-@return	current value
-*/
-bool x_bool::value()
+arena::arena()
+    : d_head(0)
+{ }
+
+arena::~arena()
 {
-    bool value = false;
-    string sHelp = d_value;
-    transform(sHelp.begin(), sHelp.end(), sHelp.begin(), ::toupper);
-    if (sHelp == "TRUE") return true;
-    return value;
-};
+    while (d_head)
+    {
+        block* next = d_head->next;
+        free(d_head);
+        d_head = next;
+    }
+}
 
-/**
-* Assign a value to the xTime_t member
-*/
-void x_time_t::assign_value(const time_t value)
+void* arena::allocate(size_t size)
+{
+    const size_t header = align_size(sizeof(block));
+    size = align_size(size);
+    if (!d_head || d_head->used + size > d_head->size)
+    {
+        size_t block_size = d_head ? d_head->size * 2 : kArenaFirstBlock;
+        if (block_size > kArenaMaxBlock)
+            block_size = kArenaMaxBlock;
+        if (block_size < size)
+            block_size = size;
+        block* new_block = (block*)malloc(header + block_size);
+        if (!new_block)
+            throw std::bad_alloc();
+        new_block->next = d_head;
+        new_block->size = block_size;
+        new_block->used = 0;
+        d_head = new_block;
+    }
+    void* ptr = (char*)d_head + header + d_head->used;
+    d_head->used += size;
+    return ptr;
+}
+
+void collection_base::link(serializable* item, arena* owner)
+{
+    item->d_arena = owner;
+    item->d_next = 0;
+    if (d_last)
+        d_last->d_next = item;
+    else
+        d_first = item;
+    d_last = item;
+    d_size++;
+}
+
+serializable* collection_base::getItem(int itemID)
 {
-    stringstream ss;
-    ss << value;
-    d_value = ss.str();
-};
+    serializable* item = d_first;
+    for (int i = 0; item && i < itemID; i++)
+        item = item->d_next;
+    return item;
+}
 
 /**
-* Delete all (self created) collection-elements
+* Destroy all collection-elements
 */
 void collection_base::Clear()
 {
-    if (m_vCollection.size() > 0)
+    serializable* item = d_first;
+    while (item)
     {
-        for (vector<serializable*>::iterator it = m_vCollection.begin(); it != m_vCollection.end(); ++it)
-            if (m_mOwner.find(*it)->second)
-                delete(*it);
-        m_vCollection.clear();
-        m_mOwner.clear();
+        serializable* next = item->d_next;
+        item->~serializable();
+        item = next;
     }
+    d_first = d_last = 0;
+    d_size = 0;
 }
 
 /**
 * SerializableBase Constructor
 */
 serializable::serializable()
+    : d_table(0)
+    , d_registering(0)
+    , d_registering_slot(0)
+    , d_next(0)
+    , d_arena(0)
+    , d_owns_arena(false)
 { }
 
 /**
 * SerializableBase Destructor
-* Clean Collections, Mappings and Subclass-Mappings
+* Collections are members of derived classes and are already cleared,
+* so the arena can be released. Table is still being registered only if
+* constructor of derived class has thrown.
 */
 serializable::~serializable()
 {
-    if (d_subclass_collections.size() > 0)
+    delete d_registering;
+    if (d_owns_arena)
+        delete d_arena;
+}
+
+bool serializable::begin_registration(class_table** table, const char* class_name)
+{
+    const class_table* registered = g2::fasth::atomic_load_ptr(table);
+    if (registered)
     {
-        for (CollectionIterator it_collection = d_subclass_collections.begin(); it_collection != d_subclass_collections.end(); ++it_collection)
-            (*it_collection)->Clear();
-        d_subclass_collections.clear();
+        d_table = registered;
+        return false;
     }
-    if (d_subclass_mappings.size() > 0)
-        for (ClassMappingIterator it_subClassMapping = d_subclass_mappings.begin(); it_subClassMapping != d_subclass_mappings.end(); ++it_subClassMapping)
-            delete(*it_subClassMapping);
-
-    if (d_field_mappings.size() > 0)
-        for (FieldMappingIterator it_fieldMapping = d_field_mappings.begin(); it_fieldMapping != d_field_mappings.end(); ++it_fieldMapping)
-            delete(*it_fieldMapping);
-
-    d_subclass_collections.clear();
-    d_subclass_mappings.clear();
-    d_field_mappings.clear();
+    d_registering = new class_table();
+    d_registering->class_name = class_name;
+    // Members of base class are registered already
+    if (d_table)
+        d_registering->fields = d_table->fields;
+    d_registering_slot = table;
+    return true;
 }
 
-void serializable::register_type(string MemberName, member_base *Member, string DefaultValue)
+void serializable::add_field(const char* name, field_kind kind, const void* member)
 {
-    field_mapping *mapping = new field_mapping(MemberName, Member->get_string_ptr());
-    *(Member->get_string_ptr()) = DefaultValue;
-    d_field_mappings.push_back(mapping);
+    assert(d_registering);
+    field_info field;
+    field.name = name;
+    field.kind = kind;
+    field.offset = (const char*)member - (const char*)this;
+    d_registering->fields.push_back(field);
 }
 
-void serializable::register_type(string MemberName, serializable *Member)
+void serializable::end_registration()
 {
-    class_mapping *mapping = new class_mapping(MemberName, Member);
-    d_subclass_mappings.push_back(mapping);
+    assert(d_registering);
+    {
+        tthread::lock_guard<tthread::mutex> guard(s_registry_mutex);
+        if (*d_registering_slot)
+        {
+            // Another instance has published the same table first
+            delete d_registering;
+        }
+        else
+        {
+            g2::fasth::atomic_store_ptr(d_registering_slot, d_registering);
+        }
+        d_table = *d_registering_slot;
+    }
+    d_registering = 0;
+    d_registering_slot = 0;
 }
 
-void serializable::register_type(string CollectionName, collection_base *SubclassCollection)
+arena& serializable::get_arena()
 {
-    SubclassCollection->setCollectionName(CollectionName);
-    d_subclass_collections.push_back(SubclassCollection);
+    if (!d_arena)
+    {
+        d_arena = new arena();
+        d_owns_arena = true;
+    }
+    return *d_arena;
 }
 
-void serializable::serialize(tinyxml2::XMLDocument *classDoc, tinyxml2::XMLElement *rootNode)
+void serializable::serialize(tinyxml2::XMLPrinter& printer, const char* element_name) const
 {
-    for (FieldMappingIterator it_member = d_field_mappings.begin(); it_member != d_field_mappings.end(); ++it_member)
+    printer.OpenElement(element_name);
+    if (!d_table)
     {
-        rootNode->SetAttribute((*it_member)->getFieldName().c_str(), (*(*it_member)->getField()).c_str());
+        printer.CloseElement();
+        return;
     }
-
-    for (ClassMappingIterator it_subclass = d_subclass_mappings.begin(); it_subclass != d_subclass_mappings.end(); ++it_subclass)
+    const char* base = (const char*)this;
+    const vector<field_info>& fields = d_table->fields;
+    char buf[24];
+    for (vector<field_info>::const_iterator it = fields.begin(); it != fields.end(); ++it)
     {
-        serializable *sub_class = (*it_subclass)->getSubclass();
-        tinyxml2::XMLElement *subClassNode = classDoc->NewElement(((*it_subclass)->getName()).c_str());
-        rootNode->InsertEndChild(subClassNode);
-        auto inner_text = (*it_subclass)->getSubclass()->get_inner_text();
-        if (inner_text != "")
+        const char* member = base + it->offset;
+        switch (it->kind)
         {
-            tinyxml2::XMLText* memberValue = classDoc->NewText(inner_text.c_str());
-            subClassNode->InsertEndChild(memberValue);
+        case field_string:
+            printer.PushAttribute(it->name.c_str(), ((const x_string*)member)->c_str());
+            break;
+        case field_int:
+            printer.PushAttribute(it->name.c_str(), format_int(((const x_int*)member)->value(), buf));
+            break;
+        case field_bool:
+            printer.PushAttribute(it->name.c_str(), ((const x_bool*)member)->value() ? "true" : "false");
+            break;
+        case field_time:
+            printer.PushAttribute(it->name.c_str(), format_int((long long)((const x_time_t*)member)->value(), buf));
+            break;
+        default:
+            break;
         }
-        sub_class->serialize(classDoc, subClassNode);
     }
 
-    for (CollectionIterator it_collection = d_subclass_collections.begin(); it_collection != d_subclass_collections.end(); ++it_collection)
+    if (!d_inner_text.empty())
+        printer.PushText(d_inner_text.c_str());
+
+    for (vector<field_info>::const_iterator it = fields.begin(); it != fields.end(); ++it)
     {
-        for (size_t c = 0; c < (*it_collection)->size(); c++)
-        {
-            serializable *item = (*it_collection)->getItem((int)c);
-            tinyxml2::XMLElement *elementNode = classDoc->NewElement(item->get_class_name().c_str());
-            auto inner_text = item->get_inner_text();
-            if (inner_text != "")
-            {
-                tinyxml2::XMLText* memberValue = classDoc->NewText(inner_text.c_str());
-                elementNode->InsertEndChild(memberValue);
-            }
-            item->serialize(classDoc, elementNode);
-            rootNode->InsertEndChild(elementNode);
-        }
+        if (it->kind == field_subclass)
+            ((const serializable*)(base + it->offset))->serialize(printer, it->name.c_str());
+    }
+
+    for (vector<field_info>::const_iterator it = fields.begin(); it != fields.end(); ++it)
+    {
+        if (it->kind != field_collection)
+            continue;
+        const collection_base* items = (const collection_base*)(base + it->offset);
+        for (const serializable* item = items->d_first; item; item = item->d_next)
+            item->serialize(printer, item->d_table ? item->d_table->class_name.c_str() : "");
     }
+
+    printer.CloseElement();
 }
 
 string serializable::to_xml(std::string file_name = "")
 {
-    tinyxml2::XMLDocument *classDoc = new tinyxml2::XMLDocument();
-    tinyxml2::XMLElement *rootNode;
-    rootNode = classDoc->NewElement(d_class_name.c_str());
-    classDoc->InsertFirstChild(rootNode);
-    serialize(classDoc, rootNode);
+    const string element_name = get_class_name();
     if (!file_name.empty())
     {
-        classDoc->SaveFile(file_name.c_str(), true);
+        FILE* file = fopen(file_name.c_str(), "w");
+        if (file)
+        {
+            tinyxml2::XMLPrinter file_printer(file, true);
+            serialize(file_printer, element_name.c_str());
+            fclose(file);
+        }
     }
     tinyxml2::XMLPrinter printer;
-    classDoc->Accept(&printer);
-    string xmlResult = printer.CStr();
-    classDoc->Clear();
-    delete(classDoc);
-    return xmlResult;
+    serialize(printer, element_name.c_str());
+    return printer.CStr();
+}
 }
-}
\ No newline at end of file
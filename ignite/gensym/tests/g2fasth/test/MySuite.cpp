@@ -47,11 +47,9 @@ void MySuite::after()
 
 void MySuite::first_test(const std::string& test_case_name)
 {
-    char buf[25];
-    sprintf(buf, "%d", d_iParam);
-    get_logger().log(log_level::VERBOSE, std::string("Value of d_sParam is ") + buf);
-    get_logger().log(log_level::VERBOSE, std::string("Value of d_sParam is ") + d_sParam);
-    get_logger().log(log_level::VERBOSE, std::string("Value of d_bParam is ") + (d_bParam ? "true" : "false"));
+    G2FASTH_LOGF(get_logger(), VERBOSE, "Value of d_sParam is %d", d_iParam);
+    G2FASTH_LOGF(get_logger(), VERBOSE, "Value of d_sParam is %s", d_sParam.c_str());
+    G2FASTH_LOGF(get_logger(), VERBOSE, "Value of d_bParam is %s", d_bParam ? "true" : "false");
     
     complete_test_case(test_case_name, test_outcome::pass);
 }
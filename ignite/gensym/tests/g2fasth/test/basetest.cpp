@@ -15,8 +15,12 @@ int main(int argc, char **argv) {
 
     auto suiteA = std::make_shared<MySuite>("SuiteA", 0, "TestValue", false, options.get_output_file());
     suiteA->run(&MySuite::first_test, "first_test");
+    suiteA->set_result_log(options.get_result_log());
+    options.configure_logger(suiteA->get_logger());
 
     auto suiteB = std::make_shared<MySuite>("SuiteB", 100, "AnotherValue", true, options.get_output_file());
+    suiteB->set_result_log(options.get_result_log());
+    options.configure_logger(suiteB->get_logger());
 
     g2::fasth::test_agent agent;
     agent.schedule_suite(suiteB);
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "g2fasth.hpp"
+#include "gsi_load_generator.hpp"
+#include "libgsi.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+struct load_test_options {
+    load_test_options() : port(22060), variables(100), prefix("LOAD-VAR-"), type(g2_float), output("load_test.csv") {
+        run.duration_s = 60;
+    }
+    int port;
+    int variables;
+    std::string prefix;
+    g2_type type;
+    load_profile profile;
+    load_options run;
+    std::string output;
+};
+
+load_test_options s_options;
+gsi_load_generator* s_generator = nullptr;
+
+void usage(const char* program)
+{
+    fprintf(stderr, "Usage: %s [-port=n] [-variables=n] [-prefix=name] [-type=integer|float] [-rate=n]\n"
+        "          [-ramp=to_rate,seconds] [-burst=peak_rate,period_s,burst_s] [-duration=s] [-interval=s]\n"
+        "          [-output=file.csv]\n", program);
+    fprintf(stderr, "Offers updates of variables <prefix>0 .. <prefix><n-1> of the KB at the aggregate rate\n");
+    fprintf(stderr, "once G2 connects, then writes the time series to the CSV file, prints summary and exits.\n");
+    fprintf(stderr, "G2 must poll the GSI interface, as values are sent by gsi_g2_poll.\n");
+    fprintf(stderr, "  -rate=n       updates per second, the starting rate of ramp, the base rate of bursts (1000)\n");
+    fprintf(stderr, "  -ramp=r,s     rate changes linearly to r over s seconds\n");
+    fprintf(stderr, "  -burst=r,p,b  rate is r for b seconds at the start of each period of p seconds\n");
+}
+
+bool parse(int argc, char** argv)
+{
+    double rate = 1000;
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        double a = 0, b = 0, c = 0;
+        if (strncmp(arg, "-port=", 6) == 0)
+            s_options.port = atoi(arg + 6);
+        else if (strncmp(arg, "-variables=", 11) == 0)
+            s_options.variables = atoi(arg + 11);
+        else if (strncmp(arg, "-prefix=", 8) == 0)
+            s_options.prefix = arg + 8;
+        else if (strcmp(arg, "-type=integer") == 0)
+            s_options.type = g2_integer;
+        else if (strcmp(arg, "-type=float") == 0)
+            s_options.type = g2_float;
+        else if (strncmp(arg, "-rate=", 6) == 0)
+            rate = atof(arg + 6);
+        else if (sscanf(arg, "-ramp=%lf,%lf", &a, &b) == 2)
+            s_options.profile = load_profile::ramp(0, a, b);
+        else if (sscanf(arg, "-burst=%lf,%lf,%lf", &a, &b, &c) == 3)
+            s_options.profile = load_profile::burst(0, a, b, c);
+        else if (strncmp(arg, "-duration=", 10) == 0)
+            s_options.run.duration_s = atof(arg + 10);
+        else if (strncmp(arg, "-interval=", 10) == 0)
+            s_options.run.interval_s = atof(arg + 10);
+        else if (strncmp(arg, "-output=", 8) == 0)
+            s_options.output = arg + 8;
+        else
+            return false;
+    }
+    s_options.profile.rate = rate;
+    if (s_options.profile.shape == load_constant)
+        s_options.profile.peak_rate = rate;
+    return s_options.variables > 0 && s_options.run.duration_s > 0 && s_options.run.interval_s > 0;
+}
+
+/**
+* Runs the load once G2 has connected, writes results and exits the process.
+*/
+void load_thread(void*)
+{
+    s_generator->run(s_options.profile, s_options.run);
+    std::string csv = s_generator->samples_csv();
+    FILE* file = fopen(s_options.output.c_str(), "w");
+    if (file)
+    {
+        fputs(csv.c_str(), file);
+        fclose(file);
+    }
+    else
+        fprintf(stderr, "Cannot write %s\n", s_options.output.c_str());
+    printf("%s", csv.c_str());
+    printf("%s", s_generator->summary_text().c_str());
+    exit(0);
+}
+
+void start_load()
+{
+    static bool started = false;
+    if (started)
+        return;
+    started = true;
+    new tthread::thread(load_thread, nullptr);
+}
+}
+
+int main(int argc, char** argv)
+{
+    g2_options options;
+    options.parse_arguments(&argc, argv);
+    options.set_signal_handler();
+    if (!parse(argc, argv))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    libgsi& gsiobj = libgsi::getInstance();
+    gsiobj.continuous(true);
+    gsiobj.port(s_options.port);
+    s_generator = new gsi_load_generator(gsiobj);
+    printf("%d variables declared\n", s_generator->add_variables(s_options.prefix, s_options.variables, s_options.type));
+    gsiobj.declare_g2_init(start_load);
+    gsiobj.startgsi();
+    return 0;
+}
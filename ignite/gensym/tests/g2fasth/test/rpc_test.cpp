@@ -4,6 +4,7 @@
 #include "test_agent.hpp"
 
 #include "libgsi.hpp"
+#include "kb_loader.hpp"
 #include "gsi_misc.h"
 
 using namespace g2::fasth;
@@ -412,6 +413,15 @@ int main(int argc, char **argv) {
         gsiobj.declare_g2_variable<int>("INTEGER-DAT", int_handler);
         gsiobj.declare_g2_variable<double>("FLOAT64-DAT", float_handler);
     }
+    if (argc > 4)
+    {   // Declare variables exported in KB, in addition to ones declared by the test
+        printf("Arg 4 = %s\n", argv[4]);
+        kb_loader kb;
+        if (kb.load(argv[4]))
+            printf("%d variables declared from KB\n", kb.declare_variables(gsiobj));
+        else
+            printf("%s\n", kb.error().c_str());
+    }
 
     gsiobj.declare_g2_function("RPC-ADD-FLOAT", rpc_add_float);
     gsiobj.declare_g2_function("RPC-TEXT", rpc_text);
@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "binary_log.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+const char* level_str[] = { "NONE", "SILENT", "REGULAR", "VERBOSE" };
+
+struct filter {
+    filter() : thread(0), from_ns(0), to_ns(~0ULL), level(VERBOSE) {}
+    std::string suite;
+    std::string test;
+    unsigned thread;                // 0 accepts all threads
+    unsigned long long from_ns;
+    unsigned long long to_ns;
+    log_level level;
+    bool accepts(const binary_log_entry& entry) const {
+        return (suite.empty() || *entry.suite_name == suite)
+            && (test.empty() || *entry.test_name == test)
+            && (!thread || entry.thread == thread)
+            && entry.time_ns >= from_ns && entry.time_ns <= to_ns
+            && entry.level <= level;
+    }
+};
+
+void usage(const char* program)
+{
+    fprintf(stderr, "Usage: %s [-text] [-suite=name] [-test=name] [-thread=n] [-from=sec] [-to=sec] [-level=n] log_file...\n", program);
+    fprintf(stderr, "  -text         print message text only, as the text log would have it\n");
+    fprintf(stderr, "  -suite=name   print messages of the suite only\n");
+    fprintf(stderr, "  -test=name    print messages of the test case only\n");
+    fprintf(stderr, "  -thread=n     print messages of the thread only\n");
+    fprintf(stderr, "  -from=sec     skip messages logged earlier since start of the session\n");
+    fprintf(stderr, "  -to=sec       skip messages logged later since start of the session\n");
+    fprintf(stderr, "  -level=n      skip messages more detailed than the log level (1-3)\n");
+}
+
+unsigned long long seconds_to_ns(const char* value)
+{
+    return (unsigned long long)(atof(value) * 1e9);
+}
+}
+
+int main(int argc, char** argv)
+{
+    bool text_only = false;
+    filter selection;
+    std::vector<std::string> logs;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-text") == 0)
+            text_only = true;
+        else if (strncmp(argv[i], "-suite=", 7) == 0)
+            selection.suite = argv[i] + 7;
+        else if (strncmp(argv[i], "-test=", 6) == 0)
+            selection.test = argv[i] + 6;
+        else if (strncmp(argv[i], "-thread=", 8) == 0)
+            selection.thread = (unsigned)strtoul(argv[i] + 8, nullptr, 10);
+        else if (strncmp(argv[i], "-from=", 6) == 0)
+            selection.from_ns = seconds_to_ns(argv[i] + 6);
+        else if (strncmp(argv[i], "-to=", 4) == 0)
+            selection.to_ns = seconds_to_ns(argv[i] + 4);
+        else if (strncmp(argv[i], "-level=", 7) == 0)
+            selection.level = (log_level)strtol(argv[i] + 7, nullptr, 10);
+        else if (argv[i][0] == '-')
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        else
+            logs.push_back(argv[i]);
+    }
+    if (logs.empty())
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    for (auto log = logs.begin(); log != logs.end(); ++log)
+    {
+        binary_log_reader reader;
+        if (!reader.open(*log))
+        {
+            fprintf(stderr, "Cannot read binary log %s\n", log->c_str());
+            return 1;
+        }
+        binary_log_entry entry;
+        while (reader.next(entry))
+        {
+            if (!selection.accepts(entry))
+                continue;
+            if (text_only)
+            {
+                printf("%s\n", entry.text.c_str());
+                continue;
+            }
+            const char* level = (unsigned)entry.level < sizeof(level_str) / sizeof(level_str[0])
+                ? level_str[entry.level] : "?";
+            printf("%12.6f T%-3u %-7s %s%s%s: %s\n", entry.time_ns / 1e9, entry.thread, level,
+                entry.suite_name->c_str(), entry.test_name->empty() ? "" : ".", entry.test_name->c_str(),
+                entry.text.c_str());
+        }
+    }
+    return 0;
+}
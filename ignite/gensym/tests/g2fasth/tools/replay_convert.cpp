@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include "time_series_replay.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+void usage(const char* program)
+{
+    fprintf(stderr, "Usage: %s [-type=name] [-header] csv_file recording\n", program);
+    fprintf(stderr, "  Converts rows of time_s,variable,value in order of time to a recording\n");
+    fprintf(stderr, "  played by time_series_replay.\n");
+    fprintf(stderr, "  -type=name    type of variables: integer, float, logical, string or symbol\n");
+    fprintf(stderr, "                (default float)\n");
+    fprintf(stderr, "  -header       skip the first line\n");
+}
+
+bool parse_type(const char* name, g2_type& type)
+{
+    if (strcmp(name, "integer") == 0)
+        type = g2_integer;
+    else if (strcmp(name, "float") == 0)
+        type = g2_float;
+    else if (strcmp(name, "logical") == 0)
+        type = g2_logical;
+    else if (strcmp(name, "string") == 0)
+        type = g2_string;
+    else if (strcmp(name, "symbol") == 0)
+        type = g2_symbol;
+    else
+        return false;
+    return true;
+}
+
+/**
+* Splits line in place into three fields separated by commas, trailing blanks are removed.
+*/
+bool split(char* line, char* fields[3])
+{
+    char* end = line + strlen(line);
+    while (end > line && (end[-1] == '\n' || end[-1] == '\r' || end[-1] == ' '))
+        *--end = '\0';
+    fields[0] = line;
+    for (int i = 1; i < 3; i++)
+    {
+        char* comma = strchr(fields[i - 1], ',');
+        if (!comma)
+            return false;
+        *comma = '\0';
+        fields[i] = comma + 1;
+    }
+    return true;
+}
+}
+
+int main(int argc, char** argv)
+{
+    g2_type type = g2_float;
+    bool header = false;
+    const char* paths[2] = { nullptr, nullptr };
+    int path_count = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "-type=", 6) == 0 && parse_type(argv[i] + 6, type))
+            continue;
+        else if (strcmp(argv[i], "-header") == 0)
+            header = true;
+        else if (argv[i][0] != '-' && path_count < 2)
+            paths[path_count++] = argv[i];
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (path_count != 2)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FILE* csv = fopen(paths[0], "r");
+    if (!csv)
+    {
+        fprintf(stderr, "Cannot read %s\n", paths[0]);
+        return 1;
+    }
+    replay_writer writer;
+    if (!writer.open(paths[1]))
+    {
+        fprintf(stderr, "Cannot create %s\n", paths[1]);
+        fclose(csv);
+        return 1;
+    }
+    std::map<std::string, unsigned> variables;
+    char line[4096];
+    unsigned long long line_number = 0, rows = 0;
+    int result = 0;
+    while (fgets(line, sizeof(line), csv))
+    {
+        line_number++;
+        if ((header && line_number == 1) || line[0] == '\n' || line[0] == '\r' || line[0] == '\0')
+            continue;
+        char* fields[3];
+        if (!split(line, fields))
+        {
+            fprintf(stderr, "%s:%llu: expected time_s,variable,value\n", paths[0], line_number);
+            result = 1;
+            break;
+        }
+        auto found = variables.find(fields[1]);
+        if (found == variables.end())
+            found = variables.insert(std::make_pair(std::string(fields[1]), writer.add_variable(fields[1], type))).first;
+        long long time_ns = (long long)(atof(fields[0]) * 1e9 + 0.5);
+        if (!writer.write(time_ns, found->second, atof(fields[2])))
+        {
+            fprintf(stderr, "%s:%llu: row is older than the previous one\n", paths[0], line_number);
+            result = 1;
+            break;
+        }
+        rows++;
+    }
+    fclose(csv);
+    if (!writer.close())
+    {
+        fprintf(stderr, "Cannot write %s\n", paths[1]);
+        return 1;
+    }
+    if (!result)
+        printf("%llu rows of %u variables\n", rows, (unsigned)variables.size());
+    return result;
+}
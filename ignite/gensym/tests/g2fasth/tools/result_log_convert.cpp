@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "result_log.hpp"
+#include "junit_report.hpp"
+#include "g2fasth_enums.hpp"
+#include "suite.hpp"
+
+using namespace g2::fasth;
+
+namespace {
+struct suite_results {
+    suite_results() : passed(0), failed(0), first_ms(0), last_ms(0) {}
+    std::vector<result_log_entry> entries;
+    int passed;
+    int failed;
+    unsigned long long first_ms;   // earliest test case start
+    unsigned long long last_ms;    // latest test case end
+};
+
+void usage(const char* program)
+{
+    fprintf(stderr, "Usage: %s [-summary] [-output_dir=dir] [-output=file] log_file...\n", program);
+    fprintf(stderr, "  -summary         print number of passed and failed tests per suite\n");
+    fprintf(stderr, "  -output_dir=dir  write <dir>/<suite>.xml instead of printing reports\n");
+    fprintf(stderr, "  -output=file     write single <testsuites> report of all suites\n");
+}
+
+void add_testcases(testsuite_data& test_suite, const std::string& suite_name, const suite_results& results)
+{
+    for (auto it = results.entries.begin(); it != results.entries.end(); ++it)
+    {
+        auto test_case = test_suite.add_testcase(suite_name + "." + *it->test_name, *it->test_name);
+        if (it->outcome != test_outcome::pass)
+            test_case->fail_test_case(test_outcome_str[(int)it->outcome],
+                it->failure.empty() ? G2FASTH_FAILURE_REASON : it->failure);
+    }
+}
+}
+
+int main(int argc, char** argv)
+{
+    bool summary = false;
+    std::string output_dir;
+    std::string output;
+    std::vector<std::string> logs;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-summary") == 0)
+            summary = true;
+        else if (strncmp(argv[i], "-output_dir=", 12) == 0)
+            output_dir = argv[i] + 12;
+        else if (strncmp(argv[i], "-output=", 8) == 0)
+            output = argv[i] + 8;
+        else if (argv[i][0] == '-')
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        else
+            logs.push_back(argv[i]);
+    }
+    if (logs.empty())
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Readers own the name strings referenced by entries, keep them all alive
+    std::vector<std::shared_ptr<result_log_reader>> readers;
+    std::map<std::string, suite_results> suites;
+    std::map<std::string, std::string> start_times;
+    for (auto log = logs.begin(); log != logs.end(); ++log)
+    {
+        auto reader = std::make_shared<result_log_reader>();
+        if (!reader->open(*log))
+        {
+            fprintf(stderr, "Cannot read result log %s\n", log->c_str());
+            return 2;
+        }
+        readers.push_back(reader);
+        result_log_entry entry;
+        while (reader->next(entry))
+        {
+            suite_results& results = suites[*entry.suite_name];
+            results.entries.push_back(entry);
+            unsigned long long end_ms = entry.start_ms + entry.duration_ms;
+            if (results.entries.size() == 1 || entry.start_ms < results.first_ms)
+                results.first_ms = entry.start_ms;
+            if (end_ms > results.last_ms)
+                results.last_ms = end_ms;
+            if (entry.outcome == test_outcome::pass)
+                results.passed++;
+            else
+                results.failed++;
+            if (!start_times.count(*entry.suite_name))
+                start_times[*entry.suite_name] = reader->suite_start_time(*entry.suite_name);
+        }
+    }
+
+    int total_passed = 0, total_failed = 0;
+    unsigned long long first_ms = 0, last_ms = 0;
+    testsuites_data aggregated;
+    for (auto it = suites.begin(); it != suites.end(); ++it)
+    {
+        const suite_results& results = it->second;
+        total_passed += results.passed;
+        total_failed += results.failed;
+        if (it == suites.begin() || results.first_ms < first_ms)
+            first_ms = results.first_ms;
+        if (results.last_ms > last_ms)
+            last_ms = results.last_ms;
+        if (summary)
+        {
+            printf("%s: %d passed, %d failed\n", it->first.c_str(), results.passed, results.failed);
+            continue;
+        }
+        if (!output.empty())
+        {
+            auto test_suite = aggregated.add_testsuite(it->first, (int)results.entries.size(), results.failed,
+                start_times[it->first], (int)(results.last_ms - results.first_ms));
+            add_testcases(*test_suite, it->first, results);
+            continue;
+        }
+        testsuite_data test_suite((int)results.entries.size(), start_times[it->first]);
+        add_testcases(test_suite, it->first, results);
+        std::string file_name = output_dir.empty() ? std::string() : output_dir + "/" + it->first + ".xml";
+        std::string report = test_suite.to_xml(file_name);
+        if (output_dir.empty())
+            printf("%s\n", report.c_str());
+    }
+    if (summary)
+        printf("Total: %d passed, %d failed\n", total_passed, total_failed);
+    else if (!output.empty())
+    {
+        aggregated.set_elapsed((int)(last_ms - first_ms));
+        aggregated.to_xml(output);
+    }
+    return total_failed ? 1 : 0;
+}